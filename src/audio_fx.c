@@ -1,14 +1,45 @@
-/* SDL audio helper module for procedural UI/gameplay tones. */
+/* SDL audio helper module for procedural UI/gameplay tones.
+   Every gameplay cue is synthesized once into an immutable PCM buffer; the
+   UI thread posts "start buffer" commands through a single-producer ring and
+   the audio callback mixes a fixed pool of voices, so overlapping cues play
+   together and start within one device period. */
 
 #include "audio_fx.h"
 
-#include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+#include "audio_osc.h"
+#include "trace.h"
+
+#define CUE_MAX_STEPS 10
+/* Ring positions run over twice the capacity so full and empty differ. */
+#define RING_INDEX_MASK (2 * AUDIO_FX_COMMAND_RING - 1)
+
+/* Kind of one synthesized segment inside a cue. */
+typedef enum {
+    STEP_NOTE = 0,
+    STEP_GLIDE = 1,
+    STEP_NOISE = 2
+} CueStepKind;
+
+/* One segment of a cue; segments play back to back. */
+typedef struct {
+    CueStepKind kind;
+    float f0;
+    float f1;
+    int duration_ms;
+    float gain;
+    float vibrato_hz;
+    float vibrato_depth;
+} CueStep;
+
+/* Ordered list of segments describing a whole cue. */
+typedef struct {
+    CueStep steps[CUE_MAX_STEPS];
+    int count;
+} CueScore;
 
 /* Clamps gain/envelope values to avoid clipping. */
 static float clampf(float v, float lo, float hi) {
@@ -21,213 +52,446 @@ static float clampf(float v, float lo, float hi) {
     return v;
 }
 
-/* Rich note synthesizer with simple harmonic color and vibrato. */
-static void queue_note(AudioFx *fx, float frequency, int duration_ms, float gain, float vibrato_hz, float vibrato_depth) {
-    if (!fx->ready || duration_ms <= 0) {
-        return;
+/* Returns number of samples a segment of duration_ms occupies. */
+static int step_samples(const AudioFx *fx, int duration_ms) {
+    if (duration_ms <= 0) {
+        return 0;
     }
+    return SDL_max(0, (fx->spec.freq * duration_ms) / 1000);
+}
 
-    int sample_count = (fx->spec.freq * duration_ms) / 1000;
-    if (sample_count <= 0) {
-        return;
+/* Subtle broadband burst for particle-like texture. Uses a local xorshift
+   so cues can be rendered off the main thread without touching rand(). */
+static void synth_noise_burst(float *samples, int sample_count, float gain) {
+    uint32_t noise = 0x9E3779B9u;
+    float state = 0.0f;
+    for (int i = 0; i < sample_count; ++i) {
+        float t = (float)i / (float)sample_count;
+        float attack = SDL_min(1.0f, t * 40.0f);
+        float release = SDL_min(1.0f, (1.0f - t) * 10.0f);
+        float env = attack * release;
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        float white = (float)(noise >> 8) / (float)(1u << 24);
+        white = white * 2.0f - 1.0f;
+        state = state * 0.78f + white * 0.22f;
+        samples[i] = state * clampf(gain, 0.0f, 0.20f) * env;
     }
+}
 
-    float *samples = (float *)malloc((size_t)sample_count * sizeof(float));
-    if (samples == NULL) {
-        return;
+/* Renders one segment into samples[0..sample_count). */
+static void synth_step(const AudioFx *fx, const CueStep *step, float *samples, int sample_count) {
+    if (step->kind == STEP_NOTE) {
+        audio_osc_render(&AUDIO_OSC_NOTE, step->f0, step->f0, step->gain, step->vibrato_hz, step->vibrato_depth, fx->spec.freq, samples, sample_count);
+    } else if (step->kind == STEP_GLIDE) {
+        float gain = clampf(step->gain, 0.0f, 0.35f);
+        audio_osc_render(&AUDIO_OSC_GLIDE, step->f0, step->f1, gain, step->vibrato_hz, step->vibrato_depth, fx->spec.freq, samples, sample_count);
+    } else {
+        synth_noise_burst(samples, sample_count, step->gain);
     }
+}
 
-    float phase = 0.0f;
-    float base_step = 2.0f * (float)M_PI * frequency / (float)fx->spec.freq;
-    float vib_phase = 0.0f;
-    float vib_step = 2.0f * (float)M_PI * vibrato_hz / (float)fx->spec.freq;
+/* Appends a note segment to a cue score. */
+static void score_note(CueScore *score, float frequency, int duration_ms, float gain, float vibrato_hz, float vibrato_depth) {
+    if (score->count < CUE_MAX_STEPS) {
+        CueStep step = {STEP_NOTE, frequency, frequency, duration_ms, gain, vibrato_hz, vibrato_depth};
+        score->steps[score->count++] = step;
+    }
+}
 
-    for (int i = 0; i < sample_count; ++i) {
-        float t = (float)i / (float)sample_count;
-        float attack = SDL_min(1.0f, t * 28.0f);
-        float release = SDL_min(1.0f, (1.0f - t) * 12.0f);
-        float env = attack * release;
-        float vib = sinf(vib_phase) * vibrato_depth;
-        float carrier = sinf(phase + vib);
-        float harmonic2 = 0.35f * sinf(2.0f * phase + vib * 0.5f);
-        float harmonic3 = 0.12f * sinf(3.0f * phase + vib * 0.25f);
-        samples[i] = (carrier + harmonic2 + harmonic3) * gain * env;
-        phase += base_step;
-        vib_phase += vib_step;
+/* Appends a glide segment to a cue score. */
+static void score_glide(CueScore *score, float f0, float f1, int duration_ms, float gain, float vibrato_hz, float vibrato_depth) {
+    if (score->count < CUE_MAX_STEPS) {
+        CueStep step = {STEP_GLIDE, f0, f1, duration_ms, gain, vibrato_hz, vibrato_depth};
+        score->steps[score->count++] = step;
     }
+}
 
-    SDL_QueueAudio(fx->device, samples, (Uint32)(sample_count * (int)sizeof(float)));
-    free(samples);
+/* Appends a noise segment to a cue score. */
+static void score_noise(CueScore *score, int duration_ms, float gain) {
+    if (score->count < CUE_MAX_STEPS) {
+        CueStep step = {STEP_NOISE, 0.0f, 0.0f, duration_ms, gain, 0.0f, 0.0f};
+        score->steps[score->count++] = step;
+    }
 }
 
-/* Queues a short frequency glide for musical transitions. */
-static void queue_glide(AudioFx *fx, float f0, float f1, int duration_ms, float gain, float vibrato_hz, float vibrato_depth) {
-    if (!fx->ready || duration_ms <= 0) {
-        return;
+/* Describes the line-clear cue for a cleared count in
+   [AUDIO_FX_LINE_CLEAR_MIN..AUDIO_FX_LINE_CLEAR_MAX]. */
+static void score_line_clear(CueScore *score, int cleared_count) {
+    float bonus = (float)(cleared_count - 5) * 4.0f;
+    float root = 170.0f + bonus;
+    float gain = 0.14f + (float)(cleared_count - 5) * 0.007f;
+    if (gain > 0.24f) {
+        gain = 0.24f;
     }
 
-    int sample_count = (fx->spec.freq * duration_ms) / 1000;
-    if (sample_count <= 0) {
+    score_noise(score, 85, 0.09f + (float)(cleared_count - 5) * 0.004f);
+    score_note(score, root * 0.5f, 80, gain * 0.95f, 4.0f, 0.03f);
+    score_note(score, root, 95, gain, 4.5f, 0.04f);
+    score_note(score, root * 1.2f, 105, gain * 0.92f, 5.0f, 0.04f);
+    score_glide(score, root * 1.1f, root * 0.7f, 130, gain * 0.86f, 5.5f, 0.05f);
+}
+
+/* Describes the segments of one cached cue. */
+static void score_for_cue(AudioCueId id, CueScore *score) {
+    memset(score, 0, sizeof(*score));
+    switch (id) {
+        case AUDIO_CUE_SELECT:
+            score_note(score, 560.0f, 45, 0.07f, 7.0f, 0.04f);
+            score_note(score, 700.0f, 55, 0.09f, 7.0f, 0.04f);
+            score_note(score, 840.0f, 65, 0.10f, 7.0f, 0.04f);
+            break;
+        case AUDIO_CUE_INVALID:
+            score_note(score, 246.0f, 52, 0.10f, 2.5f, 0.02f);
+            score_glide(score, 246.0f, 164.0f, 110, 0.11f, 2.5f, 0.02f);
+            break;
+        case AUDIO_CUE_MOVE:
+            score_note(score, 320.0f, 35, 0.06f, 5.0f, 0.03f);
+            score_glide(score, 380.0f, 520.0f, 72, 0.09f, 5.5f, 0.03f);
+            score_note(score, 620.0f, 48, 0.08f, 6.0f, 0.04f);
+            break;
+        case AUDIO_CUE_RESTART:
+            score_note(score, 392.0f, 75, 0.10f, 5.0f, 0.03f);
+            score_note(score, 523.3f, 85, 0.12f, 5.5f, 0.03f);
+            score_glide(score, 622.0f, 698.5f, 110, 0.13f, 6.0f, 0.04f);
+            break;
+        case AUDIO_CUE_GAME_OVER:
+            score_note(score, 392.0f, 170, 0.10f, 4.0f, 0.03f);
+            score_note(score, 349.2f, 190, 0.11f, 4.0f, 0.03f);
+            score_note(score, 311.1f, 210, 0.12f, 4.2f, 0.04f);
+            score_glide(score, 293.7f, 246.9f, 280, 0.13f, 4.2f, 0.04f);
+            score_note(score, 261.6f, 290, 0.14f, 4.5f, 0.05f);
+            score_note(score, 220.0f, 330, 0.15f, 4.6f, 0.06f);
+            score_note(score, 196.0f, 370, 0.15f, 4.8f, 0.07f);
+            score_glide(score, 174.6f, 130.8f, 560, 0.13f, 5.0f, 0.08f);
+            score_noise(score, 180, 0.04f);
+            break;
+        default:
+            score_line_clear(score, AUDIO_FX_LINE_CLEAR_MIN + ((int)id - AUDIO_CUE_LINE_CLEAR_FIRST));
+            break;
+    }
+}
+
+/* Returns total sample count of a score. */
+static int score_sample_count(const AudioFx *fx, const CueScore *score) {
+    int total = 0;
+    for (int i = 0; i < score->count; ++i) {
+        total += step_samples(fx, score->steps[i].duration_ms);
+    }
+    return total;
+}
+
+/* Synthesizes a score into out, which holds score_sample_count() samples. */
+static void synth_score(const AudioFx *fx, const CueScore *score, float *out) {
+    int offset = 0;
+    for (int i = 0; i < score->count; ++i) {
+        int n = step_samples(fx, score->steps[i].duration_ms);
+        if (n > 0) {
+            synth_step(fx, &score->steps[i], out + offset, n);
+            offset += n;
+        }
+    }
+}
+
+/* Synthesizes a whole score into one contiguous buffer. */
+static void render_score(const AudioFx *fx, const CueScore *score, AudioCue *out) {
+    out->samples = NULL;
+    out->sample_count = 0;
+
+    int total = score_sample_count(fx, score);
+    if (total <= 0) {
         return;
     }
 
-    float *samples = (float *)malloc((size_t)sample_count * sizeof(float));
+    float *samples = (float *)malloc((size_t)total * sizeof(float));
     if (samples == NULL) {
         return;
     }
 
-    float phase = 0.0f;
-    float vib_phase = 0.0f;
-    float vib_step = 2.0f * (float)M_PI * vibrato_hz / (float)fx->spec.freq;
-    for (int i = 0; i < sample_count; ++i) {
-        float t = (float)i / (float)sample_count;
-        float f = f0 + (f1 - f0) * t;
-        float step = 2.0f * (float)M_PI * f / (float)fx->spec.freq;
-        float attack = SDL_min(1.0f, t * 24.0f);
-        float release = SDL_min(1.0f, (1.0f - t) * 8.0f);
-        float env = attack * release;
-        float vib = sinf(vib_phase) * vibrato_depth;
-        float s0 = sinf(phase + vib);
-        float s1 = 0.30f * sinf(2.0f * phase + vib * 0.5f);
-        float s2 = 0.08f * sinf(4.0f * phase + vib * 0.2f);
-        samples[i] = (s0 + s1 + s2) * clampf(gain, 0.0f, 0.35f) * env;
-        phase += step;
-        vib_phase += vib_step;
+    synth_score(fx, score, samples);
+    out->samples = samples;
+    out->sample_count = total;
+}
+
+/* Renders every cue into fx->cues; runs inline or on the builder thread. */
+static int build_cues(void *data) {
+    AudioFx *fx = (AudioFx *)data;
+    trace_begin("audio", "build_cues");
+    for (int id = 0; id < AUDIO_CUE_COUNT; ++id) {
+        CueScore score;
+        score_for_cue((AudioCueId)id, &score);
+        trace_begin("audio", "render_cue");
+        render_score(fx, &score, &fx->cues[id]);
+        trace_end("audio", "render_cue");
     }
+    trace_end("audio", "build_cues");
+    SDL_AtomicSet(&fx->cues_built, 1);
+    return 0;
+}
+
+/* Thread entry for the background cue build; names the thread in traces. */
+static int build_cues_thread(void *data) {
+    trace_set_thread_name("audio-cues");
+    return build_cues(data);
+}
+
+/* Pushes one command into the SPSC ring; returns false when it is full. */
+static bool push_command(AudioFx *fx, const float *samples, int sample_count, bool retrigger) {
+    int head = SDL_AtomicGet(&fx->command_head);
+    int tail = SDL_AtomicGet(&fx->command_tail);
+    if (((head - tail) & RING_INDEX_MASK) >= AUDIO_FX_COMMAND_RING) {
+        return false;
+    }
+
+    AudioFxCommand *cmd = &fx->commands[head & (AUDIO_FX_COMMAND_RING - 1)];
+    cmd->samples = samples;
+    cmd->sample_count = sample_count;
+    cmd->queued_ticks = SDL_GetPerformanceCounter();
+    cmd->retrigger = retrigger;
+    SDL_AtomicSet(&fx->command_head, (head + 1) & RING_INDEX_MASK);
+    return true;
+}
 
-    SDL_QueueAudio(fx->device, samples, (Uint32)(sample_count * (int)sizeof(float)));
-    free(samples);
+/* Converts mixer frames to milliseconds at the device rate. */
+static int frames_to_ms(const AudioFx *fx, int frames) {
+    if (fx->spec.freq <= 0) {
+        return 0;
+    }
+    return (int)(((long long)frames * 1000) / fx->spec.freq);
 }
 
-/* Queues a subtle broadband burst for particle-like texture. */
-static void queue_noise_burst(AudioFx *fx, int duration_ms, float gain) {
-    if (!fx->ready || duration_ms <= 0) {
+/* Starts a cached cue by reference to its immutable PCM buffer. Cues
+   requested while the background build is still running are dropped, so
+   the UI thread never synthesizes. */
+static void play_cue(AudioFx *fx, AudioCueId id) {
+    if (!fx->ready) {
         return;
     }
 
-    int sample_count = (fx->spec.freq * duration_ms) / 1000;
-    if (sample_count <= 0) {
+    if (!SDL_AtomicGet(&fx->cues_built)) {
+        ++fx->dropped;
         return;
     }
 
-    float *samples = (float *)malloc((size_t)sample_count * sizeof(float));
-    if (samples == NULL) {
+    const AudioCue *cue = &fx->cues[id];
+    if (cue->samples == NULL) {
         return;
     }
+    trace_instant("audio", "cue");
+
+    /* Under backlog, a repeat of a cue that is still sounding restarts that
+       voice rather than stacking another copy on top of it. */
+    int now = SDL_AtomicGet(&fx->mixed_frames);
+    int since = (int)((unsigned)now - (unsigned)fx->cue_started_at[id]);
+    bool still_sounding = fx->cue_started[id] && since < cue->sample_count;
+    bool backlogged = frames_to_ms(fx, SDL_AtomicGet(&fx->backlog_frames)) > AUDIO_FX_BACKLOG_LIMIT_MS;
+    bool merge = still_sounding && backlogged;
+
+    if (!push_command(fx, cue->samples, cue->sample_count, merge)) {
+        ++fx->dropped;
+        return;
+    }
+    if (merge) {
+        ++fx->merged;
+    } else {
+        ++fx->enqueued;
+    }
+    fx->cue_started[id] = true;
+    fx->cue_started_at[id] = now;
+}
+
+/* Assigns a command to a free voice, stealing the most advanced one if needed.
+   Retrigger commands rewind a voice already playing the same buffer.
+   now_ticks is the performance counter when the mix call began. */
+static void start_voice(AudioFx *fx, const AudioFxCommand *cmd, Uint64 now_ticks, Uint64 ticks_per_second) {
+    Uint64 waited = now_ticks > cmd->queued_ticks ? now_ticks - cmd->queued_ticks : 0;
+    Uint64 latency_us = ticks_per_second > 0 ? waited * 1000000u / ticks_per_second : 0;
+    int latency = latency_us > (Uint64)SDL_MAX_SINT32 ? SDL_MAX_SINT32 : (int)latency_us;
+    if (latency > SDL_AtomicGet(&fx->max_start_latency_us)) {
+        SDL_AtomicSet(&fx->max_start_latency_us, latency);
+    }
+
+    if (cmd->retrigger) {
+        for (int i = 0; i < AUDIO_FX_MAX_VOICES; ++i) {
+            if (fx->voices[i].samples == cmd->samples) {
+                fx->voices[i].position = 0;
+                return;
+            }
+        }
+    }
+
+    int target = -1;
+    int best_position = -1;
+    for (int i = 0; i < AUDIO_FX_MAX_VOICES; ++i) {
+        const AudioFxVoice *voice = &fx->voices[i];
+        if (voice->samples == NULL) {
+            target = i;
+            break;
+        }
+        if (voice->position > best_position) {
+            best_position = voice->position;
+            target = i;
+        }
+    }
+
+    AudioFxVoice *voice = &fx->voices[target];
+    voice->samples = cmd->samples;
+    voice->sample_count = cmd->sample_count;
+    voice->position = 0;
+}
+
+/* Drains pending commands and mixes active voices into out; called from
+   the audio callback, exposed so the mixer can be driven without a device. */
+void audio_fx_mix(AudioFx *fx, float *out, int sample_count) {
+    Uint64 now_ticks = SDL_GetPerformanceCounter();
+    Uint64 ticks_per_second = SDL_GetPerformanceFrequency();
+    int tail = SDL_AtomicGet(&fx->command_tail);
+    int head = SDL_AtomicGet(&fx->command_head);
+    while (tail != head) {
+        start_voice(fx, &fx->commands[tail & (AUDIO_FX_COMMAND_RING - 1)], now_ticks, ticks_per_second);
+        tail = (tail + 1) & RING_INDEX_MASK;
+    }
+    SDL_AtomicSet(&fx->command_tail, tail);
+
+    memset(out, 0, (size_t)sample_count * sizeof(float));
+    int backlog = 0;
+    for (int v = 0; v < AUDIO_FX_MAX_VOICES; ++v) {
+        AudioFxVoice *voice = &fx->voices[v];
+        if (voice->samples == NULL) {
+            continue;
+        }
+
+        int n = SDL_min(sample_count, voice->sample_count - voice->position);
+        const float *src = voice->samples + voice->position;
+        for (int i = 0; i < n; ++i) {
+            out[i] += src[i];
+        }
+        voice->position += n;
+
+        if (voice->position >= voice->sample_count) {
+            voice->samples = NULL;
+        } else {
+            backlog = SDL_max(backlog, voice->sample_count - voice->position);
+        }
+    }
+    SDL_AtomicSet(&fx->backlog_frames, backlog);
+    SDL_AtomicAdd(&fx->mixed_frames, sample_count);
 
-    float state = 0.0f;
     for (int i = 0; i < sample_count; ++i) {
-        float t = (float)i / (float)sample_count;
-        float attack = SDL_min(1.0f, t * 40.0f);
-        float release = SDL_min(1.0f, (1.0f - t) * 10.0f);
-        float env = attack * release;
-        float white = (float)rand() / (float)RAND_MAX;
-        white = white * 2.0f - 1.0f;
-        state = state * 0.78f + white * 0.22f;
-        samples[i] = state * clampf(gain, 0.0f, 0.20f) * env;
+        out[i] = clampf(out[i], -1.0f, 1.0f);
     }
+}
 
-    SDL_QueueAudio(fx->device, samples, (Uint32)(sample_count * (int)sizeof(float)));
-    free(samples);
+/* SDL audio callback; stream is mono F32 in device order. Names the
+   device thread in traces on its first call. */
+static void audio_callback(void *userdata, Uint8 *stream, int len) {
+    AudioFx *fx = (AudioFx *)userdata;
+    if (!fx->callback_named) {
+        trace_set_thread_name("audio");
+        fx->callback_named = true;
+    }
+    trace_begin("audio", "mix");
+    audio_fx_mix(fx, (float *)stream, len / (int)sizeof(float));
+    trace_end("audio", "mix");
 }
 
-/* Initializes SDL audio device for procedural tone playback. */
-void audio_fx_init(AudioFx *fx) {
+/* Initializes SDL audio device and renders all cues once, either inline
+   or on a background thread when background_build is true. */
+void audio_fx_init(AudioFx *fx, bool background_build) {
     memset(fx, 0, sizeof(*fx));
+    audio_osc_init();
 
     SDL_AudioSpec want;
     SDL_zero(want);
     want.freq = 48000;
     want.format = AUDIO_F32SYS;
     want.channels = 1;
-    want.samples = 1024;
+    want.samples = 512;
+    want.callback = audio_callback;
+    want.userdata = fx;
 
     fx->device = SDL_OpenAudioDevice(NULL, 0, &want, &fx->spec, 0);
-    if (fx->device != 0) {
-        SDL_PauseAudioDevice(fx->device, 0);
-        fx->ready = true;
+    if (fx->device == 0) {
+        return;
     }
+
+    fx->ready = true;
+    if (background_build) {
+        fx->cue_builder = SDL_CreateThread(build_cues_thread, "audio-cues", fx);
+    }
+    if (fx->cue_builder == NULL) {
+        (void)build_cues(fx);
+    }
+    SDL_PauseAudioDevice(fx->device, 0);
+}
+
+/* Fills stats with cue counters and mixer latency measurements. */
+void audio_fx_get_stats(AudioFx *fx, AudioFxStats *stats) {
+    stats->enqueued = fx->enqueued;
+    stats->merged = fx->merged;
+    stats->dropped = fx->dropped;
+    stats->backlog_ms = frames_to_ms(fx, SDL_AtomicGet(&fx->backlog_frames));
+    stats->max_start_latency_us = SDL_AtomicGet(&fx->max_start_latency_us);
+    stats->max_start_latency_ms = stats->max_start_latency_us / 1000;
 }
 
 /* Releases SDL audio resources owned by AudioFx. */
 void audio_fx_shutdown(AudioFx *fx) {
+    if (fx->cue_builder != NULL) {
+        SDL_WaitThread(fx->cue_builder, NULL);
+        fx->cue_builder = NULL;
+    }
+
     if (fx->device != 0) {
-        SDL_ClearQueuedAudio(fx->device);
         SDL_CloseAudioDevice(fx->device);
         fx->device = 0;
     }
-    fx->ready = false;
-}
 
-/* Plays one short procedural tone if audio device is available. */
-void audio_fx_play_tone(AudioFx *fx, float frequency, int duration_ms, float gain) {
-    queue_note(fx, frequency, duration_ms, gain, 4.5f, 0.05f);
+    for (int id = 0; id < AUDIO_CUE_COUNT; ++id) {
+        free(fx->cues[id].samples);
+        fx->cues[id].samples = NULL;
+        fx->cues[id].sample_count = 0;
+    }
+    memset(fx->voices, 0, sizeof(fx->voices));
+    SDL_AtomicSet(&fx->command_head, 0);
+    SDL_AtomicSet(&fx->command_tail, 0);
+    SDL_AtomicSet(&fx->cues_built, 0);
+    fx->ready = false;
 }
 
 /* Plays short selection cue. */
 void audio_fx_play_select(AudioFx *fx) {
-    queue_note(fx, 560.0f, 45, 0.07f, 7.0f, 0.04f);
-    queue_note(fx, 700.0f, 55, 0.09f, 7.0f, 0.04f);
-    queue_note(fx, 840.0f, 65, 0.10f, 7.0f, 0.04f);
+    play_cue(fx, AUDIO_CUE_SELECT);
 }
 
 /* Plays short invalid-action cue. */
 void audio_fx_play_invalid(AudioFx *fx) {
-    queue_note(fx, 246.0f, 52, 0.10f, 2.5f, 0.02f);
-    queue_glide(fx, 246.0f, 164.0f, 110, 0.11f, 2.5f, 0.02f);
+    play_cue(fx, AUDIO_CUE_INVALID);
 }
 
 /* Plays move-start cue. */
 void audio_fx_play_move(AudioFx *fx) {
-    queue_note(fx, 320.0f, 35, 0.06f, 5.0f, 0.03f);
-    queue_glide(fx, 380.0f, 520.0f, 72, 0.09f, 5.5f, 0.03f);
-    queue_note(fx, 620.0f, 48, 0.08f, 6.0f, 0.04f);
+    play_cue(fx, AUDIO_CUE_MOVE);
 }
 
 /* Plays line-clear cue; intensity depends on number of cleared balls. */
 void audio_fx_play_line_clear(AudioFx *fx, int cleared_count) {
-    if (cleared_count < 5) {
-        cleared_count = 5;
+    if (cleared_count < AUDIO_FX_LINE_CLEAR_MIN) {
+        cleared_count = AUDIO_FX_LINE_CLEAR_MIN;
     }
-    if (cleared_count > 20) {
-        cleared_count = 20;
+    if (cleared_count > AUDIO_FX_LINE_CLEAR_MAX) {
+        cleared_count = AUDIO_FX_LINE_CLEAR_MAX;
     }
-
-    float bonus = (float)(cleared_count - 5) * 4.0f;
-    float root = 170.0f + bonus;
-    float gain = 0.14f + (float)(cleared_count - 5) * 0.007f;
-    if (gain > 0.24f) {
-        gain = 0.24f;
-    }
-
-    queue_noise_burst(fx, 85, 0.09f + (float)(cleared_count - 5) * 0.004f);
-    queue_note(fx, root * 0.5f, 80, gain * 0.95f, 4.0f, 0.03f);
-    queue_note(fx, root, 95, gain, 4.5f, 0.04f);
-    queue_note(fx, root * 1.2f, 105, gain * 0.92f, 5.0f, 0.04f);
-    queue_glide(fx, root * 1.1f, root * 0.7f, 130, gain * 0.86f, 5.5f, 0.05f);
+    play_cue(fx, (AudioCueId)(AUDIO_CUE_LINE_CLEAR_FIRST + (cleared_count - AUDIO_FX_LINE_CLEAR_MIN)));
 }
 
 /* Plays restart cue. */
 void audio_fx_play_restart(AudioFx *fx) {
-    queue_note(fx, 392.0f, 75, 0.10f, 5.0f, 0.03f);
-    queue_note(fx, 523.3f, 85, 0.12f, 5.5f, 0.03f);
-    queue_glide(fx, 622.0f, 698.5f, 110, 0.13f, 6.0f, 0.04f);
+    play_cue(fx, AUDIO_CUE_RESTART);
 }
 
 /* Plays longer game-over composition. */
 void audio_fx_play_game_over(AudioFx *fx) {
-    if (!fx->ready) {
-        return;
-    }
-
-    SDL_ClearQueuedAudio(fx->device);
-    queue_note(fx, 392.0f, 170, 0.10f, 4.0f, 0.03f);
-    queue_note(fx, 349.2f, 190, 0.11f, 4.0f, 0.03f);
-    queue_note(fx, 311.1f, 210, 0.12f, 4.2f, 0.04f);
-    queue_glide(fx, 293.7f, 246.9f, 280, 0.13f, 4.2f, 0.04f);
-    queue_note(fx, 261.6f, 290, 0.14f, 4.5f, 0.05f);
-    queue_note(fx, 220.0f, 330, 0.15f, 4.6f, 0.06f);
-    queue_note(fx, 196.0f, 370, 0.15f, 4.8f, 0.07f);
-    queue_glide(fx, 174.6f, 130.8f, 560, 0.13f, 5.0f, 0.08f);
-    queue_noise_burst(fx, 180, 0.04f);
+    play_cue(fx, AUDIO_CUE_GAME_OVER);
 }
@@ -5,22 +5,100 @@
 
 #include <SDL.h>
 
-/* Small owner struct for SDL audio device and obtained format. */
+#define AUDIO_FX_LINE_CLEAR_MIN 5
+#define AUDIO_FX_LINE_CLEAR_MAX 20
+#define AUDIO_FX_MAX_VOICES 16
+#define AUDIO_FX_COMMAND_RING 64
+#define AUDIO_FX_BACKLOG_LIMIT_MS 120
+
+/* Fixed gameplay cues; line-clear has one variant per cleared count. */
+typedef enum {
+    AUDIO_CUE_SELECT = 0,
+    AUDIO_CUE_INVALID = 1,
+    AUDIO_CUE_MOVE = 2,
+    AUDIO_CUE_RESTART = 3,
+    AUDIO_CUE_GAME_OVER = 4,
+    AUDIO_CUE_LINE_CLEAR_FIRST = 5,
+    AUDIO_CUE_COUNT = AUDIO_CUE_LINE_CLEAR_FIRST + (AUDIO_FX_LINE_CLEAR_MAX - AUDIO_FX_LINE_CLEAR_MIN + 1)
+} AudioCueId;
+
+/* Immutable pre-synthesized PCM for one cue in device format. */
+typedef struct {
+    float *samples;
+    int sample_count;
+} AudioCue;
+
+/* "Start this buffer" command passed from the UI thread to the mixer.
+   retrigger restarts a voice already playing the same buffer instead of
+   layering a new one; queued_ticks stamps the performance counter at push
+   time so the mixer can measure how long the command waited. */
+typedef struct {
+    const float *samples;
+    int sample_count;
+    Uint64 queued_ticks;
+    bool retrigger;
+} AudioFxCommand;
+
+/* One playing voice; owned exclusively by the audio callback. */
+typedef struct {
+    const float *samples;
+    int sample_count;
+    int position;
+} AudioFxVoice;
+
+/* Small owner struct for SDL audio device, obtained format, cue cache and
+   callback mixer state. The UI thread is the only producer of commands and
+   the audio callback the only consumer; every voice plays a cached cue, so
+   cues requested before cues_built is set are dropped. */
 typedef struct {
     SDL_AudioDeviceID device;
     SDL_AudioSpec spec;
     bool ready;
+    AudioCue cues[AUDIO_CUE_COUNT];
+    SDL_Thread *cue_builder;
+    SDL_atomic_t cues_built;
+    AudioFxCommand commands[AUDIO_FX_COMMAND_RING];
+    SDL_atomic_t command_head;
+    SDL_atomic_t command_tail;
+    AudioFxVoice voices[AUDIO_FX_MAX_VOICES];
+    SDL_atomic_t mixed_frames;
+    SDL_atomic_t backlog_frames;
+    SDL_atomic_t max_start_latency_us;
+    int enqueued;
+    int merged;
+    int dropped;
+    int cue_started_at[AUDIO_CUE_COUNT];
+    bool cue_started[AUDIO_CUE_COUNT];
+    bool callback_named;
 } AudioFx;
 
-/* Initializes SDL audio device for procedural tone playback. */
-void audio_fx_init(AudioFx *fx);
+/* Cue traffic counters; enqueued + merged + dropped equals cue requests.
+   backlog_ms is the longest remaining voice tail after the last mix and
+   max_start_latency_us/_ms the worst wall-clock delay between a request and
+   the mix call that started its voice. */
+typedef struct {
+    int enqueued;
+    int merged;
+    int dropped;
+    int backlog_ms;
+    int max_start_latency_us;
+    int max_start_latency_ms;
+} AudioFxStats;
+
+/* Initializes SDL audio device and renders all cues once, either inline
+   or on a background thread when background_build is true. */
+void audio_fx_init(AudioFx *fx, bool background_build);
+
+/* Drains pending commands and mixes active voices into out; called from
+   the audio callback, exposed so the mixer can be driven without a device. */
+void audio_fx_mix(AudioFx *fx, float *out, int sample_count);
+
+/* Fills stats with cue counters and mixer latency measurements. */
+void audio_fx_get_stats(AudioFx *fx, AudioFxStats *stats);
 
 /* Releases SDL audio resources owned by AudioFx. */
 void audio_fx_shutdown(AudioFx *fx);
 
-/* Plays one short procedural tone if audio device is available. */
-void audio_fx_play_tone(AudioFx *fx, float frequency, int duration_ms, float gain);
-
 /* Plays short selection cue. */
 void audio_fx_play_select(AudioFx *fx);
 
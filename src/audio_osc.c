@@ -0,0 +1,173 @@
+/* Band-limited wavetable oscillator for procedural cue synthesis.
+   Phases are 32-bit fixed-point turns so harmonics are exact integer
+   multiples and wrap for free; one shared sine table is read with linear
+   interpolation, four samples at a time when SSE2 is available. */
+
+#include "audio_osc.h"
+
+#include <math.h>
+#include <stdbool.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define OSC_SIMD_WIDTH 4
+#else
+#define OSC_SIMD_WIDTH 1
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define OSC_FRAC_BITS (32 - AUDIO_OSC_TABLE_BITS)
+#define OSC_FRAC_MASK ((1u << OSC_FRAC_BITS) - 1u)
+#define OSC_FRAC_SCALE (1.0f / (float)(1u << OSC_FRAC_BITS))
+#define OSC_TURN 4294967296.0
+#define OSC_RAD_TO_PHASE ((float)(OSC_TURN / (2.0 * M_PI)))
+
+/* One period of sine plus a guard sample so index + 1 never wraps. */
+static float sine_table[AUDIO_OSC_TABLE_SIZE + 1];
+
+const AudioOscTimbre AUDIO_OSC_NOTE = {
+    {1, 2, 3},
+    {1.0f, 0.35f, 0.12f},
+    {1.0f, 0.5f, 0.25f},
+    28.0f,
+    12.0f,
+};
+
+const AudioOscTimbre AUDIO_OSC_GLIDE = {
+    {1, 2, 4},
+    {1.0f, 0.30f, 0.08f},
+    {1.0f, 0.5f, 0.2f},
+    24.0f,
+    8.0f,
+};
+
+/* Builds the shared sine table; call once before rendering from any thread. */
+void audio_osc_init(void) {
+    for (int i = 0; i <= AUDIO_OSC_TABLE_SIZE; ++i) {
+        sine_table[i] = (float)sin(2.0 * M_PI * (double)i / (double)AUDIO_OSC_TABLE_SIZE);
+    }
+}
+
+/* Converts frequency to a fixed-point per-sample phase increment. */
+static uint32_t phase_step(float frequency, int sample_rate) {
+    double turns = (double)frequency / (double)sample_rate;
+    turns -= floor(turns);
+    return (uint32_t)(turns * OSC_TURN);
+}
+
+/* Interpolated sine of a fixed-point phase. */
+static float lookup(uint32_t phase) {
+    uint32_t idx = phase >> OSC_FRAC_BITS;
+    float frac = (float)(phase & OSC_FRAC_MASK) * OSC_FRAC_SCALE;
+    float a = sine_table[idx];
+    float b = sine_table[idx + 1];
+    return a + (b - a) * frac;
+}
+
+/* Linear attack/release envelope at normalized time t. */
+static float envelope(const AudioOscTimbre *timbre, float t) {
+    float attack = fminf(1.0f, t * timbre->attack_rate);
+    float release = fminf(1.0f, (1.0f - t) * timbre->release_rate);
+    return attack * release;
+}
+
+#if OSC_SIMD_WIDTH == 4
+/* Interpolated sine of four fixed-point phases. */
+static __m128 lookup4(__m128i phase) {
+    uint32_t idx[4];
+    _mm_storeu_si128((__m128i *)idx, _mm_srli_epi32(phase, OSC_FRAC_BITS));
+    __m128i frac_bits = _mm_and_si128(phase, _mm_set1_epi32((int)OSC_FRAC_MASK));
+    __m128 frac = _mm_mul_ps(_mm_cvtepi32_ps(frac_bits), _mm_set1_ps(OSC_FRAC_SCALE));
+    __m128 a = _mm_set_ps(sine_table[idx[3]], sine_table[idx[2]], sine_table[idx[1]], sine_table[idx[0]]);
+    __m128 b = _mm_set_ps(sine_table[idx[3] + 1], sine_table[idx[2] + 1], sine_table[idx[1] + 1], sine_table[idx[0] + 1]);
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), frac));
+}
+#endif
+
+/* Renders sample_count samples of a segment gliding linearly from f0 to f1.
+   Partials at or above Nyquist are dropped so the output stays band-limited. */
+void audio_osc_render(
+    const AudioOscTimbre *timbre,
+    float f0,
+    float f1,
+    float gain,
+    float vibrato_hz,
+    float vibrato_depth,
+    int sample_rate,
+    float *out,
+    int sample_count
+) {
+    if (sample_count <= 0 || sample_rate <= 0) {
+        return;
+    }
+
+    float nyquist = 0.5f * (float)sample_rate;
+    float top = fmaxf(f0, f1);
+    float partial_gain[AUDIO_OSC_PARTIALS];
+    for (int k = 0; k < AUDIO_OSC_PARTIALS; ++k) {
+        bool audible = (float)timbre->multiple[k] * top < nyquist;
+        partial_gain[k] = audible ? timbre->gain[k] * gain : 0.0f;
+    }
+
+    uint32_t phase = 0;
+    uint32_t vib_phase = 0;
+    uint32_t vib_step = phase_step(vibrato_hz, sample_rate);
+    float inv_count = 1.0f / (float)sample_count;
+    float depth_phase = vibrato_depth * OSC_RAD_TO_PHASE;
+    bool glide = f0 != f1;
+    uint32_t step = phase_step(f0, sample_rate);
+
+    uint32_t partial_phase[AUDIO_OSC_PARTIALS][AUDIO_OSC_BLOCK];
+    uint32_t vib_block[AUDIO_OSC_BLOCK];
+
+    for (int base = 0; base < sample_count; base += AUDIO_OSC_BLOCK) {
+        int n = sample_count - base < AUDIO_OSC_BLOCK ? sample_count - base : AUDIO_OSC_BLOCK;
+
+        /* Sequential phase accumulation is integer-only and cheap. */
+        for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < AUDIO_OSC_PARTIALS; ++k) {
+                partial_phase[k][i] = (uint32_t)timbre->multiple[k] * phase;
+            }
+            vib_block[i] = vib_phase;
+            if (glide) {
+                float t = (float)(base + i) * inv_count;
+                step = phase_step(f0 + (f1 - f0) * t, sample_rate);
+            }
+            phase += step;
+            vib_phase += vib_step;
+        }
+
+        int i = 0;
+#if OSC_SIMD_WIDTH == 4
+        const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 attack_rate = _mm_set1_ps(timbre->attack_rate);
+        const __m128 release_rate = _mm_set1_ps(timbre->release_rate);
+        for (; i + 4 <= n; i += 4) {
+            __m128 vib = _mm_mul_ps(lookup4(_mm_loadu_si128((const __m128i *)&vib_block[i])), _mm_set1_ps(depth_phase));
+            __m128 sum = _mm_setzero_ps();
+            for (int k = 0; k < AUDIO_OSC_PARTIALS; ++k) {
+                __m128i offset = _mm_cvtps_epi32(_mm_mul_ps(vib, _mm_set1_ps(timbre->vibrato_share[k])));
+                __m128i p = _mm_add_epi32(_mm_loadu_si128((const __m128i *)&partial_phase[k][i]), offset);
+                sum = _mm_add_ps(sum, _mm_mul_ps(lookup4(p), _mm_set1_ps(partial_gain[k])));
+            }
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)(base + i)), lane), _mm_set1_ps(inv_count));
+            __m128 attack = _mm_min_ps(one, _mm_mul_ps(t, attack_rate));
+            __m128 release = _mm_min_ps(one, _mm_mul_ps(_mm_sub_ps(one, t), release_rate));
+            _mm_storeu_ps(&out[base + i], _mm_mul_ps(sum, _mm_mul_ps(attack, release)));
+        }
+#endif
+        for (; i < n; ++i) {
+            float vib = lookup(vib_block[i]) * depth_phase;
+            float sum = 0.0f;
+            for (int k = 0; k < AUDIO_OSC_PARTIALS; ++k) {
+                int32_t offset = (int32_t)lrintf(vib * timbre->vibrato_share[k]);
+                sum += lookup(partial_phase[k][i] + (uint32_t)offset) * partial_gain[k];
+            }
+            out[base + i] = sum * envelope(timbre, (float)(base + i) * inv_count);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef AUDIO_OSC_H
+#define AUDIO_OSC_H
+
+#include <stdint.h>
+
+#define AUDIO_OSC_TABLE_BITS 11
+#define AUDIO_OSC_TABLE_SIZE (1 << AUDIO_OSC_TABLE_BITS)
+#define AUDIO_OSC_PARTIALS 3
+#define AUDIO_OSC_BLOCK 64
+
+/* Additive recipe for one voice: partials as harmonic multiples of the
+   fundamental, each with its own gain and share of the vibrato offset,
+   plus linear attack/release slopes over normalized segment time. */
+typedef struct {
+    int multiple[AUDIO_OSC_PARTIALS];
+    float gain[AUDIO_OSC_PARTIALS];
+    float vibrato_share[AUDIO_OSC_PARTIALS];
+    float attack_rate;
+    float release_rate;
+} AudioOscTimbre;
+
+/* Timbre of the sustained note cue segment. */
+extern const AudioOscTimbre AUDIO_OSC_NOTE;
+
+/* Timbre of the pitch glide cue segment. */
+extern const AudioOscTimbre AUDIO_OSC_GLIDE;
+
+/* Builds the shared sine table; call once before rendering from any thread. */
+void audio_osc_init(void);
+
+/* Renders sample_count samples of a segment gliding linearly from f0 to f1.
+   Partials at or above Nyquist are dropped so the output stays band-limited. */
+void audio_osc_render(
+    const AudioOscTimbre *timbre,
+    float f0,
+    float f1,
+    float gain,
+    float vibrato_hz,
+    float vibrato_depth,
+    int sample_rate,
+    float *out,
+    int sample_count
+);
+
+#endif
@@ -0,0 +1,36 @@
+/* Hot-path work counters for the rules engine.
+   Counting sites use ENGINE_COUNT and vanish unless LINES98_ENGINE_COUNTERS
+   is defined; counters are per thread so parallel runners need no atomics. */
+
+#include "engine_counters.h"
+
+#include <string.h>
+
+#ifdef LINES98_ENGINE_COUNTERS
+_Thread_local EngineCounters engine_counters_local;
+#endif
+
+/* Returns true when the engine was built with -Dengine_counters=true. */
+bool engine_counters_enabled(void) {
+#ifdef LINES98_ENGINE_COUNTERS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* Copies the calling thread's counters; all zero when compiled out. */
+void engine_counters_snapshot(EngineCounters *out) {
+#ifdef LINES98_ENGINE_COUNTERS
+    *out = engine_counters_local;
+#else
+    memset(out, 0, sizeof(*out));
+#endif
+}
+
+/* Zeroes the calling thread's counters. */
+void engine_counters_reset(void) {
+#ifdef LINES98_ENGINE_COUNTERS
+    memset(&engine_counters_local, 0, sizeof(engine_counters_local));
+#endif
+}
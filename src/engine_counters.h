@@ -0,0 +1,36 @@
+#ifndef ENGINE_COUNTERS_H
+#define ENGINE_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Algorithmic work done by the rules engine on one thread. Totals only;
+   divide by turns for per-turn figures. */
+typedef struct {
+    uint64_t reach_nodes;
+    uint64_t path_nodes;
+    uint64_t clear_passes;
+    uint64_t clear_cells_scanned;
+    uint64_t turns;
+    uint64_t spawned_balls;
+    uint64_t cleared_balls;
+    uint64_t empty_count_calls;
+} EngineCounters;
+
+#ifdef LINES98_ENGINE_COUNTERS
+extern _Thread_local EngineCounters engine_counters_local;
+#define ENGINE_COUNT(field, n) (engine_counters_local.field += (uint64_t)(n))
+#else
+#define ENGINE_COUNT(field, n) ((void)0)
+#endif
+
+/* Returns true when the engine was built with -Dengine_counters=true. */
+bool engine_counters_enabled(void);
+
+/* Copies the calling thread's counters; all zero when compiled out. */
+void engine_counters_snapshot(EngineCounters *out);
+
+/* Zeroes the calling thread's counters. */
+void engine_counters_reset(void);
+
+#endif
@@ -0,0 +1,93 @@
+/* Rolling per-stage frame timing statistics.
+   SDL-independent so the ring/histogram bookkeeping is unit-testable. */
+
+#include "frame_stats.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Maps microseconds to a quarter-octave bucket; bucket 0 holds < 1 us. */
+static int bucket_for(float us) {
+    if (!(us >= 1.0f)) {
+        return 0;
+    }
+    int b = 1 + (int)(log2f(us) * (float)FRAME_STATS_BUCKETS_PER_OCTAVE);
+    return b < FRAME_STATS_BUCKETS ? b : FRAME_STATS_BUCKETS - 1;
+}
+
+/* Returns upper edge of a bucket in microseconds. */
+static float bucket_upper(int bucket) {
+    return exp2f((float)bucket / (float)FRAME_STATS_BUCKETS_PER_OCTAVE);
+}
+
+/* Clears all history for stage_count stages. */
+void frame_stats_init(FrameStats *stats, int stage_count) {
+    memset(stats, 0, sizeof(*stats));
+    if (stage_count > FRAME_STATS_MAX_STAGES) {
+        stage_count = FRAME_STATS_MAX_STAGES;
+    }
+    stats->stage_count = stage_count < 0 ? 0 : stage_count;
+}
+
+/* Adds microseconds to a stage of the frame being recorded. */
+void frame_stats_add(FrameStats *stats, int stage, float us) {
+    if (stage >= 0 && stage < stats->stage_count) {
+        stats->pending[stage] += us;
+    }
+}
+
+/* Commits the recorded frame into the ring, evicting the oldest one. */
+void frame_stats_end_frame(FrameStats *stats) {
+    int slot = stats->head;
+    bool full = stats->count == FRAME_STATS_HISTORY;
+    for (int stage = 0; stage < stats->stage_count; ++stage) {
+        if (full) {
+            --stats->histogram[stage][bucket_for(stats->samples[stage][slot])];
+        }
+        float us = stats->pending[stage];
+        stats->samples[stage][slot] = us;
+        ++stats->histogram[stage][bucket_for(us)];
+        stats->pending[stage] = 0.0f;
+    }
+
+    stats->head = (slot + 1) % FRAME_STATS_HISTORY;
+    if (!full) {
+        ++stats->count;
+    }
+}
+
+/* Returns number of frames currently in the window. */
+int frame_stats_count(const FrameStats *stats) {
+    return stats->count;
+}
+
+/* Returns the most recently committed time of a stage in microseconds. */
+float frame_stats_last(const FrameStats *stats, int stage) {
+    if (stats->count == 0 || stage < 0 || stage >= stats->stage_count) {
+        return 0.0f;
+    }
+    int slot = (stats->head + FRAME_STATS_HISTORY - 1) % FRAME_STATS_HISTORY;
+    return stats->samples[stage][slot];
+}
+
+/* Returns upper bound of the histogram bucket holding percentile p in
+   [0..1] of a stage over the window; 0 when the window is empty. */
+float frame_stats_percentile(const FrameStats *stats, int stage, float p) {
+    if (stats->count == 0 || stage < 0 || stage >= stats->stage_count) {
+        return 0.0f;
+    }
+
+    int rank = (int)ceilf(p * (float)stats->count);
+    if (rank < 1) {
+        rank = 1;
+    }
+    int seen = 0;
+    for (int b = 0; b < FRAME_STATS_BUCKETS; ++b) {
+        seen += stats->histogram[stage][b];
+        if (seen >= rank) {
+            return bucket_upper(b);
+        }
+    }
+    return bucket_upper(FRAME_STATS_BUCKETS - 1);
+}
@@ -0,0 +1,42 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <stdint.h>
+
+#define FRAME_STATS_MAX_STAGES 16
+#define FRAME_STATS_HISTORY 256
+#define FRAME_STATS_BUCKETS 64
+#define FRAME_STATS_BUCKETS_PER_OCTAVE 4
+
+/* Per-stage frame timings: a ring of the last FRAME_STATS_HISTORY frames
+   and a log-scale histogram of exactly those frames, so percentiles roll
+   with the window without sorting. Stage ids are chosen by the caller. */
+typedef struct {
+    float samples[FRAME_STATS_MAX_STAGES][FRAME_STATS_HISTORY];
+    uint16_t histogram[FRAME_STATS_MAX_STAGES][FRAME_STATS_BUCKETS];
+    float pending[FRAME_STATS_MAX_STAGES];
+    int stage_count;
+    int head;
+    int count;
+} FrameStats;
+
+/* Clears all history for stage_count stages. */
+void frame_stats_init(FrameStats *stats, int stage_count);
+
+/* Adds microseconds to a stage of the frame being recorded. */
+void frame_stats_add(FrameStats *stats, int stage, float us);
+
+/* Commits the recorded frame into the ring, evicting the oldest one. */
+void frame_stats_end_frame(FrameStats *stats);
+
+/* Returns number of frames currently in the window. */
+int frame_stats_count(const FrameStats *stats);
+
+/* Returns the most recently committed time of a stage in microseconds. */
+float frame_stats_last(const FrameStats *stats, int stage);
+
+/* Returns upper bound of the histogram bucket holding percentile p in
+   [0..1] of a stage over the window; 0 when the window is empty. */
+float frame_stats_percentile(const FrameStats *stats, int stage, float p);
+
+#endif
@@ -1,15 +1,69 @@
 /* Particle simulation and rendering for line-clear dust effect.
-   This module is pure fixed-size state and does not allocate memory. */
+   Simulation state is fixed-size; only the draw batch allocates, once at init.
+   The integration step runs in SSE/AVX batches when the compiler targets
+   them and falls back to a scalar loop otherwise. */
 
 #include "fx_particles.h"
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FX_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FX_SIMD_WIDTH 4
+#else
+#define FX_SIMD_WIDTH 1
+#endif
+
+#if FX_SIMD_WIDTH == 8
+typedef __m256 FxVec;
+#define FX_LOAD(p) _mm256_loadu_ps(p)
+#define FX_STORE(p, v) _mm256_storeu_ps((p), (v))
+#define FX_SET1(v) _mm256_set1_ps(v)
+#define FX_ADD(a, b) _mm256_add_ps((a), (b))
+#define FX_SUB(a, b) _mm256_sub_ps((a), (b))
+#define FX_MUL(a, b) _mm256_mul_ps((a), (b))
+#define FX_LT(a, b) _mm256_cmp_ps((a), (b), _CMP_LT_OQ)
+#define FX_GT(a, b) _mm256_cmp_ps((a), (b), _CMP_GT_OQ)
+#define FX_OR(a, b) _mm256_or_ps((a), (b))
+#define FX_ANDNOT(m, a) _mm256_andnot_ps((m), (a))
+#define FX_SELECT(m, a, b) _mm256_blendv_ps((b), (a), (m))
+#elif FX_SIMD_WIDTH == 4
+typedef __m128 FxVec;
+#define FX_LOAD(p) _mm_loadu_ps(p)
+#define FX_STORE(p, v) _mm_storeu_ps((p), (v))
+#define FX_SET1(v) _mm_set1_ps(v)
+#define FX_ADD(a, b) _mm_add_ps((a), (b))
+#define FX_SUB(a, b) _mm_sub_ps((a), (b))
+#define FX_MUL(a, b) _mm_mul_ps((a), (b))
+#define FX_LT(a, b) _mm_cmplt_ps((a), (b))
+#define FX_GT(a, b) _mm_cmpgt_ps((a), (b))
+#define FX_OR(a, b) _mm_or_ps((a), (b))
+#define FX_ANDNOT(m, a) _mm_andnot_ps((m), (a))
+#define FX_SELECT(m, a, b) _mm_or_ps(_mm_and_ps((m), (a)), _mm_andnot_ps((m), (b)))
+#endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+#define FX_GRAVITY 560.0f
+#define FX_BOUNCE 0.58f
+#define FX_FLOOR_FRICTION 0.88f
+#define FX_BALL_FRICTION 0.94f
+
+/* Board rectangle in world space used by the edge bounce/clamp step. */
+typedef struct {
+    float min_x;
+    float max_x;
+    float min_y;
+    float max_y;
+} FxBounds;
+
 /* Clamps color alpha/brightness mixing towards white. */
 static SDL_Color mix_white(SDL_Color c, float t) {
     if (t < 0.0f) {
@@ -44,46 +98,92 @@ static int ball_center_y(int row, int cell_size, int board_offset_y) {
     return board_offset_y + row * cell_size + cell_size / 2;
 }
 
-/* Resets all particles to inactive state. */
-void particles_init(ParticleSystem *ps) {
-    for (int i = 0; i < MAX_PARTICLES; ++i) {
-        ps->items[i].active = false;
-    }
-}
+/* Integrates particles [begin, end) one at a time: life decay, gravity,
+   position and board-edge bounce. Used as fallback and for SIMD tails. */
+static void integrate_scalar(ParticleSystem *ps, int begin, int end, float dt, FxBounds b) {
+    for (int i = begin; i < end; ++i) {
+        float r = ps->radius[i];
+        float vx = ps->vx[i];
+        float vy = ps->vy[i] + FX_GRAVITY * dt;
+        float x = ps->x[i] + vx * dt;
+        float y = ps->y[i] + vy * dt;
 
-/* Spawns one particle with randomized velocity and lifetime. */
-void particles_spawn_one(ParticleSystem *ps, float x, float y, SDL_Color color) {
-    for (int i = 0; i < MAX_PARTICLES; ++i) {
-        if (!ps->items[i].active) {
-            float a = (float)rand() / (float)RAND_MAX * 2.0f * (float)M_PI;
-            float s = 70.0f + ((float)rand() / (float)RAND_MAX) * 240.0f;
-            float jx = (((float)rand() / (float)RAND_MAX) - 0.5f) * 10.0f;
-            float jy = (((float)rand() / (float)RAND_MAX) - 0.5f) * 10.0f;
-
-            ps->items[i].active = true;
-            ps->items[i].x = x + jx;
-            ps->items[i].y = y + jy;
-            ps->items[i].vx = cosf(a) * s;
-            ps->items[i].vy = sinf(a) * s - 30.0f;
-            ps->items[i].radius = 1.8f + ((float)rand() / (float)RAND_MAX) * 2.2f;
-            ps->items[i].life = 0.7f + ((float)rand() / (float)RAND_MAX) * 0.9f;
-            ps->items[i].color = mix_white(color, 0.25f);
-            return;
+        if (x < b.min_x + r) {
+            x = b.min_x + r;
+            vx = vx * -FX_BOUNCE;
+        } else if (x > b.max_x - r) {
+            x = b.max_x - r;
+            vx = vx * -FX_BOUNCE;
+        }
+
+        if (y < b.min_y + r) {
+            y = b.min_y + r;
+            vy = vy * -FX_BOUNCE;
+        } else if (y > b.max_y - r) {
+            y = b.max_y - r;
+            vy = vy * -FX_BOUNCE;
+            vx *= FX_FLOOR_FRICTION;
         }
+
+        ps->life[i] -= dt;
+        ps->x[i] = x;
+        ps->y[i] = y;
+        ps->vx[i] = vx;
+        ps->vy[i] = vy;
     }
 }
 
-/* Spawns a burst of particles at one world-space point. */
-void particles_spawn_burst(ParticleSystem *ps, float x, float y, SDL_Color color, int count) {
-    for (int i = 0; i < count; ++i) {
-        particles_spawn_one(ps, x, y, color);
+#if FX_SIMD_WIDTH > 1
+/* Same step as integrate_scalar on FX_SIMD_WIDTH particles per instruction;
+   branches become compare masks. Returns first index left for the tail. */
+static int integrate_simd(ParticleSystem *ps, int count, float dt, FxBounds b) {
+    const FxVec vdt = FX_SET1(dt);
+    const FxVec vgdt = FX_SET1(FX_GRAVITY * dt);
+    const FxVec vbounce = FX_SET1(-FX_BOUNCE);
+    const FxVec vfriction = FX_SET1(FX_FLOOR_FRICTION);
+    const FxVec vmin_x = FX_SET1(b.min_x);
+    const FxVec vmax_x = FX_SET1(b.max_x);
+    const FxVec vmin_y = FX_SET1(b.min_y);
+    const FxVec vmax_y = FX_SET1(b.max_y);
+
+    int i = 0;
+    for (; i + FX_SIMD_WIDTH <= count; i += FX_SIMD_WIDTH) {
+        FxVec r = FX_LOAD(&ps->radius[i]);
+        FxVec vx = FX_LOAD(&ps->vx[i]);
+        FxVec vy = FX_ADD(FX_LOAD(&ps->vy[i]), vgdt);
+        FxVec x = FX_ADD(FX_LOAD(&ps->x[i]), FX_MUL(vx, vdt));
+        FxVec y = FX_ADD(FX_LOAD(&ps->y[i]), FX_MUL(vy, vdt));
+
+        FxVec lo = FX_ADD(vmin_x, r);
+        FxVec hi = FX_SUB(vmax_x, r);
+        FxVec hit_lo = FX_LT(x, lo);
+        FxVec hit_hi = FX_ANDNOT(hit_lo, FX_GT(x, hi));
+        x = FX_SELECT(hit_lo, lo, FX_SELECT(hit_hi, hi, x));
+        vx = FX_SELECT(FX_OR(hit_lo, hit_hi), FX_MUL(vx, vbounce), vx);
+
+        lo = FX_ADD(vmin_y, r);
+        hi = FX_SUB(vmax_y, r);
+        hit_lo = FX_LT(y, lo);
+        hit_hi = FX_ANDNOT(hit_lo, FX_GT(y, hi));
+        y = FX_SELECT(hit_lo, lo, FX_SELECT(hit_hi, hi, y));
+        vy = FX_SELECT(FX_OR(hit_lo, hit_hi), FX_MUL(vy, vbounce), vy);
+        vx = FX_SELECT(hit_hi, FX_MUL(vx, vfriction), vx);
+
+        FX_STORE(&ps->life[i], FX_SUB(FX_LOAD(&ps->life[i]), vdt));
+        FX_STORE(&ps->x[i], x);
+        FX_STORE(&ps->y[i], y);
+        FX_STORE(&ps->vx[i], vx);
+        FX_STORE(&ps->vy[i], vy);
     }
+    return i;
 }
+#endif
 
-/* Advances particle simulation and collisions against board balls. */
-void particles_update(
+/* Pushes live particles out of nearby board balls. Only cells within
+   collision reach of the particle are tested, so the pass touches a 3x3
+   neighbourhood instead of the whole board. */
+static void collide_with_balls(
     ParticleSystem *ps,
-    float dt,
     const uint8_t *board,
     int board_size,
     int cell_size,
@@ -91,50 +191,22 @@ void particles_update(
     int board_offset_y,
     float ball_radius
 ) {
-    const float gravity = 560.0f;
-    const float bounce = 0.58f;
-    const int board_w = board_size * cell_size;
-    const int board_h = board_size * cell_size;
-    const float min_x = (float)board_offset_x;
-    const float max_x = (float)(board_offset_x + board_w);
-    const float min_y = (float)board_offset_y;
-    const float max_y = (float)(board_offset_y + board_h);
-
-    for (int i = 0; i < MAX_PARTICLES; ++i) {
-        Particle *p = &ps->items[i];
-        if (!p->active) {
-            continue;
-        }
-
-        p->life -= dt;
-        if (p->life <= 0.0f) {
-            p->active = false;
+    for (int i = 0; i < ps->count; ++i) {
+        if (ps->life[i] <= 0.0f) {
             continue;
         }
 
-        p->vy += gravity * dt;
-        p->x += p->vx * dt;
-        p->y += p->vy * dt;
-
-        if (p->x < min_x + p->radius) {
-            p->x = min_x + p->radius;
-            p->vx = -p->vx * bounce;
-        } else if (p->x > max_x - p->radius) {
-            p->x = max_x - p->radius;
-            p->vx = -p->vx * bounce;
-        }
-
-        if (p->y < min_y + p->radius) {
-            p->y = min_y + p->radius;
-            p->vy = -p->vy * bounce;
-        } else if (p->y > max_y - p->radius) {
-            p->y = max_y - p->radius;
-            p->vy = -p->vy * bounce;
-            p->vx *= 0.88f;
-        }
+        float min_dist = ps->radius[i] + ball_radius;
+        int reach = (int)(min_dist / (float)cell_size) + 1;
+        int pcol = (int)floorf((ps->x[i] - (float)board_offset_x) / (float)cell_size);
+        int prow = (int)floorf((ps->y[i] - (float)board_offset_y) / (float)cell_size);
+        int row0 = SDL_max(0, prow - reach);
+        int row1 = SDL_min(board_size - 1, prow + reach);
+        int col0 = SDL_max(0, pcol - reach);
+        int col1 = SDL_min(board_size - 1, pcol + reach);
 
-        for (int row = 0; row < board_size; ++row) {
-            for (int col = 0; col < board_size; ++col) {
+        for (int row = row0; row <= row1; ++row) {
+            for (int col = col0; col <= col1; ++col) {
                 uint8_t cell = board[row * board_size + col];
                 if (cell == 0) {
                     continue;
@@ -142,9 +214,8 @@ void particles_update(
 
                 float ox = (float)ball_center_x(col, cell_size, board_offset_x);
                 float oy = (float)ball_center_y(row, cell_size, board_offset_y);
-                float dx = p->x - ox;
-                float dy = p->y - oy;
-                float min_dist = p->radius + ball_radius;
+                float dx = ps->x[i] - ox;
+                float dy = ps->y[i] - oy;
                 float d2 = dx * dx + dy * dy;
                 if (d2 >= min_dist * min_dist) {
                     continue;
@@ -153,32 +224,276 @@ void particles_update(
                 float d = sqrtf(SDL_max(d2, 0.0001f));
                 float nx = dx / d;
                 float ny = dy / d;
-                p->x = ox + nx * min_dist;
-                p->y = oy + ny * min_dist;
+                ps->x[i] = ox + nx * min_dist;
+                ps->y[i] = oy + ny * min_dist;
 
-                float vn = p->vx * nx + p->vy * ny;
+                float vn = ps->vx[i] * nx + ps->vy[i] * ny;
                 if (vn < 0.0f) {
-                    p->vx -= (1.0f + bounce) * vn * nx;
-                    p->vy -= (1.0f + bounce) * vn * ny;
-                    p->vx *= 0.94f;
-                    p->vy *= 0.94f;
+                    ps->vx[i] -= (1.0f + FX_BOUNCE) * vn * nx;
+                    ps->vy[i] -= (1.0f + FX_BOUNCE) * vn * ny;
+                    ps->vx[i] *= FX_BALL_FRICTION;
+                    ps->vy[i] *= FX_BALL_FRICTION;
                 }
             }
         }
     }
 }
 
-/* Renders all active particles with alpha fade. */
-void particles_draw(SDL_Renderer *renderer, const ParticleSystem *ps) {
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    for (int i = 0; i < MAX_PARTICLES; ++i) {
-        const Particle *p = &ps->items[i];
-        if (!p->active) {
+/* Removes expired particles by moving the last live one into their slot. */
+static void compact_dead(ParticleSystem *ps) {
+    int i = 0;
+    while (i < ps->count) {
+        if (ps->life[i] > 0.0f) {
+            ++i;
             continue;
         }
-        SDL_Color c = p->color;
-        c.a = (uint8_t)SDL_min(255, (int)(255.0f * SDL_min(1.0f, p->life)));
-        draw_filled_circle(renderer, (int)p->x, (int)p->y, (int)p->radius, c);
+
+        int last = --ps->count;
+        ps->x[i] = ps->x[last];
+        ps->y[i] = ps->y[last];
+        ps->prev_x[i] = ps->prev_x[last];
+        ps->prev_y[i] = ps->prev_y[last];
+        ps->vx[i] = ps->vx[last];
+        ps->vy[i] = ps->vy[last];
+        ps->radius[i] = ps->radius[last];
+        ps->life[i] = ps->life[last];
+        ps->color[i] = ps->color[last];
+    }
+}
+
+/* Returns the board rectangle particles bounce inside. */
+static FxBounds board_bounds(int board_size, int cell_size, int board_offset_x, int board_offset_y) {
+    FxBounds bounds;
+    bounds.min_x = (float)board_offset_x;
+    bounds.max_x = (float)(board_offset_x + board_size * cell_size);
+    bounds.min_y = (float)board_offset_y;
+    bounds.max_y = (float)(board_offset_y + board_size * cell_size);
+    return bounds;
+}
+
+/* Resets all particles to inactive state. */
+void particles_init(ParticleSystem *ps) {
+    ps->count = 0;
+}
+
+/* Spawns one particle with randomized velocity and lifetime. */
+void particles_spawn_one(ParticleSystem *ps, float x, float y, SDL_Color color) {
+    if (ps->count >= MAX_PARTICLES) {
+        return;
+    }
+
+    float a = (float)rand() / (float)RAND_MAX * 2.0f * (float)M_PI;
+    float s = 70.0f + ((float)rand() / (float)RAND_MAX) * 240.0f;
+    float jx = (((float)rand() / (float)RAND_MAX) - 0.5f) * 10.0f;
+    float jy = (((float)rand() / (float)RAND_MAX) - 0.5f) * 10.0f;
+
+    int i = ps->count++;
+    ps->x[i] = x + jx;
+    ps->y[i] = y + jy;
+    ps->prev_x[i] = ps->x[i];
+    ps->prev_y[i] = ps->y[i];
+    ps->vx[i] = cosf(a) * s;
+    ps->vy[i] = sinf(a) * s - 30.0f;
+    ps->radius[i] = 1.8f + ((float)rand() / (float)RAND_MAX) * 2.2f;
+    ps->life[i] = 0.7f + ((float)rand() / (float)RAND_MAX) * 0.9f;
+    ps->color[i] = mix_white(color, 0.25f);
+}
+
+/* Spawns a burst of particles at one world-space point. */
+void particles_spawn_burst(ParticleSystem *ps, float x, float y, SDL_Color color, int count) {
+    for (int i = 0; i < count; ++i) {
+        particles_spawn_one(ps, x, y, color);
+    }
+}
+
+/* Returns number of live particles. */
+int particles_active_count(const ParticleSystem *ps) {
+    return ps->count;
+}
+
+/* Advances particle simulation and collisions against board balls. */
+void particles_update(
+    ParticleSystem *ps,
+    float dt,
+    const uint8_t *board,
+    int board_size,
+    int cell_size,
+    int board_offset_x,
+    int board_offset_y,
+    float ball_radius
+) {
+    FxBounds bounds = board_bounds(board_size, cell_size, board_offset_x, board_offset_y);
+
+    memcpy(ps->prev_x, ps->x, (size_t)ps->count * sizeof(float));
+    memcpy(ps->prev_y, ps->y, (size_t)ps->count * sizeof(float));
+
+    int tail = 0;
+#if FX_SIMD_WIDTH > 1
+    tail = integrate_simd(ps, ps->count, dt, bounds);
+#endif
+    integrate_scalar(ps, tail, ps->count, dt, bounds);
+
+    collide_with_balls(ps, board, board_size, cell_size, board_offset_x, board_offset_y, ball_radius);
+    compact_dead(ps);
+}
+
+/* Runs only the integration step of particles_update (gravity, motion,
+   edge bounce, life decay) over all particles, through the SIMD kernel
+   when simd is true and the scalar loop otherwise, so tests can check the
+   two agree. Builds without SIMD use the scalar loop either way. */
+void particles_integrate(
+    ParticleSystem *ps,
+    float dt,
+    int board_size,
+    int cell_size,
+    int board_offset_x,
+    int board_offset_y,
+    bool simd
+) {
+    FxBounds bounds = board_bounds(board_size, cell_size, board_offset_x, board_offset_y);
+    int tail = 0;
+#if FX_SIMD_WIDTH > 1
+    if (simd) {
+        tail = integrate_simd(ps, ps->count, dt, bounds);
+    }
+#else
+    (void)simd;
+#endif
+    integrate_scalar(ps, tail, ps->count, dt, bounds);
+}
+
+/* Interpolates particle position between the last two simulation steps. */
+static void render_pos(const ParticleSystem *ps, int i, float blend, float *x, float *y) {
+    *x = ps->prev_x[i] + (ps->x[i] - ps->prev_x[i]) * blend;
+    *y = ps->prev_y[i] + (ps->y[i] - ps->prev_y[i]) * blend;
+}
+
+/* Fallback renderer: one scanline circle per particle. */
+static void draw_particles_scanline(SDL_Renderer *renderer, const ParticleSystem *ps, float blend) {
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    for (int i = 0; i < ps->count; ++i) {
+        SDL_Color c = ps->color[i];
+        c.a = (uint8_t)SDL_min(255, (int)(255.0f * SDL_min(1.0f, ps->life[i])));
+        float x;
+        float y;
+        render_pos(ps, i, blend, &x, &y);
+        draw_filled_circle(renderer, (int)x, (int)y, (int)ps->radius[i], c);
     }
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
 }
+
+/* Rasterizes the soft particle sprite and allocates batch buffers.
+   Returns false if unavailable; particles_draw then uses scanline circles. */
+bool particles_batch_init(ParticleBatch *batch, SDL_Renderer *renderer) {
+    SDL_zerop(batch);
+
+    /* White disc with a one-pixel feathered rim; vertex color tints it. */
+    uint8_t pixels[PARTICLE_SPRITE_SIZE * PARTICLE_SPRITE_SIZE * 4];
+    const float half = (float)PARTICLE_SPRITE_SIZE * 0.5f;
+    for (int y = 0; y < PARTICLE_SPRITE_SIZE; ++y) {
+        for (int x = 0; x < PARTICLE_SPRITE_SIZE; ++x) {
+            float dx = (float)x + 0.5f - half;
+            float dy = (float)y + 0.5f - half;
+            float edge = half - sqrtf(dx * dx + dy * dy);
+            float a = SDL_max(0.0f, SDL_min(1.0f, edge));
+            uint8_t *px = &pixels[(y * PARTICLE_SPRITE_SIZE + x) * 4];
+            px[0] = 255;
+            px[1] = 255;
+            px[2] = 255;
+            px[3] = (uint8_t)(a * 255.0f);
+        }
+    }
+
+    batch->sprite = SDL_CreateTexture(
+        renderer,
+        SDL_PIXELFORMAT_RGBA32,
+        SDL_TEXTUREACCESS_STATIC,
+        PARTICLE_SPRITE_SIZE,
+        PARTICLE_SPRITE_SIZE
+    );
+    batch->vertices = (SDL_Vertex *)SDL_malloc((size_t)MAX_PARTICLES * 4 * sizeof(SDL_Vertex));
+    batch->indices = (int *)SDL_malloc((size_t)MAX_PARTICLES * 6 * sizeof(int));
+    if (batch->sprite == NULL || batch->vertices == NULL || batch->indices == NULL
+        || SDL_UpdateTexture(batch->sprite, NULL, pixels, PARTICLE_SPRITE_SIZE * 4) != 0) {
+        particles_batch_shutdown(batch);
+        return false;
+    }
+    SDL_SetTextureBlendMode(batch->sprite, SDL_BLENDMODE_BLEND);
+
+    /* Quad topology never changes, so indices are filled once. */
+    for (int i = 0; i < MAX_PARTICLES; ++i) {
+        int *q = &batch->indices[i * 6];
+        int v = i * 4;
+        q[0] = v;
+        q[1] = v + 1;
+        q[2] = v + 2;
+        q[3] = v + 2;
+        q[4] = v + 1;
+        q[5] = v + 3;
+    }
+    return true;
+}
+
+/* Releases sprite texture and batch buffers. */
+void particles_batch_shutdown(ParticleBatch *batch) {
+    if (batch->sprite != NULL) {
+        SDL_DestroyTexture(batch->sprite);
+    }
+    SDL_free(batch->vertices);
+    SDL_free(batch->indices);
+    SDL_zerop(batch);
+}
+
+/* Renders all active particles with alpha fade at position
+   prev + (current - prev) * blend, where blend in [0..1] is the fraction
+   of a simulation step elapsed since the last update. */
+void particles_draw(SDL_Renderer *renderer, ParticleBatch *batch, const ParticleSystem *ps, float blend) {
+    if (ps->count == 0) {
+        return;
+    }
+    if (batch == NULL || batch->sprite == NULL) {
+        draw_particles_scanline(renderer, ps, blend);
+        return;
+    }
+
+    for (int i = 0; i < ps->count; ++i) {
+        SDL_Color c = ps->color[i];
+        c.a = (uint8_t)SDL_min(255, (int)(255.0f * SDL_min(1.0f, ps->life[i])));
+        float x;
+        float y;
+        render_pos(ps, i, blend, &x, &y);
+
+        /* Same footprint as the scanline circle: 2 * radius + 1 pixels. */
+        float h = (float)(int)ps->radius[i] + 0.5f;
+        float x0 = (float)(int)x + 0.5f - h;
+        float y0 = (float)(int)y + 0.5f - h;
+        float x1 = x0 + 2.0f * h;
+        float y1 = y0 + 2.0f * h;
+
+        SDL_Vertex *v = &batch->vertices[i * 4];
+        v[0].position.x = x0;
+        v[0].position.y = y0;
+        v[0].tex_coord.x = 0.0f;
+        v[0].tex_coord.y = 0.0f;
+        v[1].position.x = x1;
+        v[1].position.y = y0;
+        v[1].tex_coord.x = 1.0f;
+        v[1].tex_coord.y = 0.0f;
+        v[2].position.x = x0;
+        v[2].position.y = y1;
+        v[2].tex_coord.x = 0.0f;
+        v[2].tex_coord.y = 1.0f;
+        v[3].position.x = x1;
+        v[3].position.y = y1;
+        v[3].tex_coord.x = 1.0f;
+        v[3].tex_coord.y = 1.0f;
+        v[0].color = c;
+        v[1].color = c;
+        v[2].color = c;
+        v[3].color = c;
+    }
+
+    if (SDL_RenderGeometry(renderer, batch->sprite, batch->vertices, ps->count * 4, batch->indices, ps->count * 6) != 0) {
+        draw_particles_scanline(renderer, ps, blend);
+    }
+}
@@ -7,25 +7,33 @@
 
 #include "game.h"
 
-#define MAX_PARTICLES 4096
+#define MAX_PARTICLES 16384
+#define PARTICLE_SPRITE_SIZE 32
 
-/* One transient dust particle used by clear-line visual effect. */
+/* Transient dust particles used by clear-line visual effect.
+   Stored as structure-of-arrays with live particles packed into [0, count)
+   so the update kernel can stream over them in SIMD-width batches.
+   prev_x/prev_y hold positions before the last step for render interpolation. */
 typedef struct {
-    float x;
-    float y;
-    float vx;
-    float vy;
-    float radius;
-    float life;
-    SDL_Color color;
-    bool active;
-} Particle;
-
-/* Fixed-size particle container to avoid heap allocations. */
-typedef struct {
-    Particle items[MAX_PARTICLES];
+    float x[MAX_PARTICLES];
+    float y[MAX_PARTICLES];
+    float prev_x[MAX_PARTICLES];
+    float prev_y[MAX_PARTICLES];
+    float vx[MAX_PARTICLES];
+    float vy[MAX_PARTICLES];
+    float radius[MAX_PARTICLES];
+    float life[MAX_PARTICLES];
+    SDL_Color color[MAX_PARTICLES];
+    int count;
 } ParticleSystem;
 
+/* Renderer-side resources for drawing all particles in one geometry batch. */
+typedef struct {
+    SDL_Texture *sprite;
+    SDL_Vertex *vertices;
+    int *indices;
+} ParticleBatch;
+
 /* Resets all particles to inactive state. */
 void particles_init(ParticleSystem *ps);
 
@@ -35,6 +43,9 @@ void particles_spawn_one(ParticleSystem *ps, float x, float y, SDL_Color color);
 /* Spawns a burst of particles at one world-space point. */
 void particles_spawn_burst(ParticleSystem *ps, float x, float y, SDL_Color color, int count);
 
+/* Returns number of live particles. */
+int particles_active_count(const ParticleSystem *ps);
+
 /* Advances particle simulation and collisions against board balls. */
 void particles_update(
     ParticleSystem *ps,
@@ -47,7 +58,30 @@ void particles_update(
     float ball_radius
 );
 
-/* Renders all active particles with alpha fade. */
-void particles_draw(SDL_Renderer *renderer, const ParticleSystem *ps);
+/* Runs only the integration step of particles_update (gravity, motion,
+   edge bounce, life decay) over all particles, through the SIMD kernel
+   when simd is true and the scalar loop otherwise, so tests can check the
+   two agree. Builds without SIMD use the scalar loop either way. */
+void particles_integrate(
+    ParticleSystem *ps,
+    float dt,
+    int board_size,
+    int cell_size,
+    int board_offset_x,
+    int board_offset_y,
+    bool simd
+);
+
+/* Rasterizes the soft particle sprite and allocates batch buffers.
+   Returns false if unavailable; particles_draw then uses scanline circles. */
+bool particles_batch_init(ParticleBatch *batch, SDL_Renderer *renderer);
+
+/* Releases sprite texture and batch buffers. */
+void particles_batch_shutdown(ParticleBatch *batch);
+
+/* Renders all active particles with alpha fade at position
+   prev + (current - prev) * blend, where blend in [0..1] is the fraction
+   of a simulation step elapsed since the last update. */
+void particles_draw(SDL_Renderer *renderer, ParticleBatch *batch, const ParticleSystem *ps, float blend);
 
 #endif
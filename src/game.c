@@ -3,6 +3,8 @@
 
 #include "game.h"
 
+#include "engine_counters.h"
+
 #include <string.h>
 
 /* Checks whether board coordinates are inside 9x9 bounds. */
@@ -35,6 +37,7 @@ static void generate_next(Game *game) {
 
 /* Counts current number of empty board cells. */
 int game_empty_count(const Game *game) {
+    ENGINE_COUNT(empty_count_calls, 1);
     int count = 0;
     for (int i = 0; i < GAME_CELLS; ++i) {
         if (game->board[i] == 0) {
@@ -64,6 +67,7 @@ static int spawn_random_balls(Game *game, const uint8_t *colors, int count) {
         --empty_count;
         ++placed;
     }
+    ENGINE_COUNT(spawned_balls, placed);
     return placed;
 }
 
@@ -78,6 +82,8 @@ static int clear_lines(Game *game) {
 
     bool to_clear[GAME_CELLS];
     memset(to_clear, 0, sizeof(to_clear));
+    ENGINE_COUNT(clear_passes, 1);
+    ENGINE_COUNT(clear_cells_scanned, GAME_CELLS);
 
     for (int row = 0; row < GAME_BOARD_SIZE; ++row) {
         for (int col = 0; col < GAME_BOARD_SIZE; ++col) {
@@ -100,6 +106,7 @@ static int clear_lines(Game *game) {
                 int r = row;
                 int c = col;
                 while (in_bounds(r, c) && game->board[to_index(r, c)] == color) {
+                    ENGINE_COUNT(clear_cells_scanned, 1);
                     ++length;
                     r += dr;
                     c += dc;
@@ -125,6 +132,7 @@ static int clear_lines(Game *game) {
             ++cleared;
         }
     }
+    ENGINE_COUNT(cleared_balls, cleared);
 
     if (cleared >= 5) {
         /* Canonical Lines-98 progression:
@@ -138,6 +146,7 @@ static int clear_lines(Game *game) {
 
 /* Applies post-move turn logic: clear, optional spawn, next preview, game-over. */
 static bool finish_turn(Game *game) {
+    ENGINE_COUNT(turns, 1);
     int cleared = clear_lines(game);
     if (cleared == 0) {
         (void)spawn_random_balls(game, game->next_colors, GAME_NEXT_COUNT);
@@ -209,6 +218,7 @@ bool game_can_reach(const Game *game, int from_row, int from_col, int to_row, in
 
     while (head < tail) {
         int cur = queue[head++];
+        ENGINE_COUNT(reach_nodes, 1);
         int row;
         int col;
         to_row_col(cur, &row, &col);
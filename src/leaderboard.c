@@ -0,0 +1,480 @@
+/* Memory-mapped leaderboard.
+   The file is a 4 KiB header followed by fixed 32-byte records:
+   commit | seq | session | score | finished_ms | 0, little-endian. A
+   record is written by clearing its commit word, filling the body, then
+   storing the commit word (CRC-32 of the body) last; seq must equal the
+   slot number + 1, so stale or torn slots never validate. Each record's
+   page is synced before the next record is written. Recovery keeps
+   the committed prefix, and the first bad slot is where the next result
+   goes. Records are 32-byte aligned, so none straddles a page or sector. */
+
+#include "leaderboard.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "movelog.h"
+
+#define LEADERBOARD_MAGIC "L98BOARD"
+#define LEADERBOARD_VERSION 1
+#define LEADERBOARD_FENWICK_INITIAL 4096
+
+/* Stores v little-endian. */
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* Loads a little-endian u32. */
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* Returns record slot index in the mapping. */
+static uint8_t *record_at(Leaderboard *board, uint32_t index) {
+    return board->map + LEADERBOARD_HEADER_SIZE + (size_t)index * LEADERBOARD_RECORD_SIZE;
+}
+
+/* Parses slot index; returns false unless it holds a committed record. */
+static bool read_record(Leaderboard *board, uint32_t index, LeaderboardEntry *entry) {
+    const uint8_t *rec = record_at(board, index);
+    if (get_u32(rec) != movelog_crc32(rec + 4, LEADERBOARD_RECORD_SIZE - 4) || get_u32(rec + 4) != index + 1) {
+        return false;
+    }
+    entry->seq = index + 1;
+    entry->session = get_u32(rec + 8);
+    entry->score = (int32_t)get_u32(rec + 12);
+    entry->finished_ms = (uint64_t)get_u32(rec + 16) | (uint64_t)get_u32(rec + 20) << 32;
+    return true;
+}
+
+/* Writes entry into its slot and seals it with the commit word. */
+static void write_record(Leaderboard *board, const LeaderboardEntry *entry) {
+    uint8_t *rec = record_at(board, entry->seq - 1);
+    volatile uint32_t *commit = (volatile uint32_t *)(void *)rec;
+    *commit = 0;
+    atomic_thread_fence(memory_order_release);
+
+    put_u32(rec + 4, entry->seq);
+    put_u32(rec + 8, entry->session);
+    put_u32(rec + 12, (uint32_t)entry->score);
+    put_u32(rec + 16, (uint32_t)entry->finished_ms);
+    put_u32(rec + 20, (uint32_t)(entry->finished_ms >> 32));
+    memset(rec + 24, 0, LEADERBOARD_RECORD_SIZE - 24);
+    atomic_thread_fence(memory_order_release);
+
+    /* One aligned 4-byte store publishes the record. */
+    uint8_t word[4];
+    put_u32(word, movelog_crc32(rec + 4, LEADERBOARD_RECORD_SIZE - 4));
+    uint32_t raw;
+    memcpy(&raw, word, sizeof(raw));
+    *commit = raw;
+}
+
+/* Forces the page holding slot index to stable storage. Records never
+   straddle a page, so this covers the whole record. */
+static bool sync_record(Leaderboard *board, uint32_t index) {
+    size_t offset = (size_t)(record_at(board, index) - board->map);
+    size_t page = offset - offset % board->page_bytes;
+    return msync(board->map + page, board->page_bytes, MS_SYNC) == 0;
+}
+
+/* Maps bytes of the file; NULL on failure. */
+static uint8_t *map_file(int fd, size_t bytes) {
+    void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return map == MAP_FAILED ? NULL : (uint8_t *)map;
+}
+
+/* Doubles the record capacity; the old mapping stays valid on failure. */
+static bool grow_file(Leaderboard *board) {
+    uint32_t capacity = board->capacity * 2u;
+    size_t bytes = LEADERBOARD_HEADER_SIZE + (size_t)capacity * LEADERBOARD_RECORD_SIZE;
+    if (capacity <= board->capacity || ftruncate(board->fd, (off_t)bytes) != 0) {
+        return false;
+    }
+    uint8_t *map = map_file(board->fd, bytes);
+    if (map == NULL) {
+        return false;
+    }
+    munmap(board->map, board->map_bytes);
+    board->map = map;
+    board->map_bytes = bytes;
+    board->capacity = capacity;
+    return true;
+}
+
+/* Returns the Fenwick position of a score (clamped to the indexed range). */
+static uint32_t score_pos(int32_t score) {
+    if (score < 0) {
+        score = 0;
+    }
+    if (score > LEADERBOARD_MAX_SCORE) {
+        score = LEADERBOARD_MAX_SCORE;
+    }
+    return (uint32_t)score + 1u;
+}
+
+/* Widens the Fenwick tree to cover pos. Doubling a power-of-two tree only
+   adds one non-empty node: the new root, which covers everything. */
+static bool fenwick_reserve(Leaderboard *board, uint32_t pos) {
+    while (pos > board->fenwick_size) {
+        uint32_t size = board->fenwick_size * 2u;
+        uint32_t *tree = (uint32_t *)realloc(board->fenwick, ((size_t)size + 1) * sizeof(uint32_t));
+        if (tree == NULL) {
+            return false;
+        }
+        memset(tree + board->fenwick_size + 1, 0, (size_t)board->fenwick_size * sizeof(uint32_t));
+        tree[size] = board->count;
+        board->fenwick = tree;
+        board->fenwick_size = size;
+    }
+    return true;
+}
+
+/* Counts one result at pos. */
+static void fenwick_add(Leaderboard *board, uint32_t pos) {
+    for (; pos <= board->fenwick_size; pos += pos & (0u - pos)) {
+        ++board->fenwick[pos];
+    }
+}
+
+/* Returns how many results sit at positions 1..pos. */
+static uint32_t fenwick_prefix(const Leaderboard *board, uint32_t pos) {
+    uint32_t sum = 0;
+    for (; pos > 0; pos -= pos & (0u - pos)) {
+        sum += board->fenwick[pos];
+    }
+    return sum;
+}
+
+/* True if a ranks above b: higher score, then earlier submission. */
+static bool better(const LeaderboardEntry *a, const LeaderboardEntry *b) {
+    return a->score > b->score || (a->score == b->score && a->seq < b->seq);
+}
+
+/* Recomputes a node's subtree size. */
+static void update_size(LeaderboardNode *nodes, uint32_t t) {
+    nodes[t].size = 1 + nodes[nodes[t].left].size + nodes[nodes[t].right].size;
+}
+
+/* Splits t into entries better than key (*l) and the rest (*r). */
+static void treap_split(LeaderboardNode *nodes, uint32_t t, const LeaderboardEntry *key, uint32_t *l, uint32_t *r) {
+    if (t == 0) {
+        *l = 0;
+        *r = 0;
+    } else if (better(&nodes[t].entry, key)) {
+        treap_split(nodes, nodes[t].right, key, &nodes[t].right, r);
+        *l = t;
+        update_size(nodes, t);
+    } else {
+        treap_split(nodes, nodes[t].left, key, l, &nodes[t].left);
+        *r = t;
+        update_size(nodes, t);
+    }
+}
+
+/* Joins l and r where every entry of l ranks above r. */
+static uint32_t treap_merge(LeaderboardNode *nodes, uint32_t l, uint32_t r) {
+    if (l == 0 || r == 0) {
+        return l != 0 ? l : r;
+    }
+    if (nodes[l].prio > nodes[r].prio) {
+        nodes[l].right = treap_merge(nodes, nodes[l].right, r);
+        update_size(nodes, l);
+        return l;
+    }
+    nodes[r].left = treap_merge(nodes, l, nodes[r].left);
+    update_size(nodes, r);
+    return r;
+}
+
+/* Detaches the worst (last) entry of t into *removed; returns the new root. */
+static uint32_t treap_remove_last(LeaderboardNode *nodes, uint32_t t, uint32_t *removed) {
+    if (nodes[t].right == 0) {
+        *removed = t;
+        return nodes[t].left;
+    }
+    nodes[t].right = treap_remove_last(nodes, nodes[t].right, removed);
+    update_size(nodes, t);
+    return t;
+}
+
+/* Returns the worst entry kept in the top-K. */
+static const LeaderboardEntry *treap_last(const LeaderboardNode *nodes, uint32_t t) {
+    while (nodes[t].right != 0) {
+        t = nodes[t].right;
+    }
+    return &nodes[t].entry;
+}
+
+/* Copies entries in order, skipping *skip first, until *left runs out. */
+static void treap_collect(
+    const LeaderboardNode *nodes, uint32_t t, size_t *skip, size_t *left, LeaderboardEntry *out, size_t *copied
+) {
+    if (t == 0 || *left == 0) {
+        return;
+    }
+    size_t left_size = nodes[nodes[t].left].size;
+    if (*skip >= left_size) {
+        *skip -= left_size;
+    } else {
+        treap_collect(nodes, nodes[t].left, skip, left, out, copied);
+    }
+    if (*left == 0) {
+        return;
+    }
+    if (*skip > 0) {
+        --*skip;
+    } else {
+        out[(*copied)++] = nodes[t].entry;
+        --*left;
+    }
+    if (*skip >= nodes[nodes[t].right].size) {
+        *skip -= nodes[nodes[t].right].size;
+        return;
+    }
+    treap_collect(nodes, nodes[t].right, skip, left, out, copied);
+}
+
+/* Offers entry to the top-K, evicting the worst kept entry if full. */
+static void top_insert(Leaderboard *board, const LeaderboardEntry *entry) {
+    LeaderboardNode *nodes = board->nodes;
+    uint32_t node;
+    if (board->used_nodes < board->top_k) {
+        node = ++board->used_nodes;
+    } else {
+        if (!better(entry, treap_last(nodes, board->root))) {
+            return;
+        }
+        board->root = treap_remove_last(nodes, board->root, &node);
+    }
+
+    board->prio_state ^= board->prio_state << 13;
+    board->prio_state ^= board->prio_state >> 17;
+    board->prio_state ^= board->prio_state << 5;
+    nodes[node].entry = *entry;
+    nodes[node].prio = board->prio_state;
+    nodes[node].left = 0;
+    nodes[node].right = 0;
+    nodes[node].size = 1;
+
+    uint32_t l;
+    uint32_t r;
+    treap_split(nodes, board->root, entry, &l, &r);
+    board->root = treap_merge(nodes, treap_merge(nodes, l, node), r);
+}
+
+/* Adds a committed entry to both indexes. */
+static bool index_entry(Leaderboard *board, const LeaderboardEntry *entry) {
+    uint32_t pos = score_pos(entry->score);
+    if (!fenwick_reserve(board, pos)) {
+        return false;
+    }
+    fenwick_add(board, pos);
+    top_insert(board, entry);
+    ++board->count;
+    return true;
+}
+
+/* Validates or writes the header of a file of size bytes. */
+static bool prepare_header(Leaderboard *board, const char *path, off_t size) {
+    if (size == 0) {
+        size_t bytes = LEADERBOARD_HEADER_SIZE + (size_t)LEADERBOARD_INITIAL_RECORDS * LEADERBOARD_RECORD_SIZE;
+        if (ftruncate(board->fd, (off_t)bytes) != 0) {
+            perror(path);
+            return false;
+        }
+        size = (off_t)bytes;
+    }
+    if (size < LEADERBOARD_HEADER_SIZE + LEADERBOARD_RECORD_SIZE) {
+        fprintf(stderr, "%s: not a leaderboard file\n", path);
+        return false;
+    }
+    board->map_bytes = (size_t)size;
+    board->capacity = (uint32_t)(((size_t)size - LEADERBOARD_HEADER_SIZE) / LEADERBOARD_RECORD_SIZE);
+    board->map = map_file(board->fd, board->map_bytes);
+    if (board->map == NULL) {
+        perror(path);
+        return false;
+    }
+
+    uint8_t header[16];
+    memcpy(header, LEADERBOARD_MAGIC, 8);
+    put_u32(header + 8, LEADERBOARD_VERSION);
+    put_u32(header + 12, LEADERBOARD_RECORD_SIZE);
+    static const uint8_t blank[16];
+    if (memcmp(board->map, blank, sizeof(blank)) == 0) {
+        /* New file, or a crash before its header landed. */
+        memcpy(board->map, header, sizeof(header));
+        if (msync(board->map, LEADERBOARD_HEADER_SIZE, MS_SYNC) != 0) {
+            perror(path);
+            return false;
+        }
+    } else if (memcmp(board->map, header, sizeof(header)) != 0) {
+        fprintf(stderr, "%s: not a leaderboard file\n", path);
+        return false;
+    }
+    return true;
+}
+
+/* Opens or creates the table at path, keeping the best top_k (0 picks
+   LEADERBOARD_DEFAULT_TOP_K) in memory. Recovers the committed prefix and
+   rebuilds the indexes from it. Returns false and prints the reason on
+   failure. */
+bool leaderboard_open(Leaderboard *board, const char *path, uint32_t top_k) {
+    memset(board, 0, sizeof(*board));
+    board->fd = -1;
+    board->top_k = top_k > 0 ? top_k : LEADERBOARD_DEFAULT_TOP_K;
+    board->prio_state = 0x9E3779B9u;
+    board->fenwick_size = LEADERBOARD_FENWICK_INITIAL;
+    board->page_bytes = (size_t)sysconf(_SC_PAGESIZE);
+    board->fenwick = (uint32_t *)calloc((size_t)board->fenwick_size + 1, sizeof(uint32_t));
+    board->nodes = (LeaderboardNode *)calloc((size_t)board->top_k + 1, sizeof(LeaderboardNode));
+    if (board->fenwick == NULL || board->nodes == NULL) {
+        fprintf(stderr, "Cannot allocate leaderboard index\n");
+        free(board->fenwick);
+        free(board->nodes);
+        board->fenwick = NULL;
+        board->nodes = NULL;
+        return false;
+    }
+    pthread_mutex_init(&board->lock, NULL);
+
+    struct stat st;
+    board->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (board->fd < 0 || fstat(board->fd, &st) != 0) {
+        perror(path);
+        leaderboard_close(board);
+        return false;
+    }
+    if (!prepare_header(board, path, st.st_size)) {
+        leaderboard_close(board);
+        return false;
+    }
+
+    LeaderboardEntry entry;
+    while (board->count < board->capacity && read_record(board, board->count, &entry)) {
+        if (!index_entry(board, &entry)) {
+            fprintf(stderr, "Cannot allocate leaderboard index\n");
+            leaderboard_close(board);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Flushes the mapping and releases everything. Safe on a zeroed board. */
+void leaderboard_close(Leaderboard *board) {
+    if (board->nodes == NULL) {
+        return;
+    }
+    if (board->map != NULL) {
+        msync(board->map, board->map_bytes, MS_SYNC);
+        munmap(board->map, board->map_bytes);
+        board->map = NULL;
+    }
+    if (board->fd >= 0) {
+        close(board->fd);
+        board->fd = -1;
+    }
+    pthread_mutex_destroy(&board->lock);
+    free(board->fenwick);
+    free(board->nodes);
+    board->fenwick = NULL;
+    board->nodes = NULL;
+}
+
+/* Commits one result, syncs its page to stable storage and indexes it;
+   fills *out if non-NULL. Returns false if the file cannot grow or the
+   record cannot be synced. */
+bool leaderboard_submit(Leaderboard *board, uint32_t session, int32_t score, uint64_t finished_ms, LeaderboardEntry *out) {
+    pthread_mutex_lock(&board->lock);
+    if (board->count == board->capacity && !grow_file(board)) {
+        pthread_mutex_unlock(&board->lock);
+        return false;
+    }
+    LeaderboardEntry entry = {board->count + 1, session, score, finished_ms};
+    if (!fenwick_reserve(board, score_pos(score))) {
+        pthread_mutex_unlock(&board->lock);
+        return false;
+    }
+    write_record(board, &entry);
+    /* Syncing under the lock keeps the on-disk records a prefix: slot N
+       is stable before slot N + 1 is written. */
+    bool synced = sync_record(board, entry.seq - 1);
+    index_entry(board, &entry);
+    pthread_mutex_unlock(&board->lock);
+    if (out != NULL) {
+        *out = entry;
+    }
+    return synced;
+}
+
+/* Copies up to count entries starting at 0-based offset, best first, from
+   the in-memory top-K; returns how many were copied. */
+size_t leaderboard_top(Leaderboard *board, size_t offset, size_t count, LeaderboardEntry *out) {
+    pthread_mutex_lock(&board->lock);
+    size_t copied = 0;
+    treap_collect(board->nodes, board->root, &offset, &count, out, &copied);
+    pthread_mutex_unlock(&board->lock);
+    return copied;
+}
+
+/* Returns the rank score would get among all results: 1 + how many scored
+   higher. */
+uint32_t leaderboard_rank(Leaderboard *board, int32_t score) {
+    pthread_mutex_lock(&board->lock);
+    uint32_t higher = board->count;
+    if (score >= 0) {
+        uint32_t pos = score_pos(score);
+        higher -= fenwick_prefix(board, pos < board->fenwick_size ? pos : board->fenwick_size);
+    }
+    pthread_mutex_unlock(&board->lock);
+    return higher + 1;
+}
+
+/* Returns the score at 1-based rank among all results, or -1 if there are
+   fewer results. */
+int32_t leaderboard_score_at(Leaderboard *board, uint32_t rank) {
+    pthread_mutex_lock(&board->lock);
+    if (rank == 0 || rank > board->count) {
+        pthread_mutex_unlock(&board->lock);
+        return -1;
+    }
+    /* Descend to the last position whose prefix is still short of the
+       rank-th result counted from the bottom. */
+    uint32_t want = board->count - rank + 1;
+    uint32_t pos = 0;
+    for (uint32_t step = board->fenwick_size; step > 0; step >>= 1) {
+        if (pos + step <= board->fenwick_size && board->fenwick[pos + step] < want) {
+            pos += step;
+            want -= board->fenwick[pos];
+        }
+    }
+    pthread_mutex_unlock(&board->lock);
+    return (int32_t)pos;
+}
+
+/* Returns the number of committed results. */
+uint32_t leaderboard_count(Leaderboard *board) {
+    pthread_mutex_lock(&board->lock);
+    uint32_t count = board->count;
+    pthread_mutex_unlock(&board->lock);
+    return count;
+}
+
+/* Forces committed records to stable storage. */
+bool leaderboard_sync(Leaderboard *board) {
+    pthread_mutex_lock(&board->lock);
+    bool ok = msync(board->map, board->map_bytes, MS_SYNC) == 0;
+    pthread_mutex_unlock(&board->lock);
+    return ok;
+}
@@ -0,0 +1,90 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LEADERBOARD_RECORD_SIZE 32
+#define LEADERBOARD_HEADER_SIZE 4096
+#define LEADERBOARD_INITIAL_RECORDS 4096
+#define LEADERBOARD_DEFAULT_TOP_K 1024
+#define LEADERBOARD_MAX_SCORE ((1 << 22) - 1)
+
+/* One finished game. seq numbers results from 1 in submission order and
+   breaks score ties (earlier wins). */
+typedef struct {
+    uint32_t seq;
+    uint32_t session;
+    int32_t score;
+    uint64_t finished_ms;
+} LeaderboardEntry;
+
+/* Top-K node: a treap ordered best-first, each node counting its subtree
+   so rank lookups and range reads start in O(log K). Index 0 is nil. */
+typedef struct {
+    LeaderboardEntry entry;
+    uint32_t prio;
+    uint32_t left;
+    uint32_t right;
+    uint32_t size;
+} LeaderboardNode;
+
+/* Persistent high-score table. Results are fixed 32-byte records in a
+   memory-mapped file, each sealed by a commit word (CRC-32 of the record)
+   stored last and synced before the next is written, so a crash leaves a
+   prefix of whole records and every submitted one survives. In memory
+   a Fenwick tree counts results per score for O(log n) rank and score
+   queries over all of them, and a treap keeps the best top_k entries for
+   O(log K + k) range reads. All calls are serialized by lock. */
+typedef struct {
+    pthread_mutex_t lock;
+    int fd;
+    uint8_t *map;
+    size_t map_bytes;
+    size_t page_bytes;
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t *fenwick;
+    uint32_t fenwick_size;
+    LeaderboardNode *nodes;
+    uint32_t top_k;
+    uint32_t root;
+    uint32_t used_nodes;
+    uint32_t prio_state;
+} Leaderboard;
+
+/* Opens or creates the table at path, keeping the best top_k (0 picks
+   LEADERBOARD_DEFAULT_TOP_K) in memory. Recovers the committed prefix and
+   rebuilds the indexes from it. Returns false and prints the reason on
+   failure. */
+bool leaderboard_open(Leaderboard *board, const char *path, uint32_t top_k);
+
+/* Flushes the mapping and releases everything. Safe on a zeroed board. */
+void leaderboard_close(Leaderboard *board);
+
+/* Commits one result, syncs its page to stable storage and indexes it;
+   fills *out if non-NULL. Returns false if the file cannot grow or the
+   record cannot be synced. */
+bool leaderboard_submit(Leaderboard *board, uint32_t session, int32_t score, uint64_t finished_ms, LeaderboardEntry *out);
+
+/* Copies up to count entries starting at 0-based offset, best first, from
+   the in-memory top-K; returns how many were copied. */
+size_t leaderboard_top(Leaderboard *board, size_t offset, size_t count, LeaderboardEntry *out);
+
+/* Returns the rank score would get among all results: 1 + how many scored
+   higher. */
+uint32_t leaderboard_rank(Leaderboard *board, int32_t score);
+
+/* Returns the score at 1-based rank among all results, or -1 if there are
+   fewer results. */
+int32_t leaderboard_score_at(Leaderboard *board, uint32_t rank);
+
+/* Returns the number of committed results. */
+uint32_t leaderboard_count(Leaderboard *board);
+
+/* Forces committed records to stable storage. */
+bool leaderboard_sync(Leaderboard *board);
+
+#endif
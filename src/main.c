@@ -7,13 +7,16 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #include "audio_fx.h"
+#include "frame_stats.h"
 #include "fx_particles.h"
 #include "game.h"
 #include "render_ui.h"
+#include "trace.h"
 #include "turn_controller.h"
 #include "turn_anim.h"
 
@@ -28,17 +31,136 @@
 #define CELL_SIZE 64
 #define NEXT_OFFSET_X 92
 #define NEXT_OFFSET_Y 36
+#define BOARD_PIXELS (GAME_BOARD_SIZE * CELL_SIZE)
+#define IDLE_WAIT_TIMEOUT_MS 500
+#define SIM_STEP (1.0f / 120.0f)
+#define SIM_MAX_FRAME_TIME 0.25f
+#define HEADLESS_FRAME_TIME (1.0f / 60.0f)
+#define HEADLESS_DEFAULT_FRAMES 600
+#define HEADLESS_PICK_ATTEMPTS 64
+
+/* What one board cell currently shows; compared to skip unchanged cells. */
+typedef struct {
+    uint8_t color;
+    uint8_t radius;
+    bool selected;
+} CellView;
+
+/* Command-line options; headless runs draw offscreen for benchmarking. */
+typedef struct {
+    bool headless;
+    int frames;
+    uint32_t seed;
+    const char *replay_path;
+    const char *trace_path;
+} RunOptions;
+
+/* Timed stages of one frame, reported by headless runs. */
+typedef enum {
+    FRAME_STAGE_UPDATE = 0,
+    FRAME_STAGE_DRAW = 1,
+    FRAME_STAGE_BOARD = 2,
+    FRAME_STAGE_BALLS = 3,
+    FRAME_STAGE_PARTICLES = 4,
+    FRAME_STAGE_COUNT = 5
+} FrameStage;
+
+/* CPU time per stage of one frame in microseconds. */
+typedef struct {
+    double stage_us[FRAME_STAGE_COUNT];
+} FrameTimes;
+
+#ifdef LINES98_FRAME_STATS
+/* Main-loop stages timed for the frame statistics HUD. */
+typedef enum {
+    HUD_STAGE_EVENTS = 0,
+    HUD_STAGE_TURN_ANIM = 1,
+    HUD_STAGE_PARTICLES = 2,
+    HUD_STAGE_DRAW_NEXT = 3,
+    HUD_STAGE_DRAW_SCORE = 4,
+    HUD_STAGE_DRAW_BOARD = 5,
+    HUD_STAGE_DRAW_MOVE = 6,
+    HUD_STAGE_DRAW_PARTICLES = 7,
+    HUD_STAGE_DRAW_OVERLAY = 8,
+    HUD_STAGE_DRAW_HUD = 9,
+    HUD_STAGE_PRESENT = 10,
+    HUD_STAGE_FRAME = 11,
+    HUD_STAGE_COUNT = 12
+} HudStage;
+
+static const char *const HUD_STAGE_NAMES[HUD_STAGE_COUNT] = {
+    "EVENTS",
+    "TURN ANIM",
+    "PARTICLES",
+    "DRAW NEXT",
+    "DRAW SCORE",
+    "DRAW BOARD",
+    "DRAW MOVE",
+    "DRAW DUST",
+    "DRAW OVERLAY",
+    "DRAW HUD",
+    "PRESENT",
+    "FRAME"
+};
+
+#define HUD_SCALE 2
+#define HUD_LINE_HEIGHT 18
+#define HUD_BAR_X 360
+#define HUD_BAR_WIDTH 380
+#define HUD_BUDGET_US 16667.0f
+#endif
 
 typedef struct {
     SDL_Window *window;
+    SDL_Surface *offscreen;
     SDL_Renderer *renderer;
     AudioFx audio;
     Game game;
     uint8_t render_board[GAME_CELLS];
     TurnAnim turn_anim;
     ParticleSystem particles;
+    ParticleBatch particle_batch;
+    RuBallCache ball_cache;
+    SDL_Texture *board_layer;
+    CellView board_layer_cells[GAME_CELLS];
+    bool board_layer_valid;
+    float sim_accumulator;
+    float move_u_prev;
+    float move_u_curr;
+    RuGlyphAtlas glyphs;
+    RuLabel score_label;
+    RuLabel over_title_label;
+    RuLabel over_caption_label;
+    RuLabel over_score_label;
+    bool fixed_seed;
+    uint32_t seed;
+#ifdef LINES98_FRAME_STATS
+    FrameStats frame_stats;
+    bool hud_visible;
+#endif
 } App;
 
+/* Returns microseconds between two performance counter values. */
+static double elapsed_us(uint64_t from, uint64_t to) {
+    return (double)(to - from) * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+#ifdef LINES98_FRAME_STATS
+/* Runs stmt and adds its CPU time to a HUD stage of the current frame. */
+#define TIMED_STAGE(app, stage, stmt)                                                                            \
+    do {                                                                                                         \
+        uint64_t timed_stage_start = SDL_GetPerformanceCounter();                                                \
+        stmt;                                                                                                    \
+        frame_stats_add(&(app)->frame_stats, (stage), (float)elapsed_us(timed_stage_start, SDL_GetPerformanceCounter())); \
+    } while (0)
+#else
+/* Frame statistics compiled out: runs stmt with no timing. */
+#define TIMED_STAGE(app, stage, stmt) \
+    do {                              \
+        stmt;                         \
+    } while (0)
+#endif
+
 static const SDL_Color BG = {22, 26, 34, 255};
 static const SDL_Color GRID_BG = {33, 39, 49, 255};
 static const SDL_Color GRID_LINE = {64, 76, 92, 255};
@@ -76,14 +198,23 @@ static bool idx_to_rc(int idx, int *row, int *col) {
     return true;
 }
 
+/* Returns seed for a new game: wall clock normally, a fixed sequence when
+   runs must be reproducible. */
+static uint32_t new_game_seed(App *app) {
+    if (app->fixed_seed) {
+        return app->seed++;
+    }
+    return (uint32_t)time(NULL);
+}
+
 /* Copies authoritative game board into render board. */
 static void sync_render_board(App *app) {
     memcpy(app->render_board, app->game.board, sizeof(app->render_board));
 }
 
-/* Resets turn animation state to idle. */
+/* Resets turn animation state to idle, abandoning any running turn. */
 static void clear_turn_anim(App *app) {
-    turn_anim_init(&app->turn_anim);
+    turn_anim_cancel(&app->turn_anim);
 }
 
 /* Clears all active dust particles. */
@@ -120,6 +251,8 @@ static void start_turn_animation(
 ) {
     turn_anim_start(&app->turn_anim, before, app->game.board, from_idx, to_idx, path, path_len);
     turn_anim_begin_render(&app->turn_anim, app->render_board, GAME_CELLS);
+    app->move_u_prev = 0.0f;
+    app->move_u_curr = 0.0f;
 }
 
 /* Returns growth scale for spawned ball or -1 when not in spawn phase. */
@@ -142,22 +275,48 @@ static void update_particles(App *app, float dt) {
     particles_update(&app->particles, dt, app->render_board, GAME_BOARD_SIZE, CELL_SIZE, BOARD_OFFSET_X, BOARD_OFFSET_Y, 23.0f);
 }
 
+/* Runs one fixed simulation step and keeps the previous move position
+   so rendering can interpolate between steps. */
+static void step_simulation(App *app) {
+    app->move_u_prev = app->move_u_curr;
+    TIMED_STAGE(app, HUD_STAGE_TURN_ANIM, update_turn_animation(app, SIM_STEP));
+    TIMED_STAGE(app, HUD_STAGE_PARTICLES, update_particles(app, SIM_STEP));
+    if (!turn_anim_move_u(&app->turn_anim, &app->move_u_curr)) {
+        app->move_u_curr = 0.0f;
+    }
+}
+
+/* Advances simulation by whole fixed steps covering frame_time. Time past
+   SIM_MAX_FRAME_TIME after a hitch is dropped instead of replayed. */
+static void advance_simulation(App *app, float frame_time) {
+    app->sim_accumulator += SDL_min(frame_time, SIM_MAX_FRAME_TIME);
+    while (app->sim_accumulator >= SIM_STEP) {
+        step_simulation(app);
+        app->sim_accumulator -= SIM_STEP;
+    }
+}
+
+/* Returns fraction of a simulation step elapsed since the last step. */
+static float sim_blend(const App *app) {
+    return SDL_min(1.0f, app->sim_accumulator / SIM_STEP);
+}
+
 /* Draws all active particles with alpha fade. */
-static void draw_particles(SDL_Renderer *renderer, const App *app) {
-    particles_draw(renderer, &app->particles);
+static void draw_particles(SDL_Renderer *renderer, App *app) {
+    particles_draw(renderer, &app->particle_batch, &app->particles, sim_blend(app));
 }
 
 /* Draws interpolated moving ball during MOVE phase. */
-static void draw_move_animation(SDL_Renderer *renderer, const App *app) {
+static void draw_move_animation(SDL_Renderer *renderer, App *app) {
     const TurnAnim *anim = &app->turn_anim;
     if (!anim->active || anim->move.color == 0 || anim->move.path_len < 2) {
         return;
     }
 
-    float u = 0.0f;
-    if (!turn_anim_move_u(anim, &u)) {
+    if (!turn_anim_move_u(anim, NULL)) {
         return;
     }
+    float u = app->move_u_prev + (app->move_u_curr - app->move_u_prev) * sim_blend(app);
 
     int seg = (int)u;
     if (seg >= anim->move.path_len - 1) {
@@ -182,40 +341,69 @@ static void draw_move_animation(SDL_Renderer *renderer, const App *app) {
     float y1 = (float)ball_center_y(r1);
     int cx = (int)(x0 + (x1 - x0) * frac);
     int cy = (int)(y0 + (y1 - y0) * frac);
-    ru_draw_ball(renderer, cx, cy, 23, BALL_COLORS[anim->move.color]);
+    ru_draw_ball_cached(&app->ball_cache, renderer, cx, cy, 23, BALL_COLORS[anim->move.color]);
 }
 
-/* Renders top-right score display. */
-static void draw_score(SDL_Renderer *renderer, int score) {
-    if (score < 0) {
-        score = 0;
-    }
-    if (score > 9999) {
-        score = 9999;
-    }
+/* Renders top-right score display from a cached number texture. */
+static void draw_score(SDL_Renderer *renderer, App *app) {
+    ru_label_set_number(&app->score_label, renderer, 2, 40, app->game.score, 4);
+    ru_label_draw(&app->score_label, renderer, &app->glyphs, 520, 18, TEXT);
+}
 
-    ru_set_color(renderer, TEXT);
-    int d0 = (score / 1000) % 10;
-    int d1 = (score / 100) % 10;
-    int d2 = (score / 10) % 10;
-    int d3 = score % 10;
+/* Creates retained board render target; without it boards draw directly. */
+static void board_layer_create(App *app) {
+    app->board_layer_valid = false;
+    if (!SDL_RenderTargetSupported(app->renderer)) {
+        return;
+    }
 
-    ru_draw_digit(renderer, 520, 18, 2, d0);
-    ru_draw_digit(renderer, 560, 18, 2, d1);
-    ru_draw_digit(renderer, 600, 18, 2, d2);
-    ru_draw_digit(renderer, 640, 18, 2, d3);
+    /* One extra pixel keeps the closing grid lines inside the layer. */
+    app->board_layer = SDL_CreateTexture(
+        app->renderer,
+        SDL_PIXELFORMAT_RGBA8888,
+        SDL_TEXTUREACCESS_TARGET,
+        BOARD_PIXELS + 1,
+        BOARD_PIXELS + 1
+    );
+    if (app->board_layer == NULL) {
+        fprintf(stderr, "Board layer unavailable, drawing board directly: %s\n", SDL_GetError());
+        return;
+    }
+    SDL_SetTextureBlendMode(app->board_layer, SDL_BLENDMODE_NONE);
 }
 
-/* Initializes SDL systems, window, renderer, audio and game state. */
-static bool app_init(App *app) {
-    memset(app, 0, sizeof(*app));
-    srand((unsigned int)time(NULL));
+/* Releases retained board render target. */
+static void board_layer_destroy(App *app) {
+    if (app->board_layer != NULL) {
+        SDL_DestroyTexture(app->board_layer);
+        app->board_layer = NULL;
+    }
+    app->board_layer_valid = false;
+}
 
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
-        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
-        return false;
+/* Recreates every texture after the renderer lost them all (device
+   reset): board layer, ball atlas, particle sprite, glyph atlas and
+   labels. Labels rebuild the next time they are set. */
+static void reload_device_textures(App *app) {
+    board_layer_destroy(app);
+    board_layer_create(app);
+    ru_ball_cache_invalidate(&app->ball_cache, app->window != NULL);
+    particles_batch_shutdown(&app->particle_batch);
+    if (!particles_batch_init(&app->particle_batch, app->renderer)) {
+        fprintf(stderr, "Particle batch unavailable, using scanline particles: %s\n", SDL_GetError());
+    }
+    ru_label_destroy(&app->score_label);
+    ru_label_destroy(&app->over_title_label);
+    ru_label_destroy(&app->over_caption_label);
+    ru_label_destroy(&app->over_score_label);
+    ru_glyph_atlas_shutdown(&app->glyphs);
+    if (!ru_glyph_atlas_init(&app->glyphs, app->renderer)) {
+        fprintf(stderr, "Glyph atlas unavailable, drawing text with rectangles: %s\n", SDL_GetError());
     }
+}
 
+/* Creates the on-screen window and vsynced renderer. */
+static bool create_window_renderer(App *app) {
     app->window = SDL_CreateWindow(
         "Lines-98 in C/SDL2",
         SDL_WINDOWPOS_CENTERED,
@@ -235,93 +423,236 @@ static bool app_init(App *app) {
         fprintf(stderr, "SDL_CreateRenderer failed: %s\n", SDL_GetError());
         return false;
     }
+    return true;
+}
 
-    audio_fx_init(&app->audio);
+/* Creates a software renderer drawing into a window-sized offscreen surface. */
+static bool create_offscreen_renderer(App *app) {
+    app->offscreen = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_RGBA8888);
+    if (app->offscreen == NULL) {
+        fprintf(stderr, "SDL_CreateRGBSurfaceWithFormat failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    app->renderer = SDL_CreateSoftwareRenderer(app->offscreen);
+    if (app->renderer == NULL) {
+        fprintf(stderr, "SDL_CreateSoftwareRenderer failed: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+/* Initializes SDL systems, window, renderer, audio and game state.
+   Headless runs use the dummy drivers, a fixed seed and synchronous cache
+   builds so every run draws the same frames. */
+static bool app_init(App *app, const RunOptions *options) {
+    memset(app, 0, sizeof(*app));
+    app->fixed_seed = options->headless;
+    app->seed = options->seed;
+#ifdef LINES98_FRAME_STATS
+    frame_stats_init(&app->frame_stats, HUD_STAGE_COUNT);
+#endif
+    srand(options->headless ? (unsigned int)options->seed : (unsigned int)time(NULL));
+
+    if (options->headless) {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    }
 
-    game_init(&app->game, (uint32_t)time(NULL));
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    bool created = options->headless ? create_offscreen_renderer(app) : create_window_renderer(app);
+    if (!created) {
+        return false;
+    }
+
+    /* Sprites rasterize on a worker; balls draw directly until it finishes. */
+    if (!ru_ball_cache_init(&app->ball_cache, BALL_COLORS, GAME_COLORS + 1, !options->headless)) {
+        fprintf(stderr, "Ball sprite cache unavailable, drawing balls directly\n");
+    }
+
+    if (!particles_batch_init(&app->particle_batch, app->renderer)) {
+        fprintf(stderr, "Particle batch unavailable, using scanline particles: %s\n", SDL_GetError());
+    }
+
+    board_layer_create(app);
+    if (!ru_glyph_atlas_init(&app->glyphs, app->renderer)) {
+        fprintf(stderr, "Glyph atlas unavailable, drawing text with rectangles: %s\n", SDL_GetError());
+    }
+    audio_fx_init(&app->audio, !options->headless);
+
+    game_init(&app->game, new_game_seed(app));
     sync_render_board(app);
     clear_turn_anim(app);
     clear_particles(app);
     return true;
 }
 
-/* Releases all SDL resources owned by the app. */
+/* Releases all SDL resources owned by the app and flushes any trace. */
 static void app_shutdown(App *app) {
+    if (SDL_getenv("LINES98_AUDIO_STATS") != NULL) {
+        AudioFxStats stats;
+        audio_fx_get_stats(&app->audio, &stats);
+        fprintf(
+            stderr,
+            "audio: enqueued=%d merged=%d dropped=%d max_start_latency_us=%d\n",
+            stats.enqueued,
+            stats.merged,
+            stats.dropped,
+            stats.max_start_latency_us
+        );
+    }
     audio_fx_shutdown(&app->audio);
+    particles_batch_shutdown(&app->particle_batch);
+    ru_ball_cache_shutdown(&app->ball_cache);
+    board_layer_destroy(app);
+    ru_label_destroy(&app->score_label);
+    ru_label_destroy(&app->over_title_label);
+    ru_label_destroy(&app->over_caption_label);
+    ru_label_destroy(&app->over_score_label);
+    ru_glyph_atlas_shutdown(&app->glyphs);
 
     if (app->renderer != NULL) {
         SDL_DestroyRenderer(app->renderer);
         app->renderer = NULL;
     }
 
+    if (app->offscreen != NULL) {
+        SDL_FreeSurface(app->offscreen);
+        app->offscreen = NULL;
+    }
+
     if (app->window != NULL) {
         SDL_DestroyWindow(app->window);
         app->window = NULL;
     }
 
     SDL_Quit();
+
+    /* Audio and sprite worker threads are joined above, so buffers are quiet. */
+    if (trace_enabled() && !trace_stop()) {
+        fprintf(stderr, "Cannot write trace file\n");
+    }
 }
 
 /* Draws preview balls for the next spawn step. */
-static void draw_next_balls(SDL_Renderer *renderer, const Game *game) {
+static void draw_next_balls(SDL_Renderer *renderer, App *app) {
     for (int i = 0; i < GAME_NEXT_COUNT; ++i) {
         int x = NEXT_OFFSET_X + i * 56;
         int y = NEXT_OFFSET_Y;
-        ru_draw_ball(renderer, x, y, 18, BALL_COLORS[game->next_colors[i]]);
+        ru_draw_ball_cached(&app->ball_cache, renderer, x, y, 18, BALL_COLORS[app->game.next_colors[i]]);
     }
 }
 
-/* Draws board grid and all balls from current render snapshot. */
-static void draw_board(SDL_Renderer *renderer, const App *app) {
-    SDL_Rect board_rect = {BOARD_OFFSET_X, BOARD_OFFSET_Y, GAME_BOARD_SIZE * CELL_SIZE, GAME_BOARD_SIZE * CELL_SIZE};
+/* Computes what a board cell should show this frame. */
+static CellView cell_view_for_index(const App *app, int idx) {
+    CellView view = {0, 0, false};
+    bool animating = turn_anim_active(&app->turn_anim);
+    view.color = animating ? app->render_board[idx] : app->game.board[idx];
+    if (view.color == 0) {
+        return view;
+    }
+
+    int radius = 23;
+    if (animating) {
+        float s = spawned_scale_for_index(&app->turn_anim, idx);
+        if (s >= 0.0f) {
+            radius = (int)(2.0f + 21.0f * s);
+        }
+    }
+    view.radius = (uint8_t)radius;
+    view.selected = !animating && idx == app->game.selected_index;
+    return view;
+}
+
+/* Draws one cell's ball and selection marker relative to board origin. */
+static void draw_cell_view(SDL_Renderer *renderer, App *app, int row, int col, CellView view, int origin_x, int origin_y) {
+    if (view.color == 0) {
+        return;
+    }
+
+    int cx = origin_x + col * CELL_SIZE + CELL_SIZE / 2;
+    int cy = origin_y + row * CELL_SIZE + CELL_SIZE / 2;
+    ru_draw_ball_cached(&app->ball_cache, renderer, cx, cy, view.radius, BALL_COLORS[view.color]);
+
+    if (view.selected) {
+        ru_set_color(renderer, SELECTED);
+        SDL_Rect marker = {cx - 26, cy - 26, 52, 52};
+        SDL_RenderDrawRect(renderer, &marker);
+    }
+}
+
+/* Fills board background and grid lines relative to board origin. */
+static void draw_grid(SDL_Renderer *renderer, int origin_x, int origin_y) {
+    SDL_Rect board_rect = {origin_x, origin_y, BOARD_PIXELS, BOARD_PIXELS};
     ru_set_color(renderer, GRID_BG);
     SDL_RenderFillRect(renderer, &board_rect);
 
     ru_set_color(renderer, GRID_LINE);
     for (int i = 0; i <= GAME_BOARD_SIZE; ++i) {
-        int x = BOARD_OFFSET_X + i * CELL_SIZE;
-        int y = BOARD_OFFSET_Y + i * CELL_SIZE;
-        SDL_RenderDrawLine(renderer, x, BOARD_OFFSET_Y, x, BOARD_OFFSET_Y + GAME_BOARD_SIZE * CELL_SIZE);
-        SDL_RenderDrawLine(renderer, BOARD_OFFSET_X, y, BOARD_OFFSET_X + GAME_BOARD_SIZE * CELL_SIZE, y);
+        int x = origin_x + i * CELL_SIZE;
+        int y = origin_y + i * CELL_SIZE;
+        SDL_RenderDrawLine(renderer, x, origin_y, x, origin_y + BOARD_PIXELS);
+        SDL_RenderDrawLine(renderer, origin_x, y, origin_x + BOARD_PIXELS, y);
     }
+}
 
-    int sel_row = -1;
-    int sel_col = -1;
-    if (!turn_anim_active(&app->turn_anim) && app->game.selected_index >= 0) {
-        sel_row = app->game.selected_index / GAME_BOARD_SIZE;
-        sel_col = app->game.selected_index % GAME_BOARD_SIZE;
+/* Re-renders only cells whose view changed since the layer was last drawn. */
+static bool board_layer_refresh(App *app) {
+    SDL_Renderer *renderer = app->renderer;
+    if (SDL_SetRenderTarget(renderer, app->board_layer) != 0) {
+        return false;
     }
 
-    for (int row = 0; row < GAME_BOARD_SIZE; ++row) {
-        for (int col = 0; col < GAME_BOARD_SIZE; ++col) {
-            int idx = row * GAME_BOARD_SIZE + col;
-            uint8_t cell = turn_anim_active(&app->turn_anim) ? app->render_board[idx] : app->game.board[idx];
-            if (cell == 0) {
-                continue;
-            }
+    bool full = !app->board_layer_valid;
+    if (full) {
+        draw_grid(renderer, 0, 0);
+    }
 
-            int cx = ball_center_x(col);
-            int cy = ball_center_y(row);
-            int radius = 23;
-            if (turn_anim_active(&app->turn_anim)) {
-                float s = spawned_scale_for_index(&app->turn_anim, idx);
-                if (s >= 0.0f) {
-                    radius = (int)(2.0f + 21.0f * s);
-                }
-            }
-            ru_draw_ball(renderer, cx, cy, radius, BALL_COLORS[cell]);
+    for (int idx = 0; idx < GAME_CELLS; ++idx) {
+        CellView view = cell_view_for_index(app, idx);
+        CellView *drawn = &app->board_layer_cells[idx];
+        if (!full && view.color == drawn->color && view.radius == drawn->radius && view.selected == drawn->selected) {
+            continue;
+        }
 
-            if (row == sel_row && col == sel_col) {
-                ru_set_color(renderer, SELECTED);
-                SDL_Rect marker = {cx - 26, cy - 26, 52, 52};
-                SDL_RenderDrawRect(renderer, &marker);
-            }
+        int row = idx / GAME_BOARD_SIZE;
+        int col = idx % GAME_BOARD_SIZE;
+        if (!full) {
+            /* Cell interior only; grid lines on the borders stay intact. */
+            SDL_Rect inner = {col * CELL_SIZE + 1, row * CELL_SIZE + 1, CELL_SIZE - 1, CELL_SIZE - 1};
+            ru_set_color(renderer, GRID_BG);
+            SDL_RenderFillRect(renderer, &inner);
         }
+        draw_cell_view(renderer, app, row, col, view, 0, 0);
+        *drawn = view;
+    }
+
+    SDL_SetRenderTarget(renderer, NULL);
+    app->board_layer_valid = true;
+    return true;
+}
+
+/* Draws board grid and all balls from current render snapshot. */
+static void draw_board(SDL_Renderer *renderer, App *app) {
+    if (app->board_layer != NULL && board_layer_refresh(app)) {
+        SDL_Rect dst = {BOARD_OFFSET_X, BOARD_OFFSET_Y, BOARD_PIXELS + 1, BOARD_PIXELS + 1};
+        SDL_RenderCopy(renderer, app->board_layer, NULL, &dst);
+        return;
+    }
+
+    draw_grid(renderer, BOARD_OFFSET_X, BOARD_OFFSET_Y);
+    for (int idx = 0; idx < GAME_CELLS; ++idx) {
+        CellView view = cell_view_for_index(app, idx);
+        draw_cell_view(renderer, app, idx / GAME_BOARD_SIZE, idx % GAME_BOARD_SIZE, view, BOARD_OFFSET_X, BOARD_OFFSET_Y);
     }
 }
 
 /* Draws game-over overlay panel and final score. */
-static void draw_overlay(SDL_Renderer *renderer, const Game *game, bool visible) {
+static void draw_overlay(SDL_Renderer *renderer, App *app, bool visible) {
     if (!visible) {
         return;
     }
@@ -337,27 +668,14 @@ static void draw_overlay(SDL_Renderer *renderer, const Game *game, bool visible)
     SDL_SetRenderDrawColor(renderer, 80, 102, 130, 255);
     SDL_RenderDrawRect(renderer, &panel);
 
-    ru_set_color(renderer, TEXT);
-    const char *title = "GAME OVER";
-    const char *label = "SCORE";
-    int title_scale = 8;
-    int label_scale = 5;
-    int title_x = panel.x + (panel.w - ru_text_pixel_width(title_scale, title)) / 2;
-    int label_x = panel.x + (panel.w - ru_text_pixel_width(label_scale, label)) / 2;
-    ru_draw_text(renderer, title_x, 300, title_scale, title);
-    ru_draw_text(renderer, label_x, 390, label_scale, label);
-
-    int score = game->score;
-    if (score < 0) {
-        score = 0;
-    }
-    if (score > 9999) {
-        score = 9999;
-    }
-    ru_draw_digit(renderer, 270, 440, 3, (score / 1000) % 10);
-    ru_draw_digit(renderer, 332, 440, 3, (score / 100) % 10);
-    ru_draw_digit(renderer, 394, 440, 3, (score / 10) % 10);
-    ru_draw_digit(renderer, 456, 440, 3, score % 10);
+    ru_label_set_text(&app->over_title_label, renderer, 8, "GAME OVER");
+    ru_label_set_text(&app->over_caption_label, renderer, 5, "SCORE");
+    ru_label_set_number(&app->over_score_label, renderer, 3, 62, app->game.score, 4);
+    int title_x = panel.x + (panel.w - app->over_title_label.w) / 2;
+    int label_x = panel.x + (panel.w - app->over_caption_label.w) / 2;
+    ru_label_draw(&app->over_title_label, renderer, &app->glyphs, title_x, 300, TEXT);
+    ru_label_draw(&app->over_caption_label, renderer, &app->glyphs, label_x, 390, TEXT);
+    ru_label_draw(&app->over_score_label, renderer, &app->glyphs, 270, 440, TEXT);
 
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
 }
@@ -371,7 +689,7 @@ static void handle_click(App *app, int x, int y) {
     if (app->game.game_over) {
         (void)x;
         (void)y;
-        game_init(&app->game, (uint32_t)time(NULL));
+        game_init(&app->game, new_game_seed(app));
         sync_render_board(app);
         clear_turn_anim(app);
         clear_particles(app);
@@ -410,52 +728,393 @@ static void handle_click(App *app, int x, int y) {
     }
 }
 
+/* Applies one SDL event; returns true if the frame must be redrawn. */
+static bool handle_event(App *app, const SDL_Event *event, bool *running) {
+    if (event->type == SDL_QUIT) {
+        *running = false;
+    } else if (event->type == SDL_MOUSEMOTION) {
+        return false;
+    } else if (event->type == SDL_RENDER_TARGETS_RESET) {
+        app->board_layer_valid = false;
+    } else if (event->type == SDL_RENDER_DEVICE_RESET) {
+        reload_device_textures(app);
+    } else if (event->type == SDL_MOUSEBUTTONDOWN && event->button.button == SDL_BUTTON_LEFT) {
+        handle_click(app, event->button.x, event->button.y);
+#ifdef LINES98_FRAME_STATS
+    } else if (event->type == SDL_KEYDOWN && event->key.keysym.sym == SDLK_F3) {
+        app->hud_visible = !app->hud_visible;
+#endif
+    } else if (event->type == SDL_KEYDOWN && event->key.keysym.sym == SDLK_r) {
+        game_init(&app->game, new_game_seed(app));
+        sync_render_board(app);
+        clear_turn_anim(app);
+        clear_particles(app);
+        audio_fx_play_restart(&app->audio);
+    }
+    return true;
+}
+
+/* Applies the pending event (if any) and everything queued behind it;
+   returns true if the frame must be redrawn. */
+static bool pump_events(App *app, SDL_Event *event, bool have_event, bool *running) {
+    bool redraw = false;
+    while (have_event) {
+        if (handle_event(app, event, running)) {
+            redraw = true;
+        }
+        have_event = SDL_PollEvent(event) != 0;
+    }
+    return redraw;
+}
+
+/* Returns true while something on screen moves without user input. */
+static bool scene_animating(const App *app) {
+    return turn_anim_active(&app->turn_anim) || particles_active_count(&app->particles) > 0;
+}
+
+#ifdef LINES98_FRAME_STATS
+/* Draws rolling p50/p99 stage times with bars against the 60 Hz frame budget. */
+static void draw_hud(SDL_Renderer *renderer, App *app) {
+    if (!app->hud_visible) {
+        return;
+    }
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 5, 8, 12, 210);
+    SDL_Rect panel = {8, 8, WINDOW_WIDTH - 16, 16 + (HUD_STAGE_COUNT + 1) * HUD_LINE_HEIGHT};
+    SDL_RenderFillRect(renderer, &panel);
+
+    char line[64];
+    snprintf(line, sizeof(line), "%-12s %7s %7s", "STAGE US", "P50", "P99");
+    ru_glyph_atlas_draw_text(&app->glyphs, renderer, 16, 16, HUD_SCALE, line, TEXT);
+
+    const FrameStats *stats = &app->frame_stats;
+    for (int stage = 0; stage < HUD_STAGE_COUNT; ++stage) {
+        float p50 = frame_stats_percentile(stats, stage, 0.50f);
+        float p99 = frame_stats_percentile(stats, stage, 0.99f);
+        int y = 16 + (stage + 1) * HUD_LINE_HEIGHT;
+        snprintf(line, sizeof(line), "%-12s %7.0f %7.0f", HUD_STAGE_NAMES[stage], p50, p99);
+        ru_glyph_atlas_draw_text(&app->glyphs, renderer, 16, y, HUD_SCALE, line, TEXT);
+
+        float share = SDL_min(1.0f, p99 / HUD_BUDGET_US);
+        if (p99 > HUD_BUDGET_US) {
+            SDL_SetRenderDrawColor(renderer, 229, 73, 81, 255);
+        } else if (p99 > HUD_BUDGET_US * 0.25f) {
+            SDL_SetRenderDrawColor(renderer, 248, 225, 68, 255);
+        } else {
+            SDL_SetRenderDrawColor(renderer, 110, 207, 93, 255);
+        }
+        SDL_Rect bar = {HUD_BAR_X, y, SDL_max(1, (int)(share * (float)HUD_BAR_WIDTH)), 12};
+        SDL_RenderFillRect(renderer, &bar);
+    }
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
+
+/* Records total frame time since frame_start and commits the frame. */
+static void commit_frame_stats(App *app, uint64_t frame_start) {
+    frame_stats_add(&app->frame_stats, HUD_STAGE_FRAME, (float)elapsed_us(frame_start, SDL_GetPerformanceCounter()));
+    frame_stats_end_frame(&app->frame_stats);
+}
+#endif
+
+/* Draws and presents one frame; fills per-stage times when times is not NULL. */
+static void render_frame(App *app, FrameTimes *times) {
+    SDL_Renderer *renderer = app->renderer;
+    uint64_t t0 = SDL_GetPerformanceCounter();
+    trace_begin("frame", "draw");
+
+    ru_set_color(renderer, BG);
+    SDL_RenderClear(renderer);
+
+    TIMED_STAGE(app, HUD_STAGE_DRAW_NEXT, draw_next_balls(renderer, app));
+    uint64_t t1 = SDL_GetPerformanceCounter();
+    TIMED_STAGE(app, HUD_STAGE_DRAW_SCORE, draw_score(renderer, app));
+    uint64_t t2 = SDL_GetPerformanceCounter();
+    TIMED_STAGE(app, HUD_STAGE_DRAW_BOARD, draw_board(renderer, app));
+    uint64_t t3 = SDL_GetPerformanceCounter();
+    TIMED_STAGE(app, HUD_STAGE_DRAW_MOVE, draw_move_animation(renderer, app));
+    uint64_t t4 = SDL_GetPerformanceCounter();
+    TIMED_STAGE(app, HUD_STAGE_DRAW_PARTICLES, draw_particles(renderer, app));
+    uint64_t t5 = SDL_GetPerformanceCounter();
+    TIMED_STAGE(app, HUD_STAGE_DRAW_OVERLAY, draw_overlay(renderer, app, app->game.game_over && !turn_anim_active(&app->turn_anim)));
+#ifdef LINES98_FRAME_STATS
+    TIMED_STAGE(app, HUD_STAGE_DRAW_HUD, draw_hud(renderer, app));
+#endif
+    trace_end("frame", "draw");
+
+    trace_begin("frame", "present");
+    TIMED_STAGE(app, HUD_STAGE_PRESENT, SDL_RenderPresent(renderer));
+    trace_end("frame", "present");
+    uint64_t t6 = SDL_GetPerformanceCounter();
+
+    if (times != NULL) {
+        times->stage_us[FRAME_STAGE_DRAW] = elapsed_us(t0, t6);
+        times->stage_us[FRAME_STAGE_BOARD] = elapsed_us(t2, t3);
+        times->stage_us[FRAME_STAGE_BALLS] = elapsed_us(t0, t1) + elapsed_us(t3, t4);
+        times->stage_us[FRAME_STAGE_PARTICLES] = elapsed_us(t4, t5);
+    }
+}
+
+/* Parses command-line flags; returns false and prints usage on bad input. */
+static bool parse_options(int argc, char **argv, RunOptions *options) {
+    options->headless = false;
+    options->frames = HEADLESS_DEFAULT_FRAMES;
+    options->seed = 1;
+    options->replay_path = NULL;
+    options->trace_path = SDL_getenv("LINES98_TRACE");
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "--headless") == 0) {
+            options->headless = true;
+        } else if (strcmp(arg, "--frames") == 0 && has_value) {
+            options->frames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            options->seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--replay") == 0 && has_value) {
+            options->replay_path = argv[++i];
+        } else if (strcmp(arg, "--trace") == 0 && has_value) {
+            options->trace_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--trace FILE] [--headless [--frames N] [--seed S] [--replay FILE]]\n", argv[0]);
+            return false;
+        }
+    }
+
+    if (options->frames <= 0) {
+        fprintf(stderr, "--frames must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+/* Scripted or replayed click source for headless runs. */
+typedef struct {
+    FILE *replay;
+    Rng rng;
+    int pending_x;
+    int pending_y;
+    bool has_pending;
+    int clicks;
+} ClickScript;
+
+/* Queues a click on the center of a board cell. */
+static void script_queue_cell(ClickScript *script, int idx) {
+    script->pending_x = ball_center_x(idx % GAME_BOARD_SIZE);
+    script->pending_y = ball_center_y(idx / GAME_BOARD_SIZE);
+    script->has_pending = true;
+}
+
+/* Picks a random legal move and queues its selection click; the target
+   click follows on the next idle frame. Returns false without a move. */
+static bool script_pick_move(ClickScript *script, const Game *game, int *target_idx) {
+    int balls[GAME_CELLS];
+    int empties[GAME_CELLS];
+    int ball_count = 0;
+    int empty_count = 0;
+    for (int idx = 0; idx < GAME_CELLS; ++idx) {
+        if (game->board[idx] != 0) {
+            balls[ball_count++] = idx;
+        } else {
+            empties[empty_count++] = idx;
+        }
+    }
+    if (ball_count == 0 || empty_count == 0) {
+        return false;
+    }
+
+    for (int attempt = 0; attempt < HEADLESS_PICK_ATTEMPTS; ++attempt) {
+        int from = balls[rng_range(&script->rng, (uint32_t)ball_count)];
+        int to = empties[rng_range(&script->rng, (uint32_t)empty_count)];
+        if (game_can_reach(game, from / GAME_BOARD_SIZE, from % GAME_BOARD_SIZE, to / GAME_BOARD_SIZE, to % GAME_BOARD_SIZE)) {
+            script_queue_cell(script, from);
+            *target_idx = to;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Produces the next click for an idle scene; returns false when none is due. */
+static bool script_next_click(ClickScript *script, const App *app, int *x, int *y) {
+    if (script->has_pending) {
+        script->has_pending = false;
+        *x = script->pending_x;
+        *y = script->pending_y;
+        return true;
+    }
+
+    if (script->replay != NULL) {
+        return fscanf(script->replay, "%d %d", x, y) == 2;
+    }
+
+    int target = -1;
+    if (app->game.game_over || !script_pick_move(script, &app->game, &target)) {
+        /* Any click restarts after game over; an unreachable board gets an
+           invalid click so the run keeps moving. */
+        *x = ball_center_x(0);
+        *y = ball_center_y(0);
+        return true;
+    }
+
+    *x = script->pending_x;
+    *y = script->pending_y;
+    script_queue_cell(script, target);
+    return true;
+}
+
+/* Compares doubles for qsort. */
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+/* Prints mean/median/p99/max of one stage over all frames; sorts samples. */
+static void report_stage(const char *name, double *samples, int count) {
+    qsort(samples, (size_t)count, sizeof(double), compare_double);
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i) {
+        sum += samples[i];
+    }
+    int p99 = (int)((double)(count - 1) * 0.99);
+    printf("%-10s %10.1f %10.1f %10.1f %10.1f\n", name, sum / count, samples[count / 2], samples[p99], samples[count - 1]);
+}
+
+/* Runs a fixed number of frames offscreen with a fixed frame time, feeding
+   scripted or replayed clicks through handle_click, and prints per-stage
+   CPU times. */
+static int run_headless(App *app, const RunOptions *options) {
+    static const char *const STAGE_NAMES[FRAME_STAGE_COUNT] = {"update", "draw", "board", "balls", "particles"};
+
+    ClickScript script;
+    memset(&script, 0, sizeof(script));
+    rng_seed(&script.rng, options->seed ^ 0x5EEDu);
+    if (options->replay_path != NULL) {
+        script.replay = fopen(options->replay_path, "r");
+        if (script.replay == NULL) {
+            fprintf(stderr, "Cannot open replay file %s\n", options->replay_path);
+            return 1;
+        }
+    }
+
+    double *samples = (double *)malloc((size_t)options->frames * FRAME_STAGE_COUNT * sizeof(double));
+    if (samples == NULL) {
+        if (script.replay != NULL) {
+            fclose(script.replay);
+        }
+        return 1;
+    }
+
+    for (int frame = 0; frame < options->frames; ++frame) {
+#ifdef LINES98_FRAME_STATS
+        uint64_t frame_start = SDL_GetPerformanceCounter();
+#endif
+        int x;
+        int y;
+        if (!scene_animating(app) && script_next_click(&script, app, &x, &y)) {
+            handle_click(app, x, y);
+            ++script.clicks;
+        }
+
+        FrameTimes times;
+        trace_begin("frame", "frame");
+        uint64_t update_start = SDL_GetPerformanceCounter();
+        advance_simulation(app, HEADLESS_FRAME_TIME);
+        times.stage_us[FRAME_STAGE_UPDATE] = elapsed_us(update_start, SDL_GetPerformanceCounter());
+        render_frame(app, &times);
+        trace_end("frame", "frame");
+#ifdef LINES98_FRAME_STATS
+        commit_frame_stats(app, frame_start);
+#endif
+
+        for (int stage = 0; stage < FRAME_STAGE_COUNT; ++stage) {
+            samples[stage * options->frames + frame] = times.stage_us[stage];
+        }
+    }
+
+    printf("headless: frames=%d seed=%u clicks=%d score=%d\n", options->frames, options->seed, script.clicks, app->game.score);
+    printf("%-10s %10s %10s %10s %10s\n", "stage", "mean_us", "p50_us", "p99_us", "max_us");
+    for (int stage = 0; stage < FRAME_STAGE_COUNT; ++stage) {
+        report_stage(STAGE_NAMES[stage], samples + stage * options->frames, options->frames);
+    }
+
+    free(samples);
+    if (script.replay != NULL) {
+        fclose(script.replay);
+    }
+    return 0;
+}
+
 /* Runs SDL event loop, frame updates and rendering. */
-int main(void) {
-    App app;
-    if (!app_init(&app)) {
+int main(int argc, char **argv) {
+    RunOptions options;
+    if (!parse_options(argc, argv, &options)) {
+        return 2;
+    }
+
+    if (options.trace_path != NULL && options.trace_path[0] != '\0') {
+        trace_start(options.trace_path);
+        trace_set_thread_name("main");
+    }
+
+    /* Static: the particle arrays alone are several hundred KiB, too much
+       for the main thread's stack on some platforms. */
+    static App app;
+    if (!app_init(&app, &options)) {
         app_shutdown(&app);
         return 1;
     }
 
+    if (options.headless) {
+        int status = run_headless(&app, &options);
+        app_shutdown(&app);
+        return status;
+    }
+
     bool running = true;
-    uint32_t prev_ticks = SDL_GetTicks();
+    bool redraw = true;
+    const double counter_freq = (double)SDL_GetPerformanceFrequency();
+    uint64_t prev_counter = SDL_GetPerformanceCounter();
     while (running) {
-        uint32_t now = SDL_GetTicks();
-        float dt = (float)(now - prev_ticks) / 1000.0f;
-        if (dt > 0.033f) {
-            dt = 0.033f;
-        }
-        prev_ticks = now;
-
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                running = false;
-            } else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
-                handle_click(&app, event.button.x, event.button.y);
-            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_r) {
-                game_init(&app.game, (uint32_t)time(NULL));
-                sync_render_board(&app);
-                clear_turn_anim(&app);
-                clear_particles(&app);
-                audio_fx_play_restart(&app.audio);
+        bool have_event;
+        if (!redraw && !scene_animating(&app)) {
+            /* Static scene: sleep in the event queue instead of spinning on vsync. */
+            have_event = SDL_WaitEventTimeout(&event, IDLE_WAIT_TIMEOUT_MS) != 0;
+            prev_counter = SDL_GetPerformanceCounter();
+            app.sim_accumulator = 0.0f;
+            if (!have_event) {
+                continue;
             }
+        } else {
+            have_event = SDL_PollEvent(&event) != 0;
         }
-        update_turn_animation(&app, dt);
-        update_particles(&app, dt);
 
-        ru_set_color(app.renderer, BG);
-        SDL_RenderClear(app.renderer);
+#ifdef LINES98_FRAME_STATS
+        uint64_t frame_start = SDL_GetPerformanceCounter();
+#endif
+        bool changed = false;
+        TIMED_STAGE(&app, HUD_STAGE_EVENTS, changed = pump_events(&app, &event, have_event, &running));
+        redraw = redraw || changed;
+        if (!redraw && !scene_animating(&app)) {
+            continue;
+        }
 
-        draw_next_balls(app.renderer, &app.game);
-        draw_score(app.renderer, app.game.score);
-        draw_board(app.renderer, &app);
-        draw_move_animation(app.renderer, &app);
-        draw_particles(app.renderer, &app);
-        draw_overlay(app.renderer, &app.game, app.game.game_over && !turn_anim_active(&app.turn_anim));
+        uint64_t now = SDL_GetPerformanceCounter();
+        float frame_time = (float)((double)(now - prev_counter) / counter_freq);
+        prev_counter = now;
 
-        SDL_RenderPresent(app.renderer);
+        trace_begin("frame", "frame");
+        advance_simulation(&app, frame_time);
+        render_frame(&app, NULL);
+        trace_end("frame", "frame");
+#ifdef LINES98_FRAME_STATS
+        commit_frame_stats(&app, frame_start);
+#endif
+        redraw = false;
     }
 
     app_shutdown(&app);
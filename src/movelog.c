@@ -0,0 +1,326 @@
+/* Write-ahead move journal.
+   Records are fixed 16-byte frames with a CRC so recovery can tell a torn
+   tail from data. Appenders never touch the file: they fill the pending
+   buffer under the lock, and the I/O thread turns everything gathered
+   since its last commit into one write plus one fdatasync. */
+
+#include "movelog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* A batch this full commits without waiting out the window. */
+#define MOVELOG_EARLY_COMMIT_BYTES (MOVELOG_BUFFER_BYTES / 2)
+
+/* CRC-32 (IEEE) of len bytes. */
+uint32_t movelog_crc32(const uint8_t *data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/* Stores v little-endian. */
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* Loads a little-endian u32. */
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* Serializes a record with its CRC. */
+static void encode_record(const MoveLogRecord *record, uint8_t *out) {
+    put_u32(out + 4, record->session);
+    put_u32(out + 8, record->seed);
+    out[12] = record->type;
+    out[13] = record->a;
+    out[14] = record->b;
+    out[15] = 0;
+    put_u32(out, movelog_crc32(out + 4, MOVELOG_RECORD_SIZE - 4));
+}
+
+/* Parses a record; returns false if its CRC or padding is wrong. */
+static bool decode_record(const uint8_t *in, MoveLogRecord *record) {
+    if (get_u32(in) != movelog_crc32(in + 4, MOVELOG_RECORD_SIZE - 4) || in[15] != 0) {
+        return false;
+    }
+    record->session = get_u32(in + 4);
+    record->seed = get_u32(in + 8);
+    record->type = in[12];
+    record->a = in[13];
+    record->b = in[14];
+    return true;
+}
+
+/* Milliseconds on the monotonic clock. */
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/* Writes all bytes at the current offset. */
+static bool write_all(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/* Replays intact records and returns the length of the valid prefix, or -1
+   on a read error. */
+static off_t recover(int fd, MoveLogReplay replay, void *ctx) {
+    static uint8_t chunk[MOVELOG_RECORD_SIZE * 4096];
+    off_t valid = 0;
+    for (;;) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        size_t whole = (size_t)n / MOVELOG_RECORD_SIZE * MOVELOG_RECORD_SIZE;
+        for (size_t pos = 0; pos < whole; pos += MOVELOG_RECORD_SIZE) {
+            MoveLogRecord record;
+            if (!decode_record(chunk + pos, &record)) {
+                return valid;
+            }
+            if (replay != NULL) {
+                replay(ctx, &record);
+            }
+            valid += MOVELOG_RECORD_SIZE;
+        }
+        /* A short read mid-file only happens at the (torn) end. */
+        if ((size_t)n < sizeof(chunk)) {
+            return valid;
+        }
+    }
+}
+
+/* Opens or creates the log at path, replays every intact record through
+   replay, and truncates a torn or corrupt tail. Returns false and prints
+   the reason on I/O failure. */
+bool movelog_open(MoveLog *log, const char *path, int window_ms, MoveLogReplay replay, void *ctx) {
+    memset(log, 0, sizeof(*log));
+    log->window_ms = window_ms > 0 ? window_ms : 0;
+    atomic_init(&log->durable_lsn, 0);
+    atomic_init(&log->commits, 0);
+    atomic_init(&log->records, 0);
+
+    log->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (log->fd < 0) {
+        perror(path);
+        return false;
+    }
+    off_t valid = recover(log->fd, replay, ctx);
+    if (valid < 0 || ftruncate(log->fd, valid) != 0 || lseek(log->fd, valid, SEEK_SET) != valid ||
+        fdatasync(log->fd) != 0) {
+        perror(path);
+        close(log->fd);
+        log->fd = -1;
+        return false;
+    }
+    log->appended_lsn = (uint64_t)valid;
+    atomic_store(&log->durable_lsn, (uint64_t)valid);
+
+    log->pending = (uint8_t *)malloc(MOVELOG_BUFFER_BYTES);
+    log->writing = (uint8_t *)malloc(MOVELOG_BUFFER_BYTES);
+    if (log->pending == NULL || log->writing == NULL) {
+        fprintf(stderr, "Cannot allocate move log buffers\n");
+        free(log->pending);
+        free(log->writing);
+        log->pending = NULL;
+        log->writing = NULL;
+        close(log->fd);
+        log->fd = -1;
+        return false;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->io_cond, &attr);
+    pthread_cond_init(&log->space_cond, NULL);
+    pthread_condattr_destroy(&attr);
+    return true;
+}
+
+/* Discards every record and starts the log over with head alone, synced
+   before returning; LSNs restart from there. Only before start, once the
+   replayed state has been saved elsewhere. */
+bool movelog_restart(MoveLog *log, const MoveLogRecord *head) {
+    if (log->started) {
+        return false;
+    }
+    uint8_t frame[MOVELOG_RECORD_SIZE];
+    encode_record(head, frame);
+    if (ftruncate(log->fd, 0) != 0 || lseek(log->fd, 0, SEEK_SET) != 0 || !write_all(log->fd, frame, sizeof(frame)) ||
+        fdatasync(log->fd) != 0) {
+        perror("move log restart");
+        return false;
+    }
+    log->appended_lsn = MOVELOG_RECORD_SIZE;
+    atomic_store(&log->durable_lsn, (uint64_t)MOVELOG_RECORD_SIZE);
+    return true;
+}
+
+/* Registers an eventfd to be signalled after each commit (before start). */
+bool movelog_add_notify(MoveLog *log, int fd) {
+    if (log->started || log->notify_count >= MOVELOG_MAX_NOTIFY) {
+        return false;
+    }
+    log->notify_fds[log->notify_count++] = fd;
+    return true;
+}
+
+/* Waits for the batch to fill or its window to close; lock held. */
+static void wait_window(MoveLog *log) {
+    uint64_t deadline = log->first_pending_ms + (uint64_t)log->window_ms;
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline / 1000u);
+    ts.tv_nsec = (long)(deadline % 1000u) * 1000000L;
+    while (!log->closing && log->pending_len < MOVELOG_EARLY_COMMIT_BYTES && monotonic_ms() < deadline) {
+        if (pthread_cond_timedwait(&log->io_cond, &log->lock, &ts) == ETIMEDOUT) {
+            break;
+        }
+    }
+}
+
+/* I/O thread: one write and one fdatasync per gathered batch. */
+static void *io_main(void *data) {
+    MoveLog *log = (MoveLog *)data;
+    pthread_mutex_lock(&log->lock);
+    for (;;) {
+        while (!log->closing && log->pending_len == 0) {
+            pthread_cond_wait(&log->io_cond, &log->lock);
+        }
+        if (log->pending_len == 0) {
+            break;
+        }
+        if (log->window_ms > 0) {
+            wait_window(log);
+        }
+
+        uint8_t *batch = log->pending;
+        size_t len = log->pending_len;
+        uint64_t lsn = log->appended_lsn;
+        log->pending = log->writing;
+        log->writing = batch;
+        log->pending_len = 0;
+        pthread_cond_broadcast(&log->space_cond);
+        pthread_mutex_unlock(&log->lock);
+
+        /* After a failed fsync the kernel may have dropped the dirty pages,
+           so retrying proves nothing; stop rather than acknowledge moves
+           that may not be on disk. */
+        if (!write_all(log->fd, batch, len) || fdatasync(log->fd) != 0) {
+            perror("move log commit");
+            abort();
+        }
+        atomic_store(&log->durable_lsn, lsn);
+        atomic_fetch_add_explicit(&log->commits, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&log->records, len / MOVELOG_RECORD_SIZE, memory_order_relaxed);
+        for (int i = 0; i < log->notify_count; ++i) {
+            uint64_t one = 1;
+            ssize_t n = write(log->notify_fds[i], &one, sizeof(one));
+            (void)n;
+        }
+
+        pthread_mutex_lock(&log->lock);
+    }
+    pthread_mutex_unlock(&log->lock);
+    return NULL;
+}
+
+/* Starts the I/O thread. */
+bool movelog_start(MoveLog *log) {
+    if (pthread_create(&log->thread, NULL, io_main, log) != 0) {
+        fprintf(stderr, "Cannot start move log thread\n");
+        return false;
+    }
+    log->started = true;
+    return true;
+}
+
+/* Queues one record and returns its LSN; blocks while the pending buffer
+   is full. */
+uint64_t movelog_append(MoveLog *log, const MoveLogRecord *record) {
+    pthread_mutex_lock(&log->lock);
+    while (log->pending_len + MOVELOG_RECORD_SIZE > MOVELOG_BUFFER_BYTES) {
+        pthread_cond_wait(&log->space_cond, &log->lock);
+    }
+    if (log->pending_len == 0) {
+        log->first_pending_ms = log->window_ms > 0 ? monotonic_ms() : 0;
+        pthread_cond_signal(&log->io_cond);
+    } else if (log->pending_len + MOVELOG_RECORD_SIZE == MOVELOG_EARLY_COMMIT_BYTES) {
+        pthread_cond_signal(&log->io_cond);
+    }
+    encode_record(record, log->pending + log->pending_len);
+    log->pending_len += MOVELOG_RECORD_SIZE;
+    log->appended_lsn += MOVELOG_RECORD_SIZE;
+    uint64_t lsn = log->appended_lsn;
+    pthread_mutex_unlock(&log->lock);
+    return lsn;
+}
+
+/* Returns the LSN just past the last appended record. */
+uint64_t movelog_appended(MoveLog *log) {
+    pthread_mutex_lock(&log->lock);
+    uint64_t lsn = log->appended_lsn;
+    pthread_mutex_unlock(&log->lock);
+    return lsn;
+}
+
+/* Returns the LSN up to which records are on stable storage. */
+uint64_t movelog_durable(MoveLog *log) {
+    return atomic_load(&log->durable_lsn);
+}
+
+/* Commits everything queued, stops the I/O thread and closes the file.
+   Safe on a zeroed or failed-to-open log. */
+void movelog_close(MoveLog *log) {
+    if (log->pending == NULL) {
+        return;
+    }
+    if (log->started) {
+        pthread_mutex_lock(&log->lock);
+        log->closing = true;
+        pthread_cond_signal(&log->io_cond);
+        pthread_mutex_unlock(&log->lock);
+        pthread_join(log->thread, NULL);
+        log->started = false;
+    }
+    pthread_mutex_destroy(&log->lock);
+    pthread_cond_destroy(&log->io_cond);
+    pthread_cond_destroy(&log->space_cond);
+    free(log->pending);
+    free(log->writing);
+    log->pending = NULL;
+    log->writing = NULL;
+    close(log->fd);
+    log->fd = -1;
+}
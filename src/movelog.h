@@ -0,0 +1,87 @@
+#ifndef MOVELOG_H
+#define MOVELOG_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MOVELOG_RECORD_SIZE 16
+#define MOVELOG_BUFFER_BYTES (1 << 20)
+#define MOVELOG_MAX_NOTIFY 64
+
+/* One journaled request: type is the protocol request type (new game,
+   select or move); seed is set for new games, a/b hold the cell or the
+   from/to pair. Stored as crc32 | session | seed | type a b 0, LE. */
+typedef struct {
+    uint32_t session;
+    uint32_t seed;
+    uint8_t type;
+    uint8_t a;
+    uint8_t b;
+} MoveLogRecord;
+
+/* Called once per valid record during recovery, in log order. */
+typedef void (*MoveLogReplay)(void *ctx, const MoveLogRecord *record);
+
+/* Append-only move journal with group commit. Appenders copy records into
+   the pending buffer and get back the log position (LSN, the byte offset
+   just past the record); one I/O thread swaps buffers, writes and
+   fdatasyncs a whole batch, publishes the durable LSN and pokes the
+   registered eventfds. window_ms lets a batch gather before committing. */
+typedef struct {
+    int fd;
+    int window_ms;
+    pthread_t thread;
+    bool started;
+    bool closing;
+    pthread_mutex_t lock;
+    pthread_cond_t io_cond;
+    pthread_cond_t space_cond;
+    uint8_t *pending;
+    uint8_t *writing;
+    size_t pending_len;
+    uint64_t first_pending_ms;
+    uint64_t appended_lsn;
+    atomic_ullong durable_lsn;
+    atomic_ullong commits;
+    atomic_ullong records;
+    int notify_fds[MOVELOG_MAX_NOTIFY];
+    int notify_count;
+} MoveLog;
+
+/* Opens or creates the log at path, replays every intact record through
+   replay, and truncates a torn or corrupt tail. Returns false and prints
+   the reason on I/O failure. */
+bool movelog_open(MoveLog *log, const char *path, int window_ms, MoveLogReplay replay, void *ctx);
+
+/* Discards every record and starts the log over with head alone, synced
+   before returning; LSNs restart from there. Only before start, once the
+   replayed state has been saved elsewhere. */
+bool movelog_restart(MoveLog *log, const MoveLogRecord *head);
+
+/* Registers an eventfd to be signalled after each commit (before start). */
+bool movelog_add_notify(MoveLog *log, int fd);
+
+/* Starts the I/O thread. */
+bool movelog_start(MoveLog *log);
+
+/* Queues one record and returns its LSN; blocks while the pending buffer
+   is full. */
+uint64_t movelog_append(MoveLog *log, const MoveLogRecord *record);
+
+/* Returns the LSN just past the last appended record. */
+uint64_t movelog_appended(MoveLog *log);
+
+/* Returns the LSN up to which records are on stable storage. */
+uint64_t movelog_durable(MoveLog *log);
+
+/* Commits everything queued, stops the I/O thread and closes the file.
+   Safe on a zeroed or failed-to-open log. */
+void movelog_close(MoveLog *log);
+
+/* CRC-32 (IEEE) of len bytes. */
+uint32_t movelog_crc32(const uint8_t *data, size_t len);
+
+#endif
@@ -0,0 +1,508 @@
+/* Compact binary protocol for hosted games.
+   Frames are length-prefixed and little-endian; bodies hold only cell
+   indices and counts, so a full move reply stays well under one packet.
+   This module is socket-free: it encodes, decodes and applies requests. */
+
+#include "protocol.h"
+
+#include <string.h>
+
+#include "turn_controller.h"
+
+/* Bounded little-endian writer over a caller buffer. */
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool ok;
+} ProtoWriter;
+
+/* Bounded little-endian reader over one frame body. */
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+    bool ok;
+} ProtoReader;
+
+/* Appends one byte. */
+static void put_u8(ProtoWriter *w, uint8_t v) {
+    if (w->len + 1 > w->cap) {
+        w->ok = false;
+        return;
+    }
+    w->buf[w->len++] = v;
+}
+
+/* Appends a little-endian u16. */
+static void put_u16(ProtoWriter *w, uint16_t v) {
+    put_u8(w, (uint8_t)v);
+    put_u8(w, (uint8_t)(v >> 8));
+}
+
+/* Appends a little-endian u32. */
+static void put_u32(ProtoWriter *w, uint32_t v) {
+    put_u16(w, (uint16_t)v);
+    put_u16(w, (uint16_t)(v >> 16));
+}
+
+/* Appends a little-endian u64. */
+static void put_u64(ProtoWriter *w, uint64_t v) {
+    put_u32(w, (uint32_t)v);
+    put_u32(w, (uint32_t)(v >> 32));
+}
+
+/* Appends raw bytes. */
+static void put_bytes(ProtoWriter *w, const uint8_t *src, size_t n) {
+    if (w->len + n > w->cap) {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->buf + w->len, src, n);
+    w->len += n;
+}
+
+/* Reads one byte; zero once the frame is exhausted. */
+static uint8_t get_u8(ProtoReader *r) {
+    if (r->pos + 1 > r->len) {
+        r->ok = false;
+        return 0;
+    }
+    return r->buf[r->pos++];
+}
+
+/* Reads a little-endian u16. */
+static uint16_t get_u16(ProtoReader *r) {
+    uint16_t lo = get_u8(r);
+    uint16_t hi = get_u8(r);
+    return (uint16_t)(lo | hi << 8);
+}
+
+/* Reads a little-endian u32. */
+static uint32_t get_u32(ProtoReader *r) {
+    uint32_t lo = get_u16(r);
+    uint32_t hi = get_u16(r);
+    return lo | hi << 16;
+}
+
+/* Reads a little-endian u64. */
+static uint64_t get_u64(ProtoReader *r) {
+    uint64_t lo = get_u32(r);
+    uint64_t hi = get_u32(r);
+    return lo | hi << 32;
+}
+
+/* Reads raw bytes. */
+static void get_bytes(ProtoReader *r, uint8_t *dst, size_t n) {
+    if (r->pos + n > r->len) {
+        r->ok = false;
+        return;
+    }
+    memcpy(dst, r->buf + r->pos, n);
+    r->pos += n;
+}
+
+/* Reads a count-prefixed cell list of at most GAME_CELLS entries. */
+static uint8_t get_cells(ProtoReader *r, uint8_t *cells) {
+    uint8_t count = get_u8(r);
+    if (count > GAME_CELLS) {
+        r->ok = false;
+        return 0;
+    }
+    get_bytes(r, cells, count);
+    return count;
+}
+
+/* Appends the board packed 3 bits per cell, low bits first. */
+static void put_packed_board(ProtoWriter *w, const uint8_t *board) {
+    uint8_t packed[PROTO_PACKED_BOARD_BYTES];
+    memset(packed, 0, sizeof(packed));
+    for (int i = 0; i < GAME_CELLS; ++i) {
+        unsigned bit = (unsigned)i * 3u;
+        unsigned value = (unsigned)(board[i] & 0x7u) << (bit & 7u);
+        packed[bit >> 3] |= (uint8_t)value;
+        if ((bit & 7u) > 5u) {
+            packed[(bit >> 3) + 1] |= (uint8_t)(value >> 8);
+        }
+    }
+    put_bytes(w, packed, sizeof(packed));
+}
+
+/* Reads a board packed by put_packed_board. */
+static void get_packed_board(ProtoReader *r, uint8_t *board) {
+    uint8_t packed[PROTO_PACKED_BOARD_BYTES];
+    get_bytes(r, packed, sizeof(packed));
+    if (!r->ok) {
+        return;
+    }
+    for (int i = 0; i < GAME_CELLS; ++i) {
+        unsigned bit = (unsigned)i * 3u;
+        unsigned value = packed[bit >> 3];
+        if ((bit & 7u) > 5u) {
+            value |= (unsigned)packed[(bit >> 3) + 1] << 8;
+        }
+        board[i] = (uint8_t)((value >> (bit & 7u)) & 0x7u);
+    }
+}
+
+/* Writes the common header; the length is patched by finish_frame. */
+static void put_header(ProtoWriter *w, uint8_t type, uint8_t status, uint32_t session, uint32_t tag) {
+    put_u16(w, 0);
+    put_u8(w, type);
+    put_u8(w, status);
+    put_u32(w, session);
+    put_u32(w, tag);
+}
+
+/* Patches the frame length; returns frame bytes or -1 on overflow. */
+static int finish_frame(ProtoWriter *w) {
+    if (!w->ok || w->len > PROTO_MAX_FRAME) {
+        return -1;
+    }
+    w->buf[0] = (uint8_t)w->len;
+    w->buf[1] = (uint8_t)(w->len >> 8);
+    return (int)w->len;
+}
+
+/* Splits off one frame: returns its length, 0 if incomplete, -1 if bad. */
+static int frame_length(const uint8_t *buf, size_t len) {
+    if (len < 2) {
+        return 0;
+    }
+    size_t frame = (size_t)buf[0] | (size_t)buf[1] << 8;
+    if (frame < PROTO_HEADER_SIZE || frame > PROTO_MAX_FRAME) {
+        return -1;
+    }
+    return len < frame ? 0 : (int)frame;
+}
+
+/* Encodes a request; returns frame bytes or -1 if cap is too small. */
+int proto_encode_request(const ProtoRequest *req, uint8_t *buf, size_t cap) {
+    ProtoWriter w = {buf, cap, 0, true};
+    put_header(&w, req->type, 0, req->session, req->tag);
+    switch (req->type) {
+    case PROTO_NEW_GAME:
+        put_u32(&w, req->seed);
+        put_u64(&w, req->token);
+        break;
+    case PROTO_SELECT:
+        put_u8(&w, req->cell);
+        put_u64(&w, req->token);
+        break;
+    case PROTO_MOVE:
+        put_u8(&w, req->from);
+        put_u8(&w, req->to);
+        put_u64(&w, req->token);
+        break;
+    case PROTO_TOP:
+        put_u32(&w, req->offset);
+        put_u8(&w, req->count);
+        break;
+    case PROTO_RANK:
+        put_u32(&w, (uint32_t)req->score);
+        break;
+    default:
+        break;
+    }
+    return finish_frame(&w);
+}
+
+/* Decodes one request frame from buf. Returns consumed bytes, 0 when more
+   input is needed, or -1 for a malformed frame. */
+int proto_decode_request(const uint8_t *buf, size_t len, ProtoRequest *out) {
+    int frame = frame_length(buf, len);
+    if (frame <= 0) {
+        return frame;
+    }
+
+    ProtoReader r = {buf, (size_t)frame, 2, true};
+    memset(out, 0, sizeof(*out));
+    out->type = get_u8(&r);
+    (void)get_u8(&r);
+    out->session = get_u32(&r);
+    out->tag = get_u32(&r);
+    switch (out->type) {
+    case PROTO_NEW_GAME:
+        out->seed = get_u32(&r);
+        out->token = get_u64(&r);
+        break;
+    case PROTO_SELECT:
+        out->cell = get_u8(&r);
+        out->token = get_u64(&r);
+        break;
+    case PROTO_MOVE:
+        out->from = get_u8(&r);
+        out->to = get_u8(&r);
+        out->token = get_u64(&r);
+        break;
+    case PROTO_TOP:
+        out->offset = get_u32(&r);
+        out->count = get_u8(&r);
+        break;
+    case PROTO_RANK:
+        out->score = (int32_t)get_u32(&r);
+        break;
+    case PROTO_STATE:
+    case PROTO_WATCH:
+        break;
+    default:
+        return -1;
+    }
+    return r.ok && r.pos == r.len ? frame : -1;
+}
+
+/* Encodes a reply; returns frame bytes or -1 if cap is too small. */
+int proto_encode_reply(const ProtoReply *reply, uint8_t *buf, size_t cap) {
+    ProtoWriter w = {buf, cap, 0, true};
+    put_header(&w, reply->type, reply->status, reply->session, reply->tag);
+    switch (reply->type) {
+    case PROTO_REPLY_STATE:
+        put_bytes(&w, reply->board, GAME_CELLS);
+        put_bytes(&w, reply->next_colors, GAME_NEXT_COUNT);
+        put_u32(&w, (uint32_t)reply->score);
+        put_u8(&w, (uint8_t)reply->selected);
+        put_u8(&w, reply->game_over ? 1 : 0);
+        put_u64(&w, reply->token);
+        break;
+    case PROTO_REPLY_SELECT:
+        put_u8(&w, reply->action);
+        put_u8(&w, (uint8_t)reply->selected);
+        break;
+    case PROTO_REPLY_MOVE:
+        put_u8(&w, reply->action);
+        put_u8(&w, (uint8_t)reply->selected);
+        put_u8(&w, reply->game_over ? 1 : 0);
+        put_u32(&w, (uint32_t)reply->score);
+        put_u32(&w, (uint32_t)reply->score_delta);
+        put_bytes(&w, reply->next_colors, GAME_NEXT_COUNT);
+        put_u8(&w, reply->path_len);
+        put_bytes(&w, reply->path, reply->path_len);
+        put_u8(&w, reply->cleared_count);
+        put_bytes(&w, reply->cleared, reply->cleared_count);
+        put_u8(&w, reply->spawned_count);
+        put_bytes(&w, reply->spawned, reply->spawned_count);
+        put_bytes(&w, reply->spawned_color, reply->spawned_count);
+        break;
+    case PROTO_KEYFRAME:
+        put_u32(&w, reply->seq);
+        put_packed_board(&w, reply->board);
+        put_bytes(&w, reply->next_colors, GAME_NEXT_COUNT);
+        put_u32(&w, (uint32_t)reply->score);
+        put_u8(&w, reply->game_over ? 1 : 0);
+        break;
+    case PROTO_DELTA:
+        put_u32(&w, reply->seq);
+        put_u8(&w, reply->action);
+        put_u8(&w, reply->game_over ? 1 : 0);
+        put_u32(&w, (uint32_t)reply->score);
+        put_u32(&w, (uint32_t)reply->score_delta);
+        put_bytes(&w, reply->next_colors, GAME_NEXT_COUNT);
+        put_u8(&w, reply->path_len);
+        put_bytes(&w, reply->path, reply->path_len);
+        put_u8(&w, reply->cleared_count);
+        put_bytes(&w, reply->cleared, reply->cleared_count);
+        put_u8(&w, reply->spawned_count);
+        put_bytes(&w, reply->spawned, reply->spawned_count);
+        put_bytes(&w, reply->spawned_color, reply->spawned_count);
+        break;
+    case PROTO_REPLY_TOP:
+        put_u32(&w, reply->total);
+        put_u8(&w, reply->entry_count);
+        for (int i = 0; i < reply->entry_count; ++i) {
+            put_u32(&w, reply->entry_session[i]);
+            put_u32(&w, (uint32_t)reply->entry_score[i]);
+        }
+        break;
+    case PROTO_REPLY_RANK:
+        put_u32(&w, reply->rank);
+        put_u32(&w, reply->total);
+        break;
+    default:
+        break;
+    }
+    return finish_frame(&w);
+}
+
+/* Decodes one reply frame from buf. Returns consumed bytes, 0 when more
+   input is needed, or -1 for a malformed frame. */
+int proto_decode_reply(const uint8_t *buf, size_t len, ProtoReply *out) {
+    int frame = frame_length(buf, len);
+    if (frame <= 0) {
+        return frame;
+    }
+
+    ProtoReader r = {buf, (size_t)frame, 2, true};
+    memset(out, 0, sizeof(*out));
+    out->selected = -1;
+    out->type = get_u8(&r);
+    out->status = get_u8(&r);
+    out->session = get_u32(&r);
+    out->tag = get_u32(&r);
+    switch (out->type) {
+    case PROTO_REPLY_STATE:
+        get_bytes(&r, out->board, GAME_CELLS);
+        get_bytes(&r, out->next_colors, GAME_NEXT_COUNT);
+        out->score = (int32_t)get_u32(&r);
+        out->selected = (int8_t)get_u8(&r);
+        out->game_over = get_u8(&r) != 0;
+        out->token = get_u64(&r);
+        break;
+    case PROTO_REPLY_SELECT:
+        out->action = get_u8(&r);
+        out->selected = (int8_t)get_u8(&r);
+        break;
+    case PROTO_REPLY_MOVE:
+        out->action = get_u8(&r);
+        out->selected = (int8_t)get_u8(&r);
+        out->game_over = get_u8(&r) != 0;
+        out->score = (int32_t)get_u32(&r);
+        out->score_delta = (int32_t)get_u32(&r);
+        get_bytes(&r, out->next_colors, GAME_NEXT_COUNT);
+        out->path_len = get_cells(&r, out->path);
+        out->cleared_count = get_cells(&r, out->cleared);
+        out->spawned_count = get_cells(&r, out->spawned);
+        get_bytes(&r, out->spawned_color, out->spawned_count);
+        break;
+    case PROTO_KEYFRAME:
+        out->seq = get_u32(&r);
+        get_packed_board(&r, out->board);
+        get_bytes(&r, out->next_colors, GAME_NEXT_COUNT);
+        out->score = (int32_t)get_u32(&r);
+        out->game_over = get_u8(&r) != 0;
+        break;
+    case PROTO_DELTA:
+        out->seq = get_u32(&r);
+        out->action = get_u8(&r);
+        out->game_over = get_u8(&r) != 0;
+        out->score = (int32_t)get_u32(&r);
+        out->score_delta = (int32_t)get_u32(&r);
+        get_bytes(&r, out->next_colors, GAME_NEXT_COUNT);
+        out->path_len = get_cells(&r, out->path);
+        out->cleared_count = get_cells(&r, out->cleared);
+        out->spawned_count = get_cells(&r, out->spawned);
+        get_bytes(&r, out->spawned_color, out->spawned_count);
+        break;
+    case PROTO_REPLY_TOP:
+        out->total = get_u32(&r);
+        out->entry_count = get_u8(&r);
+        if (out->entry_count > PROTO_MAX_ENTRIES) {
+            return -1;
+        }
+        for (int i = 0; i < out->entry_count; ++i) {
+            out->entry_session[i] = get_u32(&r);
+            out->entry_score[i] = (int32_t)get_u32(&r);
+        }
+        break;
+    case PROTO_REPLY_RANK:
+        out->rank = get_u32(&r);
+        out->total = get_u32(&r);
+        break;
+    case PROTO_REPLY_WATCH:
+    case PROTO_REPLY_ERROR:
+        break;
+    default:
+        return -1;
+    }
+    return r.ok && r.pos == r.len ? frame : -1;
+}
+
+/* Fills an error reply for req. */
+void proto_error_reply(const ProtoRequest *req, ProtoStatus status, ProtoReply *out) {
+    memset(out, 0, sizeof(*out));
+    out->type = PROTO_REPLY_ERROR;
+    out->status = (uint8_t)status;
+    out->session = req->session;
+    out->tag = req->tag;
+    out->selected = -1;
+}
+
+/* Copies the full observable game state into a STATE reply. */
+static void fill_state(const Game *game, ProtoReply *out) {
+    out->type = PROTO_REPLY_STATE;
+    memcpy(out->board, game->board, GAME_CELLS);
+    memcpy(out->next_colors, game->next_colors, GAME_NEXT_COUNT);
+    out->score = game->score;
+    out->selected = (int8_t)game->selected_index;
+    out->game_over = game->game_over;
+}
+
+/* Runs a select+move pair through the turn controller and diffs the
+   boards into path, cleared and spawned cell lists. */
+static void apply_move(Game *game, const ProtoRequest *req, ProtoReply *out) {
+    out->type = PROTO_REPLY_MOVE;
+    out->action = GAME_ACTION_INVALID;
+
+    if (!game->game_over && game->board[req->from] != 0) {
+        TurnClickResult click;
+        turn_controller_click(game, req->from / GAME_BOARD_SIZE, req->from % GAME_BOARD_SIZE, &click);
+        turn_controller_click(game, req->to / GAME_BOARD_SIZE, req->to % GAME_BOARD_SIZE, &click);
+        out->action = (uint8_t)click.action;
+        out->score_delta = click.score_after - click.score_before;
+
+        if (click.action == GAME_ACTION_MOVED || click.action == GAME_ACTION_GAME_OVER) {
+            uint8_t after_move[GAME_CELLS];
+            memcpy(after_move, click.before_board, GAME_CELLS);
+            after_move[click.to_idx] = after_move[click.from_idx];
+            after_move[click.from_idx] = 0;
+
+            out->path_len = (uint8_t)click.path_len;
+            for (int i = 0; i < click.path_len; ++i) {
+                out->path[i] = (uint8_t)click.path[i];
+            }
+            for (int i = 0; i < GAME_CELLS; ++i) {
+                if (after_move[i] != 0 && game->board[i] == 0) {
+                    out->cleared[out->cleared_count++] = (uint8_t)i;
+                } else if (after_move[i] == 0 && game->board[i] != 0) {
+                    out->spawned[out->spawned_count] = (uint8_t)i;
+                    out->spawned_color[out->spawned_count++] = game->board[i];
+                }
+            }
+        }
+    }
+
+    out->selected = (int8_t)game->selected_index;
+    out->game_over = game->game_over;
+    out->score = game->score;
+    memcpy(out->next_colors, game->next_colors, GAME_NEXT_COUNT);
+}
+
+/* Applies one SELECT/MOVE/STATE/NEW_GAME request to game and fills the
+   reply. Session ownership and NEW_GAME seeding are up to the caller. */
+void proto_apply(Game *game, const ProtoRequest *req, ProtoReply *out) {
+    memset(out, 0, sizeof(*out));
+    out->session = req->session;
+    out->tag = req->tag;
+    out->status = PROTO_OK;
+
+    switch (req->type) {
+    case PROTO_NEW_GAME:
+        game_init(game, req->seed);
+        fill_state(game, out);
+        break;
+    case PROTO_STATE:
+        fill_state(game, out);
+        break;
+    case PROTO_SELECT:
+        if (req->cell >= GAME_CELLS) {
+            proto_error_reply(req, PROTO_ERR_MALFORMED, out);
+            return;
+        }
+        out->type = PROTO_REPLY_SELECT;
+        out->action = GAME_ACTION_INVALID;
+        if (game->board[req->cell] != 0) {
+            out->action = (uint8_t)game_click(game, req->cell / GAME_BOARD_SIZE, req->cell % GAME_BOARD_SIZE);
+        }
+        out->selected = (int8_t)game->selected_index;
+        break;
+    case PROTO_MOVE:
+        if (req->from >= GAME_CELLS || req->to >= GAME_CELLS) {
+            proto_error_reply(req, PROTO_ERR_MALFORMED, out);
+            return;
+        }
+        apply_move(game, req, out);
+        break;
+    default:
+        proto_error_reply(req, PROTO_ERR_MALFORMED, out);
+        break;
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+
+/* Every frame starts with: u16 frame length (header included), u8 type,
+   u8 status, u32 session id, u32 client tag; all little-endian. Replies
+   echo the request tag and come back in request order per connection. */
+#define PROTO_HEADER_SIZE 12
+#define PROTO_MAX_FRAME 512
+#define PROTO_PACKED_BOARD_BYTES ((GAME_CELLS * 3 + 7) / 8)
+#define PROTO_MAX_ENTRIES 32
+
+/* Request and reply frame types. */
+typedef enum {
+    PROTO_NEW_GAME = 1,
+    PROTO_SELECT = 2,
+    PROTO_MOVE = 3,
+    PROTO_STATE = 4,
+    PROTO_WATCH = 5,
+    PROTO_TOP = 6,
+    PROTO_RANK = 7,
+    PROTO_REPLY_STATE = 0x81,
+    PROTO_REPLY_SELECT = 0x82,
+    PROTO_REPLY_MOVE = 0x83,
+    PROTO_REPLY_WATCH = 0x84,
+    PROTO_KEYFRAME = 0x85,
+    PROTO_DELTA = 0x86,
+    PROTO_REPLY_TOP = 0x87,
+    PROTO_REPLY_RANK = 0x88,
+    PROTO_REPLY_ERROR = 0xFF
+} ProtoType;
+
+/* Reply status codes. */
+typedef enum {
+    PROTO_OK = 0,
+    PROTO_ERR_MALFORMED = 1,
+    PROTO_ERR_NO_SESSION = 2,
+    PROTO_ERR_FULL = 3,
+    PROTO_ERR_UNAVAILABLE = 4,
+    PROTO_ERR_FORBIDDEN = 5
+} ProtoStatus;
+
+/* Decoded request. NEW_GAME with session 0 creates a session; with a
+   session id it restarts that game. seed 0 lets the server pick. WATCH
+   subscribes the connection to a session's spectator frames (session 0
+   stops watching). TOP reads count leaderboard entries from 0-based
+   offset; RANK asks where score would place. NEW_GAME, SELECT and MOVE
+   also carry the session token from the NEW_GAME reply that created the
+   session; it is ignored when NEW_GAME creates a fresh session. */
+typedef struct {
+    uint8_t type;
+    uint32_t session;
+    uint32_t tag;
+    uint64_t token;
+    uint32_t seed;
+    uint8_t cell;
+    uint8_t from;
+    uint8_t to;
+    uint32_t offset;
+    uint8_t count;
+    int32_t score;
+} ProtoRequest;
+
+/* Decoded reply; which fields are meaningful depends on type. MOVE replies
+   carry the TurnClickResult data: path, cleared and spawned cells, and the
+   score delta, plus the new preview colors. Spectator frames arrive
+   unsolicited with tag 0: a KEYFRAME carries the board packed 3 bits per
+   cell, preview, score and game_over; a DELTA carries one turn like a MOVE
+   reply minus the selection. Both number turns with seq and, like replies,
+   are only sent once the turn is in the journal. TOP replies list
+   up to PROTO_MAX_ENTRIES (session, score) pairs best first; TOP and RANK
+   replies carry the leaderboard total, RANK also the rank. STATE replies
+   carry the session token; it is only filled in for NEW_GAME, so STATE
+   and spectator frames never reveal it. */
+typedef struct {
+    uint8_t type;
+    uint8_t status;
+    uint32_t session;
+    uint32_t tag;
+    uint64_t token;
+    uint32_t seq;
+
+    uint8_t action;
+    int8_t selected;
+    bool game_over;
+    int32_t score;
+    int32_t score_delta;
+    uint8_t next_colors[GAME_NEXT_COUNT];
+    uint8_t board[GAME_CELLS];
+
+    uint8_t path_len;
+    uint8_t path[GAME_CELLS];
+    uint8_t cleared_count;
+    uint8_t cleared[GAME_CELLS];
+    uint8_t spawned_count;
+    uint8_t spawned[GAME_CELLS];
+    uint8_t spawned_color[GAME_CELLS];
+
+    uint32_t rank;
+    uint32_t total;
+    uint8_t entry_count;
+    uint32_t entry_session[PROTO_MAX_ENTRIES];
+    int32_t entry_score[PROTO_MAX_ENTRIES];
+} ProtoReply;
+
+/* Encodes a request; returns frame bytes or -1 if cap is too small. */
+int proto_encode_request(const ProtoRequest *req, uint8_t *buf, size_t cap);
+
+/* Decodes one request frame from buf. Returns consumed bytes, 0 when more
+   input is needed, or -1 for a malformed frame. */
+int proto_decode_request(const uint8_t *buf, size_t len, ProtoRequest *out);
+
+/* Encodes a reply; returns frame bytes or -1 if cap is too small. */
+int proto_encode_reply(const ProtoReply *reply, uint8_t *buf, size_t cap);
+
+/* Decodes one reply frame from buf. Returns consumed bytes, 0 when more
+   input is needed, or -1 for a malformed frame. */
+int proto_decode_reply(const uint8_t *buf, size_t len, ProtoReply *out);
+
+/* Fills an error reply for req. */
+void proto_error_reply(const ProtoRequest *req, ProtoStatus status, ProtoReply *out);
+
+/* Applies one SELECT/MOVE/STATE/NEW_GAME request to game and fills the
+   reply. Session ownership and NEW_GAME seeding are up to the caller. */
+void proto_apply(Game *game, const ProtoRequest *req, ProtoReply *out);
+
+#endif
@@ -6,6 +6,21 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+
+#define BALL_LAYERS 5
+#define GLYPH_COLS 5
+#define GLYPH_ROWS 7
+#define GLYPH_ADVANCE 6
+#define BALL_ATLAS_WIDTH 1024
+
+/* One filled circle of the layered ball look, relative to ball center. */
+typedef struct {
+    int dx;
+    int dy;
+    int radius;
+    SDL_Color color;
+} BallLayer;
 
 /* Scales RGB channels by scalar factor. */
 static SDL_Color scale_color(SDL_Color c, float k) {
@@ -43,50 +58,253 @@ static void draw_filled_circle(SDL_Renderer *renderer, int cx, int cy, int radiu
     }
 }
 
-/* Draws one seven-segment rectangle slice when enabled. */
-static void draw_segment(SDL_Renderer *renderer, int x, int y, int w, int h, bool on) {
-    if (!on) {
-        return;
+/* Describes the pseudo-3D ball as back-to-front circles: shadow, body,
+   face, highlight and specular dot. Shared by direct and cached drawing. */
+static void ball_layers(int radius, SDL_Color base, BallLayer out[BALL_LAYERS]) {
+    const BallLayer layers[BALL_LAYERS] = {
+        {2, 3, radius, scale_color(base, 0.28f)},
+        {0, 0, radius, scale_color(base, 0.72f)},
+        {-1, -1, (radius * 8) / 10, base},
+        {-5, -6, radius / 2, mix_white(base, 0.65f)},
+        {-8, -9, SDL_max(2, radius / 6), mix_white(base, 0.9f)}
+    };
+    for (int i = 0; i < BALL_LAYERS; ++i) {
+        out[i] = layers[i];
+    }
+}
+
+/* Computes pixel extents of a ball sprite around its center. */
+static void ball_extents(int radius, int *left, int *top, int *right, int *bottom) {
+    SDL_Color any = {0, 0, 0, 255};
+    BallLayer layers[BALL_LAYERS];
+    ball_layers(radius, any, layers);
+
+    *left = 0;
+    *top = 0;
+    *right = 0;
+    *bottom = 0;
+    for (int i = 0; i < BALL_LAYERS; ++i) {
+        *left = SDL_max(*left, layers[i].radius - layers[i].dx);
+        *top = SDL_max(*top, layers[i].radius - layers[i].dy);
+        *right = SDL_max(*right, layers[i].radius + layers[i].dx);
+        *bottom = SDL_max(*bottom, layers[i].radius + layers[i].dy);
+    }
+}
+
+/* Software twin of draw_filled_circle writing opaque RGBA32 pixels. */
+static void raster_filled_circle(uint8_t *pixels, int pitch, int cx, int cy, int radius, SDL_Color color) {
+    for (int y = -radius; y <= radius; ++y) {
+        int span = (int)sqrt((double)(radius * radius - y * y));
+        uint8_t *row = pixels + (cy + y) * pitch;
+        for (int x = cx - span; x <= cx + span; ++x) {
+            uint8_t *px = row + x * 4;
+            px[0] = color.r;
+            px[1] = color.g;
+            px[2] = color.b;
+            px[3] = color.a;
+        }
+    }
+}
+
+/* Rasterizes every palette/radius sprite into the CPU-side atlas. */
+static int ball_cache_build(void *data) {
+    RuBallCache *cache = (RuBallCache *)data;
+    int pitch = cache->atlas_w * 4;
+
+    for (int c = 0; c < cache->color_count; ++c) {
+        for (int r = 0; r < RU_BALL_CACHE_RADII; ++r) {
+            const SDL_Rect *src = &cache->src[c][r];
+            int cx = src->x + cache->center_x[r];
+            int cy = src->y + cache->center_y[r];
+            BallLayer layers[BALL_LAYERS];
+            ball_layers(RU_BALL_CACHE_MIN_RADIUS + r, cache->colors[c], layers);
+            for (int i = 0; i < BALL_LAYERS; ++i) {
+                raster_filled_circle(cache->pixels, pitch, cx + layers[i].dx, cy + layers[i].dy, layers[i].radius, layers[i].color);
+            }
+        }
     }
-    SDL_Rect r = {x, y, w, h};
-    SDL_RenderFillRect(renderer, &r);
-}
-
-/* Draws one small bitmap glyph used in overlays. */
-static void draw_glyph(SDL_Renderer *renderer, int x, int y, int scale, char ch) {
-    static const uint8_t glyph_space[7] = {0, 0, 0, 0, 0, 0, 0};
-    static const uint8_t glyph_a[7] = {14, 17, 17, 31, 17, 17, 17};
-    static const uint8_t glyph_c[7] = {14, 17, 16, 16, 16, 17, 14};
-    static const uint8_t glyph_e[7] = {31, 16, 16, 30, 16, 16, 31};
-    static const uint8_t glyph_g[7] = {14, 17, 16, 23, 17, 17, 14};
-    static const uint8_t glyph_m[7] = {17, 27, 21, 21, 17, 17, 17};
-    static const uint8_t glyph_o[7] = {14, 17, 17, 17, 17, 17, 14};
-    static const uint8_t glyph_r[7] = {30, 17, 17, 30, 20, 18, 17};
-    static const uint8_t glyph_s[7] = {15, 16, 16, 14, 1, 1, 30};
-    static const uint8_t glyph_v[7] = {17, 17, 17, 17, 17, 10, 4};
-
-    const uint8_t *glyph = glyph_space;
-    switch (ch) {
-        case 'A': glyph = glyph_a; break;
-        case 'C': glyph = glyph_c; break;
-        case 'E': glyph = glyph_e; break;
-        case 'G': glyph = glyph_g; break;
-        case 'M': glyph = glyph_m; break;
-        case 'O': glyph = glyph_o; break;
-        case 'R': glyph = glyph_r; break;
-        case 'S': glyph = glyph_s; break;
-        case 'V': glyph = glyph_v; break;
-        default: glyph = glyph_space; break;
-    }
-
-    for (int row = 0; row < 7; ++row) {
-        for (int col = 0; col < 5; ++col) {
-            if ((glyph[row] >> (4 - col)) & 1u) {
+
+    SDL_AtomicSet(&cache->built, 1);
+    return 0;
+}
+
+/* Uploads a finished CPU atlas to a texture on the render thread. */
+static void ball_cache_upload(RuBallCache *cache, SDL_Renderer *renderer) {
+    if (cache->builder != NULL) {
+        SDL_WaitThread(cache->builder, NULL);
+        cache->builder = NULL;
+    }
+
+    cache->atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, cache->atlas_w, cache->atlas_h);
+    if (cache->atlas != NULL) {
+        if (SDL_UpdateTexture(cache->atlas, NULL, cache->pixels, cache->atlas_w * 4) == 0) {
+            SDL_SetTextureBlendMode(cache->atlas, SDL_BLENDMODE_BLEND);
+        } else {
+            SDL_DestroyTexture(cache->atlas);
+            cache->atlas = NULL;
+        }
+    }
+
+    /* Atlas stays CPU-only on failure; drawing keeps using the fallback. */
+    SDL_free(cache->pixels);
+    cache->pixels = NULL;
+}
+
+/* Finds palette slot for a color, or -1 when it is not cached. */
+static int ball_cache_color_slot(const RuBallCache *cache, SDL_Color c) {
+    for (int i = 0; i < cache->color_count; ++i) {
+        SDL_Color k = cache->colors[i];
+        if (k.r == c.r && k.g == c.g && k.b == c.b && k.a == c.a) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* 5x7 bitmap glyph; each row stores 5 pixels in its low bits, MSB left. */
+typedef struct {
+    char ch;
+    uint8_t rows[GLYPH_ROWS];
+} Glyph;
+
+static const Glyph GLYPHS[] = {
+    {' ', {0, 0, 0, 0, 0, 0, 0}},
+    {'.', {0, 0, 0, 0, 0, 12, 12}},
+    {'/', {0, 1, 2, 4, 8, 16, 0}},
+    {'0', {14, 17, 19, 21, 25, 17, 14}},
+    {'1', {4, 12, 4, 4, 4, 4, 14}},
+    {'2', {14, 17, 1, 2, 4, 8, 31}},
+    {'3', {31, 2, 4, 2, 1, 17, 14}},
+    {'4', {2, 6, 10, 18, 31, 2, 2}},
+    {'5', {31, 16, 30, 1, 1, 17, 14}},
+    {'6', {6, 8, 16, 30, 17, 17, 14}},
+    {'7', {31, 1, 2, 4, 8, 8, 8}},
+    {'8', {14, 17, 17, 14, 17, 17, 14}},
+    {'9', {14, 17, 17, 15, 1, 2, 12}},
+    {'A', {14, 17, 17, 31, 17, 17, 17}},
+    {'B', {30, 17, 17, 30, 17, 17, 30}},
+    {'C', {14, 17, 16, 16, 16, 17, 14}},
+    {'D', {30, 17, 17, 17, 17, 17, 30}},
+    {'E', {31, 16, 16, 30, 16, 16, 31}},
+    {'F', {31, 16, 16, 30, 16, 16, 16}},
+    {'G', {14, 17, 16, 23, 17, 17, 14}},
+    {'H', {17, 17, 17, 31, 17, 17, 17}},
+    {'I', {14, 4, 4, 4, 4, 4, 14}},
+    {'J', {7, 2, 2, 2, 2, 18, 12}},
+    {'K', {17, 18, 20, 24, 20, 18, 17}},
+    {'L', {16, 16, 16, 16, 16, 16, 31}},
+    {'M', {17, 27, 21, 21, 17, 17, 17}},
+    {'N', {17, 17, 25, 21, 19, 17, 17}},
+    {'O', {14, 17, 17, 17, 17, 17, 14}},
+    {'P', {30, 17, 17, 30, 16, 16, 16}},
+    {'Q', {14, 17, 17, 17, 21, 18, 13}},
+    {'R', {30, 17, 17, 30, 20, 18, 17}},
+    {'S', {15, 16, 16, 14, 1, 1, 30}},
+    {'T', {31, 4, 4, 4, 4, 4, 4}},
+    {'U', {17, 17, 17, 17, 17, 17, 14}},
+    {'V', {17, 17, 17, 17, 17, 10, 4}},
+    {'W', {17, 17, 17, 21, 21, 21, 10}},
+    {'X', {17, 17, 10, 4, 10, 17, 17}},
+    {'Y', {17, 17, 10, 4, 4, 4, 4}},
+    {'Z', {31, 1, 2, 4, 8, 16, 31}}
+};
+
+/* Seven-segment on/off table: top, upper-right, lower-right, bottom,
+   lower-left, upper-left, middle. */
+static const bool DIGIT_SEGMENTS[10][7] = {
+    {true, true, true, true, true, true, false},
+    {false, true, true, false, false, false, false},
+    {true, true, false, true, true, false, true},
+    {true, true, true, true, false, false, true},
+    {false, true, true, false, false, true, true},
+    {true, false, true, true, false, true, true},
+    {true, false, true, true, true, true, true},
+    {true, true, true, false, false, false, false},
+    {true, true, true, true, true, true, true},
+    {true, true, true, true, false, true, true}
+};
+
+/* Returns glyph table slot for a character; unknown characters are blank. */
+static int glyph_slot(char ch) {
+    for (int i = 0; i < (int)SDL_arraysize(GLYPHS); ++i) {
+        if (GLYPHS[i].ch == ch) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/* Collects lit pixel squares of one glyph; returns rect count. */
+static int glyph_rects(int x, int y, int scale, char ch, SDL_Rect out[GLYPH_COLS * GLYPH_ROWS]) {
+    const uint8_t *rows = GLYPHS[glyph_slot(ch)].rows;
+    int n = 0;
+    for (int row = 0; row < GLYPH_ROWS; ++row) {
+        for (int col = 0; col < GLYPH_COLS; ++col) {
+            if ((rows[row] >> (GLYPH_COLS - 1 - col)) & 1u) {
                 SDL_Rect px = {x + col * scale, y + row * scale, scale, scale};
-                SDL_RenderFillRect(renderer, &px);
+                out[n++] = px;
             }
         }
     }
+    return n;
+}
+
+/* Collects lit segments of one seven-segment digit; returns rect count. */
+static int digit_rects(int x, int y, int scale, int digit, SDL_Rect out[7]) {
+    int t = scale;
+    int lw = 6 * scale;
+    int lh = 10 * scale;
+    const SDL_Rect segments[7] = {
+        {x + t, y, lw, t},
+        {x + lw + t, y + t, t, lh},
+        {x + lw + t, y + lh + 2 * t, t, lh},
+        {x + t, y + 2 * lh + 2 * t, lw, t},
+        {x, y + lh + 2 * t, t, lh},
+        {x, y + t, t, lh},
+        {x + t, y + lh + t, lw, t}
+    };
+
+    int n = 0;
+    for (int i = 0; i < 7; ++i) {
+        if (DIGIT_SEGMENTS[digit][i]) {
+            out[n++] = segments[i];
+        }
+    }
+    return n;
+}
+
+/* Fills rects with opaque white into an RGBA32 buffer, clipped to it. */
+static void raster_rects(uint8_t *pixels, int w, int h, const SDL_Rect *rects, int count) {
+    for (int i = 0; i < count; ++i) {
+        int x0 = SDL_max(0, rects[i].x);
+        int y0 = SDL_max(0, rects[i].y);
+        int x1 = SDL_min(w, rects[i].x + rects[i].w);
+        int y1 = SDL_min(h, rects[i].y + rects[i].h);
+        for (int y = y0; y < y1; ++y) {
+            memset(pixels + ((size_t)y * (size_t)w + (size_t)x0) * 4, 255, (size_t)SDL_max(0, x1 - x0) * 4);
+        }
+    }
+}
+
+/* Creates a static white-on-transparent texture from RGBA32 pixels. */
+static SDL_Texture *upload_mask(SDL_Renderer *renderer, const uint8_t *pixels, int w, int h) {
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, w, h);
+    if (texture == NULL) {
+        return NULL;
+    }
+    if (SDL_UpdateTexture(texture, NULL, pixels, w * 4) != 0) {
+        SDL_DestroyTexture(texture);
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(texture, SDL_ScaleModeNearest);
+    return texture;
+}
+
+/* Tints a white mask texture with the given color. */
+static void tint_mask(SDL_Texture *texture, SDL_Color color) {
+    SDL_SetTextureColorMod(texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(texture, color.a);
 }
 
 /* Sets current renderer draw color. */
@@ -96,47 +314,129 @@ void ru_set_color(SDL_Renderer *renderer, SDL_Color color) {
 
 /* Draws pseudo-3D game ball with highlight/shadow. */
 void ru_draw_ball(SDL_Renderer *renderer, int cx, int cy, int radius, SDL_Color base) {
-    draw_filled_circle(renderer, cx + 2, cy + 3, radius, scale_color(base, 0.28f));
-    draw_filled_circle(renderer, cx, cy, radius, scale_color(base, 0.72f));
-    draw_filled_circle(renderer, cx - 1, cy - 1, (radius * 8) / 10, base);
-    draw_filled_circle(renderer, cx - 5, cy - 6, radius / 2, mix_white(base, 0.65f));
-    draw_filled_circle(renderer, cx - 8, cy - 9, SDL_max(2, radius / 6), mix_white(base, 0.9f));
+    BallLayer layers[BALL_LAYERS];
+    ball_layers(radius, base, layers);
+    for (int i = 0; i < BALL_LAYERS; ++i) {
+        draw_filled_circle(renderer, cx + layers[i].dx, cy + layers[i].dy, layers[i].radius, layers[i].color);
+    }
 }
 
-/* Draws one seven-segment digit. */
-void ru_draw_digit(SDL_Renderer *renderer, int x, int y, int scale, int digit) {
-    static const bool segments[10][7] = {
-        {true, true, true, true, true, true, false},
-        {false, true, true, false, false, false, false},
-        {true, true, false, true, true, false, true},
-        {true, true, true, true, false, false, true},
-        {false, true, true, false, false, true, true},
-        {true, false, true, true, false, true, true},
-        {true, false, true, true, true, true, true},
-        {true, true, true, false, false, false, false},
-        {true, true, true, true, true, true, true},
-        {true, true, true, true, false, true, true}
-    };
+/* Lays out the atlas and rasterizes all palette/radius sprites, either
+   inline or on a background thread. Returns false if nothing can be cached. */
+bool ru_ball_cache_init(RuBallCache *cache, const SDL_Color *colors, int color_count, bool background) {
+    SDL_zerop(cache);
+    cache->color_count = SDL_min(color_count, RU_BALL_CACHE_MAX_COLORS);
+    for (int i = 0; i < cache->color_count; ++i) {
+        cache->colors[i] = colors[i];
+    }
 
-    int t = scale;
-    int lw = 6 * scale;
-    int lh = 10 * scale;
+    /* Shelf packing, largest radius first so each shelf has even heights. */
+    int x = 0;
+    int y = 0;
+    int shelf_h = 0;
+    cache->atlas_w = BALL_ATLAS_WIDTH;
+    for (int r = RU_BALL_CACHE_RADII - 1; r >= 0; --r) {
+        int left;
+        int top;
+        int right;
+        int bottom;
+        ball_extents(RU_BALL_CACHE_MIN_RADIUS + r, &left, &top, &right, &bottom);
+        cache->center_x[r] = left;
+        cache->center_y[r] = top;
+
+        for (int c = 0; c < cache->color_count; ++c) {
+            SDL_Rect rect = {x, y, left + right + 1, top + bottom + 1};
+            if (rect.x + rect.w > cache->atlas_w) {
+                y += shelf_h;
+                shelf_h = 0;
+                rect.x = 0;
+                rect.y = y;
+            }
+            cache->src[c][r] = rect;
+            x = rect.x + rect.w;
+            shelf_h = SDL_max(shelf_h, rect.h);
+        }
+    }
+    cache->atlas_h = y + shelf_h;
+
+    cache->pixels = (uint8_t *)SDL_calloc((size_t)cache->atlas_w * (size_t)cache->atlas_h, 4);
+    if (cache->pixels == NULL || cache->color_count <= 0) {
+        ru_ball_cache_shutdown(cache);
+        return false;
+    }
+
+    if (background) {
+        cache->builder = SDL_CreateThread(ball_cache_build, "ball-cache", cache);
+    }
+    if (cache->builder == NULL) {
+        (void)ball_cache_build(cache);
+    }
+    return true;
+}
+
+/* Waits for a pending background build and frees atlas resources. */
+void ru_ball_cache_shutdown(RuBallCache *cache) {
+    if (cache->builder != NULL) {
+        SDL_WaitThread(cache->builder, NULL);
+        cache->builder = NULL;
+    }
+    if (cache->atlas != NULL) {
+        SDL_DestroyTexture(cache->atlas);
+        cache->atlas = NULL;
+    }
+    SDL_free(cache->pixels);
+    cache->pixels = NULL;
+    SDL_AtomicSet(&cache->built, 0);
+}
+
+/* Drops the atlas texture after the renderer lost it (device reset) and
+   rasterizes the same palette again, so balls draw directly until the new
+   atlas is uploaded. */
+void ru_ball_cache_invalidate(RuBallCache *cache, bool background) {
+    SDL_Color colors[RU_BALL_CACHE_MAX_COLORS];
+    int color_count = cache->color_count;
+    for (int i = 0; i < color_count; ++i) {
+        colors[i] = cache->colors[i];
+    }
+    ru_ball_cache_shutdown(cache);
+    if (color_count > 0) {
+        ru_ball_cache_init(cache, colors, color_count, background);
+    }
+}
+
+/* Draws ball as one atlas copy, or via ru_draw_ball while not cached. */
+void ru_draw_ball_cached(RuBallCache *cache, SDL_Renderer *renderer, int cx, int cy, int radius, SDL_Color base) {
+    if (cache->atlas == NULL && cache->pixels != NULL && SDL_AtomicGet(&cache->built)) {
+        ball_cache_upload(cache, renderer);
+    }
+
+    int slot = ball_cache_color_slot(cache, base);
+    if (cache->atlas == NULL || slot < 0 || radius < RU_BALL_CACHE_MIN_RADIUS || radius > RU_BALL_CACHE_MAX_RADIUS) {
+        ru_draw_ball(renderer, cx, cy, radius, base);
+        return;
+    }
+
+    int r = radius - RU_BALL_CACHE_MIN_RADIUS;
+    const SDL_Rect *src = &cache->src[slot][r];
+    SDL_Rect dst = {cx - cache->center_x[r], cy - cache->center_y[r], src->w, src->h};
+    SDL_RenderCopy(renderer, cache->atlas, src, &dst);
+}
 
-    draw_segment(renderer, x + t, y, lw, t, segments[digit][0]);
-    draw_segment(renderer, x + lw + t, y + t, t, lh, segments[digit][1]);
-    draw_segment(renderer, x + lw + t, y + lh + 2 * t, t, lh, segments[digit][2]);
-    draw_segment(renderer, x + t, y + 2 * lh + 2 * t, lw, t, segments[digit][3]);
-    draw_segment(renderer, x, y + lh + 2 * t, t, lh, segments[digit][4]);
-    draw_segment(renderer, x, y + t, t, lh, segments[digit][5]);
-    draw_segment(renderer, x + t, y + lh + t, lw, t, segments[digit][6]);
+/* Draws one seven-segment digit. */
+void ru_draw_digit(SDL_Renderer *renderer, int x, int y, int scale, int digit) {
+    SDL_Rect rects[7];
+    int n = digit_rects(x, y, scale, digit, rects);
+    SDL_RenderFillRects(renderer, rects, n);
 }
 
 /* Draws text with tiny bitmap glyphs. */
 void ru_draw_text(SDL_Renderer *renderer, int x, int y, int scale, const char *text) {
     int cursor = x;
     for (const char *p = text; *p != '\0'; ++p) {
-        draw_glyph(renderer, cursor, y, scale, *p);
-        cursor += 6 * scale;
+        SDL_Rect rects[GLYPH_COLS * GLYPH_ROWS];
+        int n = glyph_rects(cursor, y, scale, *p, rects);
+        SDL_RenderFillRects(renderer, rects, n);
+        cursor += GLYPH_ADVANCE * scale;
     }
 }
 
@@ -146,5 +446,197 @@ int ru_text_pixel_width(int scale, const char *text) {
     for (const char *p = text; *p != '\0'; ++p) {
         ++len;
     }
-    return len * 6 * scale;
+    return len * GLYPH_ADVANCE * scale;
+}
+
+/* Builds the scale-1 glyph and digit atlas; false keeps fill-rect text. */
+bool ru_glyph_atlas_init(RuGlyphAtlas *atlas, SDL_Renderer *renderer) {
+    SDL_zerop(atlas);
+    int glyph_count = (int)SDL_arraysize(GLYPHS);
+    int w = SDL_max(glyph_count * GLYPH_ADVANCE, 10 * RU_DIGIT_ADVANCE);
+    int h = GLYPH_ROWS + 1 + RU_DIGIT_HEIGHT;
+
+    uint8_t *pixels = (uint8_t *)SDL_calloc((size_t)w * (size_t)h, 4);
+    if (pixels == NULL) {
+        return false;
+    }
+
+    /* Glyphs on the top row, seven-segment digits below them. */
+    for (int i = 0; i < glyph_count; ++i) {
+        SDL_Rect rects[GLYPH_COLS * GLYPH_ROWS];
+        int n = glyph_rects(i * GLYPH_ADVANCE, 0, 1, GLYPHS[i].ch, rects);
+        raster_rects(pixels, w, h, rects, n);
+    }
+    for (int d = 0; d < 10; ++d) {
+        SDL_Rect rects[7];
+        int n = digit_rects(d * RU_DIGIT_ADVANCE, GLYPH_ROWS + 1, 1, d, rects);
+        raster_rects(pixels, w, h, rects, n);
+    }
+
+    atlas->texture = upload_mask(renderer, pixels, w, h);
+    SDL_free(pixels);
+    return atlas->texture != NULL;
+}
+
+/* Releases glyph atlas texture. */
+void ru_glyph_atlas_shutdown(RuGlyphAtlas *atlas) {
+    if (atlas->texture != NULL) {
+        SDL_DestroyTexture(atlas->texture);
+    }
+    SDL_zerop(atlas);
+}
+
+/* Draws text with one atlas copy per glyph, falling back to ru_draw_text. */
+void ru_glyph_atlas_draw_text(const RuGlyphAtlas *atlas, SDL_Renderer *renderer, int x, int y, int scale, const char *text, SDL_Color color) {
+    if (atlas == NULL || atlas->texture == NULL) {
+        ru_set_color(renderer, color);
+        ru_draw_text(renderer, x, y, scale, text);
+        return;
+    }
+
+    tint_mask(atlas->texture, color);
+    int cursor = x;
+    for (const char *p = text; *p != '\0'; ++p) {
+        int slot = glyph_slot(*p);
+        if (slot != 0) {
+            SDL_Rect src = {slot * GLYPH_ADVANCE, 0, GLYPH_COLS, GLYPH_ROWS};
+            SDL_Rect dst = {cursor, y, GLYPH_COLS * scale, GLYPH_ROWS * scale};
+            SDL_RenderCopy(renderer, atlas->texture, &src, &dst);
+        }
+        cursor += GLYPH_ADVANCE * scale;
+    }
+}
+
+/* Draws one seven-segment digit as one atlas copy, falling back to ru_draw_digit. */
+void ru_glyph_atlas_draw_digit(const RuGlyphAtlas *atlas, SDL_Renderer *renderer, int x, int y, int scale, int digit, SDL_Color color) {
+    if (atlas == NULL || atlas->texture == NULL) {
+        ru_set_color(renderer, color);
+        ru_draw_digit(renderer, x, y, scale, digit);
+        return;
+    }
+
+    tint_mask(atlas->texture, color);
+    SDL_Rect src = {digit * RU_DIGIT_ADVANCE, GLYPH_ROWS + 1, RU_DIGIT_WIDTH, RU_DIGIT_HEIGHT};
+    SDL_Rect dst = {x, y, RU_DIGIT_WIDTH * scale, RU_DIGIT_HEIGHT * scale};
+    SDL_RenderCopy(renderer, atlas->texture, &src, &dst);
+}
+
+/* Rasterizes label content into a fresh texture of the exact final size. */
+static void label_rebuild(RuLabel *label, SDL_Renderer *renderer) {
+    int scale = label->scale;
+    int w;
+    int h;
+    if (label->pitch > 0) {
+        w = ((int)strlen(label->text) - 1) * label->pitch + RU_DIGIT_WIDTH * scale;
+        h = RU_DIGIT_HEIGHT * scale;
+    } else {
+        w = ru_text_pixel_width(scale, label->text);
+        h = GLYPH_ROWS * scale;
+    }
+
+    if (label->texture != NULL && (w != label->w || h != label->h)) {
+        SDL_DestroyTexture(label->texture);
+        label->texture = NULL;
+    }
+    label->w = w;
+    label->h = h;
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    uint8_t *pixels = (uint8_t *)SDL_calloc((size_t)w * (size_t)h, 4);
+    if (pixels == NULL) {
+        return;
+    }
+
+    int cursor = 0;
+    for (const char *p = label->text; *p != '\0'; ++p) {
+        SDL_Rect rects[GLYPH_COLS * GLYPH_ROWS];
+        int n;
+        if (label->pitch > 0) {
+            n = digit_rects(cursor, 0, scale, *p - '0', rects);
+            cursor += label->pitch;
+        } else {
+            n = glyph_rects(cursor, 0, scale, *p, rects);
+            cursor += GLYPH_ADVANCE * scale;
+        }
+        raster_rects(pixels, w, h, rects, n);
+    }
+
+    if (label->texture == NULL) {
+        label->texture = upload_mask(renderer, pixels, w, h);
+    } else if (SDL_UpdateTexture(label->texture, NULL, pixels, w * 4) != 0) {
+        SDL_DestroyTexture(label->texture);
+        label->texture = NULL;
+    }
+    SDL_free(pixels);
+}
+
+/* Sets label to bitmap text; texture is rebuilt only on change. */
+void ru_label_set_text(RuLabel *label, SDL_Renderer *renderer, int scale, const char *text) {
+    if (label->valid && label->pitch == 0 && label->scale == scale && strcmp(label->text, text) == 0) {
+        return;
+    }
+    SDL_strlcpy(label->text, text, sizeof(label->text));
+    label->scale = scale;
+    label->pitch = 0;
+    label->valid = true;
+    label_rebuild(label, renderer);
+}
+
+/* Sets label to a zero-padded seven-segment number clamped to digits;
+   pitch is the pixel advance between digits. Rebuilt only on change. */
+void ru_label_set_number(RuLabel *label, SDL_Renderer *renderer, int scale, int pitch, int value, int digits) {
+    char text[RU_LABEL_MAX_CHARS + 1];
+    digits = SDL_max(1, SDL_min(digits, RU_LABEL_MAX_CHARS));
+    int max_value = 1;
+    for (int i = 0; i < digits; ++i) {
+        max_value *= 10;
+    }
+    value = SDL_max(0, SDL_min(value, max_value - 1));
+    for (int i = digits - 1; i >= 0; --i) {
+        text[i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    text[digits] = '\0';
+
+    if (label->valid && label->pitch == pitch && label->scale == scale && strcmp(label->text, text) == 0) {
+        return;
+    }
+    SDL_strlcpy(label->text, text, sizeof(label->text));
+    label->scale = scale;
+    label->pitch = SDL_max(1, pitch);
+    label->valid = true;
+    label_rebuild(label, renderer);
+}
+
+/* Draws label with one texture copy, or glyph by glyph if no texture. */
+void ru_label_draw(const RuLabel *label, SDL_Renderer *renderer, const RuGlyphAtlas *atlas, int x, int y, SDL_Color color) {
+    if (!label->valid) {
+        return;
+    }
+    if (label->texture != NULL) {
+        tint_mask(label->texture, color);
+        SDL_Rect dst = {x, y, label->w, label->h};
+        SDL_RenderCopy(renderer, label->texture, NULL, &dst);
+        return;
+    }
+
+    if (label->pitch == 0) {
+        ru_glyph_atlas_draw_text(atlas, renderer, x, y, label->scale, label->text, color);
+        return;
+    }
+    int cursor = x;
+    for (const char *p = label->text; *p != '\0'; ++p) {
+        ru_glyph_atlas_draw_digit(atlas, renderer, cursor, y, label->scale, *p - '0', color);
+        cursor += label->pitch;
+    }
+}
+
+/* Releases label texture and clears cached content. */
+void ru_label_destroy(RuLabel *label) {
+    if (label->texture != NULL) {
+        SDL_DestroyTexture(label->texture);
+    }
+    SDL_zerop(label);
 }
@@ -1,14 +1,72 @@
 #ifndef RENDER_UI_H
 #define RENDER_UI_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <SDL.h>
 
+#define RU_BALL_CACHE_MIN_RADIUS 2
+#define RU_BALL_CACHE_MAX_RADIUS 23
+#define RU_BALL_CACHE_RADII (RU_BALL_CACHE_MAX_RADIUS - RU_BALL_CACHE_MIN_RADIUS + 1)
+#define RU_BALL_CACHE_MAX_COLORS 8
+#define RU_DIGIT_WIDTH 8
+#define RU_DIGIT_HEIGHT 23
+#define RU_DIGIT_ADVANCE (RU_DIGIT_WIDTH + 1)
+#define RU_LABEL_MAX_CHARS 31
+
+/* Atlas of pre-rendered balls keyed by palette color and radius. */
+typedef struct {
+    SDL_Texture *atlas;
+    uint8_t *pixels;
+    int atlas_w;
+    int atlas_h;
+    SDL_Color colors[RU_BALL_CACHE_MAX_COLORS];
+    int color_count;
+    SDL_Rect src[RU_BALL_CACHE_MAX_COLORS][RU_BALL_CACHE_RADII];
+    int center_x[RU_BALL_CACHE_RADII];
+    int center_y[RU_BALL_CACHE_RADII];
+    SDL_Thread *builder;
+    SDL_atomic_t built;
+} RuBallCache;
+
+/* White scale-1 texture of all bitmap glyphs and seven-segment digits. */
+typedef struct {
+    SDL_Texture *texture;
+} RuGlyphAtlas;
+
+/* Cached texture for one string or number; rebuilt only when content changes. */
+typedef struct {
+    SDL_Texture *texture;
+    char text[RU_LABEL_MAX_CHARS + 1];
+    int scale;
+    int pitch;
+    int w;
+    int h;
+    bool valid;
+} RuLabel;
+
 /* Sets current renderer draw color. */
 void ru_set_color(SDL_Renderer *renderer, SDL_Color color);
 
 /* Draws pseudo-3D game ball with highlight/shadow. */
 void ru_draw_ball(SDL_Renderer *renderer, int cx, int cy, int radius, SDL_Color base);
 
+/* Lays out the atlas and rasterizes all palette/radius sprites, either
+   inline or on a background thread. Returns false if nothing can be cached. */
+bool ru_ball_cache_init(RuBallCache *cache, const SDL_Color *colors, int color_count, bool background);
+
+/* Waits for a pending background build and frees atlas resources. */
+void ru_ball_cache_shutdown(RuBallCache *cache);
+
+/* Drops the atlas texture after the renderer lost it (device reset) and
+   rasterizes the same palette again, so balls draw directly until the new
+   atlas is uploaded. */
+void ru_ball_cache_invalidate(RuBallCache *cache, bool background);
+
+/* Draws ball as one atlas copy, or via ru_draw_ball while not cached. */
+void ru_draw_ball_cached(RuBallCache *cache, SDL_Renderer *renderer, int cx, int cy, int radius, SDL_Color base);
+
 /* Draws one seven-segment digit. */
 void ru_draw_digit(SDL_Renderer *renderer, int x, int y, int scale, int digit);
 
@@ -18,4 +76,29 @@ void ru_draw_text(SDL_Renderer *renderer, int x, int y, int scale, const char *t
 /* Returns pixel width of text drawn by ru_draw_text at given scale. */
 int ru_text_pixel_width(int scale, const char *text);
 
+/* Builds the scale-1 glyph and digit atlas; false keeps fill-rect text. */
+bool ru_glyph_atlas_init(RuGlyphAtlas *atlas, SDL_Renderer *renderer);
+
+/* Releases glyph atlas texture. */
+void ru_glyph_atlas_shutdown(RuGlyphAtlas *atlas);
+
+/* Draws text with one atlas copy per glyph, falling back to ru_draw_text. */
+void ru_glyph_atlas_draw_text(const RuGlyphAtlas *atlas, SDL_Renderer *renderer, int x, int y, int scale, const char *text, SDL_Color color);
+
+/* Draws one seven-segment digit as one atlas copy, falling back to ru_draw_digit. */
+void ru_glyph_atlas_draw_digit(const RuGlyphAtlas *atlas, SDL_Renderer *renderer, int x, int y, int scale, int digit, SDL_Color color);
+
+/* Sets label to bitmap text; texture is rebuilt only on change. */
+void ru_label_set_text(RuLabel *label, SDL_Renderer *renderer, int scale, const char *text);
+
+/* Sets label to a zero-padded seven-segment number clamped to digits;
+   pitch is the pixel advance between digits. Rebuilt only on change. */
+void ru_label_set_number(RuLabel *label, SDL_Renderer *renderer, int scale, int pitch, int value, int digits);
+
+/* Draws label with one texture copy, or glyph by glyph if no texture. */
+void ru_label_draw(const RuLabel *label, SDL_Renderer *renderer, const RuGlyphAtlas *atlas, int x, int y, SDL_Color color);
+
+/* Releases label texture and clears cached content. */
+void ru_label_destroy(RuLabel *label);
+
 #endif
@@ -0,0 +1,1305 @@
+/* Epoll game server hosting many Game sessions on a fixed thread pool.
+   Sockets are non-blocking and level-triggered; each connection has one
+   fixed input and output buffer, and frames are only decoded while the
+   output buffer can hold a full reply, so slow readers get backpressure
+   instead of unbounded queues. */
+
+#define _GNU_SOURCE
+
+#include "server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "protocol.h"
+
+#define SERVER_ACCEPT_BATCH 16
+#define SERVER_KEY_BYTES 16
+#define SERVER_CHECKPOINT_MAGIC 0x4B433839u
+#define SERVER_CHECKPOINT_VERSION 1u
+#define SERVER_CHECKPOINT_HEADER 16
+#define SERVER_CHECKPOINT_ENTRY (12 + SESSIONS_PACKED_BOARD_BYTES + 3)
+/* Journal record type (no request uses 0) that opens a journal restarted
+   after the checkpoint whose generation is in seed. */
+#define SERVER_JOURNAL_CHECKPOINT 0
+#define SERVER_LISTEN_BACKLOG 1024
+
+/* One client connection, owned by the worker that accepted it. Pushed
+   spectator frames queue in watcher and are written from the shared
+   frames, never copied into out. */
+struct ServerConn {
+    ServerHandle handle;
+    ServerConn *prev;
+    ServerConn *next;
+    ServerConn *held_prev;
+    ServerConn *held_next;
+    ServerConn *watch_prev;
+    ServerConn *watch_next;
+    bool held;
+    bool watching;
+    bool closed;
+    uint32_t events;
+    uint64_t held_lsn;
+    size_t in_len;
+    size_t out_len;
+    size_t out_pos;
+    size_t out_ready;
+    uint8_t in[SERVER_READ_BUFFER];
+    uint8_t out[SERVER_WRITE_BUFFER];
+    SpectateWatcher watcher;
+};
+
+/* Closes fd if open and marks it closed. */
+static void close_fd(int *fd) {
+    if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+/* Binds a non-blocking Unix stream listener at path. */
+static int listen_unix(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Unix socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket(AF_UNIX)");
+        return -1;
+    }
+    unlink(path);
+    if (bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SERVER_LISTEN_BACKLOG) != 0) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Binds a non-blocking TCP listener; *port receives the bound port. */
+static int listen_tcp(const char *host, int *port) {
+    char service[16];
+    snprintf(service, sizeof(service), "%d", *port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    struct addrinfo *list = NULL;
+    int rc = getaddrinfo(host, service, &hints, &list);
+    if (rc != 0) {
+        fprintf(stderr, "Cannot resolve %s: %s\n", host != NULL ? host : "*", gai_strerror(rc));
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = list; ai != NULL && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || listen(fd, SERVER_LISTEN_BACKLOG) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(list);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot listen on TCP port %d: %s\n", *port, strerror(errno));
+        return -1;
+    }
+
+    struct sockaddr_storage bound;
+    socklen_t len = sizeof(bound);
+    if (getsockname(fd, (struct sockaddr *)&bound, &len) == 0) {
+        if (bound.ss_family == AF_INET) {
+            *port = ntohs(((struct sockaddr_in *)&bound)->sin_port);
+        } else if (bound.ss_family == AF_INET6) {
+            *port = ntohs(((struct sockaddr_in6 *)&bound)->sin6_port);
+        }
+    }
+    return fd;
+}
+
+/* Registers a handle with a worker's epoll set. */
+static bool watch(ServerWorker *worker, ServerHandle *handle, uint32_t events) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = handle;
+    return epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, handle->fd, &ev) == 0;
+}
+
+/* Returns a fresh session id owned by this worker's shard. */
+static uint32_t mint_session_id(ServerWorker *worker) {
+    uint32_t workers = (uint32_t)worker->server->config.workers;
+    uint32_t id;
+    do {
+        id = ++worker->next_session * workers + (uint32_t)worker->index;
+    } while (id == 0);
+    return id;
+}
+
+/* Rotates x left by b bits. */
+static uint64_t rotl64(uint64_t x, int b) {
+    return x << b | x >> (64 - b);
+}
+
+/* One SipHash round over the four state words. */
+static void sip_round(uint64_t *v) {
+    v[0] += v[1];
+    v[1] = rotl64(v[1], 13) ^ v[0];
+    v[0] = rotl64(v[0], 32);
+    v[2] += v[3];
+    v[3] = rotl64(v[3], 16) ^ v[2];
+    v[0] += v[3];
+    v[3] = rotl64(v[3], 21) ^ v[0];
+    v[2] += v[1];
+    v[1] = rotl64(v[1], 17) ^ v[2];
+    v[2] = rotl64(v[2], 32);
+}
+
+/* Returns the token that authorizes changes to session: SipHash-2-4 of the
+   id under the server key, so ids can be public while tokens can't be
+   guessed from them. */
+static uint64_t session_token(const Server *server, uint32_t session) {
+    uint64_t k0 = server->session_key[0];
+    uint64_t k1 = server->session_key[1];
+    uint64_t v[4] = {k0 ^ 0x736f6d6570736575ull, k1 ^ 0x646f72616e646f6dull, k0 ^ 0x6c7967656e657261ull,
+                     k1 ^ 0x7465646279746573ull};
+    const uint64_t blocks[2] = {session, (uint64_t)8 << 56};
+    for (int i = 0; i < 2; ++i) {
+        v[3] ^= blocks[i];
+        sip_round(v);
+        sip_round(v);
+        v[0] ^= blocks[i];
+    }
+    v[2] ^= 0xff;
+    for (int i = 0; i < 4; ++i) {
+        sip_round(v);
+    }
+    return v[0] ^ v[1] ^ v[2] ^ v[3];
+}
+
+/* Reads exactly n bytes from fd. */
+static bool read_full(int fd, uint8_t *buf, size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        ssize_t got = read(fd, buf + done, n - done);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        done += (size_t)got;
+    }
+    return true;
+}
+
+/* Writes all bytes at the current offset. */
+static bool write_full(int fd, const uint8_t *buf, size_t n) {
+    while (n > 0) {
+        ssize_t put = write(fd, buf, n);
+        if (put < 0 && errno == EINTR) {
+            continue;
+        }
+        if (put <= 0) {
+            return false;
+        }
+        buf += put;
+        n -= (size_t)put;
+    }
+    return true;
+}
+
+/* Builds the path of a file kept next to the journal. */
+static bool journal_side_path(const Server *server, const char *suffix, char *out, size_t cap) {
+    const char *journal = server->config.journal_path;
+    if (snprintf(out, cap, "%s%s", journal, suffix) >= (int)cap) {
+        fprintf(stderr, "Journal path too long: %s\n", journal);
+        return false;
+    }
+    return true;
+}
+
+/* Returns true if a checkpoint or a non-empty journal exists, i.e. there
+   are sessions whose tokens depend on the stored key. */
+static bool journal_has_sessions(const Server *server) {
+    char snap[4096];
+    struct stat st;
+    if (!journal_side_path(server, ".snap", snap, sizeof(snap)) || stat(snap, &st) == 0) {
+        return true;
+    }
+    return stat(server->config.journal_path, &st) == 0 && st.st_size > 0;
+}
+
+/* Fills the session key from /dev/urandom. With a journal the key is
+   loaded from, or first written to, <journal>.key so that recovered
+   sessions keep their tokens; a missing or short key next to existing
+   sessions fails startup rather than locking their owners out. */
+static bool load_session_key(Server *server) {
+    uint8_t key[SERVER_KEY_BYTES];
+    char path[4096];
+    const char *journal = server->config.journal_path;
+    if (journal != NULL && !journal_side_path(server, ".key", path, sizeof(path))) {
+        return false;
+    }
+
+    int fd = journal != NULL ? open(path, O_RDONLY | O_CLOEXEC) : -1;
+    if (journal != NULL && fd < 0 && errno != ENOENT) {
+        perror(path);
+        return false;
+    }
+    bool loaded = fd >= 0 && read_full(fd, key, sizeof(key));
+    close_fd(&fd);
+    if (!loaded && journal != NULL && journal_has_sessions(server)) {
+        fprintf(stderr, "%s: session key missing or short while the journal holds sessions\n", path);
+        return false;
+    }
+    if (!loaded) {
+        fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+        bool random = fd >= 0 && read_full(fd, key, sizeof(key));
+        close_fd(&fd);
+        if (!random) {
+            perror("/dev/urandom");
+            return false;
+        }
+        if (journal != NULL) {
+            fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            bool saved = fd >= 0 && write_full(fd, key, sizeof(key)) && fsync(fd) == 0;
+            close_fd(&fd);
+            if (!saved) {
+                fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+                return false;
+            }
+        }
+    }
+    memcpy(&server->session_key[0], key, 8);
+    memcpy(&server->session_key[1], key + 8, 8);
+    return true;
+}
+
+/* Stores v little-endian. */
+static void store_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* Loads a little-endian u32. */
+static uint32_t load_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* Checkpoint image being filled by sessions_visit. */
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+} CheckpointImage;
+
+/* Appends one session: id, score, rng state, packed board and meta. */
+static void checkpoint_entry(void *ctx, uint32_t id, const SessionPacked *packed) {
+    CheckpointImage *image = (CheckpointImage *)ctx;
+    if (image->len + SERVER_CHECKPOINT_ENTRY > image->cap) {
+        return;
+    }
+    uint8_t *p = image->buf + image->len;
+    store_u32(p, id);
+    store_u32(p + 4, packed->score);
+    store_u32(p + 8, packed->rng_state);
+    memcpy(p + 12, packed->board, SESSIONS_PACKED_BOARD_BYTES);
+    memcpy(p + 12 + SESSIONS_PACKED_BOARD_BYTES, packed->meta, sizeof(packed->meta));
+    image->len += SERVER_CHECKPOINT_ENTRY;
+}
+
+/* Makes a rename in path's directory durable. */
+static bool sync_parent_dir(const char *path) {
+    char dir[4096];
+    const char *slash = strrchr(path, '/');
+    if (slash == NULL) {
+        strcpy(dir, ".");
+    } else if (slash == path) {
+        strcpy(dir, "/");
+    } else {
+        size_t len = (size_t)(slash - path);
+        if (len >= sizeof(dir)) {
+            return false;
+        }
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+    }
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    bool ok = fd >= 0 && fsync(fd) == 0;
+    close_fd(&fd);
+    return ok;
+}
+
+/* Loads <journal>.snap if present: a header (magic, version, generation,
+   session count), one fixed entry per session and a CRC-32 of the rest.
+   Sessions come back hibernated. A missing file is an empty checkpoint; a
+   damaged one stops startup, since the journal it replaced is gone. */
+static bool load_checkpoint(Server *server) {
+    char path[4096];
+    if (!journal_side_path(server, ".snap", path, sizeof(path))) {
+        return false;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        perror(path);
+        return false;
+    }
+
+    off_t size = lseek(fd, 0, SEEK_END);
+    uint8_t *buf = size >= SERVER_CHECKPOINT_HEADER + 4 ? (uint8_t *)malloc((size_t)size) : NULL;
+    bool ok = buf != NULL && lseek(fd, 0, SEEK_SET) == 0 && read_full(fd, buf, (size_t)size);
+    close_fd(&fd);
+    size_t body = (size_t)size - 4;
+    uint32_t count = ok ? load_u32(buf + 12) : 0;
+    ok = ok && load_u32(buf) == SERVER_CHECKPOINT_MAGIC && load_u32(buf + 4) == SERVER_CHECKPOINT_VERSION &&
+         load_u32(buf + body) == movelog_crc32(buf, body) &&
+         body == SERVER_CHECKPOINT_HEADER + (size_t)count * SERVER_CHECKPOINT_ENTRY;
+    for (uint32_t i = 0; ok && i < count; ++i) {
+        const uint8_t *p = buf + SERVER_CHECKPOINT_HEADER + (size_t)i * SERVER_CHECKPOINT_ENTRY;
+        SessionPacked packed;
+        uint32_t id = load_u32(p);
+        packed.score = load_u32(p + 4);
+        packed.rng_state = load_u32(p + 8);
+        memcpy(packed.board, p + 12, SESSIONS_PACKED_BOARD_BYTES);
+        memcpy(packed.meta, p + 12 + SESSIONS_PACKED_BOARD_BYTES, sizeof(packed.meta));
+        ok = sessions_insert_packed(&server->sessions, id, &packed);
+        if (id > server->journal_max_session) {
+            server->journal_max_session = id;
+        }
+    }
+    if (ok) {
+        server->checkpoint_generation = load_u32(buf + 8);
+        server->checkpoint_loaded = true;
+        server->checkpoint_sessions = count;
+    } else {
+        fprintf(stderr, "Cannot load checkpoint %s\n", path);
+    }
+    free(buf);
+    return ok;
+}
+
+/* Writes every session to a new <journal>.snap (temporary file, fsync,
+   rename) and restarts the journal with a record naming that checkpoint,
+   so the next startup replays only what came after it. A crash between
+   the two steps leaves a journal whose first record names an older
+   checkpoint, and recovery skips it. */
+static bool checkpoint_journal(Server *server) {
+    char path[4096];
+    char tmp[4096];
+    if (!journal_side_path(server, ".snap", path, sizeof(path)) ||
+        !journal_side_path(server, ".snap.tmp", tmp, sizeof(tmp))) {
+        return false;
+    }
+
+    uint32_t generation = server->checkpoint_generation + 1;
+    size_t count = sessions_count(&server->sessions);
+    CheckpointImage image;
+    image.cap = SERVER_CHECKPOINT_HEADER + count * SERVER_CHECKPOINT_ENTRY + 4;
+    image.len = SERVER_CHECKPOINT_HEADER;
+    image.buf = (uint8_t *)malloc(image.cap);
+    if (image.buf == NULL) {
+        fprintf(stderr, "Cannot allocate checkpoint\n");
+        return false;
+    }
+    store_u32(image.buf, SERVER_CHECKPOINT_MAGIC);
+    store_u32(image.buf + 4, SERVER_CHECKPOINT_VERSION);
+    store_u32(image.buf + 8, generation);
+    store_u32(image.buf + 12, (uint32_t)count);
+    sessions_visit(&server->sessions, checkpoint_entry, &image);
+    store_u32(image.buf + image.len, movelog_crc32(image.buf, image.len));
+    image.len += 4;
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 && write_full(fd, image.buf, image.len) && fsync(fd) == 0;
+    close_fd(&fd);
+    free(image.buf);
+    if (!ok || rename(tmp, path) != 0 || !sync_parent_dir(path)) {
+        fprintf(stderr, "Cannot write checkpoint %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    MoveLogRecord head;
+    memset(&head, 0, sizeof(head));
+    head.type = SERVER_JOURNAL_CHECKPOINT;
+    head.seed = generation;
+    if (!movelog_restart(&server->journal, &head)) {
+        return false;
+    }
+    server->checkpoint_generation = generation;
+    return true;
+}
+
+/* Milliseconds on the monotonic clock. */
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/* Picks a game seed when the client leaves it 0. */
+static uint32_t pick_seed(uint32_t session) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint32_t seed = (uint32_t)ts.tv_nsec ^ (uint32_t)ts.tv_sec ^ session * 2654435761u;
+    return seed != 0 ? seed : 1u;
+}
+
+/* Adds or removes a connection on the worker's list of spectators. */
+static void set_watching(ServerWorker *worker, ServerConn *conn, bool watching) {
+    if (conn->watching == watching) {
+        return;
+    }
+    if (watching) {
+        conn->watch_prev = NULL;
+        conn->watch_next = worker->watching;
+        if (worker->watching != NULL) {
+            worker->watching->watch_prev = conn;
+        }
+        worker->watching = conn;
+    } else {
+        if (conn->watch_prev != NULL) {
+            conn->watch_prev->watch_next = conn->watch_next;
+        } else {
+            worker->watching = conn->watch_next;
+        }
+        if (conn->watch_next != NULL) {
+            conn->watch_next->watch_prev = conn->watch_prev;
+        }
+        conn->watch_prev = NULL;
+        conn->watch_next = NULL;
+    }
+    conn->watching = watching;
+}
+
+/* Subscribes conn to a session's spectator frames; session 0 unsubscribes.
+   The keyframe is queued under the session lock so no turn can slip in
+   between it and the first delta. */
+static void handle_watch(ServerWorker *worker, ServerConn *conn, const ProtoRequest *req, ProtoReply *reply) {
+    SpectateHub *hub = &worker->server->spectators;
+    if (req->session == 0) {
+        spectate_unwatch(hub, &conn->watcher);
+        set_watching(worker, conn, false);
+    } else {
+        SessionTable *sessions = &worker->server->sessions;
+        Session *session = sessions_acquire(sessions, req->session, worker->now_ms);
+        if (session == NULL) {
+            proto_error_reply(req, PROTO_ERR_NO_SESSION, reply);
+            return;
+        }
+        /* The session lock is held, so everything it journaled so far is
+           at or before the journal's end. */
+        uint64_t lsn = worker->server->journal_open ? movelog_appended(&worker->server->journal) : 0;
+        spectate_watch(hub, &conn->watcher, session->id, &session->game, lsn);
+        sessions_release(sessions, session);
+        set_watching(worker, conn, conn->watcher.session != 0);
+        if (!conn->watching) {
+            proto_error_reply(req, PROTO_ERR_FULL, reply);
+            return;
+        }
+    }
+    memset(reply, 0, sizeof(*reply));
+    reply->type = PROTO_REPLY_WATCH;
+    reply->status = PROTO_OK;
+    reply->session = req->session;
+    reply->tag = req->tag;
+}
+
+/* Milliseconds since the Unix epoch. */
+static uint64_t wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/* Answers TOP and RANK from the leaderboard's in-memory indexes. */
+static void handle_leaderboard(Server *server, const ProtoRequest *req, ProtoReply *reply) {
+    if (!server->leaderboard_open) {
+        proto_error_reply(req, PROTO_ERR_UNAVAILABLE, reply);
+        return;
+    }
+    memset(reply, 0, sizeof(*reply));
+    reply->status = PROTO_OK;
+    reply->session = req->session;
+    reply->tag = req->tag;
+    reply->total = leaderboard_count(&server->leaderboard);
+    if (req->type == PROTO_RANK) {
+        reply->type = PROTO_REPLY_RANK;
+        reply->rank = leaderboard_rank(&server->leaderboard, req->score);
+        return;
+    }
+
+    LeaderboardEntry entries[PROTO_MAX_ENTRIES];
+    size_t want = req->count < PROTO_MAX_ENTRIES ? req->count : PROTO_MAX_ENTRIES;
+    size_t n = leaderboard_top(&server->leaderboard, req->offset, want, entries);
+    reply->type = PROTO_REPLY_TOP;
+    reply->entry_count = (uint8_t)n;
+    for (size_t i = 0; i < n; ++i) {
+        reply->entry_session[i] = entries[i].session;
+        reply->entry_score[i] = entries[i].score;
+    }
+}
+
+/* Records one finished game on the leaderboard. */
+static void submit_result(Server *server, const ServerResult *result) {
+    if (!leaderboard_submit(&server->leaderboard, result->session, result->score, result->finished_ms, NULL)) {
+        fprintf(stderr, "Cannot record result of session %u\n", (unsigned)result->session);
+    }
+}
+
+/* Ranks a finished game once the journal record at lsn is durable, so a
+   crash can neither roll back a ranked game nor rank a replayed one
+   twice. Without a journal (lsn 0) it is ranked at once. */
+static void queue_result(ServerWorker *worker, uint32_t session, int32_t score, uint64_t lsn) {
+    ServerResult result = {lsn, wall_ms(), session, score};
+    if (lsn == 0) {
+        submit_result(worker->server, &result);
+        return;
+    }
+    if (worker->result_count == worker->result_cap) {
+        size_t cap = worker->result_cap > 0 ? worker->result_cap * 2 : 16;
+        ServerResult *grown = (ServerResult *)realloc(worker->results, cap * sizeof(ServerResult));
+        if (grown == NULL) {
+            fprintf(stderr, "Cannot queue result of session %u\n", (unsigned)session);
+            return;
+        }
+        worker->results = grown;
+        worker->result_cap = cap;
+    }
+    worker->results[worker->result_count++] = result;
+}
+
+/* Ranks queued games whose records are durable. A worker appends in LSN
+   order, so they form a prefix of its queue. */
+static void submit_durable_results(ServerWorker *worker, uint64_t durable) {
+    size_t done = 0;
+    while (done < worker->result_count && worker->results[done].lsn <= durable) {
+        submit_result(worker->server, &worker->results[done]);
+        ++done;
+    }
+    if (done > 0) {
+        memmove(worker->results, worker->results + done, (worker->result_count - done) * sizeof(ServerResult));
+        worker->result_count -= done;
+    }
+}
+
+/* Resolves the request's session and applies the request to it. Returns
+   the journal LSN the reply must wait for, or 0 if it need not wait. */
+static uint64_t handle_request(ServerWorker *worker, ServerConn *conn, const ProtoRequest *req, ProtoReply *reply) {
+    if (req->type == PROTO_WATCH) {
+        handle_watch(worker, conn, req, reply);
+        return 0;
+    }
+    if (req->type == PROTO_TOP || req->type == PROTO_RANK) {
+        handle_leaderboard(worker->server, req, reply);
+        return 0;
+    }
+
+    SessionTable *sessions = &worker->server->sessions;
+    Session *session;
+    bool created = false;
+    if (req->type == PROTO_NEW_GAME && req->session == 0) {
+        session = sessions_create(sessions, mint_session_id(worker), worker->now_ms);
+        if (session == NULL) {
+            proto_error_reply(req, PROTO_ERR_FULL, reply);
+            return 0;
+        }
+        created = true;
+    } else {
+        /* STATE stays open to anyone who knows the id; every change needs
+           the token handed out when the session was created. */
+        if (req->type != PROTO_STATE && req->token != session_token(worker->server, req->session)) {
+            proto_error_reply(req, PROTO_ERR_FORBIDDEN, reply);
+            return 0;
+        }
+        session = sessions_acquire(sessions, req->session, worker->now_ms);
+        if (session == NULL) {
+            proto_error_reply(req, PROTO_ERR_NO_SESSION, reply);
+            return 0;
+        }
+    }
+
+    ProtoRequest applied = *req;
+    applied.session = session->id;
+    if (applied.type == PROTO_NEW_GAME && applied.seed == 0) {
+        applied.seed = pick_seed(session->id);
+    }
+    proto_apply(&session->game, &applied, reply);
+    if (applied.type == PROTO_NEW_GAME && reply->status == PROTO_OK) {
+        reply->token = session_token(worker->server, session->id);
+    }
+
+    /* Appending under the session lock keeps each game's records in the
+       order its requests were applied. A STATE reply may show turns
+       another connection made, so it waits for everything journaled so
+       far, like a new watcher's keyframe. */
+    uint64_t lsn = 0;
+    if (worker->server->journal_open && applied.type == PROTO_STATE) {
+        lsn = movelog_appended(&worker->server->journal);
+    } else if (worker->server->journal_open && reply->status == PROTO_OK) {
+        MoveLogRecord record;
+        record.session = applied.session;
+        record.seed = applied.type == PROTO_NEW_GAME ? applied.seed : 0;
+        record.type = applied.type;
+        record.a = applied.type == PROTO_MOVE ? applied.from : applied.cell;
+        record.b = applied.type == PROTO_MOVE ? applied.to : 0;
+        lsn = movelog_append(&worker->server->journal, &record);
+    }
+    if (applied.type == PROTO_MOVE && reply->action == GAME_ACTION_GAME_OVER && worker->server->leaderboard_open) {
+        queue_result(worker, session->id, session->game.score, lsn);
+    }
+    /* Publishing under the session lock keeps spectator seqs in turn order. */
+    if (applied.type == PROTO_MOVE &&
+        (reply->action == GAME_ACTION_MOVED || reply->action == GAME_ACTION_GAME_OVER)) {
+        spectate_publish_move(&worker->server->spectators, session->id, reply, &session->game, lsn);
+    } else if (applied.type == PROTO_NEW_GAME && !created) {
+        spectate_publish_reset(&worker->server->spectators, session->id, &session->game, lsn);
+    }
+    sessions_release(sessions, session);
+    return lsn;
+}
+
+/* Rebuilds one journaled request during recovery. */
+static void replay_record(void *ctx, const MoveLogRecord *record) {
+    Server *server = (Server *)ctx;
+    if (record->type == SERVER_JOURNAL_CHECKPOINT) {
+        /* A journal not restarted after the loaded checkpoint is already
+           folded into it. */
+        server->journal_current = !server->checkpoint_loaded || record->seed == server->checkpoint_generation;
+        return;
+    }
+    if (!server->journal_current) {
+        return;
+    }
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = record->type;
+    req.session = record->session;
+    req.seed = record->seed;
+    req.cell = record->a;
+    req.from = record->a;
+    req.to = record->b;
+
+    Session *session = sessions_acquire(&server->sessions, req.session, 0);
+    if (session == NULL && req.type == PROTO_NEW_GAME) {
+        session = sessions_create(&server->sessions, req.session, 0);
+    }
+    if (session == NULL) {
+        return;
+    }
+    ProtoReply reply;
+    proto_apply(&session->game, &req, &reply);
+    sessions_release(&server->sessions, session);
+    if (req.session > server->journal_max_session) {
+        server->journal_max_session = req.session;
+    }
+    ++server->journal_replayed;
+}
+
+/* Returns the journal LSN that held replies and spectator frames may be
+   sent up to; everything goes out at once without a journal. */
+static uint64_t durable_lsn(Server *server) {
+    return server->journal_open ? movelog_durable(&server->journal) : UINT64_MAX;
+}
+
+/* Takes a connection off the worker's waiting-for-durability list. */
+static void held_remove(ServerWorker *worker, ServerConn *conn) {
+    if (!conn->held) {
+        return;
+    }
+    if (conn->held_prev != NULL) {
+        conn->held_prev->held_next = conn->held_next;
+    } else {
+        worker->held = conn->held_next;
+    }
+    if (conn->held_next != NULL) {
+        conn->held_next->held_prev = conn->held_prev;
+    }
+    conn->held_prev = NULL;
+    conn->held_next = NULL;
+    conn->held = false;
+}
+
+/* Marks buffered replies sendable once their journal records are durable;
+   otherwise parks the connection until the next commit. */
+static void conn_release_durable(ServerWorker *worker, ServerConn *conn) {
+    if (conn->held_lsn == 0 || conn->held_lsn <= movelog_durable(&worker->server->journal)) {
+        conn->out_ready = conn->out_len;
+        conn->held_lsn = 0;
+        held_remove(worker, conn);
+    } else if (!conn->held) {
+        conn->held_prev = NULL;
+        conn->held_next = worker->held;
+        if (worker->held != NULL) {
+            worker->held->held_prev = conn;
+        }
+        worker->held = conn;
+        conn->held = true;
+    }
+}
+
+/* Closes a connection and moves it to the worker's closed list. It is only
+   freed by free_closed once the current epoll batch is done, since later
+   events in the batch may still point at it. */
+static void conn_close(ServerWorker *worker, ServerConn *conn) {
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, conn->handle.fd, NULL);
+    close_fd(&conn->handle.fd);
+    held_remove(worker, conn);
+    set_watching(worker, conn, false);
+    spectate_watcher_destroy(&worker->server->spectators, &conn->watcher);
+    if (conn->prev != NULL) {
+        conn->prev->next = conn->next;
+    } else {
+        worker->conns = conn->next;
+    }
+    if (conn->next != NULL) {
+        conn->next->prev = conn->prev;
+    }
+    conn->closed = true;
+    conn->prev = NULL;
+    conn->next = worker->closed;
+    worker->closed = conn;
+}
+
+/* Frees connections closed since the last call. */
+static void free_closed(ServerWorker *worker) {
+    while (worker->closed != NULL) {
+        ServerConn *next = worker->closed->next;
+        free(worker->closed);
+        worker->closed = next;
+    }
+}
+
+/* Decodes buffered requests while a full reply still fits in the output
+   buffer; returns false on a malformed frame. Replies behind a journal
+   record stay unsent until it is durable, and so does anything after them. */
+static bool conn_process(ServerWorker *worker, ServerConn *conn) {
+    size_t pos = 0;
+    while (SERVER_WRITE_BUFFER - conn->out_len >= PROTO_MAX_FRAME) {
+        ProtoRequest req;
+        int used = proto_decode_request(conn->in + pos, conn->in_len - pos, &req);
+        if (used < 0) {
+            return false;
+        }
+        if (used == 0) {
+            break;
+        }
+        pos += (size_t)used;
+
+        ProtoReply reply;
+        uint64_t lsn = handle_request(worker, conn, &req, &reply);
+        if (lsn > conn->held_lsn) {
+            conn->held_lsn = lsn;
+        }
+        int written = proto_encode_reply(&reply, conn->out + conn->out_len, SERVER_WRITE_BUFFER - conn->out_len);
+        if (written < 0) {
+            return false;
+        }
+        conn->out_len += (size_t)written;
+        atomic_fetch_add_explicit(&worker->requests, 1, memory_order_relaxed);
+    }
+
+    if (pos > 0) {
+        memmove(conn->in, conn->in + pos, conn->in_len - pos);
+        conn->in_len -= pos;
+    }
+    conn_release_durable(worker, conn);
+    return true;
+}
+
+/* Writes sendable replies, then pushed spectator frames straight from
+   their shared buffers; returns false if the peer is gone. Frames never
+   interleave: replies wait while a pushed frame is half sent. */
+static bool conn_flush(Server *server, ServerConn *conn) {
+    for (;;) {
+        bool push = conn->out_pos == conn->out_ready || spectate_watcher_midframe(&conn->watcher);
+        ssize_t n;
+        if (push) {
+            struct iovec iov[SERVER_PUSH_IOV];
+            int count = spectate_watcher_iov(&conn->watcher, iov, SERVER_PUSH_IOV, durable_lsn(server));
+            if (count == 0) {
+                break;
+            }
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = (size_t)count;
+            n = sendmsg(conn->handle.fd, &msg, MSG_NOSIGNAL);
+            if (n > 0) {
+                spectate_watcher_consume(&conn->watcher, (size_t)n);
+                continue;
+            }
+        } else {
+            n = send(conn->handle.fd, conn->out + conn->out_pos, conn->out_ready - conn->out_pos, MSG_NOSIGNAL);
+            if (n > 0) {
+                conn->out_pos += (size_t)n;
+                continue;
+            }
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    /* Slide held replies to the front so the buffer regains room. */
+    if (conn->out_pos > 0) {
+        memmove(conn->out, conn->out + conn->out_pos, conn->out_len - conn->out_pos);
+        conn->out_len -= conn->out_pos;
+        conn->out_ready = 0;
+        conn->out_pos = 0;
+    }
+    return true;
+}
+
+/* Re-arms epoll for input while there is buffer room and for output while
+   replies or pushed frames are pending. */
+static bool conn_rearm(ServerWorker *worker, ServerConn *conn) {
+    uint32_t events = 0;
+    if (conn->in_len < SERVER_READ_BUFFER) {
+        events |= EPOLLIN;
+    }
+    if (conn->out_pos < conn->out_ready || spectate_watcher_pending(&conn->watcher, durable_lsn(worker->server))) {
+        events |= EPOLLOUT;
+    }
+    if (events == conn->events) {
+        return true;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = &conn->handle;
+    conn->events = events;
+    return epoll_ctl(worker->epoll_fd, EPOLL_CTL_MOD, conn->handle.fd, &ev) == 0;
+}
+
+/* Handles readiness on a connection: read, process, write, re-arm. */
+static void conn_service(ServerWorker *worker, ServerConn *conn, uint32_t events) {
+    if ((events & (EPOLLERR | EPOLLHUP)) != 0 && (events & EPOLLIN) == 0) {
+        conn_close(worker, conn);
+        return;
+    }
+
+    if ((events & EPOLLIN) != 0) {
+        while (conn->in_len < SERVER_READ_BUFFER) {
+            ssize_t n = recv(conn->handle.fd, conn->in + conn->in_len, SERVER_READ_BUFFER - conn->in_len, 0);
+            if (n > 0) {
+                conn->in_len += (size_t)n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                conn_close(worker, conn);
+                return;
+            }
+            break;
+        }
+    }
+
+    /* Draining output frees room for more replies, so alternate. */
+    for (;;) {
+        size_t in_before = conn->in_len;
+        size_t out_before = conn->out_len;
+        if (!conn_process(worker, conn) || !conn_flush(worker->server, conn)) {
+            conn_close(worker, conn);
+            return;
+        }
+        bool progressed = conn->in_len != in_before || conn->out_len < out_before;
+        if (conn->out_len > 0 || !progressed) {
+            break;
+        }
+    }
+
+    if (!conn_rearm(worker, conn)) {
+        conn_close(worker, conn);
+    }
+}
+
+/* Accepts a batch of pending connections onto this worker. */
+static void accept_batch(ServerWorker *worker, const ServerHandle *listener) {
+    for (int i = 0; i < SERVER_ACCEPT_BATCH; ++i) {
+        int fd = accept4(listener->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("accept4");
+            }
+            return;
+        }
+        if (listener == &worker->server->tcp_listener) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        ServerConn *conn = (ServerConn *)malloc(sizeof(ServerConn));
+        if (conn == NULL) {
+            close(fd);
+            return;
+        }
+        conn->handle.kind = SERVER_HANDLE_CONN;
+        conn->handle.fd = fd;
+        conn->events = EPOLLIN;
+        conn->in_len = 0;
+        conn->out_len = 0;
+        conn->out_pos = 0;
+        conn->out_ready = 0;
+        conn->held_lsn = 0;
+        conn->held = false;
+        conn->held_prev = NULL;
+        conn->held_next = NULL;
+        conn->closed = false;
+        conn->watching = false;
+        conn->watch_prev = NULL;
+        conn->watch_next = NULL;
+        spectate_watcher_init(&conn->watcher, worker->spectate.fd);
+        conn->prev = NULL;
+        conn->next = worker->conns;
+        if (!watch(worker, &conn->handle, EPOLLIN)) {
+            close(fd);
+            spectate_watcher_destroy(&worker->server->spectators, &conn->watcher);
+            free(conn);
+            return;
+        }
+        if (worker->conns != NULL) {
+            worker->conns->prev = conn;
+        }
+        worker->conns = conn;
+        atomic_fetch_add_explicit(&worker->connections, 1, memory_order_relaxed);
+    }
+}
+
+/* Ranks games and sends replies and spectator frames whose journal
+   records the last commit made durable; results go first, so a client
+   that sees its game-over reply also finds the game on the leaderboard. */
+static void release_held(ServerWorker *worker) {
+    uint64_t count = 0;
+    ssize_t n = read(worker->durable.fd, &count, sizeof(count));
+    (void)n;
+    uint64_t durable = movelog_durable(&worker->server->journal);
+    submit_durable_results(worker, durable);
+
+    ServerConn *conn = worker->held;
+    while (conn != NULL) {
+        ServerConn *next = conn->held_next;
+        if (conn->held_lsn <= durable) {
+            conn_release_durable(worker, conn);
+            conn_service(worker, conn, 0);
+        }
+        conn = next;
+    }
+    conn = worker->watching;
+    while (conn != NULL) {
+        ServerConn *next = conn->watch_next;
+        if (spectate_watcher_pending(&conn->watcher, durable)) {
+            conn_service(worker, conn, 0);
+        }
+        conn = next;
+    }
+}
+
+/* Writes spectator frames that other workers queued for this worker's
+   connections. */
+static void push_spectators(ServerWorker *worker) {
+    uint64_t count = 0;
+    ssize_t n = read(worker->spectate.fd, &count, sizeof(count));
+    (void)n;
+
+    ServerConn *conn = worker->watching;
+    while (conn != NULL) {
+        ServerConn *next = conn->watch_next;
+        if (spectate_watcher_pending(&conn->watcher, durable_lsn(worker->server))) {
+            conn_service(worker, conn, 0);
+        }
+        conn = next;
+    }
+}
+
+/* Worker thread: waits on its epoll set until the stop event fires. */
+static void *worker_main(void *data) {
+    ServerWorker *worker = (ServerWorker *)data;
+    Server *server = worker->server;
+    struct epoll_event events[SERVER_EPOLL_BATCH];
+    uint64_t idle_ms = server->config.hibernate_after_ms > 0 ? (uint64_t)server->config.hibernate_after_ms : 0;
+    /* Sweeping at half the threshold bounds how long past it a game stays live. */
+    int timeout = idle_ms == 0 ? -1 : (int)(idle_ms / 2 < SERVER_SWEEP_MS ? idle_ms / 2 + 1 : SERVER_SWEEP_MS);
+    uint64_t last_sweep = monotonic_ms();
+
+    while (!atomic_load(&server->stopping)) {
+        int n = epoll_wait(worker->epoll_fd, events, SERVER_EPOLL_BATCH, timeout);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            break;
+        }
+
+        worker->now_ms = monotonic_ms();
+        if (idle_ms != 0 && worker->now_ms - last_sweep >= (uint64_t)timeout) {
+            /* Each worker owns the shard its session ids map to. */
+            sessions_hibernate_idle(&server->sessions, worker->index, worker->now_ms, idle_ms);
+            last_sweep = worker->now_ms;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            ServerHandle *handle = (ServerHandle *)events[i].data.ptr;
+            if (handle->kind == SERVER_HANDLE_STOP) {
+                break;
+            }
+            if (handle->kind == SERVER_HANDLE_LISTENER) {
+                accept_batch(worker, handle);
+            } else if (handle->kind == SERVER_HANDLE_DURABLE) {
+                release_held(worker);
+            } else if (handle->kind == SERVER_HANDLE_SPECTATE) {
+                push_spectators(worker);
+            } else if (!((ServerConn *)handle)->closed) {
+                conn_service(worker, (ServerConn *)handle, events[i].events);
+            }
+        }
+        free_closed(worker);
+    }
+
+    while (worker->conns != NULL) {
+        conn_close(worker, worker->conns);
+    }
+    free_closed(worker);
+    return NULL;
+}
+
+/* Recovers sessions from the journal and opens the leaderboard if
+   configured, binds the listeners and prepares workers; returns false and
+   prints the reason on failure (call server_shutdown either way). */
+bool server_init(Server *server, const ServerConfig *config) {
+    memset(server, 0, sizeof(*server));
+    server->config = *config;
+    server->unix_listener.kind = SERVER_HANDLE_LISTENER;
+    server->unix_listener.fd = -1;
+    server->tcp_listener.kind = SERVER_HANDLE_LISTENER;
+    server->tcp_listener.fd = -1;
+    server->stop.kind = SERVER_HANDLE_STOP;
+    server->stop.fd = -1;
+    atomic_init(&server->stopping, false);
+    for (int w = 0; w < SERVER_MAX_WORKERS; ++w) {
+        server->workers[w].epoll_fd = -1;
+        server->workers[w].durable.kind = SERVER_HANDLE_DURABLE;
+        server->workers[w].durable.fd = -1;
+        server->workers[w].spectate.kind = SERVER_HANDLE_SPECTATE;
+        server->workers[w].spectate.fd = -1;
+    }
+
+    if (config->workers <= 0 || config->workers > SERVER_MAX_WORKERS) {
+        fprintf(stderr, "workers must be in [1..%d]\n", SERVER_MAX_WORKERS);
+        return false;
+    }
+    if (config->unix_path == NULL && config->tcp_port < 0) {
+        fprintf(stderr, "No listener configured\n");
+        return false;
+    }
+    if (!sessions_init(&server->sessions, config->workers)) {
+        fprintf(stderr, "Cannot allocate session table\n");
+        return false;
+    }
+    spectate_init(&server->spectators, config->workers);
+    if (!load_session_key(server)) {
+        return false;
+    }
+    if (config->journal_path != NULL) {
+        if (!load_checkpoint(server)) {
+            return false;
+        }
+        server->journal_current = !server->checkpoint_loaded;
+        if (!movelog_open(&server->journal, config->journal_path, config->journal_window_ms, replay_record, server)) {
+            return false;
+        }
+        server->journal_open = true;
+        if (!checkpoint_journal(server)) {
+            return false;
+        }
+    }
+    if (config->leaderboard_path != NULL) {
+        if (!leaderboard_open(&server->leaderboard, config->leaderboard_path, 0)) {
+            return false;
+        }
+        server->leaderboard_open = true;
+    }
+
+    if (config->unix_path != NULL && (server->unix_listener.fd = listen_unix(config->unix_path)) < 0) {
+        return false;
+    }
+    if (config->tcp_port >= 0) {
+        server->tcp_port = config->tcp_port;
+        if ((server->tcp_listener.fd = listen_tcp(config->tcp_host, &server->tcp_port)) < 0) {
+            return false;
+        }
+    }
+    server->stop.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server->stop.fd < 0) {
+        perror("eventfd");
+        return false;
+    }
+
+    for (int w = 0; w < config->workers; ++w) {
+        ServerWorker *worker = &server->workers[w];
+        worker->server = server;
+        worker->index = w;
+        atomic_init(&worker->requests, 0);
+        atomic_init(&worker->connections, 0);
+        /* Minting above every recovered id keeps new sessions distinct
+           even if the worker count changed since the journal was written. */
+        worker->next_session = server->journal_max_session / (uint32_t)config->workers;
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (worker->epoll_fd < 0 || !watch(worker, &server->stop, EPOLLIN)) {
+            perror("epoll");
+            return false;
+        }
+        worker->spectate.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (worker->spectate.fd < 0 || !watch(worker, &worker->spectate, EPOLLIN)) {
+            perror("eventfd(spectate)");
+            return false;
+        }
+        if (server->journal_open) {
+            worker->durable.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (worker->durable.fd < 0 || !watch(worker, &worker->durable, EPOLLIN) ||
+                !movelog_add_notify(&server->journal, worker->durable.fd)) {
+                perror("eventfd(journal)");
+                return false;
+            }
+        }
+        /* EPOLLEXCLUSIVE wakes one worker per incoming connection. */
+        if ((server->unix_listener.fd >= 0 && !watch(worker, &server->unix_listener, EPOLLIN | EPOLLEXCLUSIVE)) ||
+            (server->tcp_listener.fd >= 0 && !watch(worker, &server->tcp_listener, EPOLLIN | EPOLLEXCLUSIVE))) {
+            perror("epoll_ctl(listener)");
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Starts the worker threads. */
+bool server_start(Server *server) {
+    if (server->journal_open && !movelog_start(&server->journal)) {
+        return false;
+    }
+    for (int w = 0; w < server->config.workers; ++w) {
+        ServerWorker *worker = &server->workers[w];
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+            fprintf(stderr, "Cannot start worker %d\n", w);
+            return false;
+        }
+        worker->started = true;
+    }
+    return true;
+}
+
+/* Stops and joins workers, closes every socket and frees all sessions. */
+void server_shutdown(Server *server) {
+    atomic_store(&server->stopping, true);
+    if (server->stop.fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(server->stop.fd, &one, sizeof(one));
+        (void)n;
+    }
+
+    for (int w = 0; w < SERVER_MAX_WORKERS; ++w) {
+        ServerWorker *worker = &server->workers[w];
+        if (worker->started) {
+            pthread_join(worker->thread, NULL);
+            worker->started = false;
+        }
+        close_fd(&worker->epoll_fd);
+    }
+
+    /* Workers are gone, so nothing appends while the last batch commits;
+       after that every queued result is durable. */
+    if (server->journal_open) {
+        movelog_close(&server->journal);
+        server->journal_open = false;
+    }
+    for (int w = 0; w < SERVER_MAX_WORKERS; ++w) {
+        ServerWorker *worker = &server->workers[w];
+        if (server->leaderboard_open) {
+            submit_durable_results(worker, UINT64_MAX);
+        }
+        free(worker->results);
+        worker->results = NULL;
+        worker->result_count = 0;
+        worker->result_cap = 0;
+    }
+    for (int w = 0; w < SERVER_MAX_WORKERS; ++w) {
+        close_fd(&server->workers[w].durable.fd);
+        close_fd(&server->workers[w].spectate.fd);
+    }
+
+    close_fd(&server->stop.fd);
+    close_fd(&server->tcp_listener.fd);
+    if (server->unix_listener.fd >= 0) {
+        close_fd(&server->unix_listener.fd);
+        unlink(server->config.unix_path);
+    }
+    if (server->leaderboard_open) {
+        leaderboard_close(&server->leaderboard);
+        server->leaderboard_open = false;
+    }
+    if (server->spectators.shard_count > 0) {
+        spectate_shutdown(&server->spectators);
+    }
+    if (server->sessions.shard_count > 0) {
+        sessions_shutdown(&server->sessions);
+    }
+}
+
+/* Reads request/connection/session counters, session memory, journal,
+   spectator and leaderboard activity. */
+void server_get_stats(Server *server, ServerStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    for (int w = 0; w < server->config.workers && w < SERVER_MAX_WORKERS; ++w) {
+        stats->requests += atomic_load(&server->workers[w].requests);
+        stats->connections += atomic_load(&server->workers[w].connections);
+    }
+    if (server->sessions.shard_count > 0) {
+        stats->sessions = sessions_count(&server->sessions);
+        sessions_memory(&server->sessions, &stats->memory);
+    }
+    stats->checkpoint_sessions = server->checkpoint_sessions;
+    stats->journal_replayed = server->journal_replayed;
+    if (server->journal_open) {
+        stats->journal_commits = atomic_load(&server->journal.commits);
+        stats->journal_records = atomic_load(&server->journal.records);
+    }
+    stats->spectator_frames = atomic_load(&server->spectators.frames_encoded);
+    stats->spectator_pushes = atomic_load(&server->spectators.frames_queued);
+    if (server->leaderboard_open) {
+        stats->leaderboard_results = leaderboard_count(&server->leaderboard);
+    }
+}
@@ -0,0 +1,152 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "leaderboard.h"
+#include "movelog.h"
+#include "sessions.h"
+#include "spectate.h"
+
+#define SERVER_MAX_WORKERS SESSIONS_MAX_SHARDS
+#define SERVER_READ_BUFFER 4096
+#define SERVER_WRITE_BUFFER 8192
+#define SERVER_EPOLL_BATCH 64
+#define SERVER_SWEEP_MS 1000
+#define SERVER_PUSH_IOV 16
+
+/* Listener and pool settings. tcp_port -1 disables TCP, 0 picks a free
+   port; unix_path NULL disables the Unix socket. Sessions idle for
+   hibernate_after_ms are packed until their next request (0 keeps every
+   session live). With journal_path set, every state-changing request is
+   journaled and its reply held until a group commit makes it durable;
+   journal_window_ms is how long a commit may wait to gather more. At
+   startup the recovered sessions are checkpointed to journal_path.snap and
+   the journal restarted, so it only holds the current run's requests. With
+   leaderboard_path set, finished games are recorded there and served by
+   TOP and RANK requests; with a journal too, a game is only recorded once
+   its final move is durable. */
+typedef struct {
+    const char *unix_path;
+    const char *tcp_host;
+    int tcp_port;
+    int workers;
+    int hibernate_after_ms;
+    const char *journal_path;
+    int journal_window_ms;
+    const char *leaderboard_path;
+} ServerConfig;
+
+/* What an epoll registration points at. */
+typedef enum {
+    SERVER_HANDLE_LISTENER = 0,
+    SERVER_HANDLE_STOP = 1,
+    SERVER_HANDLE_CONN = 2,
+    SERVER_HANDLE_DURABLE = 3,
+    SERVER_HANDLE_SPECTATE = 4
+} ServerHandleKind;
+
+/* First member of everything registered with epoll. */
+typedef struct {
+    ServerHandleKind kind;
+    int fd;
+} ServerHandle;
+
+typedef struct ServerConn ServerConn;
+typedef struct Server Server;
+
+/* Finished game waiting for the journal to make its last move durable
+   before it is ranked. */
+typedef struct {
+    uint64_t lsn;
+    uint64_t finished_ms;
+    uint32_t session;
+    int32_t score;
+} ServerResult;
+
+/* One event-loop thread with its own epoll set and connections. */
+typedef struct {
+    Server *server;
+    int index;
+    int epoll_fd;
+    pthread_t thread;
+    bool started;
+    uint32_t next_session;
+    uint64_t now_ms;
+    ServerConn *conns;
+    ServerConn *held;
+    ServerConn *watching;
+    ServerConn *closed;
+    ServerResult *results;
+    size_t result_count;
+    size_t result_cap;
+    ServerHandle durable;
+    ServerHandle spectate;
+    atomic_ullong requests;
+    atomic_ullong connections;
+} ServerWorker;
+
+/* Multi-session game server: listeners are shared by every worker's
+   epoll set (EPOLLEXCLUSIVE), each accepted connection stays on the
+   worker that accepted it, and sessions live in a table sharded by
+   session id % workers. Connections that WATCH a session get its turns
+   pushed through the spectator hub. session_key derives each session's
+   token; it is kept next to the journal so tokens survive a restart. */
+struct Server {
+    ServerConfig config;
+    ServerHandle unix_listener;
+    ServerHandle tcp_listener;
+    ServerHandle stop;
+    int tcp_port;
+    atomic_bool stopping;
+    SessionTable sessions;
+    SpectateHub spectators;
+    uint64_t session_key[2];
+    MoveLog journal;
+    bool journal_open;
+    bool journal_current;
+    uint32_t journal_max_session;
+    unsigned long long journal_replayed;
+    uint32_t checkpoint_generation;
+    bool checkpoint_loaded;
+    unsigned long long checkpoint_sessions;
+    Leaderboard leaderboard;
+    bool leaderboard_open;
+    ServerWorker workers[SERVER_MAX_WORKERS];
+};
+
+/* Counters summed over workers. */
+typedef struct {
+    unsigned long long requests;
+    unsigned long long connections;
+    size_t sessions;
+    SessionMemory memory;
+    unsigned long long checkpoint_sessions;
+    unsigned long long journal_replayed;
+    unsigned long long journal_commits;
+    unsigned long long journal_records;
+    unsigned long long spectator_frames;
+    unsigned long long spectator_pushes;
+    unsigned long long leaderboard_results;
+} ServerStats;
+
+/* Recovers sessions from the journal and opens the leaderboard if
+   configured, binds the listeners and prepares workers; returns false and
+   prints the reason on failure (call server_shutdown either way). */
+bool server_init(Server *server, const ServerConfig *config);
+
+/* Starts the worker threads. */
+bool server_start(Server *server);
+
+/* Stops and joins workers, closes every socket and frees all sessions. */
+void server_shutdown(Server *server);
+
+/* Reads request/connection/session counters, session memory, journal,
+   spectator and leaderboard activity. */
+void server_get_stats(Server *server, ServerStats *stats);
+
+#endif
@@ -0,0 +1,170 @@
+/* Headless multi-session Lines-98 server.
+   Runs until SIGINT/SIGTERM, then prints request and session totals. */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "server.h"
+
+#define SERVER_DEFAULT_PORT 9898
+#define SERVER_DEFAULT_WORKERS 4
+#define SERVER_DEFAULT_HIBERNATE_MS 60000
+#define SERVER_DEFAULT_JOURNAL_WINDOW_MS 2
+
+/* Splits "[HOST:]PORT" into host (NULL for all interfaces) and port. */
+static bool parse_endpoint(char *spec, const char **host, int *port) {
+    char *colon = strrchr(spec, ':');
+    char *port_text = spec;
+    *host = NULL;
+    if (colon != NULL) {
+        *colon = '\0';
+        *host = spec[0] != '\0' ? spec : NULL;
+        port_text = colon + 1;
+    }
+    char *end = NULL;
+    long value = strtol(port_text, &end, 10);
+    if (end == port_text || *end != '\0' || value < 0 || value > 65535) {
+        return false;
+    }
+    *port = (int)value;
+    return true;
+}
+
+/* Parses flags; returns false and prints usage on bad input. */
+static bool parse_options(int argc, char **argv, ServerConfig *config) {
+    config->unix_path = NULL;
+    config->tcp_host = "127.0.0.1";
+    config->tcp_port = -1;
+    config->workers = SERVER_DEFAULT_WORKERS;
+    config->hibernate_after_ms = SERVER_DEFAULT_HIBERNATE_MS;
+    config->journal_path = NULL;
+    config->journal_window_ms = SERVER_DEFAULT_JOURNAL_WINDOW_MS;
+    config->leaderboard_path = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "--unix") == 0 && has_value) {
+            config->unix_path = argv[++i];
+        } else if (strcmp(arg, "--tcp") == 0 && has_value) {
+            if (!parse_endpoint(argv[++i], &config->tcp_host, &config->tcp_port)) {
+                fprintf(stderr, "--tcp expects [HOST:]PORT\n");
+                return false;
+            }
+        } else if (strcmp(arg, "--workers") == 0 && has_value) {
+            config->workers = atoi(argv[++i]);
+        } else if (strcmp(arg, "--hibernate-after") == 0 && has_value) {
+            config->hibernate_after_ms = atoi(argv[++i]);
+        } else if (strcmp(arg, "--journal") == 0 && has_value) {
+            config->journal_path = argv[++i];
+        } else if (strcmp(arg, "--journal-window") == 0 && has_value) {
+            config->journal_window_ms = atoi(argv[++i]);
+        } else if (strcmp(arg, "--leaderboard") == 0 && has_value) {
+            config->leaderboard_path = argv[++i];
+        } else {
+            fprintf(
+                stderr,
+                "usage: %s [--unix PATH] [--tcp [HOST:]PORT] [--workers N] [--hibernate-after MS]\n"
+                "          [--journal PATH] [--journal-window MS] [--leaderboard PATH]\n",
+                argv[0]
+            );
+            return false;
+        }
+    }
+
+    if (config->unix_path == NULL && config->tcp_port < 0) {
+        config->tcp_port = SERVER_DEFAULT_PORT;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    ServerConfig config;
+    if (!parse_options(argc, argv, &config)) {
+        return 2;
+    }
+
+    /* Workers inherit the blocked mask, so only sigwait sees the signals. */
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    static Server server;
+    if (!server_init(&server, &config) || !server_start(&server)) {
+        server_shutdown(&server);
+        return 1;
+    }
+
+    if (config.unix_path != NULL) {
+        printf("lines98_server: listening on unix:%s\n", config.unix_path);
+    }
+    if (config.tcp_port >= 0) {
+        printf("lines98_server: listening on tcp:%s:%d\n", config.tcp_host != NULL ? config.tcp_host : "*", server.tcp_port);
+    }
+    printf("lines98_server: %d workers, hibernate after %d ms\n", config.workers, config.hibernate_after_ms);
+    if (config.journal_path != NULL) {
+        ServerStats recovered;
+        server_get_stats(&server, &recovered);
+        printf(
+            "lines98_server: journal %s (window %d ms), %llu sessions from checkpoint + %llu records replayed = %zu "
+            "sessions\n",
+            config.journal_path,
+            config.journal_window_ms,
+            recovered.checkpoint_sessions,
+            recovered.journal_replayed,
+            recovered.sessions
+        );
+    }
+    if (config.leaderboard_path != NULL) {
+        ServerStats loaded;
+        server_get_stats(&server, &loaded);
+        printf("lines98_server: leaderboard %s, %llu results\n", config.leaderboard_path, loaded.leaderboard_results);
+    }
+    fflush(stdout);
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+
+    ServerStats stats;
+    server_get_stats(&server, &stats);
+    server_shutdown(&server);
+    printf(
+        "lines98_server: stopped (requests=%llu connections=%llu sessions=%zu)\n",
+        stats.requests,
+        stats.connections,
+        stats.sessions
+    );
+    printf(
+        "lines98_server: live=%zu (%zu B, slabs %zu B) hibernated=%zu (%zu B, slabs %zu B) index=%zu B "
+        "hibernations=%llu restores=%llu\n",
+        stats.memory.live_sessions,
+        stats.memory.live_bytes,
+        stats.memory.live_slab_bytes,
+        stats.memory.hibernated_sessions,
+        stats.memory.hibernated_bytes,
+        stats.memory.hibernated_slab_bytes,
+        stats.memory.index_bytes,
+        (unsigned long long)stats.memory.hibernations,
+        (unsigned long long)stats.memory.restores
+    );
+    if (config.journal_path != NULL) {
+        printf(
+            "lines98_server: journal commits=%llu records=%llu\n",
+            stats.journal_commits,
+            stats.journal_records
+        );
+    }
+    printf(
+        "lines98_server: spectator frames=%llu pushes=%llu\n",
+        stats.spectator_frames,
+        stats.spectator_pushes
+    );
+    if (config.leaderboard_path != NULL) {
+        printf("lines98_server: leaderboard results=%llu\n", stats.leaderboard_results);
+    }
+    return 0;
+}
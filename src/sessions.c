@@ -0,0 +1,362 @@
+/* Sharded session store for the game server.
+   Each shard is a linear-probing index of SessionSlot entries with its own
+   mutex; lookups hold the shard lock while the caller uses the game. Live
+   games come from a cache-aligned slab and sit on an LRU list; idle ones
+   are packed into a second, much denser slab and unpacked on next use. */
+
+#include "sessions.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SESSIONS_INITIAL_CAPACITY 64
+#define SESSIONS_CELL_BITS 3
+#define SESSIONS_CELL_MASK 0x7u
+
+/* Spreads ids across slots; ids in one shard share their low residue. */
+static size_t slot_hash(uint32_t id, size_t capacity) {
+    return (size_t)((id * 2654435761u) >> 7) & (capacity - 1);
+}
+
+/* Returns the shard owning id. */
+static SessionShard *shard_for(SessionTable *table, uint32_t id) {
+    return &table->shards[id % (uint32_t)table->shard_count];
+}
+
+/* Finds the slot holding id or the empty slot where it belongs. */
+static size_t find_slot(const SessionShard *shard, uint32_t id) {
+    size_t i = slot_hash(id, shard->capacity);
+    while (shard->slots[i].id != 0 && shard->slots[i].id != id) {
+        i = (i + 1) & (shard->capacity - 1);
+    }
+    return i;
+}
+
+/* Doubles a shard's index; returns false on OOM. */
+static bool grow(SessionShard *shard) {
+    size_t capacity = shard->capacity * 2;
+    SessionSlot *slots = (SessionSlot *)calloc(capacity, sizeof(SessionSlot));
+    if (slots == NULL) {
+        return false;
+    }
+
+    SessionSlot *old = shard->slots;
+    size_t old_capacity = shard->capacity;
+    shard->slots = slots;
+    shard->capacity = capacity;
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old[i].id != 0) {
+            shard->slots[find_slot(shard, old[i].id)] = old[i];
+        }
+    }
+    free(old);
+    return true;
+}
+
+/* Unlinks a live session from the LRU list. */
+static void lru_remove(SessionShard *shard, Session *session) {
+    if (session->lru_prev != NULL) {
+        session->lru_prev->lru_next = session->lru_next;
+    } else {
+        shard->lru_head = session->lru_next;
+    }
+    if (session->lru_next != NULL) {
+        session->lru_next->lru_prev = session->lru_prev;
+    } else {
+        shard->lru_tail = session->lru_prev;
+    }
+    session->lru_prev = NULL;
+    session->lru_next = NULL;
+}
+
+/* Appends a live session as the most recently used. */
+static void lru_append(SessionShard *shard, Session *session) {
+    session->lru_prev = shard->lru_tail;
+    session->lru_next = NULL;
+    if (shard->lru_tail != NULL) {
+        shard->lru_tail->lru_next = session;
+    } else {
+        shard->lru_head = session;
+    }
+    shard->lru_tail = session;
+}
+
+/* Marks a live session used at now_ms. */
+static void touch(SessionShard *shard, Session *session, uint64_t now_ms) {
+    session->last_used_ms = now_ms;
+    if (shard->lru_tail != session) {
+        lru_remove(shard, session);
+        lru_append(shard, session);
+    }
+}
+
+/* Packs a game into its hibernated form. */
+static void pack_game(const Game *game, SessionPacked *packed) {
+    memset(packed, 0, sizeof(*packed));
+    packed->score = (uint32_t)game->score;
+    packed->rng_state = game->rng.state;
+    for (int i = 0; i < GAME_CELLS; ++i) {
+        unsigned bit = (unsigned)i * SESSIONS_CELL_BITS;
+        unsigned value = (game->board[i] & SESSIONS_CELL_MASK) << (bit & 7u);
+        packed->board[bit >> 3] |= (uint8_t)value;
+        if ((bit & 7u) > 8u - SESSIONS_CELL_BITS) {
+            packed->board[(bit >> 3) + 1] |= (uint8_t)(value >> 8);
+        }
+    }
+
+    uint32_t meta = 0;
+    for (int i = 0; i < GAME_NEXT_COUNT; ++i) {
+        meta |= (uint32_t)(game->next_colors[i] & SESSIONS_CELL_MASK) << (i * SESSIONS_CELL_BITS);
+    }
+    meta |= (uint32_t)(game->selected_index + 1) << 9;
+    meta |= (game->game_over ? 1u : 0u) << 16;
+    packed->meta[0] = (uint8_t)meta;
+    packed->meta[1] = (uint8_t)(meta >> 8);
+    packed->meta[2] = (uint8_t)(meta >> 16);
+}
+
+/* Restores a game from its hibernated form. */
+static void unpack_game(const SessionPacked *packed, Game *game) {
+    memset(game, 0, sizeof(*game));
+    game->score = (int)packed->score;
+    game->rng.state = packed->rng_state;
+    for (int i = 0; i < GAME_CELLS; ++i) {
+        unsigned bit = (unsigned)i * SESSIONS_CELL_BITS;
+        unsigned value = packed->board[bit >> 3];
+        if ((bit & 7u) > 8u - SESSIONS_CELL_BITS) {
+            value |= (unsigned)packed->board[(bit >> 3) + 1] << 8;
+        }
+        game->board[i] = (uint8_t)((value >> (bit & 7u)) & SESSIONS_CELL_MASK);
+    }
+
+    uint32_t meta = packed->meta[0] | (uint32_t)packed->meta[1] << 8 | (uint32_t)packed->meta[2] << 16;
+    for (int i = 0; i < GAME_NEXT_COUNT; ++i) {
+        game->next_colors[i] = (uint8_t)((meta >> (i * SESSIONS_CELL_BITS)) & SESSIONS_CELL_MASK);
+    }
+    game->selected_index = (int)((meta >> 9) & 0x7Fu) - 1;
+    game->game_over = ((meta >> 16) & 1u) != 0;
+}
+
+/* Initializes shard_count empty shards; returns false on bad count or OOM. */
+bool sessions_init(SessionTable *table, int shard_count) {
+    memset(table, 0, sizeof(*table));
+    if (shard_count <= 0 || shard_count > SESSIONS_MAX_SHARDS) {
+        return false;
+    }
+
+    table->shard_count = shard_count;
+    for (int s = 0; s < shard_count; ++s) {
+        SessionShard *shard = &table->shards[s];
+        pthread_mutex_init(&shard->lock, NULL);
+        slab_init(&shard->live_pool, sizeof(Session), _Alignof(Session));
+        slab_init(&shard->packed_pool, sizeof(SessionPacked), _Alignof(SessionPacked));
+        shard->capacity = SESSIONS_INITIAL_CAPACITY;
+        shard->slots = (SessionSlot *)calloc(shard->capacity, sizeof(SessionSlot));
+        if (shard->slots == NULL) {
+            sessions_shutdown(table);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Frees every session and shard. */
+void sessions_shutdown(SessionTable *table) {
+    for (int s = 0; s < table->shard_count; ++s) {
+        SessionShard *shard = &table->shards[s];
+        free(shard->slots);
+        slab_destroy(&shard->live_pool);
+        slab_destroy(&shard->packed_pool);
+        pthread_mutex_destroy(&shard->lock);
+    }
+    memset(table, 0, sizeof(*table));
+}
+
+/* Locks the shard owning id and returns its session, restoring it first if
+   hibernated, or NULL (unlocked) if there is none or the restore runs out
+   of memory. Marks the session used at now_ms. Pair every non-NULL result
+   with sessions_release. */
+Session *sessions_acquire(SessionTable *table, uint32_t id, uint64_t now_ms) {
+    SessionShard *shard = shard_for(table, id);
+    pthread_mutex_lock(&shard->lock);
+    SessionSlot *slot = &shard->slots[find_slot(shard, id)];
+    if (slot->id == 0) {
+        pthread_mutex_unlock(&shard->lock);
+        return NULL;
+    }
+
+    if (!slot->hibernated) {
+        touch(shard, slot->ptr.live, now_ms);
+        return slot->ptr.live;
+    }
+
+    Session *session = (Session *)slab_alloc(&shard->live_pool);
+    if (session == NULL) {
+        pthread_mutex_unlock(&shard->lock);
+        return NULL;
+    }
+    unpack_game(slot->ptr.packed, &session->game);
+    slab_free(&shard->packed_pool, slot->ptr.packed);
+    session->id = id;
+    session->last_used_ms = now_ms;
+    lru_append(shard, session);
+    slot->hibernated = false;
+    slot->ptr.live = session;
+    --shard->hibernated;
+    ++shard->restores;
+    return session;
+}
+
+/* Locks the shard owning id and inserts a zeroed session used at now_ms,
+   or returns NULL (unlocked) if id is 0, taken, or memory runs out. */
+Session *sessions_create(SessionTable *table, uint32_t id, uint64_t now_ms) {
+    if (id == 0) {
+        return NULL;
+    }
+
+    SessionShard *shard = shard_for(table, id);
+    pthread_mutex_lock(&shard->lock);
+    if ((shard->count + 1) * 10 > shard->capacity * 7 && !grow(shard)) {
+        pthread_mutex_unlock(&shard->lock);
+        return NULL;
+    }
+
+    SessionSlot *slot = &shard->slots[find_slot(shard, id)];
+    Session *session = slot->id == 0 ? (Session *)slab_alloc(&shard->live_pool) : NULL;
+    if (session == NULL) {
+        pthread_mutex_unlock(&shard->lock);
+        return NULL;
+    }
+    memset(session, 0, sizeof(*session));
+    session->id = id;
+    session->last_used_ms = now_ms;
+    lru_append(shard, session);
+    slot->id = id;
+    slot->hibernated = false;
+    slot->ptr.live = session;
+    ++shard->count;
+    return session;
+}
+
+/* Unlocks the shard of a session returned by acquire/create. */
+void sessions_release(SessionTable *table, const Session *session) {
+    pthread_mutex_unlock(&shard_for(table, session->id)->lock);
+}
+
+/* Packs every live session of one shard unused since now_ms - idle_ms;
+   returns how many were hibernated. */
+size_t sessions_hibernate_idle(SessionTable *table, int shard_index, uint64_t now_ms, uint64_t idle_ms) {
+    if (shard_index < 0 || shard_index >= table->shard_count) {
+        return 0;
+    }
+
+    SessionShard *shard = &table->shards[shard_index];
+    size_t packed_count = 0;
+    pthread_mutex_lock(&shard->lock);
+    /* The LRU head is the oldest, so the walk stops at the first recent one. */
+    while (shard->lru_head != NULL && now_ms - shard->lru_head->last_used_ms >= idle_ms) {
+        Session *session = shard->lru_head;
+        SessionPacked *packed = (SessionPacked *)slab_alloc(&shard->packed_pool);
+        if (packed == NULL) {
+            break;
+        }
+        pack_game(&session->game, packed);
+        SessionSlot *slot = &shard->slots[find_slot(shard, session->id)];
+        slot->hibernated = true;
+        slot->ptr.packed = packed;
+        lru_remove(shard, session);
+        slab_free(&shard->live_pool, session);
+        ++shard->hibernated;
+        ++shard->hibernations;
+        ++packed_count;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return packed_count;
+}
+
+/* Calls visit with every session, packing live ones on the fly, while
+   holding one shard lock at a time; returns how many were visited. */
+size_t sessions_visit(SessionTable *table, SessionVisit visit, void *ctx) {
+    size_t visited = 0;
+    for (int s = 0; s < table->shard_count; ++s) {
+        SessionShard *shard = &table->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        for (size_t i = 0; i < shard->capacity; ++i) {
+            const SessionSlot *slot = &shard->slots[i];
+            if (slot->id == 0) {
+                continue;
+            }
+            if (slot->hibernated) {
+                visit(ctx, slot->id, slot->ptr.packed);
+            } else {
+                SessionPacked packed;
+                pack_game(&slot->ptr.live->game, &packed);
+                visit(ctx, slot->id, &packed);
+            }
+            ++visited;
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return visited;
+}
+
+/* Inserts a hibernated session from its packed state; returns false if id
+   is 0, taken, or memory runs out. */
+bool sessions_insert_packed(SessionTable *table, uint32_t id, const SessionPacked *packed) {
+    if (id == 0) {
+        return false;
+    }
+
+    SessionShard *shard = shard_for(table, id);
+    pthread_mutex_lock(&shard->lock);
+    if ((shard->count + 1) * 10 > shard->capacity * 7 && !grow(shard)) {
+        pthread_mutex_unlock(&shard->lock);
+        return false;
+    }
+
+    SessionSlot *slot = &shard->slots[find_slot(shard, id)];
+    SessionPacked *copy = slot->id == 0 ? (SessionPacked *)slab_alloc(&shard->packed_pool) : NULL;
+    if (copy == NULL) {
+        pthread_mutex_unlock(&shard->lock);
+        return false;
+    }
+    *copy = *packed;
+    slot->id = id;
+    slot->hibernated = true;
+    slot->ptr.packed = copy;
+    ++shard->count;
+    ++shard->hibernated;
+    pthread_mutex_unlock(&shard->lock);
+    return true;
+}
+
+/* Total sessions across shards. */
+size_t sessions_count(SessionTable *table) {
+    size_t total = 0;
+    for (int s = 0; s < table->shard_count; ++s) {
+        SessionShard *shard = &table->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        total += shard->count;
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return total;
+}
+
+/* Sums resident memory and hibernation counters across shards. */
+void sessions_memory(SessionTable *table, SessionMemory *memory) {
+    memset(memory, 0, sizeof(*memory));
+    for (int s = 0; s < table->shard_count; ++s) {
+        SessionShard *shard = &table->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        memory->live_sessions += shard->count - shard->hibernated;
+        memory->hibernated_sessions += shard->hibernated;
+        memory->live_bytes += shard->live_pool.in_use * shard->live_pool.object_size;
+        memory->hibernated_bytes += shard->packed_pool.in_use * shard->packed_pool.object_size;
+        memory->live_slab_bytes += slab_reserved_bytes(&shard->live_pool);
+        memory->hibernated_slab_bytes += slab_reserved_bytes(&shard->packed_pool);
+        memory->index_bytes += shard->capacity * sizeof(SessionSlot);
+        memory->hibernations += shard->hibernations;
+        memory->restores += shard->restores;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
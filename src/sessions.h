@@ -0,0 +1,125 @@
+#ifndef SESSIONS_H
+#define SESSIONS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "slab.h"
+
+#define SESSIONS_MAX_SHARDS 64
+#define SESSIONS_CACHE_LINE 64
+#define SESSIONS_PACKED_BOARD_BYTES ((GAME_CELLS * 3 + 7) / 8)
+
+typedef struct Session Session;
+
+/* One live hosted game, cache-line aligned in its shard's slab; with the
+   game first the struct packs into two lines on LP64. The LRU links order
+   a shard's live sessions from least to most recently used. */
+struct Session {
+    _Alignas(SESSIONS_CACHE_LINE) Game game;
+    uint32_t id;
+    uint64_t last_used_ms;
+    Session *lru_prev;
+    Session *lru_next;
+};
+
+/* Hibernated game: 3 bits per cell, and 3 bits per preview color, the
+   selection (+1, 7 bits) and game_over packed into meta. */
+typedef struct {
+    uint32_t score;
+    uint32_t rng_state;
+    uint8_t board[SESSIONS_PACKED_BOARD_BYTES];
+    uint8_t meta[3];
+} SessionPacked;
+
+/* Index entry: id 0 marks an empty slot. */
+typedef struct {
+    uint32_t id;
+    bool hibernated;
+    union {
+        Session *live;
+        SessionPacked *packed;
+    } ptr;
+} SessionSlot;
+
+/* Open-addressed id -> session map guarded by one mutex, with slab pools
+   for live and hibernated sessions. */
+typedef struct {
+    pthread_mutex_t lock;
+    SessionSlot *slots;
+    size_t capacity;
+    size_t count;
+    size_t hibernated;
+    Session *lru_head;
+    Session *lru_tail;
+    SlabPool live_pool;
+    SlabPool packed_pool;
+    uint64_t hibernations;
+    uint64_t restores;
+} SessionShard;
+
+/* Sessions sharded by id % shard_count. Server workers mint ids in their
+   own shard, so a connection's sessions rarely contend with other workers. */
+typedef struct {
+    SessionShard shards[SESSIONS_MAX_SHARDS];
+    int shard_count;
+} SessionTable;
+
+/* Resident memory by session state. *_bytes count objects in use;
+   *_slab_bytes count whole slab blocks held, free slots included. */
+typedef struct {
+    size_t live_sessions;
+    size_t hibernated_sessions;
+    size_t live_bytes;
+    size_t hibernated_bytes;
+    size_t live_slab_bytes;
+    size_t hibernated_slab_bytes;
+    size_t index_bytes;
+    uint64_t hibernations;
+    uint64_t restores;
+} SessionMemory;
+
+/* Initializes shard_count empty shards; returns false on bad count or OOM. */
+bool sessions_init(SessionTable *table, int shard_count);
+
+/* Frees every session and shard. */
+void sessions_shutdown(SessionTable *table);
+
+/* Locks the shard owning id and returns its session, restoring it first if
+   hibernated, or NULL (unlocked) if there is none or the restore runs out
+   of memory. Marks the session used at now_ms. Pair every non-NULL result
+   with sessions_release. */
+Session *sessions_acquire(SessionTable *table, uint32_t id, uint64_t now_ms);
+
+/* Locks the shard owning id and inserts a zeroed session used at now_ms,
+   or returns NULL (unlocked) if id is 0, taken, or memory runs out. */
+Session *sessions_create(SessionTable *table, uint32_t id, uint64_t now_ms);
+
+/* Unlocks the shard of a session returned by acquire/create. */
+void sessions_release(SessionTable *table, const Session *session);
+
+/* Packs every live session of one shard unused since now_ms - idle_ms;
+   returns how many were hibernated. */
+size_t sessions_hibernate_idle(SessionTable *table, int shard, uint64_t now_ms, uint64_t idle_ms);
+
+/* Receives one session's id and packed state from sessions_visit. */
+typedef void (*SessionVisit)(void *ctx, uint32_t id, const SessionPacked *packed);
+
+/* Calls visit with every session, packing live ones on the fly, while
+   holding one shard lock at a time; returns how many were visited. */
+size_t sessions_visit(SessionTable *table, SessionVisit visit, void *ctx);
+
+/* Inserts a hibernated session from its packed state; returns false if id
+   is 0, taken, or memory runs out. */
+bool sessions_insert_packed(SessionTable *table, uint32_t id, const SessionPacked *packed);
+
+/* Total sessions across shards. */
+size_t sessions_count(SessionTable *table);
+
+/* Sums resident memory and hibernation counters across shards. */
+void sessions_memory(SessionTable *table, SessionMemory *memory);
+
+#endif
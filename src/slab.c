@@ -0,0 +1,180 @@
+/* Fixed-size slab allocator.
+   Each block starts with a header followed by per_block objects; free
+   objects inside a block form an intrusive singly linked list. */
+
+#include "slab.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SLAB_MAX_ALIGN 64
+
+/* Block header; doubles as the node on the pool's partial list. */
+struct SlabBlock {
+    SlabBlock *prev;
+    SlabBlock *next;
+    SlabBlock *all_prev;
+    SlabBlock *all_next;
+    void *free_list;
+    size_t used;
+    bool listed;
+};
+
+/* Rounds value up to a multiple of align (a power of two). */
+static size_t round_up(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+/* Returns the block holding object. */
+static SlabBlock *block_of(void *object) {
+    return (SlabBlock *)((uintptr_t)object & ~(uintptr_t)(SLAB_BLOCK_BYTES - 1));
+}
+
+/* Adds a block to the front of the partial list. */
+static void list_push(SlabPool *pool, SlabBlock *block) {
+    block->prev = NULL;
+    block->next = pool->partial;
+    if (pool->partial != NULL) {
+        pool->partial->prev = block;
+    }
+    pool->partial = block;
+    block->listed = true;
+}
+
+/* Removes a block from the partial list. */
+static void list_remove(SlabPool *pool, SlabBlock *block) {
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        pool->partial = block->next;
+    }
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+    block->prev = NULL;
+    block->next = NULL;
+    block->listed = false;
+}
+
+/* Unlinks a block from the pool and gives it back to the system. */
+static void block_release(SlabPool *pool, SlabBlock *block) {
+    if (block->all_prev != NULL) {
+        block->all_prev->all_next = block->all_next;
+    } else {
+        pool->all = block->all_next;
+    }
+    if (block->all_next != NULL) {
+        block->all_next->all_prev = block->all_prev;
+    }
+    --pool->blocks;
+    free(block);
+}
+
+/* Allocates a block and threads all its objects onto its free list. */
+static SlabBlock *block_new(SlabPool *pool) {
+    SlabBlock *block = (SlabBlock *)aligned_alloc(SLAB_BLOCK_BYTES, SLAB_BLOCK_BYTES);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->prev = NULL;
+    block->next = NULL;
+    block->used = 0;
+    block->listed = false;
+    block->free_list = NULL;
+    block->all_prev = NULL;
+    block->all_next = pool->all;
+    if (pool->all != NULL) {
+        pool->all->all_prev = block;
+    }
+    pool->all = block;
+    uint8_t *base = (uint8_t *)block + pool->first_offset;
+    for (size_t i = pool->per_block; i-- > 0;) {
+        void *object = base + i * pool->object_size;
+        *(void **)object = block->free_list;
+        block->free_list = object;
+    }
+    ++pool->blocks;
+    return block;
+}
+
+/* Sets up a pool of object_size objects aligned to align (a power of two
+   no larger than 64); returns false if one block cannot hold an object. */
+bool slab_init(SlabPool *pool, size_t object_size, size_t align) {
+    pool->all = NULL;
+    pool->partial = NULL;
+    pool->spare = NULL;
+    pool->blocks = 0;
+    pool->in_use = 0;
+    if (align < sizeof(void *)) {
+        align = sizeof(void *);
+    }
+    if (align > SLAB_MAX_ALIGN || (align & (align - 1)) != 0) {
+        return false;
+    }
+    pool->object_size = round_up(object_size < sizeof(void *) ? sizeof(void *) : object_size, align);
+    pool->first_offset = round_up(sizeof(SlabBlock), align);
+    if (pool->first_offset + pool->object_size > SLAB_BLOCK_BYTES) {
+        return false;
+    }
+    pool->per_block = (SLAB_BLOCK_BYTES - pool->first_offset) / pool->object_size;
+    return true;
+}
+
+/* Frees every block, including ones with live objects. */
+void slab_destroy(SlabPool *pool) {
+    while (pool->all != NULL) {
+        block_release(pool, pool->all);
+    }
+    pool->partial = NULL;
+    pool->spare = NULL;
+    pool->in_use = 0;
+}
+
+/* Returns an uninitialized object or NULL when out of memory. */
+void *slab_alloc(SlabPool *pool) {
+    SlabBlock *block = pool->partial;
+    if (block == NULL) {
+        block = pool->spare;
+        pool->spare = NULL;
+        if (block == NULL && (block = block_new(pool)) == NULL) {
+            return NULL;
+        }
+        list_push(pool, block);
+    }
+
+    void *object = block->free_list;
+    block->free_list = *(void **)object;
+    ++block->used;
+    ++pool->in_use;
+    if (block->free_list == NULL) {
+        list_remove(pool, block);
+    }
+    return object;
+}
+
+/* Returns an object obtained from slab_alloc on the same pool. */
+void slab_free(SlabPool *pool, void *object) {
+    SlabBlock *block = block_of(object);
+    *(void **)object = block->free_list;
+    block->free_list = object;
+    --block->used;
+    --pool->in_use;
+
+    if (block->used == 0) {
+        if (block->listed) {
+            list_remove(pool, block);
+        }
+        if (pool->spare == NULL) {
+            pool->spare = block;
+        } else {
+            block_release(pool, block);
+        }
+    } else if (!block->listed) {
+        list_push(pool, block);
+    }
+}
+
+/* Bytes of blocks currently held from the system, free slots included. */
+size_t slab_reserved_bytes(const SlabPool *pool) {
+    return pool->blocks * SLAB_BLOCK_BYTES;
+}
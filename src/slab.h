@@ -0,0 +1,43 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SLAB_BLOCK_BYTES 16384
+
+typedef struct SlabBlock SlabBlock;
+
+/* Fixed-size object pool carved from SLAB_BLOCK_BYTES blocks aligned to
+   their own size, so an object's block is found by masking its address.
+   Blocks with free slots sit on a list; allocation and release are O(1)
+   and a block is returned to the system once it empties (one spare is
+   kept to avoid thrashing at the boundary). Not thread-safe. */
+typedef struct {
+    size_t object_size;
+    size_t first_offset;
+    size_t per_block;
+    SlabBlock *all;
+    SlabBlock *partial;
+    SlabBlock *spare;
+    size_t blocks;
+    size_t in_use;
+} SlabPool;
+
+/* Sets up a pool of object_size objects aligned to align (a power of two
+   no larger than 64); returns false if one block cannot hold an object. */
+bool slab_init(SlabPool *pool, size_t object_size, size_t align);
+
+/* Frees every block, including ones with live objects. */
+void slab_destroy(SlabPool *pool);
+
+/* Returns an uninitialized object or NULL when out of memory. */
+void *slab_alloc(SlabPool *pool);
+
+/* Returns an object obtained from slab_alloc on the same pool. */
+void slab_free(SlabPool *pool, void *object);
+
+/* Bytes of blocks currently held from the system, free slots included. */
+size_t slab_reserved_bytes(const SlabPool *pool);
+
+#endif
@@ -0,0 +1,446 @@
+/* Spectator fan-out for hosted games.
+   A turn is encoded once into a reference-counted frame; publishing hands
+   every watcher a pointer to it, and each connection writes the shared
+   bytes straight from the frame. Late joiners and lagging watchers get a
+   packed keyframe, cached per channel until the next turn. Each frame
+   carries the journal LSN of the turn it shows and is not sent before that
+   LSN is durable, so spectators never see a turn a crash could undo. */
+
+#include "spectate.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Returns the shard owning session. */
+static SpectateShard *shard_for(SpectateHub *hub, uint32_t session) {
+    return &hub->shards[session % (uint32_t)hub->shard_count];
+}
+
+/* Returns the bucket head for session within its shard. */
+static SpectateChannel **bucket_for(SpectateShard *shard, uint32_t session) {
+    return &shard->buckets[(session * 2654435761u) >> 24];
+}
+
+/* Finds a session's channel; shard lock held. */
+static SpectateChannel *find_channel(SpectateShard *shard, uint32_t session) {
+    SpectateChannel *channel = *bucket_for(shard, session);
+    while (channel != NULL && channel->session != session) {
+        channel = channel->next;
+    }
+    return channel;
+}
+
+/* Unlinks and frees an empty channel; shard lock held. */
+static void drop_channel(SpectateShard *shard, SpectateChannel *channel) {
+    SpectateChannel **link = bucket_for(shard, channel->session);
+    while (*link != channel) {
+        link = &(*link)->next;
+    }
+    *link = channel->next;
+    if (channel->keyframe != NULL) {
+        spectate_frame_unref(channel->keyframe);
+    }
+    free(channel);
+    --shard->channels;
+}
+
+/* Returns the channel's keyframe for its current seq, encoding it at most
+   once per turn and holding it until lsn is durable; shard lock held. NULL
+   on OOM. */
+static SpectateFrame *channel_keyframe(SpectateHub *hub, SpectateChannel *channel, const Game *game, uint64_t lsn) {
+    if (channel->keyframe != NULL && channel->keyframe_seq == channel->seq) {
+        return channel->keyframe;
+    }
+    ProtoReply reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.type = PROTO_KEYFRAME;
+    reply.session = channel->session;
+    reply.seq = channel->seq;
+    memcpy(reply.board, game->board, GAME_CELLS);
+    memcpy(reply.next_colors, game->next_colors, GAME_NEXT_COUNT);
+    reply.score = game->score;
+    reply.game_over = game->game_over;
+    SpectateFrame *frame = spectate_frame_encode(&reply, lsn);
+    if (frame == NULL) {
+        return NULL;
+    }
+    atomic_fetch_add_explicit(&hub->frames_encoded, 1, memory_order_relaxed);
+    if (channel->keyframe != NULL) {
+        spectate_frame_unref(channel->keyframe);
+    }
+    channel->keyframe = frame;
+    channel->keyframe_seq = channel->seq;
+    return frame;
+}
+
+/* Releases queued frames that have not started sending and are not handed
+   out as iovecs; watcher lock held. */
+static void drop_unsent(SpectateWatcher *watcher) {
+    size_t keep = watcher->head_offset > 0 ? 1 : 0;
+    if (keep < watcher->in_flight) {
+        keep = watcher->in_flight;
+    }
+    while (watcher->count > keep) {
+        size_t tail = (watcher->head + watcher->count - 1) % SPECTATE_QUEUE_FRAMES;
+        spectate_frame_unref(watcher->queue[tail]);
+        --watcher->count;
+    }
+}
+
+/* Queues a reference to frame; false if the queue is full. Watcher lock held. */
+static bool push_frame(SpectateWatcher *watcher, SpectateFrame *frame) {
+    if (watcher->count == SPECTATE_QUEUE_FRAMES) {
+        return false;
+    }
+    spectate_frame_ref(frame);
+    watcher->queue[(watcher->head + watcher->count) % SPECTATE_QUEUE_FRAMES] = frame;
+    ++watcher->count;
+    return true;
+}
+
+/* Signals each distinct wake fd in fds once. */
+static void wake_all(const int *fds, int count) {
+    for (int i = 0; i < count; ++i) {
+        uint64_t one = 1;
+        ssize_t n = write(fds[i], &one, sizeof(one));
+        (void)n;
+    }
+}
+
+/* Adds fd to a small set of fds to wake after publishing. */
+static void note_wake(int *fds, int *count, int fd) {
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < *count; ++i) {
+        if (fds[i] == fd) {
+            return;
+        }
+    }
+    if (*count < SPECTATE_MAX_SHARDS) {
+        fds[(*count)++] = fd;
+    }
+}
+
+/* Queues frame on every watcher of channel, resyncing full queues with a
+   keyframe of game; shard lock held. Returns the fds to wake. */
+static int fan_out(SpectateHub *hub, SpectateChannel *channel, SpectateFrame *frame, const Game *game, int *fds) {
+    int wake_count = 0;
+    for (SpectateWatcher *watcher = channel->watchers; watcher != NULL; watcher = watcher->next) {
+        pthread_mutex_lock(&watcher->lock);
+        if (!push_frame(watcher, frame)) {
+            drop_unsent(watcher);
+            SpectateFrame *keyframe = channel_keyframe(hub, channel, game, frame->lsn);
+            if (keyframe != NULL) {
+                push_frame(watcher, keyframe);
+            }
+            ++watcher->resyncs;
+        }
+        pthread_mutex_unlock(&watcher->lock);
+        atomic_fetch_add_explicit(&hub->frames_queued, 1, memory_order_relaxed);
+        note_wake(fds, &wake_count, watcher->wake_fd);
+    }
+    return wake_count;
+}
+
+/* Initializes shard_count empty shards; returns false on a bad count. */
+bool spectate_init(SpectateHub *hub, int shard_count) {
+    memset(hub, 0, sizeof(*hub));
+    if (shard_count <= 0 || shard_count > SPECTATE_MAX_SHARDS) {
+        return false;
+    }
+    hub->shard_count = shard_count;
+    atomic_init(&hub->frames_encoded, 0);
+    atomic_init(&hub->frames_queued, 0);
+    for (int s = 0; s < shard_count; ++s) {
+        pthread_mutex_init(&hub->shards[s].lock, NULL);
+    }
+    return true;
+}
+
+/* Frees every channel and cached keyframe; watchers must be gone. */
+void spectate_shutdown(SpectateHub *hub) {
+    for (int s = 0; s < hub->shard_count; ++s) {
+        SpectateShard *shard = &hub->shards[s];
+        for (int b = 0; b < SPECTATE_BUCKETS; ++b) {
+            while (shard->buckets[b] != NULL) {
+                drop_channel(shard, shard->buckets[b]);
+            }
+        }
+        pthread_mutex_destroy(&shard->lock);
+    }
+    hub->shard_count = 0;
+}
+
+/* Encodes reply once into a new frame holding one reference, to be sent
+   once lsn is durable. */
+SpectateFrame *spectate_frame_encode(const ProtoReply *reply, uint64_t lsn) {
+    uint8_t buf[PROTO_MAX_FRAME];
+    int len = proto_encode_reply(reply, buf, sizeof(buf));
+    if (len < 0) {
+        return NULL;
+    }
+    SpectateFrame *frame = (SpectateFrame *)malloc(sizeof(SpectateFrame) + (size_t)len);
+    if (frame == NULL) {
+        return NULL;
+    }
+    atomic_init(&frame->refs, 1);
+    frame->lsn = lsn;
+    frame->len = (size_t)len;
+    memcpy(frame->data, buf, (size_t)len);
+    return frame;
+}
+
+/* Adds a reference. */
+void spectate_frame_ref(SpectateFrame *frame) {
+    atomic_fetch_add_explicit(&frame->refs, 1, memory_order_relaxed);
+}
+
+/* Drops a reference, freeing the frame with the last one. */
+void spectate_frame_unref(SpectateFrame *frame) {
+    if (atomic_fetch_sub_explicit(&frame->refs, 1, memory_order_acq_rel) == 1) {
+        free(frame);
+    }
+}
+
+/* Prepares an idle watcher; wake_fd (an eventfd, or -1) is signalled when
+   frames are queued. */
+void spectate_watcher_init(SpectateWatcher *watcher, int wake_fd) {
+    memset(watcher, 0, sizeof(*watcher));
+    pthread_mutex_init(&watcher->lock, NULL);
+    watcher->wake_fd = wake_fd;
+}
+
+/* Unwatches and destroys a watcher. */
+void spectate_watcher_destroy(SpectateHub *hub, SpectateWatcher *watcher) {
+    spectate_unwatch(hub, watcher);
+    pthread_mutex_lock(&watcher->lock);
+    while (watcher->count > 0) {
+        spectate_frame_unref(watcher->queue[watcher->head]);
+        watcher->head = (watcher->head + 1) % SPECTATE_QUEUE_FRAMES;
+        --watcher->count;
+    }
+    pthread_mutex_unlock(&watcher->lock);
+    pthread_mutex_destroy(&watcher->lock);
+}
+
+/* Subscribes watcher to session (leaving any previous one) and queues a
+   keyframe of game, held until lsn (at or past the session's last journal
+   record) is durable. The caller holds the session lock. Returns the
+   keyframe's seq. */
+uint32_t spectate_watch(SpectateHub *hub, SpectateWatcher *watcher, uint32_t session, const Game *game, uint64_t lsn) {
+    spectate_unwatch(hub, watcher);
+
+    SpectateShard *shard = shard_for(hub, session);
+    pthread_mutex_lock(&shard->lock);
+    SpectateChannel *channel = find_channel(shard, session);
+    if (channel == NULL) {
+        channel = (SpectateChannel *)calloc(1, sizeof(SpectateChannel));
+        if (channel == NULL) {
+            pthread_mutex_unlock(&shard->lock);
+            return 0;
+        }
+        channel->session = session;
+        SpectateChannel **bucket = bucket_for(shard, session);
+        channel->next = *bucket;
+        *bucket = channel;
+        ++shard->channels;
+    }
+
+    watcher->session = session;
+    watcher->prev = NULL;
+    watcher->next = channel->watchers;
+    if (channel->watchers != NULL) {
+        channel->watchers->prev = watcher;
+    }
+    channel->watchers = watcher;
+    ++channel->watcher_count;
+
+    SpectateFrame *keyframe = channel_keyframe(hub, channel, game, lsn);
+    pthread_mutex_lock(&watcher->lock);
+    if (keyframe != NULL && !push_frame(watcher, keyframe)) {
+        drop_unsent(watcher);
+        push_frame(watcher, keyframe);
+    }
+    pthread_mutex_unlock(&watcher->lock);
+    uint32_t seq = channel->seq;
+    pthread_mutex_unlock(&shard->lock);
+    return seq;
+}
+
+/* Leaves the watched session and drops queued frames not yet started. */
+void spectate_unwatch(SpectateHub *hub, SpectateWatcher *watcher) {
+    if (watcher->session == 0) {
+        return;
+    }
+
+    SpectateShard *shard = shard_for(hub, watcher->session);
+    pthread_mutex_lock(&shard->lock);
+    SpectateChannel *channel = find_channel(shard, watcher->session);
+    if (watcher->prev != NULL) {
+        watcher->prev->next = watcher->next;
+    } else {
+        channel->watchers = watcher->next;
+    }
+    if (watcher->next != NULL) {
+        watcher->next->prev = watcher->prev;
+    }
+    watcher->prev = NULL;
+    watcher->next = NULL;
+    if (--channel->watcher_count == 0) {
+        drop_channel(shard, channel);
+    }
+    pthread_mutex_lock(&watcher->lock);
+    drop_unsent(watcher);
+    pthread_mutex_unlock(&watcher->lock);
+    pthread_mutex_unlock(&shard->lock);
+    watcher->session = 0;
+}
+
+/* Publishes one turn: move is the session's MOVE reply, game the state
+   after it and lsn its journal record (0 without a journal). Encodes one
+   DELTA and queues it on every watcher; a watcher whose queue is full is
+   resynced with a keyframe instead. The caller holds the session lock. */
+void spectate_publish_move(SpectateHub *hub, uint32_t session, const ProtoReply *move, const Game *game, uint64_t lsn) {
+    SpectateShard *shard = shard_for(hub, session);
+    pthread_mutex_lock(&shard->lock);
+    SpectateChannel *channel = shard->channels > 0 ? find_channel(shard, session) : NULL;
+    if (channel == NULL) {
+        pthread_mutex_unlock(&shard->lock);
+        return;
+    }
+
+    ProtoReply delta = *move;
+    delta.type = PROTO_DELTA;
+    delta.status = PROTO_OK;
+    delta.tag = 0;
+    delta.seq = ++channel->seq;
+    SpectateFrame *frame = spectate_frame_encode(&delta, lsn);
+    int fds[SPECTATE_MAX_SHARDS];
+    int wake_count = 0;
+    if (frame != NULL) {
+        atomic_fetch_add_explicit(&hub->frames_encoded, 1, memory_order_relaxed);
+        wake_count = fan_out(hub, channel, frame, game, fds);
+        spectate_frame_unref(frame);
+    }
+    pthread_mutex_unlock(&shard->lock);
+    wake_all(fds, wake_count);
+}
+
+/* Publishes a restarted game, journaled at lsn, as a keyframe to every
+   watcher. The caller holds the session lock. */
+void spectate_publish_reset(SpectateHub *hub, uint32_t session, const Game *game, uint64_t lsn) {
+    SpectateShard *shard = shard_for(hub, session);
+    pthread_mutex_lock(&shard->lock);
+    SpectateChannel *channel = shard->channels > 0 ? find_channel(shard, session) : NULL;
+    if (channel == NULL) {
+        pthread_mutex_unlock(&shard->lock);
+        return;
+    }
+
+    ++channel->seq;
+    SpectateFrame *keyframe = channel_keyframe(hub, channel, game, lsn);
+    int fds[SPECTATE_MAX_SHARDS];
+    int wake_count = keyframe != NULL ? fan_out(hub, channel, keyframe, game, fds) : 0;
+    pthread_mutex_unlock(&shard->lock);
+    wake_all(fds, wake_count);
+}
+
+/* Fills up to max iovecs with queued bytes, oldest first, stopping at the
+   first frame whose lsn is past durable; returns the count. The frames
+   stay queued until the next watcher_consume, leaving room for a resync
+   keyframe behind them. Only the owning thread may call this and
+   watcher_consume. */
+int spectate_watcher_iov(SpectateWatcher *watcher, struct iovec *iov, int max, uint64_t durable) {
+    pthread_mutex_lock(&watcher->lock);
+    int n = 0;
+    for (size_t i = 0; i < watcher->count && i + 1 < SPECTATE_QUEUE_FRAMES && n < max; ++i) {
+        SpectateFrame *frame = watcher->queue[(watcher->head + i) % SPECTATE_QUEUE_FRAMES];
+        size_t skip = i == 0 ? watcher->head_offset : 0;
+        /* A frame already on the wire must be finished regardless. */
+        if (skip == 0 && frame->lsn > durable) {
+            break;
+        }
+        iov[n].iov_base = frame->data + skip;
+        iov[n].iov_len = frame->len - skip;
+        ++n;
+    }
+    watcher->in_flight = (size_t)n;
+    pthread_mutex_unlock(&watcher->lock);
+    return n;
+}
+
+/* Marks bytes of the last iovecs as sent, releasing fully sent frames. */
+void spectate_watcher_consume(SpectateWatcher *watcher, size_t bytes) {
+    pthread_mutex_lock(&watcher->lock);
+    watcher->in_flight = 0;
+    while (bytes > 0 && watcher->count > 0) {
+        SpectateFrame *frame = watcher->queue[watcher->head];
+        size_t left = frame->len - watcher->head_offset;
+        if (bytes < left) {
+            watcher->head_offset += bytes;
+            break;
+        }
+        bytes -= left;
+        watcher->head_offset = 0;
+        watcher->head = (watcher->head + 1) % SPECTATE_QUEUE_FRAMES;
+        --watcher->count;
+        spectate_frame_unref(frame);
+    }
+    pthread_mutex_unlock(&watcher->lock);
+}
+
+/* Returns true while a queued frame is unsent and sendable at durable. */
+bool spectate_watcher_pending(SpectateWatcher *watcher, uint64_t durable) {
+    pthread_mutex_lock(&watcher->lock);
+    bool pending = watcher->count > 0 &&
+                   (watcher->head_offset > 0 || watcher->queue[watcher->head]->lsn <= durable);
+    pthread_mutex_unlock(&watcher->lock);
+    return pending;
+}
+
+/* Returns true if the oldest queued frame is partly sent, so nothing else
+   may be written to the connection before it. */
+bool spectate_watcher_midframe(SpectateWatcher *watcher) {
+    pthread_mutex_lock(&watcher->lock);
+    bool midframe = watcher->head_offset > 0;
+    pthread_mutex_unlock(&watcher->lock);
+    return midframe;
+}
+
+/* Applies a KEYFRAME or DELTA to a view; returns false on a seq gap or a
+   delta before any keyframe (the view then waits for the next keyframe). */
+bool spectate_view_apply(SpectateView *view, const ProtoReply *frame) {
+    if (frame->type == PROTO_KEYFRAME) {
+        view->synced = true;
+        view->seq = frame->seq;
+        memcpy(view->board, frame->board, GAME_CELLS);
+        memcpy(view->next_colors, frame->next_colors, GAME_NEXT_COUNT);
+        view->score = frame->score;
+        view->game_over = frame->game_over;
+        return true;
+    }
+    if (frame->type != PROTO_DELTA || !view->synced || frame->seq != view->seq + 1) {
+        view->synced = false;
+        return false;
+    }
+
+    if (frame->path_len >= 2) {
+        int from = frame->path[0];
+        int to = frame->path[frame->path_len - 1];
+        view->board[to] = view->board[from];
+        view->board[from] = 0;
+    }
+    for (int i = 0; i < frame->cleared_count; ++i) {
+        view->board[frame->cleared[i]] = 0;
+    }
+    for (int i = 0; i < frame->spawned_count; ++i) {
+        view->board[frame->spawned[i]] = frame->spawned_color[i];
+    }
+    view->seq = frame->seq;
+    memcpy(view->next_colors, frame->next_colors, GAME_NEXT_COUNT);
+    view->score = frame->score;
+    view->game_over = frame->game_over;
+    return true;
+}
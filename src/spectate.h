@@ -0,0 +1,151 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "game.h"
+#include "protocol.h"
+
+#define SPECTATE_MAX_SHARDS 64
+#define SPECTATE_BUCKETS 256
+#define SPECTATE_QUEUE_FRAMES 256
+
+/* One encoded spectator frame, written once and shared by every watcher
+   queue that holds a reference. lsn is the journal position that must be
+   durable before the frame is sent (0 if none). */
+typedef struct {
+    atomic_int refs;
+    uint64_t lsn;
+    size_t len;
+    uint8_t data[];
+} SpectateFrame;
+
+typedef struct SpectateWatcher SpectateWatcher;
+typedef struct SpectateChannel SpectateChannel;
+
+/* Per-connection queue of shared frames. Publishers push under the lock;
+   the owning thread drains it with writev-style iovecs. head_offset is how
+   much of the oldest frame is already on the wire; in_flight counts the
+   frames from head handed out as iovecs, which a resync must not drop
+   until they are consumed. */
+struct SpectateWatcher {
+    pthread_mutex_t lock;
+    SpectateFrame *queue[SPECTATE_QUEUE_FRAMES];
+    size_t head;
+    size_t count;
+    size_t head_offset;
+    size_t in_flight;
+    uint32_t session;
+    int wake_fd;
+    uint64_t resyncs;
+    SpectateWatcher *prev;
+    SpectateWatcher *next;
+};
+
+/* Watchers of one session plus its turn counter and a cached keyframe for
+   late joiners (valid while keyframe_seq == seq). */
+struct SpectateChannel {
+    uint32_t session;
+    uint32_t seq;
+    SpectateWatcher *watchers;
+    size_t watcher_count;
+    SpectateFrame *keyframe;
+    uint32_t keyframe_seq;
+    SpectateChannel *next;
+};
+
+/* Session id -> channel buckets guarded by one mutex. */
+typedef struct {
+    pthread_mutex_t lock;
+    SpectateChannel *buckets[SPECTATE_BUCKETS];
+    size_t channels;
+} SpectateShard;
+
+/* Spectator channels sharded by session id like the session table. Lock
+   order: session, then hub shard, then watcher. */
+typedef struct {
+    SpectateShard shards[SPECTATE_MAX_SHARDS];
+    int shard_count;
+    atomic_ullong frames_encoded;
+    atomic_ullong frames_queued;
+} SpectateHub;
+
+/* Client-side mirror rebuilt from spectator frames. */
+typedef struct {
+    bool synced;
+    uint32_t seq;
+    uint8_t board[GAME_CELLS];
+    uint8_t next_colors[GAME_NEXT_COUNT];
+    int score;
+    bool game_over;
+} SpectateView;
+
+/* Initializes shard_count empty shards; returns false on a bad count. */
+bool spectate_init(SpectateHub *hub, int shard_count);
+
+/* Frees every channel and cached keyframe; watchers must be gone. */
+void spectate_shutdown(SpectateHub *hub);
+
+/* Encodes reply once into a new frame holding one reference, to be sent
+   once lsn is durable. */
+SpectateFrame *spectate_frame_encode(const ProtoReply *reply, uint64_t lsn);
+
+/* Adds a reference. */
+void spectate_frame_ref(SpectateFrame *frame);
+
+/* Drops a reference, freeing the frame with the last one. */
+void spectate_frame_unref(SpectateFrame *frame);
+
+/* Prepares an idle watcher; wake_fd (an eventfd, or -1) is signalled when
+   frames are queued. */
+void spectate_watcher_init(SpectateWatcher *watcher, int wake_fd);
+
+/* Unwatches and destroys a watcher. */
+void spectate_watcher_destroy(SpectateHub *hub, SpectateWatcher *watcher);
+
+/* Subscribes watcher to session (leaving any previous one) and queues a
+   keyframe of game, held until lsn (at or past the session's last journal
+   record) is durable. The caller holds the session lock. Returns the
+   keyframe's seq. */
+uint32_t spectate_watch(SpectateHub *hub, SpectateWatcher *watcher, uint32_t session, const Game *game, uint64_t lsn);
+
+/* Leaves the watched session and drops queued frames not yet started. */
+void spectate_unwatch(SpectateHub *hub, SpectateWatcher *watcher);
+
+/* Publishes one turn: move is the session's MOVE reply, game the state
+   after it and lsn its journal record (0 without a journal). Encodes one
+   DELTA and queues it on every watcher; a watcher whose queue is full is
+   resynced with a keyframe instead. The caller holds the session lock. */
+void spectate_publish_move(SpectateHub *hub, uint32_t session, const ProtoReply *move, const Game *game, uint64_t lsn);
+
+/* Publishes a restarted game, journaled at lsn, as a keyframe to every
+   watcher. The caller holds the session lock. */
+void spectate_publish_reset(SpectateHub *hub, uint32_t session, const Game *game, uint64_t lsn);
+
+/* Fills up to max iovecs with queued bytes, oldest first, stopping at the
+   first frame whose lsn is past durable; returns the count. The frames
+   stay queued until the next watcher_consume, leaving room for a resync
+   keyframe behind them. Only the owning thread may call this and
+   watcher_consume. */
+int spectate_watcher_iov(SpectateWatcher *watcher, struct iovec *iov, int max, uint64_t durable);
+
+/* Marks bytes of the last iovecs as sent, releasing fully sent frames. */
+void spectate_watcher_consume(SpectateWatcher *watcher, size_t bytes);
+
+/* Returns true while a queued frame is unsent and sendable at durable. */
+bool spectate_watcher_pending(SpectateWatcher *watcher, uint64_t durable);
+
+/* Returns true if the oldest queued frame is partly sent, so nothing else
+   may be written to the connection before it. */
+bool spectate_watcher_midframe(SpectateWatcher *watcher);
+
+/* Applies a KEYFRAME or DELTA to a view; returns false on a seq gap or a
+   delta before any keyframe (the view then waits for the next keyframe). */
+bool spectate_view_apply(SpectateView *view, const ProtoReply *frame);
+
+#endif
@@ -0,0 +1,220 @@
+/* Begin/end event tracing exported as Chrome trace-event JSON.
+   Each thread appends to its own chunk of events, so recording takes no
+   locks; chunks are published on a global lock-free list and only walked
+   by trace_stop once the other threads are quiet. */
+
+#include "trace.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TRACE_CHUNK_EVENTS 16384
+
+/* One recorded event; phase is the Chrome "ph" letter (B, E, i, or b/e
+   for async spans, which also carry id). */
+typedef struct {
+    const char *category;
+    const char *name;
+    uint64_t ts_ns;
+    uint64_t id;
+    char phase;
+} TraceEvent;
+
+/* Fixed block of events written only by its owning thread. */
+typedef struct TraceChunk {
+    struct TraceChunk *next;
+    int tid;
+    const char *thread_name;
+    int count;
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+} TraceChunk;
+
+static _Atomic(TraceChunk *) chunks;
+static atomic_bool enabled;
+static atomic_int generation;
+static atomic_int next_tid;
+static atomic_int dropped;
+static uint64_t origin_ns;
+static const char *output_path;
+
+static _Thread_local TraceChunk *local_chunk;
+static _Thread_local int local_chunk_generation;
+static _Thread_local int local_tid;
+static _Thread_local int local_tid_generation;
+static _Thread_local const char *local_thread_name;
+
+/* Returns monotonic time in nanoseconds. */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Allocates a chunk for the calling thread and publishes it on the list. */
+static TraceChunk *new_chunk(int gen) {
+    TraceChunk *chunk = (TraceChunk *)malloc(sizeof(TraceChunk));
+    if (chunk == NULL) {
+        return NULL;
+    }
+
+    if (local_tid_generation != gen) {
+        local_tid = atomic_fetch_add(&next_tid, 1) + 1;
+        local_tid_generation = gen;
+    }
+    chunk->tid = local_tid;
+    chunk->thread_name = local_thread_name;
+    chunk->count = 0;
+
+    TraceChunk *head = atomic_load_explicit(&chunks, memory_order_relaxed);
+    do {
+        chunk->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&chunks, &head, chunk, memory_order_release, memory_order_relaxed));
+    return chunk;
+}
+
+/* Appends one event to the calling thread's current chunk. */
+static void record(char phase, const char *category, const char *name, uint64_t id) {
+    if (!atomic_load_explicit(&enabled, memory_order_acquire)) {
+        return;
+    }
+
+    /* The generation is compared by value before the chunk is touched: a
+       chunk from an earlier session has already been freed by trace_stop. */
+    int gen = atomic_load_explicit(&generation, memory_order_relaxed);
+    TraceChunk *chunk = local_chunk;
+    if (chunk == NULL || local_chunk_generation != gen || chunk->count == TRACE_CHUNK_EVENTS) {
+        chunk = new_chunk(gen);
+        local_chunk = chunk;
+        local_chunk_generation = gen;
+        if (chunk == NULL) {
+            atomic_fetch_add(&dropped, 1);
+            return;
+        }
+    }
+
+    TraceEvent *event = &chunk->events[chunk->count++];
+    event->category = category;
+    event->name = name;
+    event->ts_ns = now_ns();
+    event->id = id;
+    event->phase = phase;
+}
+
+/* Writes a JSON string literal; trace names are plain identifiers. */
+static void write_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (const char *p = s; *p != '\0'; ++p) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', out);
+        }
+        fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+/* Starts recording events; they are written as Chrome/Perfetto trace JSON
+   to path by trace_stop. Returns false if tracing is already running. */
+bool trace_start(const char *path) {
+    if (path == NULL || atomic_load(&enabled)) {
+        return false;
+    }
+    output_path = path;
+    origin_ns = now_ns();
+    atomic_store(&next_tid, 0);
+    atomic_store(&dropped, 0);
+    atomic_fetch_add(&generation, 1);
+    atomic_store_explicit(&enabled, true, memory_order_release);
+    return true;
+}
+
+/* Stops recording, writes the trace file and frees all buffers. Call only
+   after every other instrumented thread has finished emitting. */
+bool trace_stop(void) {
+    if (!atomic_exchange(&enabled, false)) {
+        return false;
+    }
+    /* Retires every thread's local_chunk before the chunks are freed. */
+    atomic_fetch_add(&generation, 1);
+
+    TraceChunk *list = atomic_exchange_explicit(&chunks, NULL, memory_order_acquire);
+    FILE *out = fopen(output_path, "w");
+    if (out != NULL) {
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+        bool first = true;
+        for (TraceChunk *chunk = list; chunk != NULL; chunk = chunk->next) {
+            if (chunk->thread_name != NULL) {
+                fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", chunk->tid);
+                write_json_string(out, chunk->thread_name);
+                fputs("}}", out);
+                first = false;
+            }
+            for (int i = 0; i < chunk->count; ++i) {
+                const TraceEvent *event = &chunk->events[i];
+                double ts_us = (double)(event->ts_ns - origin_ns) / 1000.0;
+                fprintf(out, "%s{\"ph\":\"%c\",\"cat\":", first ? "" : ",\n", event->phase);
+                write_json_string(out, event->category);
+                fputs(",\"name\":", out);
+                write_json_string(out, event->name);
+                if (event->phase == 'b' || event->phase == 'e') {
+                    fprintf(out, ",\"id\":\"0x%" PRIx64 "\"", event->id);
+                }
+                fprintf(out, ",\"ts\":%.3f,\"pid\":1,\"tid\":%d%s}", ts_us, chunk->tid, event->phase == 'i' ? ",\"s\":\"t\"" : "");
+                first = false;
+            }
+        }
+        fprintf(out, "\n],\"otherData\":{\"dropped_events\":%d}}\n", atomic_load(&dropped));
+        fclose(out);
+    }
+
+    while (list != NULL) {
+        TraceChunk *next = list->next;
+        free(list);
+        list = next;
+    }
+    return out != NULL;
+}
+
+/* Returns true while events are being recorded. */
+bool trace_enabled(void) {
+    return atomic_load_explicit(&enabled, memory_order_relaxed);
+}
+
+/* Names the calling thread in the trace. name must outlive the trace. */
+void trace_set_thread_name(const char *name) {
+    local_thread_name = name;
+    if (local_chunk != NULL && local_chunk_generation == atomic_load_explicit(&generation, memory_order_relaxed)) {
+        local_chunk->thread_name = name;
+    }
+}
+
+/* Opens a span on the calling thread. category/name must be string
+   literals or otherwise outlive the trace. */
+void trace_begin(const char *category, const char *name) {
+    record('B', category, name, 0);
+}
+
+/* Closes the innermost span opened by trace_begin on the calling thread. */
+void trace_end(const char *category, const char *name) {
+    record('E', category, name, 0);
+}
+
+/* Records a zero-length marker on the calling thread. */
+void trace_instant(const char *category, const char *name) {
+    record('i', category, name, 0);
+}
+
+/* Opens an async span identified by (category, id). Unlike trace_begin
+   spans it may outlive the caller's enclosing spans, so it suits work
+   spread across frames; async spans sharing an id nest among themselves. */
+void trace_async_begin(const char *category, const char *name, uint64_t id) {
+    record('b', category, name, id);
+}
+
+/* Closes the async span opened with the same category, name and id. */
+void trace_async_end(const char *category, const char *name, uint64_t id) {
+    record('e', category, name, id);
+}
@@ -0,0 +1,39 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Starts recording events; they are written as Chrome/Perfetto trace JSON
+   to path by trace_stop. Returns false if tracing is already running. */
+bool trace_start(const char *path);
+
+/* Stops recording, writes the trace file and frees all buffers. Call only
+   after every other instrumented thread has finished emitting. */
+bool trace_stop(void);
+
+/* Returns true while events are being recorded. */
+bool trace_enabled(void);
+
+/* Names the calling thread in the trace. name must outlive the trace. */
+void trace_set_thread_name(const char *name);
+
+/* Opens a span on the calling thread. category/name must be string
+   literals or otherwise outlive the trace. */
+void trace_begin(const char *category, const char *name);
+
+/* Closes the innermost span opened by trace_begin on the calling thread. */
+void trace_end(const char *category, const char *name);
+
+/* Records a zero-length marker on the calling thread. */
+void trace_instant(const char *category, const char *name);
+
+/* Opens an async span identified by (category, id). Unlike trace_begin
+   spans it may outlive the caller's enclosing spans, so it suits work
+   spread across frames; async spans sharing an id nest among themselves. */
+void trace_async_begin(const char *category, const char *name, uint64_t id);
+
+/* Closes the async span opened with the same category, name and id. */
+void trace_async_end(const char *category, const char *name, uint64_t id);
+
+#endif
@@ -4,6 +4,8 @@
 
 #include "turn_anim.h"
 
+#include "trace.h"
+
 #include <string.h>
 
 /* Clamps path length to valid static storage range. */
@@ -27,11 +29,36 @@ static bool idx_ok(int idx) {
     return idx >= 0 && idx < GAME_CELLS;
 }
 
+/* Trace span names indexed by TurnPhase. */
+static const char *const PHASE_NAMES[] = {"none", "move", "clear", "spawn"};
+
+/* Id of the last turn started; a turn spans several frames, so its trace
+   spans are async and keyed by it. */
+static uint32_t last_trace_id;
+
+/* Switches to phase, closing the previous phase span in the trace. */
+static void enter_phase(TurnAnim *anim, TurnPhase phase) {
+    trace_async_end("turn", PHASE_NAMES[anim->phase], anim->trace_id);
+    trace_async_begin("turn", PHASE_NAMES[phase], anim->trace_id);
+    anim->phase = phase;
+    anim->phase_t = 0.0f;
+}
+
 /* Resets animation state to idle. */
 void turn_anim_init(TurnAnim *anim) {
     memset(anim, 0, sizeof(*anim));
 }
 
+/* Abandons a running animation (restart mid-turn), closing its open phase
+   and turn spans in the trace, and resets to idle. */
+void turn_anim_cancel(TurnAnim *anim) {
+    if (anim->active) {
+        trace_async_end("turn", PHASE_NAMES[anim->phase], anim->trace_id);
+        trace_async_end("turn", "turn", anim->trace_id);
+    }
+    turn_anim_init(anim);
+}
+
 /* Returns true while input should stay blocked due to turn animation. */
 bool turn_anim_active(const TurnAnim *anim) {
     return anim->active;
@@ -52,6 +79,9 @@ void turn_anim_start(
     anim->active = true;
     anim->phase = TURN_PHASE_MOVE;
     anim->phase_t = 0.0f;
+    anim->trace_id = ++last_trace_id;
+    trace_async_begin("turn", "turn", anim->trace_id);
+    trace_async_begin("turn", PHASE_NAMES[TURN_PHASE_MOVE], anim->trace_id);
     anim->move_dur = 0.18f;
     anim->clear_dur = 0.16f;
     anim->spawn_dur = 0.18f;
@@ -143,16 +173,14 @@ void turn_anim_update(
 
     if (anim->phase == TURN_PHASE_MOVE) {
         if (anim->phase_t >= anim->move_dur) {
-            anim->phase = TURN_PHASE_CLEAR;
-            anim->phase_t = 0.0f;
+            enter_phase(anim, TURN_PHASE_CLEAR);
             copy_board(render_board, anim->after_move_board);
             if (emit_clear_particles != NULL) {
                 *emit_clear_particles = true;
             }
             copy_board(render_board, anim->after_clear_board);
             if (anim->cleared_count == 0) {
-                anim->phase = TURN_PHASE_SPAWN;
-                anim->phase_t = 0.0f;
+                enter_phase(anim, TURN_PHASE_SPAWN);
             }
         }
         return;
@@ -161,8 +189,7 @@ void turn_anim_update(
     if (anim->phase == TURN_PHASE_CLEAR) {
         copy_board(render_board, anim->after_clear_board);
         if (anim->phase_t >= anim->clear_dur) {
-            anim->phase = TURN_PHASE_SPAWN;
-            anim->phase_t = 0.0f;
+            enter_phase(anim, TURN_PHASE_SPAWN);
         }
         return;
     }
@@ -178,6 +205,8 @@ void turn_anim_update(
 
         if (anim->phase_t >= anim->spawn_dur) {
             copy_board(render_board, anim->final_board);
+            trace_async_end("turn", PHASE_NAMES[TURN_PHASE_SPAWN], anim->trace_id);
+            trace_async_end("turn", "turn", anim->trace_id);
             turn_anim_init(anim);
         }
     }
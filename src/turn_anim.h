@@ -30,6 +30,7 @@ typedef struct {
     bool active;
     TurnPhase phase;
     float phase_t;
+    uint32_t trace_id;
     float move_dur;
     float clear_dur;
     float spawn_dur;
@@ -53,6 +54,10 @@ typedef struct {
 /* Resets animation state to idle. */
 void turn_anim_init(TurnAnim *anim);
 
+/* Abandons a running animation (restart mid-turn), closing its open phase
+   and turn spans in the trace, and resets to idle. */
+void turn_anim_cancel(TurnAnim *anim);
+
 /* Returns true while input should stay blocked due to turn animation. */
 bool turn_anim_active(const TurnAnim *anim);
 
@@ -3,6 +3,9 @@
 
 #include "turn_controller.h"
 
+#include "engine_counters.h"
+#include "trace.h"
+
 #include <string.h>
 
 /* Converts board row/col to linear index. */
@@ -49,6 +52,7 @@ static bool build_move_path(const uint8_t *board, int from_idx, int to_idx, int
 
     while (head < tail && !found) {
         int cur = queue[head++];
+        ENGINE_COUNT(path_nodes, 1);
         int row;
         int col;
         idx_to_rc(cur, &row, &col);
@@ -106,6 +110,7 @@ void turn_controller_click(Game *game, int row, int col, TurnClickResult *out) {
         return;
     }
 
+    trace_begin("input", "turn_controller_click");
     memcpy(out->before_board, game->board, sizeof(out->before_board));
     out->score_before = game->score;
 
@@ -120,4 +125,5 @@ void turn_controller_click(Game *game, int row, int col, TurnClickResult *out) {
     out->action = game_click(game, row, col);
     out->score_after = game->score;
     out->has_move_animation = (out->action == GAME_ACTION_MOVED || out->action == GAME_ACTION_GAME_OVER);
+    trace_end("input", "turn_controller_click");
 }
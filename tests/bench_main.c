@@ -0,0 +1,535 @@
+/* Microbenchmarks for the rules engine, turn pipeline and particle kernel.
+   Every case runs over a fixed corpus built from seeded games, times
+   batches of operations and reports median/p99 nanoseconds per operation
+   as JSON on stdout. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "engine_counters.h"
+#include "game.h"
+#include "perf_counters.h"
+#include "turn_anim.h"
+#include "turn_controller.h"
+
+#ifdef LINES98_BENCH_PARTICLES
+#include "fx_particles.h"
+#endif
+
+#define BENCH_CORPUS 256
+#define BENCH_DEFAULT_SAMPLES 200
+#define BENCH_MAX_SAMPLES 10000
+#define BENCH_WARMUP_SAMPLES 5
+#define BENCH_ANIM_DT (1.0f / 120.0f)
+#define BENCH_MAX_ANIM_STEPS 512
+
+/* One corpus entry: a mid-game position and a legal move from it. */
+typedef struct {
+    Game game;
+    int from_idx;
+    int to_idx;
+} BenchPosition;
+
+/* Timed case: prepare() sets up untimed inputs for one sample, run()
+   performs ops() operations and returns a value that keeps the work live. */
+typedef struct {
+    const char *name;
+    void (*prepare)(int sample);
+    uint64_t (*run)(void);
+    int (*ops)(void);
+} BenchCase;
+
+static BenchPosition corpus[BENCH_CORPUS];
+static BenchPosition clear_corpus[BENCH_CORPUS];
+static BenchPosition spawn_corpus[BENCH_CORPUS];
+static int spawn_corpus_count;
+static Game work[BENCH_CORPUS];
+static TurnClickResult results[BENCH_CORPUS];
+static TurnAnim anims[BENCH_CORPUS];
+static uint8_t render_boards[BENCH_CORPUS][GAME_CELLS];
+static int anim_steps;
+
+/* Returns monotonic time in nanoseconds. */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Picks a random legal move; returns false when the position has none. */
+static bool pick_move(const Game *game, Rng *rng, int *from_idx, int *to_idx) {
+    int balls[GAME_CELLS];
+    int empties[GAME_CELLS];
+    int ball_count = 0;
+    int empty_count = 0;
+    for (int idx = 0; idx < GAME_CELLS; ++idx) {
+        if (game->board[idx] != 0) {
+            balls[ball_count++] = idx;
+        } else {
+            empties[empty_count++] = idx;
+        }
+    }
+
+    for (int attempt = 0; attempt < 256 && ball_count > 0 && empty_count > 0; ++attempt) {
+        int from = balls[rng_range(rng, (uint32_t)ball_count)];
+        int to = empties[rng_range(rng, (uint32_t)empty_count)];
+        if (game_can_reach(game, from / GAME_BOARD_SIZE, from % GAME_BOARD_SIZE, to / GAME_BOARD_SIZE, to % GAME_BOARD_SIZE)) {
+            *from_idx = from;
+            *to_idx = to;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Plays select + move clicks for one move. */
+static GameAction play_move(Game *game, int from_idx, int to_idx) {
+    (void)game_click(game, from_idx / GAME_BOARD_SIZE, from_idx % GAME_BOARD_SIZE);
+    return game_click(game, to_idx / GAME_BOARD_SIZE, to_idx % GAME_BOARD_SIZE);
+}
+
+/* Builds mid-game positions from seeded random play, plus derived corpora
+   of moves that complete a line and moves that end in a spawn. */
+static void build_corpus(void) {
+    Rng rng;
+    rng_seed(&rng, 0xBE7C4u);
+
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        BenchPosition *pos = &corpus[i];
+        game_init(&pos->game, (uint32_t)i + 1u);
+        int depth = 5 + (int)rng_range(&rng, 40);
+        for (int move = 0; move < depth; ++move) {
+            int from;
+            int to;
+            if (pos->game.game_over || !pick_move(&pos->game, &rng, &from, &to)) {
+                game_init(&pos->game, rng_next(&rng));
+                continue;
+            }
+            (void)play_move(&pos->game, from, to);
+        }
+        while (!pick_move(&pos->game, &rng, &pos->from_idx, &pos->to_idx)) {
+            game_init(&pos->game, rng_next(&rng));
+        }
+    }
+
+    /* Four in a row with the fifth ball one step below the gap. */
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        BenchPosition *pos = &clear_corpus[i];
+        *pos = corpus[i];
+        int row = (int)rng_range(&rng, GAME_BOARD_SIZE - 1);
+        uint8_t color = (uint8_t)(rng_range(&rng, GAME_COLORS) + 1);
+        for (int col = 0; col < 4; ++col) {
+            pos->game.board[row * GAME_BOARD_SIZE + col] = color;
+        }
+        pos->to_idx = row * GAME_BOARD_SIZE + 4;
+        pos->from_idx = (row + 1) * GAME_BOARD_SIZE + 4;
+        pos->game.board[pos->to_idx] = 0;
+        pos->game.board[pos->from_idx] = color;
+        pos->game.selected_index = -1;
+    }
+
+    spawn_corpus_count = 0;
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        Game probe = corpus[i].game;
+        int score = probe.score;
+        GameAction action = play_move(&probe, corpus[i].from_idx, corpus[i].to_idx);
+        if (action == GAME_ACTION_MOVED && probe.score == score) {
+            spawn_corpus[spawn_corpus_count++] = corpus[i];
+        }
+    }
+}
+
+/* Copies corpus games into the mutable work array. */
+static void load_work(const BenchPosition *positions, int count) {
+    for (int i = 0; i < count; ++i) {
+        work[i] = positions[i].game;
+    }
+}
+
+/* Returns corpus size for per-position cases. */
+static int corpus_ops(void) {
+    return BENCH_CORPUS;
+}
+
+/* Returns size of the no-clear move corpus. */
+static int spawn_ops(void) {
+    return spawn_corpus_count;
+}
+
+/* No per-sample setup needed. */
+static void prepare_none(int sample) {
+    (void)sample;
+}
+
+/* BFS reachability for every corpus move. */
+static uint64_t run_can_reach(void) {
+    uint64_t hits = 0;
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        const BenchPosition *pos = &corpus[i];
+        hits += game_can_reach(
+            &pos->game,
+            pos->from_idx / GAME_BOARD_SIZE,
+            pos->from_idx % GAME_BOARD_SIZE,
+            pos->to_idx / GAME_BOARD_SIZE,
+            pos->to_idx % GAME_BOARD_SIZE
+        );
+    }
+    return hits;
+}
+
+/* Restores fresh copies of the general corpus. */
+static void prepare_corpus(int sample) {
+    (void)sample;
+    load_work(corpus, BENCH_CORPUS);
+}
+
+/* Restores fresh copies of the line-completing corpus. */
+static void prepare_clear(int sample) {
+    (void)sample;
+    load_work(clear_corpus, BENCH_CORPUS);
+}
+
+/* Restores fresh copies of the spawn corpus. */
+static void prepare_spawn(int sample) {
+    (void)sample;
+    load_work(spawn_corpus, spawn_corpus_count);
+}
+
+/* Full select + move turn through game_click. */
+static uint64_t run_click_turn(void) {
+    uint64_t sum = 0;
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        sum += (uint64_t)play_move(&work[i], corpus[i].from_idx, corpus[i].to_idx);
+    }
+    return sum;
+}
+
+/* Moves that complete a line: exercises the clear step without a spawn. */
+static uint64_t run_click_clear(void) {
+    uint64_t sum = 0;
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        sum += (uint64_t)play_move(&work[i], clear_corpus[i].from_idx, clear_corpus[i].to_idx);
+        sum += (uint64_t)work[i].score;
+    }
+    return sum;
+}
+
+/* Moves that clear nothing: exercises the spawn + re-check path. */
+static uint64_t run_click_spawn(void) {
+    uint64_t sum = 0;
+    for (int i = 0; i < spawn_corpus_count; ++i) {
+        sum += (uint64_t)play_move(&work[i], spawn_corpus[i].from_idx, spawn_corpus[i].to_idx);
+    }
+    return sum;
+}
+
+/* Restores corpus games with the source ball already selected. */
+static void prepare_controller(int sample) {
+    (void)sample;
+    load_work(corpus, BENCH_CORPUS);
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        work[i].selected_index = corpus[i].from_idx;
+    }
+}
+
+/* Move click through turn_controller_click (path build + snapshots). */
+static uint64_t run_controller_click(void) {
+    uint64_t sum = 0;
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        int to = corpus[i].to_idx;
+        turn_controller_click(&work[i], to / GAME_BOARD_SIZE, to % GAME_BOARD_SIZE, &results[i]);
+        sum += (uint64_t)results[i].path_len;
+    }
+    return sum;
+}
+
+/* Captures one controller result per corpus move for animation cases. */
+static void build_results(void) {
+    prepare_controller(0);
+    (void)run_controller_click();
+}
+
+/* Turn animation setup from precomputed controller results. */
+static uint64_t run_anim_start(void) {
+    uint64_t sum = 0;
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        const TurnClickResult *r = &results[i];
+        turn_anim_start(&anims[i], r->before_board, work[i].board, r->from_idx, r->to_idx, r->path, r->path_len);
+        sum += (uint64_t)anims[i].spawned_count;
+    }
+    return sum;
+}
+
+/* Recomputes controller results and post-move boards for run_anim_start. */
+static void prepare_anim_start(int sample) {
+    (void)sample;
+    build_results();
+}
+
+/* Starts every corpus animation so updates run through all phases. */
+static void prepare_anim_update(int sample) {
+    prepare_anim_start(sample);
+    (void)run_anim_start();
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        turn_anim_begin_render(&anims[i], render_boards[i], GAME_CELLS);
+    }
+}
+
+/* Fixed-step updates until every animation finishes. */
+static uint64_t run_anim_update(void) {
+    uint64_t emitted = 0;
+    anim_steps = 0;
+    for (int i = 0; i < BENCH_CORPUS; ++i) {
+        int steps = 0;
+        while (turn_anim_active(&anims[i]) && steps < BENCH_MAX_ANIM_STEPS) {
+            bool emit = false;
+            turn_anim_update(&anims[i], BENCH_ANIM_DT, render_boards[i], GAME_CELLS, &emit);
+            emitted += emit;
+            ++steps;
+        }
+        anim_steps += steps;
+    }
+    return emitted;
+}
+
+/* Update count of the last animation sample, measured on the warmup run. */
+static int anim_update_ops(void) {
+    return anim_steps;
+}
+
+#ifdef LINES98_BENCH_PARTICLES
+#define BENCH_PARTICLE_STEPS 16
+
+static ParticleSystem bench_particles;
+static ParticleSystem particle_seed;
+static int particle_target;
+
+/* Spawns particle_target particles over the board of a corpus position. */
+static void seed_particles(int count) {
+    particles_init(&particle_seed);
+    Rng rng;
+    rng_seed(&rng, 0xD057u + (uint32_t)count);
+    SDL_Color color = {200, 180, 90, 255};
+    while (particles_active_count(&particle_seed) < count) {
+        float x = 92.0f + (float)rng_range(&rng, 576);
+        float y = 110.0f + (float)rng_range(&rng, 576);
+        particles_spawn_one(&particle_seed, x, y, color);
+    }
+    particle_target = count;
+}
+
+/* Restores the seeded particle field. */
+static void prepare_particles(int sample) {
+    (void)sample;
+    bench_particles = particle_seed;
+}
+
+/* Fixed-step particle integration with ball collisions. */
+static uint64_t run_particles(void) {
+    for (int step = 0; step < BENCH_PARTICLE_STEPS; ++step) {
+        particles_update(&bench_particles, BENCH_ANIM_DT, corpus[0].game.board, GAME_BOARD_SIZE, 64, 92, 110, 23.0f);
+    }
+    return (uint64_t)particles_active_count(&bench_particles);
+}
+
+/* Reports per-particle-step operations. */
+static int particle_ops(void) {
+    return particle_target * BENCH_PARTICLE_STEPS;
+}
+#endif
+
+/* Compares uint64 values for qsort. */
+static int compare_u64(const void *a, const void *b) {
+    uint64_t va = *(const uint64_t *)a;
+    uint64_t vb = *(const uint64_t *)b;
+    return (va > vb) - (va < vb);
+}
+
+/* Adds the calling thread's counters into total. */
+static void add_counters(EngineCounters *total) {
+    EngineCounters c;
+    engine_counters_snapshot(&c);
+    total->reach_nodes += c.reach_nodes;
+    total->path_nodes += c.path_nodes;
+    total->clear_passes += c.clear_passes;
+    total->clear_cells_scanned += c.clear_cells_scanned;
+    total->turns += c.turns;
+    total->spawned_balls += c.spawned_balls;
+    total->cleared_balls += c.cleared_balls;
+    total->empty_count_calls += c.empty_count_calls;
+}
+
+/* Prints engine work per operation for the timed samples when counters are built in. */
+static void print_counters(const EngineCounters *c, double ops) {
+    printf(
+        ", \"counters_per_op\": {\"reach_nodes\": %.2f, \"path_nodes\": %.2f, \"clear_cells_scanned\": %.2f, "
+        "\"turns\": %.3f, \"spawned_balls\": %.3f, \"cleared_balls\": %.3f, \"empty_count_calls\": %.3f}",
+        (double)c->reach_nodes / ops,
+        (double)c->path_nodes / ops,
+        (double)c->clear_cells_scanned / ops,
+        (double)c->turns / ops,
+        (double)c->spawned_balls / ops,
+        (double)c->cleared_balls / ops,
+        (double)c->empty_count_calls / ops
+    );
+}
+
+/* Prints hardware events per operation, null for events that were not counted. */
+static void print_perf(const PerfSample *sample, double ops) {
+    printf(", \"perf_per_op\": {");
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        printf("%s\"%s\": ", e == 0 ? "" : ", ", perf_event_name((PerfEvent)e));
+        if (sample->valid[e]) {
+            printf("%.2f", (double)sample->value[e] / ops);
+        } else {
+            printf("null");
+        }
+    }
+    if (sample->valid[PERF_CYCLES] && sample->valid[PERF_INSTRUCTIONS] && sample->value[PERF_CYCLES] > 0) {
+        printf(", \"ipc\": %.3f", (double)sample->value[PERF_INSTRUCTIONS] / (double)sample->value[PERF_CYCLES]);
+    }
+    printf("}");
+}
+
+/* Times one case and prints its JSON object; sink accumulates run() results.
+   perf is NULL unless --perf was given and the counters opened. */
+static void run_case(const BenchCase *bench, int samples, bool first, PerfCounters *perf, uint64_t *sink) {
+    static uint64_t sample_ns[BENCH_MAX_SAMPLES];
+
+    for (int i = 0; i < BENCH_WARMUP_SAMPLES; ++i) {
+        bench->prepare(i);
+        *sink += bench->run();
+    }
+
+    /* Counters are summed over run() only so prepare() work is excluded. */
+    int ops = bench->ops();
+    EngineCounters counters;
+    memset(&counters, 0, sizeof(counters));
+    PerfSample hw;
+    if (perf != NULL) {
+        perf_sample_reset(perf, &hw);
+    }
+    for (int i = 0; i < samples; ++i) {
+        bench->prepare(i);
+        engine_counters_reset();
+        if (perf != NULL) {
+            perf_counters_begin(perf);
+        }
+        uint64_t start = now_ns();
+        *sink += bench->run();
+        sample_ns[i] = now_ns() - start;
+        if (perf != NULL) {
+            perf_counters_end(perf, &hw);
+        }
+        add_counters(&counters);
+    }
+
+    qsort(sample_ns, (size_t)samples, sizeof(uint64_t), compare_u64);
+    double per_op = ops > 0 ? 1.0 / (double)ops : 0.0;
+    int p99 = (int)((double)(samples - 1) * 0.99);
+    printf(
+        "%s    {\"name\": \"%s\", \"ops_per_sample\": %d, \"samples\": %d, \"median_ns\": %.2f, \"p99_ns\": %.2f",
+        first ? "" : ",\n",
+        bench->name,
+        ops,
+        samples,
+        (double)sample_ns[samples / 2] * per_op,
+        (double)sample_ns[p99] * per_op
+    );
+    if (engine_counters_enabled() && ops > 0) {
+        print_counters(&counters, (double)ops * (double)samples);
+    }
+    if (perf != NULL && ops > 0) {
+        print_perf(&hw, (double)ops * (double)samples);
+    }
+    printf("}");
+}
+
+/* Parses --samples N, --filter SUBSTRING and --perf. */
+static bool parse_args(int argc, char **argv, int *samples, const char **filter, bool *use_perf) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--perf") == 0) {
+            *use_perf = true;
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            *samples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            *filter = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--samples N] [--filter SUBSTRING] [--perf]\n", argv[0]);
+            return false;
+        }
+    }
+    if (*samples <= 0 || *samples > BENCH_MAX_SAMPLES) {
+        fprintf(stderr, "--samples must be in [1..%d]\n", BENCH_MAX_SAMPLES);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int samples = BENCH_DEFAULT_SAMPLES;
+    const char *filter = NULL;
+    bool use_perf = false;
+    if (!parse_args(argc, argv, &samples, &filter, &use_perf)) {
+        return 2;
+    }
+
+    /* Hardware counters are best effort; timing still runs without them. */
+    PerfCounters perf_counters;
+    PerfCounters *perf = NULL;
+    if (use_perf) {
+        if (perf_counters_open(&perf_counters)) {
+            perf = &perf_counters;
+        } else {
+            fprintf(stderr, "Hardware counters unavailable (%s); reporting wall time only\n", perf_counters.reason);
+        }
+    }
+
+    static const BenchCase cases[] = {
+        {"game_can_reach", prepare_none, run_can_reach, corpus_ops},
+        {"game_click_turn", prepare_corpus, run_click_turn, corpus_ops},
+        {"game_click_clear", prepare_clear, run_click_clear, corpus_ops},
+        {"game_click_spawn", prepare_spawn, run_click_spawn, spawn_ops},
+        {"turn_controller_click", prepare_controller, run_controller_click, corpus_ops},
+        {"turn_anim_start", prepare_anim_start, run_anim_start, corpus_ops},
+        {"turn_anim_update", prepare_anim_update, run_anim_update, anim_update_ops},
+    };
+
+    build_corpus();
+
+    uint64_t sink = 0;
+    bool first = true;
+    printf("{\n  \"corpus\": %d,\n  \"benchmarks\": [\n", BENCH_CORPUS);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        if (filter != NULL && strstr(cases[i].name, filter) == NULL) {
+            continue;
+        }
+        run_case(&cases[i], samples, first, perf, &sink);
+        first = false;
+    }
+
+#ifdef LINES98_BENCH_PARTICLES
+    static const int particle_counts[] = {256, 2048, MAX_PARTICLES};
+    for (size_t i = 0; i < sizeof(particle_counts) / sizeof(particle_counts[0]); ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "particles_update_%d", particle_counts[i]);
+        if (filter != NULL && strstr(name, filter) == NULL) {
+            continue;
+        }
+        BenchCase bench = {name, prepare_particles, run_particles, particle_ops};
+        seed_particles(particle_counts[i]);
+        run_case(&bench, samples, first, perf, &sink);
+        first = false;
+    }
+#endif
+
+    printf("\n  ],\n  \"sink\": %llu\n}\n", (unsigned long long)sink);
+    if (perf != NULL) {
+        perf_counters_close(perf);
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+/* Lockstep differential runner between the frozen reference engine in
+   tests/ref_game.c and the engines listed in DIFF_ENGINES. */
+
+#include "diff_engine.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ref_game.h"
+
+/* Adapter for src/game.c, whose state already is the canonical Game. */
+static void current_init(void *state, uint32_t seed) {
+    game_init((Game *)state, seed);
+}
+
+/* Forwards a click to src/game.c. */
+static GameAction current_click(void *state, int row, int col) {
+    return game_click((Game *)state, row, col);
+}
+
+/* Forwards a reachability query to src/game.c. */
+static bool current_can_reach(const void *state, int from_row, int from_col, int to_row, int to_col) {
+    return game_can_reach((const Game *)state, from_row, from_col, to_row, to_col);
+}
+
+/* Copies the canonical state out of a src/game.c engine. */
+static void current_export(const void *state, Game *out) {
+    memcpy(out, state, sizeof(*out));
+}
+
+static const DiffEngine CURRENT_ENGINE = {
+    "game",
+    sizeof(Game),
+    current_init,
+    current_click,
+    current_can_reach,
+    current_export,
+};
+
+const DiffEngine *const DIFF_ENGINES[] = {
+    &CURRENT_ENGINE,
+};
+
+const int DIFF_ENGINE_COUNT = (int)(sizeof(DIFF_ENGINES) / sizeof(DIFF_ENGINES[0]));
+
+/* Fills out for one differing field; always returns false. */
+static bool mismatch(DiffMismatch *out, int click, const char *field, int index, long long expected, long long actual) {
+    out->click = click;
+    if (index >= 0) {
+        snprintf(out->field, sizeof(out->field), "%s[%d]", field, index);
+    } else {
+        snprintf(out->field, sizeof(out->field), "%s", field);
+    }
+    out->expected = expected;
+    out->actual = actual;
+    return false;
+}
+
+/* Compares every observable Game field. */
+static bool compare_games(const Game *ref, const Game *got, int click, DiffMismatch *out) {
+    for (int i = 0; i < GAME_CELLS; ++i) {
+        if (ref->board[i] != got->board[i]) {
+            return mismatch(out, click, "board", i, ref->board[i], got->board[i]);
+        }
+    }
+    for (int i = 0; i < GAME_NEXT_COUNT; ++i) {
+        if (ref->next_colors[i] != got->next_colors[i]) {
+            return mismatch(out, click, "next_colors", i, ref->next_colors[i], got->next_colors[i]);
+        }
+    }
+    if (ref->score != got->score) {
+        return mismatch(out, click, "score", -1, ref->score, got->score);
+    }
+    if (ref->selected_index != got->selected_index) {
+        return mismatch(out, click, "selected_index", -1, ref->selected_index, got->selected_index);
+    }
+    if (ref->game_over != got->game_over) {
+        return mismatch(out, click, "game_over", -1, ref->game_over, got->game_over);
+    }
+    if (ref->rng.state != got->rng.state) {
+        return mismatch(out, click, "rng.state", -1, ref->rng.state, got->rng.state);
+    }
+    return true;
+}
+
+/* Replays clicks on the reference and engine in lockstep, comparing the
+   click result, a reachability probe and the full game state after every
+   click. Returns false and fills out at the first divergence. */
+bool diff_run(const DiffEngine *engine, uint32_t seed, const DiffClick *clicks, int count, DiffMismatch *out) {
+    _Alignas(max_align_t) unsigned char state[DIFF_MAX_STATE];
+    if (engine->state_size > sizeof(state)) {
+        return mismatch(out, -1, "state_size", -1, DIFF_MAX_STATE, (long long)engine->state_size);
+    }
+
+    Game ref;
+    Game got;
+    ref_game_init(&ref, seed);
+    engine->init(state, seed);
+    engine->export_game(state, &got);
+    if (!compare_games(&ref, &got, -1, out)) {
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        int row = clicks[i].row;
+        int col = clicks[i].col;
+
+        /* Probe reachability from the selection, as game_click is about to. */
+        if (ref.selected_index >= 0) {
+            int from_row = ref.selected_index / GAME_BOARD_SIZE;
+            int from_col = ref.selected_index % GAME_BOARD_SIZE;
+            bool want = ref_game_can_reach(&ref, from_row, from_col, row, col);
+            bool have = engine->can_reach(state, from_row, from_col, row, col);
+            if (want != have) {
+                return mismatch(out, i, "can_reach", -1, want, have);
+            }
+        }
+
+        GameAction want = ref_game_click(&ref, row, col);
+        GameAction have = engine->click(state, row, col);
+        if (want != have) {
+            return mismatch(out, i, "action", -1, want, have);
+        }
+
+        engine->export_game(state, &got);
+        if (!compare_games(&ref, &got, i, out)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Prints a mismatch with the seed and engine name to stderr. */
+void diff_report(const DiffEngine *engine, uint32_t seed, const DiffMismatch *mismatch) {
+    fprintf(
+        stderr,
+        "MISMATCH: engine %s seed %u click %d: %s expected %lld got %lld\n",
+        engine->name,
+        seed,
+        mismatch->click,
+        mismatch->field,
+        mismatch->expected,
+        mismatch->actual
+    );
+}
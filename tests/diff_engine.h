@@ -0,0 +1,50 @@
+#ifndef DIFF_ENGINE_H
+#define DIFF_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#define DIFF_MAX_STATE 4096
+
+/* One board click; coordinates may be out of range on purpose. */
+typedef struct {
+    int8_t row;
+    int8_t col;
+} DiffClick;
+
+/* Rules engine under test. State is opaque so bitboard or incremental
+   engines can keep their own layout; export_game converts it to the
+   canonical Game the reference engine uses. */
+typedef struct {
+    const char *name;
+    size_t state_size;
+    void (*init)(void *state, uint32_t seed);
+    GameAction (*click)(void *state, int row, int col);
+    bool (*can_reach)(const void *state, int from_row, int from_col, int to_row, int to_col);
+    void (*export_game)(const void *state, Game *out);
+} DiffEngine;
+
+/* First divergence from the reference; click is -1 for game_init. */
+typedef struct {
+    int click;
+    char field[32];
+    long long expected;
+    long long actual;
+} DiffMismatch;
+
+/* Engines compared against the reference; add optimized engines here. */
+extern const DiffEngine *const DIFF_ENGINES[];
+extern const int DIFF_ENGINE_COUNT;
+
+/* Replays clicks on the reference and engine in lockstep, comparing the
+   click result, a reachability probe and the full game state after every
+   click. Returns false and fills out at the first divergence. */
+bool diff_run(const DiffEngine *engine, uint32_t seed, const DiffClick *clicks, int count, DiffMismatch *out);
+
+/* Prints a mismatch with the seed and engine name to stderr. */
+void diff_report(const DiffEngine *engine, uint32_t seed, const DiffMismatch *mismatch);
+
+#endif
@@ -0,0 +1,50 @@
+/* libFuzzer entry point for the differential harness (clang builds).
+   Input: 4-byte little-endian seed, then one byte per click. Bytes below
+   243 address board cells (three ways each); the rest click just outside
+   the board or at extreme coordinates. Any divergence aborts. */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "diff_engine.h"
+
+#define FUZZ_MAX_CLICKS 4096
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/* Decodes one input byte into a click. */
+static DiffClick decode_click(uint8_t byte) {
+    static const int8_t FAR[4] = {-1, GAME_BOARD_SIZE, INT8_MIN, INT8_MAX};
+    DiffClick click;
+    if (byte < 3 * GAME_CELLS) {
+        click.row = (int8_t)((byte % GAME_CELLS) / GAME_BOARD_SIZE);
+        click.col = (int8_t)(byte % GAME_BOARD_SIZE);
+    } else {
+        int k = byte - 3 * GAME_CELLS;
+        click.row = FAR[k & 3];
+        click.col = k & 4 ? (int8_t)(k % GAME_BOARD_SIZE) : FAR[(k >> 2) & 3];
+    }
+    return click;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size < 4) {
+        return 0;
+    }
+    uint32_t seed = (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+    size_t count = size - 4 < FUZZ_MAX_CLICKS ? size - 4 : FUZZ_MAX_CLICKS;
+
+    static DiffClick clicks[FUZZ_MAX_CLICKS];
+    for (size_t i = 0; i < count; ++i) {
+        clicks[i] = decode_click(data[4 + i]);
+    }
+
+    for (int e = 0; e < DIFF_ENGINE_COUNT; ++e) {
+        DiffMismatch mismatch;
+        if (!diff_run(DIFF_ENGINES[e], seed, clicks, (int)count, &mismatch)) {
+            diff_report(DIFF_ENGINES[e], seed, &mismatch);
+            abort();
+        }
+    }
+    return 0;
+}
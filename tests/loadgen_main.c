@@ -0,0 +1,775 @@
+/* Load generator for lines98_server.
+   Opens many connections spread over a few epoll threads; each connection
+   plays its own game, choosing legal moves with a local copy of the rules
+   engine that it keeps in lockstep with the server's replies. Requests are
+   paced per connection to hit a total target rate (or sent back to back
+   with --rate 0), and each latency is taken from the time the request was
+   due, not the time it went out, so a stalled server cannot hide its queue
+   (no coordinated omission). Latencies land in log-linear histograms and
+   the summary is printed as JSON on stdout. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "protocol.h"
+#include "rng.h"
+#include "server.h"
+
+#define LOADGEN_DEFAULT_CONNECTIONS 1000
+#define LOADGEN_DEFAULT_THREADS 2
+#define LOADGEN_DEFAULT_DURATION_S 10
+#define LOADGEN_DEFAULT_WARMUP_S 1
+#define LOADGEN_DEFAULT_SERVER_WORKERS 4
+#define LOADGEN_MAX_THREADS 64
+#define LOADGEN_EPOLL_BATCH 256
+
+/* Histogram: values below 2 * LOADGEN_SUB_HALF are exact, above that each
+   power of two is split into LOADGEN_SUB_HALF buckets (~3% wide). 41 bits
+   of nanoseconds covers half an hour. */
+#define LOADGEN_SUB_HALF 32
+#define LOADGEN_MAX_MAGNITUDE 41
+#define LOADGEN_BUCKETS ((LOADGEN_MAX_MAGNITUDE - 4) * LOADGEN_SUB_HALF)
+
+/* Request kinds with their own latency histogram. */
+typedef enum {
+    LOAD_KIND_ALL = 0,
+    LOAD_KIND_MOVE = 1,
+    LOAD_KIND_NEW_GAME = 2,
+    LOAD_KIND_COUNT = 3
+} LoadKind;
+
+static const char *const kind_names[LOAD_KIND_COUNT] = {"all", "move", "new_game"};
+
+/* Log-linear latency histogram in nanoseconds. */
+typedef struct {
+    uint64_t counts[LOADGEN_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} LoadHistogram;
+
+/* One client connection and the game it mirrors. */
+typedef struct {
+    int fd;
+    uint32_t session;
+    uint64_t token;
+    bool restart;
+    Game game;
+    Rng rng;
+    ProtoRequest req;
+    bool waiting;
+    uint64_t origin_ns;
+    uint64_t due_ns;
+    int heap_slot;
+    size_t in_len;
+    size_t out_len;
+    size_t out_pos;
+    uint8_t in[PROTO_MAX_FRAME * 2];
+    uint8_t out[PROTO_MAX_FRAME];
+} LoadConn;
+
+/* One client thread: an epoll set, a timerfd for pacing and a min-heap of
+   idle connections ordered by when their next request is due. */
+typedef struct {
+    int index;
+    pthread_t thread;
+    int epoll_fd;
+    int timer_fd;
+    LoadConn *conns;
+    int conn_count;
+    int first_global;
+    LoadConn **heap;
+    int heap_len;
+    LoadHistogram latency[LOAD_KIND_COUNT];
+    uint64_t requests;
+    uint64_t errors;
+    uint64_t divergences;
+    uint64_t games;
+    bool failed;
+} LoadThread;
+
+/* Command line settings. */
+typedef struct {
+    const char *unix_path;
+    const char *tcp_host;
+    const char *tcp_port;
+    bool embedded;
+    int server_workers;
+    int connections;
+    int threads;
+    double rate;
+    double duration_s;
+    double warmup_s;
+    uint32_t seed;
+} LoadConfig;
+
+static LoadConfig config;
+static LoadThread threads[LOADGEN_MAX_THREADS];
+static pthread_barrier_t start_barrier;
+static uint64_t interval_ns;
+
+/* Returns monotonic time in nanoseconds. */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Returns the bucket index of a value. */
+static int bucket_of(uint64_t value) {
+    if (value < 2 * LOADGEN_SUB_HALF) {
+        return (int)value;
+    }
+    int msb = 0;
+    while ((value >> msb) > 1) {
+        ++msb;
+    }
+    int shift = msb - 5;
+    if (shift > LOADGEN_MAX_MAGNITUDE - 6) {
+        return LOADGEN_BUCKETS - 1;
+    }
+    return shift * LOADGEN_SUB_HALF + (int)(value >> shift);
+}
+
+/* Returns the largest value that falls in bucket. */
+static uint64_t bucket_upper(int bucket) {
+    if (bucket < 2 * LOADGEN_SUB_HALF) {
+        return (uint64_t)bucket;
+    }
+    int shift = bucket / LOADGEN_SUB_HALF - 1;
+    uint64_t mantissa = (uint64_t)(bucket % LOADGEN_SUB_HALF + LOADGEN_SUB_HALF);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/* Counts one latency. */
+static void histogram_record(LoadHistogram *hist, uint64_t value) {
+    ++hist->counts[bucket_of(value)];
+    ++hist->total;
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+/* Adds src into dst. */
+static void histogram_merge(LoadHistogram *dst, const LoadHistogram *src) {
+    for (int b = 0; b < LOADGEN_BUCKETS; ++b) {
+        dst->counts[b] += src->counts[b];
+    }
+    dst->total += src->total;
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+/* Returns the upper bound of the bucket holding quantile q in [0..1],
+   capped at the exact maximum; 0 when empty. */
+static uint64_t histogram_quantile(const LoadHistogram *hist, double q) {
+    if (hist->total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(q * (double)hist->total);
+    if (rank >= hist->total) {
+        rank = hist->total - 1;
+    }
+    uint64_t seen = 0;
+    for (int b = 0; b < LOADGEN_BUCKETS; ++b) {
+        seen += hist->counts[b];
+        if (seen > rank) {
+            uint64_t upper = bucket_upper(b);
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+/* Min-heap helpers keyed by due_ns. */
+static void heap_swap(LoadThread *lt, int a, int b) {
+    LoadConn *tmp = lt->heap[a];
+    lt->heap[a] = lt->heap[b];
+    lt->heap[b] = tmp;
+    lt->heap[a]->heap_slot = a;
+    lt->heap[b]->heap_slot = b;
+}
+
+/* Schedules conn's next request at due. */
+static void heap_push(LoadThread *lt, LoadConn *conn, uint64_t due) {
+    conn->due_ns = due;
+    int i = lt->heap_len++;
+    lt->heap[i] = conn;
+    conn->heap_slot = i;
+    while (i > 0 && lt->heap[(i - 1) / 2]->due_ns > lt->heap[i]->due_ns) {
+        heap_swap(lt, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+/* Removes and returns the connection due first. */
+static LoadConn *heap_pop(LoadThread *lt) {
+    LoadConn *top = lt->heap[0];
+    heap_swap(lt, 0, --lt->heap_len);
+    int i = 0;
+    for (;;) {
+        int l = 2 * i + 1;
+        int r = l + 1;
+        int m = i;
+        if (l < lt->heap_len && lt->heap[l]->due_ns < lt->heap[m]->due_ns) {
+            m = l;
+        }
+        if (r < lt->heap_len && lt->heap[r]->due_ns < lt->heap[m]->due_ns) {
+            m = r;
+        }
+        if (m == i) {
+            break;
+        }
+        heap_swap(lt, i, m);
+        i = m;
+    }
+    top->heap_slot = -1;
+    return top;
+}
+
+/* Opens a blocking connection to the target and makes it non-blocking. */
+static int connect_target(void) {
+    int fd = -1;
+    if (config.unix_path != NULL) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", config.unix_path);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    } else {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo *list = NULL;
+        if (getaddrinfo(config.tcp_host, config.tcp_port, &hints, &list) != 0) {
+            return -1;
+        }
+        for (struct addrinfo *ai = list; ai != NULL && fd < 0; ai = ai->ai_next) {
+            fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+            if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(list);
+    }
+    if (fd >= 0 && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/* Picks a random legal move on the mirror, falling back to a full scan;
+   returns false when no ball can move. */
+static bool pick_move(LoadConn *conn, uint8_t *from, uint8_t *to) {
+    const Game *game = &conn->game;
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        int a = (int)rng_range(&conn->rng, GAME_CELLS);
+        int b = (int)rng_range(&conn->rng, GAME_CELLS);
+        if (game->board[a] != 0 && game->board[b] == 0 &&
+            game_can_reach(game, a / GAME_BOARD_SIZE, a % GAME_BOARD_SIZE, b / GAME_BOARD_SIZE, b % GAME_BOARD_SIZE)) {
+            *from = (uint8_t)a;
+            *to = (uint8_t)b;
+            return true;
+        }
+    }
+    for (int a = 0; a < GAME_CELLS; ++a) {
+        for (int b = 0; b < GAME_CELLS && game->board[a] != 0; ++b) {
+            if (game->board[b] == 0 &&
+                game_can_reach(game, a / GAME_BOARD_SIZE, a % GAME_BOARD_SIZE, b / GAME_BOARD_SIZE, b % GAME_BOARD_SIZE)) {
+                *from = (uint8_t)a;
+                *to = (uint8_t)b;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* Writes buffered output; false if the server is gone. */
+static bool conn_flush(LoadConn *conn) {
+    while (conn->out_pos < conn->out_len) {
+        ssize_t n = send(conn->fd, conn->out + conn->out_pos, conn->out_len - conn->out_pos, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn->out_pos += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    return true;
+}
+
+/* Sends the connection's next request, timed from origin. */
+static bool conn_send(LoadThread *lt, LoadConn *conn, uint64_t origin) {
+    ProtoRequest *req = &conn->req;
+    uint32_t tag = req->tag + 1;
+    memset(req, 0, sizeof(*req));
+    req->tag = tag;
+    req->session = conn->session;
+    req->token = conn->token;
+    uint8_t from = 0;
+    uint8_t to = 0;
+    if (conn->session == 0 || conn->restart || conn->game.game_over || !pick_move(conn, &from, &to)) {
+        req->type = PROTO_NEW_GAME;
+        req->seed = rng_next(&conn->rng) | 1u;
+    } else {
+        req->type = PROTO_MOVE;
+        req->from = from;
+        req->to = to;
+    }
+
+    int n = proto_encode_request(req, conn->out, sizeof(conn->out));
+    if (n < 0) {
+        return false;
+    }
+    conn->out_len = (size_t)n;
+    conn->out_pos = 0;
+    conn->origin_ns = origin;
+    conn->waiting = true;
+    if (!conn_flush(conn)) {
+        return false;
+    }
+    if (conn->out_pos < conn->out_len) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.ptr = conn;
+        epoll_ctl(lt->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+    }
+    return true;
+}
+
+/* Checks a reply against the mirror and advances it. */
+static void conn_reply(LoadThread *lt, LoadConn *conn, const ProtoReply *reply, uint64_t now, uint64_t measure_from) {
+    conn->waiting = false;
+    ++lt->requests;
+    if (conn->origin_ns >= measure_from) {
+        uint64_t latency = now - conn->origin_ns;
+        histogram_record(&lt->latency[LOAD_KIND_ALL], latency);
+        histogram_record(&lt->latency[conn->req.type == PROTO_MOVE ? LOAD_KIND_MOVE : LOAD_KIND_NEW_GAME], latency);
+    }
+
+    if (reply->tag != conn->req.tag || reply->status != PROTO_OK) {
+        ++lt->errors;
+        if (reply->status == PROTO_ERR_NO_SESSION) {
+            conn->session = 0;
+        }
+        conn->restart = true;
+        return;
+    }
+
+    ProtoRequest applied = conn->req;
+    applied.session = reply->session;
+    ProtoReply expected;
+    proto_apply(&conn->game, &applied, &expected);
+    conn->restart = false;
+    if (conn->req.type == PROTO_NEW_GAME) {
+        conn->session = reply->session;
+        conn->token = reply->token;
+        if (memcmp(reply->board, conn->game.board, GAME_CELLS) != 0) {
+            ++lt->divergences;
+            conn->restart = true;
+        }
+        return;
+    }
+    if (reply->action != expected.action || reply->score != expected.score || reply->game_over != expected.game_over ||
+        memcmp(reply->next_colors, expected.next_colors, GAME_NEXT_COUNT) != 0) {
+        ++lt->divergences;
+        conn->restart = true;
+    }
+    if (reply->action == GAME_ACTION_GAME_OVER) {
+        ++lt->games;
+    }
+}
+
+/* Reads and handles replies; false if the connection failed. */
+static bool conn_read(LoadThread *lt, LoadConn *conn, uint64_t measure_from, uint64_t end) {
+    for (;;) {
+        ssize_t n = recv(conn->fd, conn->in + conn->in_len, sizeof(conn->in) - conn->in_len, 0);
+        if (n > 0) {
+            conn->in_len += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else {
+            return false;
+        }
+
+        size_t pos = 0;
+        for (;;) {
+            ProtoReply reply;
+            int used = proto_decode_reply(conn->in + pos, conn->in_len - pos, &reply);
+            if (used < 0) {
+                return false;
+            }
+            if (used == 0) {
+                break;
+            }
+            pos += (size_t)used;
+            if (!conn->waiting) {
+                continue;
+            }
+            uint64_t now = now_ns();
+            conn_reply(lt, conn, &reply, now, measure_from);
+            if (now < end) {
+                /* Paced connections keep their schedule even when late. */
+                uint64_t due = interval_ns > 0 ? conn->due_ns + interval_ns : now;
+                heap_push(lt, conn, due);
+            }
+        }
+        memmove(conn->in, conn->in + pos, conn->in_len - pos);
+        conn->in_len -= pos;
+    }
+}
+
+/* Arms the timerfd for the earliest due request. */
+static void arm_timer(LoadThread *lt) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (lt->heap_len > 0) {
+        uint64_t due = lt->heap[0]->due_ns;
+        spec.it_value.tv_sec = (time_t)(due / 1000000000u);
+        spec.it_value.tv_nsec = (long)(due % 1000000000u);
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1;
+        }
+    }
+    timerfd_settime(lt->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+/* Connects this thread's share of connections and drives them until the
+   run ends. */
+static void *thread_main(void *data) {
+    LoadThread *lt = (LoadThread *)data;
+    bool ready = true;
+    for (int i = 0; i < lt->conn_count && ready; ++i) {
+        LoadConn *conn = &lt->conns[i];
+        rng_seed(&conn->rng, config.seed ^ (uint32_t)(lt->first_global + i) * 2654435761u);
+        conn->fd = connect_target();
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = conn;
+        if (conn->fd < 0 || epoll_ctl(lt->epoll_fd, EPOLL_CTL_ADD, conn->fd, &ev) != 0) {
+            fprintf(stderr, "connection %d: %s\n", lt->first_global + i, strerror(errno));
+            ready = false;
+        }
+    }
+    lt->failed = !ready;
+    pthread_barrier_wait(&start_barrier);
+    for (int t = 0; t < config.threads; ++t) {
+        if (threads[t].failed) {
+            return NULL;
+        }
+    }
+
+    uint64_t start = now_ns();
+    uint64_t measure_from = start + (uint64_t)(config.warmup_s * 1e9);
+    uint64_t end = measure_from + (uint64_t)(config.duration_s * 1e9);
+    for (int i = 0; i < lt->conn_count; ++i) {
+        /* Spread first requests over one interval so the rate starts flat. */
+        uint64_t phase = interval_ns * (uint64_t)(lt->first_global + i) / (uint64_t)config.connections;
+        heap_push(lt, &lt->conns[i], start + phase);
+    }
+
+    struct epoll_event events[LOADGEN_EPOLL_BATCH];
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now >= end) {
+            break;
+        }
+        while (lt->heap_len > 0 && lt->heap[0]->due_ns <= now) {
+            LoadConn *conn = heap_pop(lt);
+            if (!conn_send(lt, conn, interval_ns > 0 ? conn->due_ns : now)) {
+                fprintf(stderr, "send: %s\n", strerror(errno));
+                lt->failed = true;
+                return NULL;
+            }
+        }
+        arm_timer(lt);
+
+        uint64_t left_ms = (end - now) / 1000000u + 1;
+        int n = epoll_wait(lt->epoll_fd, events, LOADGEN_EPOLL_BATCH, (int)(left_ms < 1000 ? left_ms : 1000));
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            lt->failed = true;
+            return NULL;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.ptr == NULL) {
+                uint64_t expirations;
+                ssize_t r = read(lt->timer_fd, &expirations, sizeof(expirations));
+                (void)r;
+                continue;
+            }
+            LoadConn *conn = (LoadConn *)events[i].data.ptr;
+            bool ok = true;
+            if ((events[i].events & EPOLLOUT) != 0) {
+                ok = conn_flush(conn);
+                if (ok && conn->out_pos == conn->out_len) {
+                    struct epoll_event ev;
+                    memset(&ev, 0, sizeof(ev));
+                    ev.events = EPOLLIN;
+                    ev.data.ptr = conn;
+                    epoll_ctl(lt->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+                }
+            }
+            if (ok && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+                ok = conn_read(lt, conn, measure_from, end);
+            }
+            if (!ok) {
+                fprintf(stderr, "server closed a connection\n");
+                lt->failed = true;
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Prints a histogram's percentiles in microseconds. */
+static void print_latency(const char *name, const LoadHistogram *hist, bool last) {
+    printf(
+        "    \"%s\": {\"count\": %llu, \"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, \"p999_us\": %.1f, "
+        "\"max_us\": %.1f}%s\n",
+        name,
+        (unsigned long long)hist->total,
+        (double)histogram_quantile(hist, 0.50) / 1000.0,
+        (double)histogram_quantile(hist, 0.90) / 1000.0,
+        (double)histogram_quantile(hist, 0.99) / 1000.0,
+        (double)histogram_quantile(hist, 0.999) / 1000.0,
+        (double)hist->max / 1000.0,
+        last ? "" : ","
+    );
+}
+
+/* Parses the command line into config. */
+static bool parse_args(int argc, char **argv) {
+    config.tcp_host = "127.0.0.1";
+    config.tcp_port = "9898";
+    config.server_workers = LOADGEN_DEFAULT_SERVER_WORKERS;
+    config.connections = LOADGEN_DEFAULT_CONNECTIONS;
+    config.threads = LOADGEN_DEFAULT_THREADS;
+    config.duration_s = LOADGEN_DEFAULT_DURATION_S;
+    config.warmup_s = LOADGEN_DEFAULT_WARMUP_S;
+    config.seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "--unix") == 0 && has_value) {
+            config.unix_path = argv[++i];
+        } else if (strcmp(arg, "--tcp") == 0 && has_value) {
+            static char host[256];
+            const char *spec = argv[++i];
+            const char *colon = strrchr(spec, ':');
+            if (colon != NULL && (size_t)(colon - spec) < sizeof(host)) {
+                memcpy(host, spec, (size_t)(colon - spec));
+                host[colon - spec] = '\0';
+                config.tcp_host = host;
+                config.tcp_port = colon + 1;
+            } else {
+                config.tcp_port = spec;
+            }
+        } else if (strcmp(arg, "--embedded") == 0) {
+            config.embedded = true;
+        } else if (strcmp(arg, "--server-workers") == 0 && has_value) {
+            config.server_workers = atoi(argv[++i]);
+        } else if (strcmp(arg, "--connections") == 0 && has_value) {
+            config.connections = atoi(argv[++i]);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            config.threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--rate") == 0 && has_value) {
+            config.rate = atof(argv[++i]);
+        } else if (strcmp(arg, "--duration") == 0 && has_value) {
+            config.duration_s = atof(argv[++i]);
+        } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+            config.warmup_s = atof(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            config.seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(
+                stderr,
+                "usage: %s [--unix PATH | --tcp [HOST:]PORT | --embedded [--server-workers N]]\n"
+                "          [--connections N] [--threads N] [--rate REQ_PER_S] [--duration S] [--warmup S]\n"
+                "          [--seed N]\n",
+                argv[0]
+            );
+            return false;
+        }
+    }
+    if (config.connections <= 0 || config.threads <= 0 || config.threads > LOADGEN_MAX_THREADS ||
+        config.threads > config.connections) {
+        fprintf(stderr, "--threads must be in [1..min(%d, connections)]\n", LOADGEN_MAX_THREADS);
+        return false;
+    }
+    if (config.rate < 0 || config.duration_s <= 0 || config.warmup_s < 0) {
+        fprintf(stderr, "--rate, --duration and --warmup must not be negative\n");
+        return false;
+    }
+    return true;
+}
+
+/* Raises the open-file limit to fit every connection (twice over when the
+   server runs in this process). */
+static bool raise_fd_limit(void) {
+    rlim_t need = (rlim_t)config.connections * (config.embedded ? 2u : 1u) + 64u;
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return true;
+    }
+    if (limit.rlim_cur >= need) {
+        return true;
+    }
+    limit.rlim_cur = limit.rlim_max == RLIM_INFINITY || limit.rlim_max >= need ? need : limit.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur < need) {
+        fprintf(stderr, "Need %llu open files; raise the hard limit (ulimit -Hn)\n", (unsigned long long)need);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv) || !raise_fd_limit()) {
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    static Server server;
+    static char embedded_path[108];
+    if (config.embedded) {
+        snprintf(embedded_path, sizeof(embedded_path), "/tmp/lines98_loadgen_%d.sock", (int)getpid());
+        ServerConfig server_config;
+        memset(&server_config, 0, sizeof(server_config));
+        server_config.unix_path = embedded_path;
+        server_config.tcp_port = -1;
+        server_config.workers = config.server_workers;
+        if (!server_init(&server, &server_config) || !server_start(&server)) {
+            server_shutdown(&server);
+            return 1;
+        }
+        config.unix_path = embedded_path;
+    }
+
+    interval_ns = config.rate > 0 ? (uint64_t)((double)config.connections * 1e9 / config.rate) : 0;
+    pthread_barrier_init(&start_barrier, NULL, (unsigned)config.threads);
+    int per_thread = config.connections / config.threads;
+    int extra = config.connections % config.threads;
+    int next_global = 0;
+    bool setup_ok = true;
+    int started = 0;
+    for (int t = 0; t < config.threads && setup_ok; ++t) {
+        LoadThread *lt = &threads[t];
+        lt->index = t;
+        lt->first_global = next_global;
+        lt->conn_count = per_thread + (t < extra ? 1 : 0);
+        next_global += lt->conn_count;
+        lt->conns = (LoadConn *)calloc((size_t)lt->conn_count, sizeof(LoadConn));
+        lt->heap = (LoadConn **)calloc((size_t)lt->conn_count, sizeof(LoadConn *));
+        lt->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        lt->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+        setup_ok = lt->conns != NULL && lt->heap != NULL && lt->epoll_fd >= 0 && lt->timer_fd >= 0 &&
+                   epoll_ctl(lt->epoll_fd, EPOLL_CTL_ADD, lt->timer_fd, &ev) == 0 &&
+                   pthread_create(&lt->thread, NULL, thread_main, lt) == 0;
+        started += setup_ok ? 1 : 0;
+    }
+    if (!setup_ok) {
+        /* Threads already waiting on the barrier cannot be released; bail. */
+        fprintf(stderr, "Cannot start load threads\n");
+        _exit(1);
+    }
+
+    LoadHistogram *latency = (LoadHistogram *)calloc(LOAD_KIND_COUNT, sizeof(LoadHistogram));
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    uint64_t divergences = 0;
+    uint64_t games = 0;
+    bool failed = latency == NULL;
+    for (int t = 0; t < started; ++t) {
+        LoadThread *lt = &threads[t];
+        pthread_join(lt->thread, NULL);
+        failed = failed || lt->failed;
+        for (int k = 0; k < LOAD_KIND_COUNT && latency != NULL; ++k) {
+            histogram_merge(&latency[k], &lt->latency[k]);
+        }
+        requests += lt->requests;
+        errors += lt->errors;
+        divergences += lt->divergences;
+        games += lt->games;
+        for (int i = 0; i < lt->conn_count; ++i) {
+            if (lt->conns[i].fd > 0) {
+                close(lt->conns[i].fd);
+            }
+        }
+        close(lt->epoll_fd);
+        close(lt->timer_fd);
+        free(lt->conns);
+        free(lt->heap);
+    }
+    pthread_barrier_destroy(&start_barrier);
+    if (config.embedded) {
+        server_shutdown(&server);
+    }
+    if (failed) {
+        free(latency);
+        return 1;
+    }
+
+    double throughput = (double)latency[LOAD_KIND_ALL].total / config.duration_s;
+    printf("{\n");
+    if (config.embedded) {
+        printf("  \"target\": \"embedded:%d workers\",\n", config.server_workers);
+    } else if (config.unix_path != NULL) {
+        printf("  \"target\": \"unix:%s\",\n", config.unix_path);
+    } else {
+        printf("  \"target\": \"tcp:%s:%s\",\n", config.tcp_host, config.tcp_port);
+    }
+    printf("  \"connections\": %d,\n  \"threads\": %d,\n", config.connections, config.threads);
+    printf("  \"target_rps\": %.1f,\n  \"duration_s\": %.2f,\n", config.rate, config.duration_s);
+    printf("  \"throughput_rps\": %.1f,\n", throughput);
+    /* Falling short of the target means the server (or this client) saturated. */
+    printf("  \"saturated\": %s,\n", config.rate > 0 && throughput < config.rate * 0.95 ? "true" : "false");
+    printf(
+        "  \"requests\": %llu,\n  \"errors\": %llu,\n  \"divergences\": %llu,\n  \"games_finished\": %llu,\n",
+        (unsigned long long)requests,
+        (unsigned long long)errors,
+        (unsigned long long)divergences,
+        (unsigned long long)games
+    );
+    printf("  \"latency\": {\n");
+    for (int k = 0; k < LOAD_KIND_COUNT; ++k) {
+        print_latency(kind_names[k], &latency[k], k == LOAD_KIND_COUNT - 1);
+    }
+    printf("  }\n}\n");
+    free(latency);
+    return errors == 0 && divergences == 0 && requests > 0 ? 0 : 1;
+}
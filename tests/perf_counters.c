@@ -0,0 +1,171 @@
+/* Optional Linux hardware counters for benchmarks and stress runs.
+   Events are opened as one group so they are scheduled together, and
+   values are scaled by enabled/running time when the kernel multiplexes.
+   On other platforms, or when perf_event_paranoid or a VM hides the PMU,
+   opening fails with a reason and measurement calls do nothing. */
+
+#define _GNU_SOURCE
+
+#include "perf_counters.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char *const EVENT_NAMES[PERF_EVENT_COUNT] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+
+/* Short JSON-friendly event name. */
+const char *perf_event_name(PerfEvent event) {
+    return EVENT_NAMES[event];
+}
+
+#ifdef __linux__
+
+static const uint64_t EVENT_CONFIGS[PERF_EVENT_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+/* Opens one hardware event for the calling thread, joined to group_fd. */
+static int open_event(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+/* Reads one event scaled for multiplexing; returns false on error. */
+static bool read_event(int fd, uint64_t *value) {
+    uint64_t data[3];
+    if (read(fd, data, sizeof(data)) != (ssize_t)sizeof(data)) {
+        return false;
+    }
+    if (data[2] == 0) {
+        *value = 0;
+    } else if (data[2] < data[1]) {
+        *value = (uint64_t)((double)data[0] * (double)data[1] / (double)data[2]);
+    } else {
+        *value = data[0];
+    }
+    return true;
+}
+
+/* Opens the counter group; returns false with reason set when hardware
+   counters are unavailable, in which case every other call is a no-op. */
+bool perf_counters_open(PerfCounters *pc) {
+    memset(pc, 0, sizeof(*pc));
+    pc->leader = -1;
+    int first_errno = 0;
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        pc->fd[e] = open_event(EVENT_CONFIGS[e], pc->leader);
+        if (pc->fd[e] < 0) {
+            if (first_errno == 0) {
+                first_errno = errno;
+            }
+            continue;
+        }
+        if (pc->leader < 0) {
+            pc->leader = pc->fd[e];
+        }
+    }
+
+    if (pc->leader < 0) {
+        snprintf(pc->reason, sizeof(pc->reason), "perf_event_open: %s", strerror(first_errno));
+        return false;
+    }
+    ioctl(pc->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(pc->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    pc->available = true;
+    return true;
+}
+
+/* Closes all counter descriptors. */
+void perf_counters_close(PerfCounters *pc) {
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (pc->available && pc->fd[e] >= 0) {
+            close(pc->fd[e]);
+        }
+        pc->fd[e] = -1;
+    }
+    pc->available = false;
+}
+
+/* Marks the start of a measured region. */
+void perf_counters_begin(PerfCounters *pc) {
+    if (!pc->available) {
+        return;
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (pc->fd[e] >= 0 && !read_event(pc->fd[e], &pc->start[e])) {
+            pc->start[e] = 0;
+        }
+    }
+}
+
+/* Adds the counts since perf_counters_begin into total. */
+void perf_counters_end(PerfCounters *pc, PerfSample *total) {
+    if (!pc->available) {
+        return;
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        uint64_t now;
+        if (pc->fd[e] >= 0 && read_event(pc->fd[e], &now) && now >= pc->start[e]) {
+            total->value[e] += now - pc->start[e];
+        }
+    }
+}
+
+#else
+
+/* Opens the counter group; returns false with reason set when hardware
+   counters are unavailable, in which case every other call is a no-op. */
+bool perf_counters_open(PerfCounters *pc) {
+    memset(pc, 0, sizeof(*pc));
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        pc->fd[e] = -1;
+    }
+    pc->leader = -1;
+    snprintf(pc->reason, sizeof(pc->reason), "perf_event_open requires Linux");
+    return false;
+}
+
+/* Closes all counter descriptors. */
+void perf_counters_close(PerfCounters *pc) {
+    pc->available = false;
+}
+
+/* Marks the start of a measured region. */
+void perf_counters_begin(PerfCounters *pc) {
+    (void)pc;
+}
+
+/* Adds the counts since perf_counters_begin into total. */
+void perf_counters_end(PerfCounters *pc, PerfSample *total) {
+    (void)pc;
+    (void)total;
+}
+
+#endif
+
+/* Clears a sample accumulator; events start out valid only if counted. */
+void perf_sample_reset(const PerfCounters *pc, PerfSample *sample) {
+    memset(sample, 0, sizeof(*sample));
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        sample->valid[e] = pc->available && pc->fd[e] >= 0;
+    }
+}
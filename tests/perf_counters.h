@@ -0,0 +1,50 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS = 1,
+    PERF_CACHE_MISSES = 2,
+    PERF_BRANCH_MISSES = 3,
+    PERF_EVENT_COUNT = 4
+} PerfEvent;
+
+/* Hardware event counts over one or more regions; valid[e] is false for
+   events the kernel or CPU did not provide. */
+typedef struct {
+    uint64_t value[PERF_EVENT_COUNT];
+    bool valid[PERF_EVENT_COUNT];
+} PerfSample;
+
+/* One perf_event_open group counting the calling thread in user space. */
+typedef struct {
+    int fd[PERF_EVENT_COUNT];
+    int leader;
+    bool available;
+    uint64_t start[PERF_EVENT_COUNT];
+    char reason[96];
+} PerfCounters;
+
+/* Opens the counter group; returns false with reason set when hardware
+   counters are unavailable, in which case every other call is a no-op. */
+bool perf_counters_open(PerfCounters *pc);
+
+/* Closes all counter descriptors. */
+void perf_counters_close(PerfCounters *pc);
+
+/* Marks the start of a measured region. */
+void perf_counters_begin(PerfCounters *pc);
+
+/* Adds the counts since perf_counters_begin into total. */
+void perf_counters_end(PerfCounters *pc, PerfSample *total);
+
+/* Clears a sample accumulator; events start out valid only if counted. */
+void perf_sample_reset(const PerfCounters *pc, PerfSample *sample);
+
+/* Short JSON-friendly event name. */
+const char *perf_event_name(PerfEvent event);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef REF_GAME_H
+#define REF_GAME_H
+
+#include "game.h"
+
+/* Frozen reference rules engine over the canonical Game layout; same
+   contract as the game_* functions in src/game.h. */
+void ref_game_init(Game *game, uint32_t seed);
+uint8_t ref_game_get_cell(const Game *game, int row, int col);
+bool ref_game_can_reach(const Game *game, int from_row, int from_col, int to_row, int to_col);
+GameAction ref_game_click(Game *game, int row, int col);
+int ref_game_empty_count(const Game *game);
+
+#endif
@@ -1,4 +1,6 @@
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "audio_fx.h"
@@ -8,7 +10,6 @@ static int test_no_device_calls_are_safe(void) {
     AudioFx fx;
     memset(&fx, 0, sizeof(fx));
 
-    audio_fx_play_tone(&fx, 440.0f, 20, 0.1f);
     audio_fx_play_select(&fx);
     audio_fx_play_invalid(&fx);
     audio_fx_play_move(&fx);
@@ -19,10 +20,132 @@ static int test_no_device_calls_are_safe(void) {
     return 0;
 }
 
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+/* Installs a constant-valued buffer as a cached cue. */
+static void set_constant_cue(AudioFx *fx, AudioCueId id, float value, int count) {
+    fx->cues[id].samples = (float *)malloc((size_t)count * sizeof(float));
+    fx->cues[id].sample_count = count;
+    for (int i = 0; i < count; ++i) {
+        fx->cues[id].samples[i] = value;
+    }
+}
+
+/* Ensures overlapping cues are mixed together instead of played back to
+   back, and nothing plays before the cue cache is built. */
+static int test_mixer_layers_cues(void) {
+    AudioFx fx;
+    memset(&fx, 0, sizeof(fx));
+    fx.ready = true;
+    fx.spec.freq = 48000;
+    set_constant_cue(&fx, AUDIO_CUE_SELECT, 0.25f, 8);
+    set_constant_cue(&fx, AUDIO_CUE_MOVE, 0.5f, 4);
+
+    /* Until the cue build finishes, cues are dropped rather than
+       synthesized on the calling thread. */
+    float out[16];
+    audio_fx_play_select(&fx);
+    audio_fx_mix(&fx, out, 16);
+    CHECK(out[0] == 0.0f);
+    AudioFxStats stats;
+    audio_fx_get_stats(&fx, &stats);
+    CHECK(stats.dropped == 1 && stats.enqueued == 0);
+
+    SDL_AtomicSet(&fx.cues_built, 1);
+    audio_fx_play_select(&fx);
+    audio_fx_play_move(&fx);
+
+    audio_fx_mix(&fx, out, 16);
+    CHECK(fabsf(out[0] - 0.75f) < 1e-6f);
+    CHECK(fabsf(out[4] - 0.25f) < 1e-6f);
+    CHECK(out[8] == 0.0f);
+
+    audio_fx_shutdown(&fx);
+    return 0;
+}
+
+/* Ensures click spam under backlog merges into one voice with bounded start latency. */
+static int test_backlog_merges_repeated_cues(void) {
+    AudioFx fx;
+    memset(&fx, 0, sizeof(fx));
+    fx.ready = true;
+    fx.spec.freq = 48000;
+    set_constant_cue(&fx, AUDIO_CUE_SELECT, 0.1f, 48000);
+    set_constant_cue(&fx, AUDIO_CUE_INVALID, 0.1f, 480);
+    SDL_AtomicSet(&fx.cues_built, 1);
+
+    float out[512];
+    audio_fx_play_select(&fx);
+    audio_fx_mix(&fx, out, 512);
+    for (int i = 0; i < 20; ++i) {
+        audio_fx_play_select(&fx);
+    }
+    audio_fx_mix(&fx, out, 512);
+
+    AudioFxStats stats;
+    audio_fx_get_stats(&fx, &stats);
+    CHECK(stats.enqueued == 1);
+    CHECK(stats.merged == 20);
+    CHECK(stats.dropped == 0);
+    CHECK(stats.backlog_ms > AUDIO_FX_BACKLOG_LIMIT_MS);
+    CHECK(stats.max_start_latency_ms <= 512 * 1000 / 48000);
+    CHECK(fabsf(out[0] - 0.1f) < 1e-6f);
+
+    for (int i = 0; i < AUDIO_FX_COMMAND_RING + 4; ++i) {
+        audio_fx_play_invalid(&fx);
+    }
+    audio_fx_get_stats(&fx, &stats);
+    CHECK(stats.enqueued == 2);
+    CHECK(stats.merged == 20 + AUDIO_FX_COMMAND_RING - 1);
+    CHECK(stats.dropped == 4);
+
+    audio_fx_shutdown(&fx);
+    return 0;
+}
+
+/* A command that waits for the next mix call reports that wait as its start
+   latency. */
+static int test_start_latency_counts_queue_wait(void) {
+    AudioFx fx;
+    memset(&fx, 0, sizeof(fx));
+    fx.ready = true;
+    fx.spec.freq = 48000;
+    set_constant_cue(&fx, AUDIO_CUE_MOVE, 0.2f, 64);
+    SDL_AtomicSet(&fx.cues_built, 1);
+
+    float out[64];
+    audio_fx_play_move(&fx);
+    SDL_Delay(5);
+    audio_fx_mix(&fx, out, 64);
+
+    AudioFxStats stats;
+    audio_fx_get_stats(&fx, &stats);
+    CHECK(stats.max_start_latency_us >= 4000);
+    CHECK(stats.max_start_latency_ms >= 4);
+
+    audio_fx_shutdown(&fx);
+    return 0;
+}
+
 int main(void) {
     if (test_no_device_calls_are_safe() != 0) {
         return 1;
     }
+    if (test_mixer_layers_cues() != 0) {
+        return 1;
+    }
+    if (test_backlog_merges_repeated_cues() != 0) {
+        return 1;
+    }
+    if (test_start_latency_counts_queue_wait() != 0) {
+        return 1;
+    }
 
     printf("Audio fx safety tests passed.\n");
     return 0;
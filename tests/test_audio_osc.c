@@ -0,0 +1,114 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "audio_osc.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RATE 48000
+#define MAX_SAMPLES 32768
+#define TOLERANCE 2e-3
+
+static float rendered[MAX_SAMPLES];
+
+/* Direct-form reference: per-sample sin() of every partial and the vibrato,
+   matching the original closed-form cue synthesis. */
+static double reference_sample(
+    const AudioOscTimbre *timbre,
+    double phase,
+    double vib_phase,
+    double gain,
+    double vibrato_depth,
+    double t,
+    double nyquist,
+    double top
+) {
+    double vib = sin(vib_phase) * vibrato_depth;
+    double sum = 0.0;
+    for (int k = 0; k < AUDIO_OSC_PARTIALS; ++k) {
+        if ((double)timbre->multiple[k] * top >= nyquist) {
+            continue;
+        }
+        sum += timbre->gain[k] * sin((double)timbre->multiple[k] * phase + vib * timbre->vibrato_share[k]);
+    }
+    double attack = fmin(1.0, t * timbre->attack_rate);
+    double release = fmin(1.0, (1.0 - t) * timbre->release_rate);
+    return sum * gain * attack * release;
+}
+
+/* Returns max absolute difference between oscillator and reference. */
+static double max_error(const AudioOscTimbre *timbre, float f0, float f1, float gain, float vib_hz, float vib_depth, int rate, int count) {
+    audio_osc_render(timbre, f0, f1, gain, vib_hz, vib_depth, rate, rendered, count);
+
+    double phase = 0.0;
+    double vib_phase = 0.0;
+    double worst = 0.0;
+    for (int i = 0; i < count; ++i) {
+        double t = (double)i / (double)count;
+        double expected = reference_sample(timbre, phase, vib_phase, gain, vib_depth, t, 0.5 * rate, fmax(f0, f1));
+        double err = fabs(expected - (double)rendered[i]);
+        if (err > worst) {
+            worst = err;
+        }
+        double f = (double)f0 + ((double)f1 - (double)f0) * t;
+        phase += 2.0 * M_PI * f / (double)rate;
+        vib_phase += 2.0 * M_PI * vib_hz / (double)rate;
+    }
+    return worst;
+}
+
+/* Notes must match the closed-form timbre, including block tails. */
+static int test_note_matches_reference(void) {
+    CHECK(max_error(&AUDIO_OSC_NOTE, 840.0f, 840.0f, 0.10f, 7.0f, 0.04f, RATE, 65 * RATE / 1000) < TOLERANCE);
+    CHECK(max_error(&AUDIO_OSC_NOTE, 196.0f, 196.0f, 0.15f, 4.8f, 0.07f, RATE, 370 * RATE / 1000) < TOLERANCE);
+    CHECK(max_error(&AUDIO_OSC_NOTE, 440.0f, 440.0f, 0.20f, 4.5f, 0.05f, RATE, 67) < TOLERANCE);
+    return 0;
+}
+
+/* Glides must track the linear frequency sweep. */
+static int test_glide_matches_reference(void) {
+    CHECK(max_error(&AUDIO_OSC_GLIDE, 380.0f, 520.0f, 0.09f, 5.5f, 0.03f, RATE, 72 * RATE / 1000) < TOLERANCE);
+    CHECK(max_error(&AUDIO_OSC_GLIDE, 174.6f, 130.8f, 0.13f, 5.0f, 0.08f, RATE, 560 * RATE / 1000) < TOLERANCE);
+    return 0;
+}
+
+/* Partials above Nyquist must be dropped rather than aliased. */
+static int test_partials_above_nyquist_are_dropped(void) {
+    CHECK(max_error(&AUDIO_OSC_NOTE, 1500.0f, 1500.0f, 0.2f, 0.0f, 0.0f, 8000, 400) < TOLERANCE);
+
+    audio_osc_render(&AUDIO_OSC_NOTE, 5000.0f, 5000.0f, 0.2f, 0.0f, 0.0f, 8000, rendered, 200);
+    bool silent = true;
+    for (int i = 0; i < 200; ++i) {
+        silent = silent && rendered[i] == 0.0f;
+    }
+    CHECK(silent);
+    return 0;
+}
+
+int main(void) {
+    audio_osc_init();
+
+    if (test_note_matches_reference() != 0) {
+        return 1;
+    }
+    if (test_glide_matches_reference() != 0) {
+        return 1;
+    }
+    if (test_partials_above_nyquist_are_dropped() != 0) {
+        return 1;
+    }
+
+    printf("Audio oscillator tests passed.\n");
+    return 0;
+}
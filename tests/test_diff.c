@@ -0,0 +1,352 @@
+/* Differential test: every engine in DIFF_ENGINES must stay bit-identical
+   to the frozen reference engine over random and adversarial click
+   sequences from many seeds, spread across a thread pool. */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "diff_engine.h"
+#include "ref_game.h"
+#include "rng.h"
+
+#define DIFF_DEFAULT_SEEDS 500
+#define DIFF_DEFAULT_CLICKS 300
+#define DIFF_DEFAULT_THREADS 4
+#define DIFF_MAX_THREADS 256
+#define DIFF_MAX_CLICKS 4096
+#define DIFF_CANDIDATES 24
+#define DIFF_CLICKS_AFTER_OVER 8
+
+/* Run configuration from flags or LINES98_DIFF_* variables. */
+typedef struct {
+    long long seeds;
+    int clicks;
+    int threads;
+    uint32_t seed_base;
+} DiffConfig;
+
+/* Shared pool state; only the smallest failing seed index is reported. */
+typedef struct {
+    const DiffConfig *config;
+    atomic_llong next_seed;
+    atomic_llong first_failed;
+    pthread_mutex_t lock;
+    const DiffEngine *failed_engine;
+    const char *failed_kind;
+    DiffMismatch failure;
+    atomic_llong turns;
+} DiffRun;
+
+/* Click sequence under construction, mirrored on a reference game. */
+typedef struct {
+    DiffClick *clicks;
+    int count;
+    int capacity;
+    Game shadow;
+    Rng rng;
+} SequenceBuilder;
+
+/* Appends a click and applies it to the shadow game. */
+static void emit(SequenceBuilder *b, int row, int col) {
+    if (b->count >= b->capacity) {
+        return;
+    }
+    b->clicks[b->count].row = (int8_t)row;
+    b->clicks[b->count].col = (int8_t)col;
+    ++b->count;
+    (void)ref_game_click(&b->shadow, row, col);
+}
+
+/* Returns a random cell index holding a ball (want_ball) or empty, or -1. */
+static int random_cell(SequenceBuilder *b, bool want_ball) {
+    int start = (int)rng_range(&b->rng, GAME_CELLS);
+    for (int k = 0; k < GAME_CELLS; ++k) {
+        int idx = (start + k) % GAME_CELLS;
+        if ((b->shadow.board[idx] != 0) == want_ball) {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+/* Length of the longest color run through idx if it held color, with the
+   moving ball's old cell treated as empty. */
+static int line_through(const Game *game, int idx, int color, int vacated) {
+    static const int dirs[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    int row = idx / GAME_BOARD_SIZE;
+    int col = idx % GAME_BOARD_SIZE;
+    int best = 1;
+    for (int d = 0; d < 4; ++d) {
+        int length = 1;
+        for (int sign = -1; sign <= 1; sign += 2) {
+            int r = row + sign * dirs[d][0];
+            int c = col + sign * dirs[d][1];
+            while (r >= 0 && r < GAME_BOARD_SIZE && c >= 0 && c < GAME_BOARD_SIZE) {
+                int cell = r * GAME_BOARD_SIZE + c;
+                if (cell == vacated || game->board[cell] != color) {
+                    break;
+                }
+                ++length;
+                r += sign * dirs[d][0];
+                c += sign * dirs[d][1];
+            }
+        }
+        if (length > best) {
+            best = length;
+        }
+    }
+    return best;
+}
+
+/* Emits the legal move among sampled candidates that builds the longest
+   line, steering games into clears, multi-line clears and full boards. */
+static bool emit_line_move(SequenceBuilder *b) {
+    int best_from = -1;
+    int best_to = -1;
+    int best_len = 0;
+    for (int k = 0; k < DIFF_CANDIDATES; ++k) {
+        int from = random_cell(b, true);
+        int to = random_cell(b, false);
+        if (from < 0 || to < 0) {
+            return false;
+        }
+        int fr = from / GAME_BOARD_SIZE;
+        int fc = from % GAME_BOARD_SIZE;
+        if (!ref_game_can_reach(&b->shadow, fr, fc, to / GAME_BOARD_SIZE, to % GAME_BOARD_SIZE)) {
+            continue;
+        }
+        int len = line_through(&b->shadow, to, b->shadow.board[from], from);
+        if (len > best_len) {
+            best_len = len;
+            best_from = from;
+            best_to = to;
+        }
+    }
+    if (best_from < 0) {
+        return false;
+    }
+    emit(b, best_from / GAME_BOARD_SIZE, best_from % GAME_BOARD_SIZE);
+    emit(b, best_to / GAME_BOARD_SIZE, best_to % GAME_BOARD_SIZE);
+    return true;
+}
+
+/* Builds a sequence of uniformly random clicks, including the ring of
+   out-of-range cells around the board. */
+static int build_random(uint32_t seed, DiffClick *clicks, int capacity) {
+    Rng rng;
+    rng_seed(&rng, seed ^ 0x9E3779B9u);
+    for (int i = 0; i < capacity; ++i) {
+        clicks[i].row = (int8_t)((int)rng_range(&rng, GAME_BOARD_SIZE + 2) - 1);
+        clicks[i].col = (int8_t)((int)rng_range(&rng, GAME_BOARD_SIZE + 2) - 1);
+    }
+    return capacity;
+}
+
+/* Builds an adversarial sequence: line-building moves mixed with
+   unreachable targets, reselection, repeated clicks, extreme coordinates
+   and clicks after game over. */
+static int build_adversarial(uint32_t seed, DiffClick *clicks, int capacity) {
+    static const int8_t FAR[4] = {-1, GAME_BOARD_SIZE, INT8_MIN, INT8_MAX};
+    SequenceBuilder b;
+    b.clicks = clicks;
+    b.count = 0;
+    b.capacity = capacity;
+    ref_game_init(&b.shadow, seed);
+    rng_seed(&b.rng, seed ^ 0x85EBCA6Bu);
+
+    int after_over = 0;
+    while (b.count < capacity && after_over < DIFF_CLICKS_AFTER_OVER) {
+        if (b.shadow.game_over) {
+            ++after_over;
+        }
+
+        int roll = (int)rng_range(&b.rng, 100);
+        if (roll < 45) {
+            if (emit_line_move(&b)) {
+                continue;
+            }
+            roll = 99;
+        }
+
+        if (roll < 55) {
+            int from = random_cell(&b, true);
+            int to = random_cell(&b, false);
+            if (from >= 0 && to >= 0) {
+                emit(&b, from / GAME_BOARD_SIZE, from % GAME_BOARD_SIZE);
+                emit(&b, to / GAME_BOARD_SIZE, to % GAME_BOARD_SIZE);
+                continue;
+            }
+        } else if (roll < 65) {
+            emit(&b, FAR[rng_range(&b.rng, 4)], FAR[rng_range(&b.rng, 4)]);
+            continue;
+        } else if (roll < 75) {
+            int cell = b.shadow.selected_index >= 0 ? b.shadow.selected_index : random_cell(&b, true);
+            if (cell >= 0) {
+                emit(&b, cell / GAME_BOARD_SIZE, cell % GAME_BOARD_SIZE);
+                emit(&b, cell / GAME_BOARD_SIZE, cell % GAME_BOARD_SIZE);
+                continue;
+            }
+        }
+
+        emit(&b, (int)rng_range(&b.rng, GAME_BOARD_SIZE), (int)rng_range(&b.rng, GAME_BOARD_SIZE));
+    }
+    return b.count;
+}
+
+/* Records a failure if index is the smallest failing seed so far. */
+static void record_failure(DiffRun *run, long long index, const DiffEngine *engine, const char *kind, const DiffMismatch *m) {
+    pthread_mutex_lock(&run->lock);
+    long long current = atomic_load(&run->first_failed);
+    if (index < current) {
+        atomic_store(&run->first_failed, index);
+        run->failed_engine = engine;
+        run->failed_kind = kind;
+        run->failure = *m;
+    }
+    pthread_mutex_unlock(&run->lock);
+}
+
+/* Worker: checks every engine on both sequence kinds for each seed. */
+static void *diff_worker(void *data) {
+    DiffRun *run = (DiffRun *)data;
+    const DiffConfig *config = run->config;
+    DiffClick *clicks = (DiffClick *)malloc((size_t)config->clicks * sizeof(DiffClick));
+    if (clicks == NULL) {
+        return NULL;
+    }
+
+    for (;;) {
+        long long i = atomic_fetch_add(&run->next_seed, 1);
+        if (i >= config->seeds || i > atomic_load(&run->first_failed)) {
+            break;
+        }
+        uint32_t seed = config->seed_base + (uint32_t)i;
+
+        for (int kind = 0; kind < 2; ++kind) {
+            int count = kind == 0 ? build_random(seed, clicks, config->clicks) : build_adversarial(seed, clicks, config->clicks);
+            for (int e = 0; e < DIFF_ENGINE_COUNT; ++e) {
+                DiffMismatch m;
+                if (!diff_run(DIFF_ENGINES[e], seed, clicks, count, &m)) {
+                    record_failure(run, i, DIFF_ENGINES[e], kind == 0 ? "random" : "adversarial", &m);
+                }
+            }
+            atomic_fetch_add(&run->turns, count);
+        }
+    }
+
+    free(clicks);
+    return NULL;
+}
+
+/* Reads a numeric environment variable, or fallback. */
+static long long env_count(const char *name, long long fallback) {
+    const char *value = getenv(name);
+    if (value == NULL || value[0] == '\0') {
+        return fallback;
+    }
+    return strtoll(value, NULL, 10);
+}
+
+/* Fills config from LINES98_DIFF_* variables, then command-line flags. */
+static bool parse_config(int argc, char **argv, DiffConfig *config) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    config->seeds = env_count("LINES98_DIFF_SEEDS", DIFF_DEFAULT_SEEDS);
+    config->clicks = (int)env_count("LINES98_DIFF_CLICKS", DIFF_DEFAULT_CLICKS);
+    config->threads = (int)env_count("LINES98_DIFF_THREADS", cpus > 0 && cpus < DIFF_DEFAULT_THREADS ? cpus : DIFF_DEFAULT_THREADS);
+    config->seed_base = (uint32_t)env_count("LINES98_DIFF_SEED", 1);
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "--seeds") == 0 && has_value) {
+            config->seeds = strtoll(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--clicks") == 0 && has_value) {
+            config->clicks = atoi(argv[++i]);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            config->threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            config->seed_base = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--seeds N] [--clicks N] [--threads N] [--seed S]\n", argv[0]);
+            return false;
+        }
+    }
+
+    if (config->seeds <= 0 || config->clicks <= 0 || config->clicks > DIFF_MAX_CLICKS || config->threads <= 0 ||
+        config->threads > DIFF_MAX_THREADS) {
+        fprintf(stderr, "seeds must be positive, clicks in [1..%d], threads in [1..%d]\n", DIFF_MAX_CLICKS, DIFF_MAX_THREADS);
+        return false;
+    }
+    if (config->seeds < config->threads) {
+        config->threads = (int)config->seeds;
+    }
+    return true;
+}
+
+/* The reference must agree with itself, or the harness proves nothing. */
+static int check_reference_matches_current(void) {
+    Game a;
+    Game b;
+    ref_game_init(&a, 7);
+    game_init(&b, 7);
+    if (memcmp(a.board, b.board, sizeof(a.board)) != 0 || a.rng.state != b.rng.state) {
+        fprintf(stderr, "FAILED: reference and src/game.c disagree after game_init\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    DiffConfig config;
+    if (!parse_config(argc, argv, &config)) {
+        return 2;
+    }
+    if (check_reference_matches_current() != 0) {
+        return 1;
+    }
+
+    DiffRun run;
+    memset(&run, 0, sizeof(run));
+    run.config = &config;
+    atomic_init(&run.next_seed, 0);
+    atomic_init(&run.first_failed, config.seeds);
+    atomic_init(&run.turns, 0);
+    pthread_mutex_init(&run.lock, NULL);
+
+    pthread_t threads[DIFF_MAX_THREADS];
+    int started = 0;
+    for (int t = 0; t < config.threads; ++t) {
+        if (pthread_create(&threads[t], NULL, diff_worker, &run) != 0) {
+            break;
+        }
+        ++started;
+    }
+    if (started == 0) {
+        (void)diff_worker(&run);
+    }
+    for (int t = 0; t < started; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_mutex_destroy(&run.lock);
+
+    long long failed = atomic_load(&run.first_failed);
+    if (failed < config.seeds) {
+        fprintf(stderr, "%s sequence: ", run.failed_kind);
+        diff_report(run.failed_engine, config.seed_base + (uint32_t)failed, &run.failure);
+        return 1;
+    }
+
+    printf(
+        "Differential tests passed (%d engines, %lld seeds, %lld clicks).\n",
+        DIFF_ENGINE_COUNT,
+        config.seeds,
+        (long long)atomic_load(&run.turns)
+    );
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "engine_counters.h"
+#include "game.h"
+#include "turn_controller.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+/* Empties the board so tests can place balls explicitly. */
+static void clear_board(Game *game) {
+    memset(game->board, 0, sizeof(game->board));
+    game->selected_index = -1;
+}
+
+/* A boxed-in ball expands only its own BFS node. */
+static int test_blocked_reach(void) {
+    Game game;
+    game_init(&game, 5);
+    clear_board(&game);
+    game.board[0] = 1;
+    game.board[1] = 2;
+    game.board[GAME_BOARD_SIZE] = 2;
+
+    engine_counters_reset();
+    CHECK(!game_can_reach(&game, 0, 0, 8, 8));
+    (void)game_empty_count(&game);
+
+    EngineCounters c;
+    engine_counters_snapshot(&c);
+    CHECK(c.reach_nodes == 1);
+    CHECK(c.empty_count_calls == 1);
+    CHECK(c.turns == 0);
+    return 0;
+}
+
+/* Completing a row of five counts one turn, one clear pass and no spawn. */
+static int test_clearing_turn(void) {
+    Game game;
+    game_init(&game, 11);
+    clear_board(&game);
+    for (int c = 0; c < 4; ++c) {
+        game.board[1 * GAME_BOARD_SIZE + c] = 3;
+    }
+    game.board[0 * GAME_BOARD_SIZE + 4] = 3;
+
+    TurnClickResult result;
+    turn_controller_click(&game, 0, 4, &result);
+    engine_counters_reset();
+    turn_controller_click(&game, 1, 4, &result);
+    CHECK(result.action == GAME_ACTION_MOVED);
+
+    EngineCounters c;
+    engine_counters_snapshot(&c);
+    CHECK(c.turns == 1);
+    CHECK(c.reach_nodes == 1);
+    CHECK(c.path_nodes == 1);
+    CHECK(c.clear_passes == 1);
+    /* 81 start cells plus 8 steps from the row head and 3 from each other ball. */
+    CHECK(c.clear_cells_scanned == GAME_CELLS + 8 + 4 * 3);
+    CHECK(c.cleared_balls == 5);
+    CHECK(c.spawned_balls == 0);
+    CHECK(c.empty_count_calls == 1);
+    return 0;
+}
+
+/* A move without a line spawns the preview and rescans the board. */
+static int test_spawning_turn(void) {
+    Game game;
+    game_init(&game, 21);
+    clear_board(&game);
+    game.board[0] = 4;
+
+    engine_counters_reset();
+    CHECK(game_click(&game, 0, 0) == GAME_ACTION_SELECTED);
+    CHECK(game_click(&game, 8, 8) == GAME_ACTION_MOVED);
+
+    EngineCounters c;
+    engine_counters_snapshot(&c);
+    CHECK(c.turns == 1);
+    CHECK(c.reach_nodes > 1);
+    CHECK(c.clear_passes == 2);
+    CHECK(c.spawned_balls == GAME_NEXT_COUNT);
+    CHECK(c.cleared_balls == 0);
+
+    engine_counters_reset();
+    engine_counters_snapshot(&c);
+    CHECK(c.turns == 0 && c.reach_nodes == 0 && c.clear_cells_scanned == 0);
+    return 0;
+}
+
+int main(void) {
+    if (!engine_counters_enabled()) {
+        fprintf(stderr, "FAILED: built without LINES98_ENGINE_COUNTERS\n");
+        return 1;
+    }
+    if (test_blocked_reach() != 0) {
+        return 1;
+    }
+    if (test_clearing_turn() != 0) {
+        return 1;
+    }
+    if (test_spawning_turn() != 0) {
+        return 1;
+    }
+
+    printf("Engine counter tests passed.\n");
+    return 0;
+}
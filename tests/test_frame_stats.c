@@ -0,0 +1,82 @@
+#include <stdio.h>
+
+#include "frame_stats.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+/* Quarter-octave buckets: reported percentile is within 19% above the value. */
+static int near_upper(float reported, float actual) {
+    return reported >= actual && reported <= actual * 1.19f;
+}
+
+/* Stage time accumulates across adds within one frame. */
+static int test_accumulates_within_frame(void) {
+    static FrameStats stats;
+    frame_stats_init(&stats, 2);
+    frame_stats_add(&stats, 0, 100.0f);
+    frame_stats_add(&stats, 0, 50.0f);
+    frame_stats_add(&stats, 1, 7.0f);
+    frame_stats_add(&stats, 5, 1000.0f);
+    frame_stats_end_frame(&stats);
+
+    CHECK(frame_stats_count(&stats) == 1);
+    CHECK(frame_stats_last(&stats, 0) == 150.0f);
+    CHECK(frame_stats_last(&stats, 1) == 7.0f);
+    CHECK(near_upper(frame_stats_percentile(&stats, 0, 0.5f), 150.0f));
+    return 0;
+}
+
+/* Percentiles follow the distribution of the window. */
+static int test_percentiles(void) {
+    static FrameStats stats;
+    frame_stats_init(&stats, 1);
+    for (int i = 0; i < 100; ++i) {
+        frame_stats_add(&stats, 0, i < 98 ? 1000.0f : 16000.0f);
+        frame_stats_end_frame(&stats);
+    }
+
+    CHECK(near_upper(frame_stats_percentile(&stats, 0, 0.5f), 1000.0f));
+    CHECK(near_upper(frame_stats_percentile(&stats, 0, 0.98f), 1000.0f));
+    CHECK(near_upper(frame_stats_percentile(&stats, 0, 0.99f), 16000.0f));
+    CHECK(frame_stats_percentile(&stats, 0, 0.0f) > 0.0f);
+    return 0;
+}
+
+/* Old frames leave the histogram when the ring wraps. */
+static int test_window_rolls(void) {
+    static FrameStats stats;
+    frame_stats_init(&stats, 1);
+    for (int i = 0; i < FRAME_STATS_HISTORY; ++i) {
+        frame_stats_add(&stats, 0, 20000.0f);
+        frame_stats_end_frame(&stats);
+    }
+    for (int i = 0; i < FRAME_STATS_HISTORY; ++i) {
+        frame_stats_add(&stats, 0, 40.0f);
+        frame_stats_end_frame(&stats);
+    }
+
+    CHECK(frame_stats_count(&stats) == FRAME_STATS_HISTORY);
+    CHECK(near_upper(frame_stats_percentile(&stats, 0, 1.0f), 40.0f));
+    return 0;
+}
+
+int main(void) {
+    if (test_accumulates_within_frame() != 0) {
+        return 1;
+    }
+    if (test_percentiles() != 0) {
+        return 1;
+    }
+    if (test_window_rolls() != 0) {
+        return 1;
+    }
+
+    printf("Frame stats tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fx_particles.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+#define BOARD_X 92
+#define BOARD_Y 110
+#define CELL 64
+#define BALL_RADIUS 23.0f
+
+static ParticleSystem g_ps;
+
+static int check_in_board(const ParticleSystem *ps) {
+    const float max_x = (float)(BOARD_X + GAME_BOARD_SIZE * CELL);
+    const float max_y = (float)(BOARD_Y + GAME_BOARD_SIZE * CELL);
+    for (int i = 0; i < ps->count; ++i) {
+        CHECK(ps->life[i] > 0.0f);
+        CHECK(ps->x[i] >= (float)BOARD_X && ps->x[i] <= max_x);
+        CHECK(ps->y[i] >= (float)BOARD_Y && ps->y[i] <= max_y);
+    }
+    return 0;
+}
+
+/* Runs odd-sized bursts so both the SIMD batches and the scalar tail are hit. */
+static int test_particles_stay_on_board_and_expire(void) {
+    uint8_t board[GAME_CELLS];
+    memset(board, 0, sizeof(board));
+    for (int i = 0; i < GAME_CELLS; i += 3) {
+        board[i] = 1;
+    }
+
+    srand(7);
+    particles_init(&g_ps);
+    SDL_Color c = {200, 100, 50, 255};
+    particles_spawn_burst(&g_ps, (float)(BOARD_X + 5), (float)(BOARD_Y + 5), c, 13);
+    particles_spawn_burst(&g_ps, (float)(BOARD_X + 300), (float)(BOARD_Y + 570), c, 27);
+    CHECK(g_ps.count == 40);
+
+    for (int step = 0; step < 120; ++step) {
+        particles_update(&g_ps, 1.0f / 60.0f, board, GAME_BOARD_SIZE, CELL, BOARD_X, BOARD_Y, BALL_RADIUS);
+        if (check_in_board(&g_ps) != 0) {
+            return 1;
+        }
+    }
+
+    /* Longest lifetime is 1.6 s, so everything must be gone after 2 s. */
+    CHECK(particles_active_count(&g_ps) == 0);
+    return 0;
+}
+
+static int test_capacity_is_bounded(void) {
+    uint8_t board[GAME_CELLS];
+    memset(board, 0, sizeof(board));
+
+    particles_init(&g_ps);
+    SDL_Color c = {10, 20, 30, 255};
+    particles_spawn_burst(&g_ps, 300.0f, 300.0f, c, MAX_PARTICLES + 100);
+    CHECK(g_ps.count == MAX_PARTICLES);
+
+    particles_update(&g_ps, 1.0f / 60.0f, board, GAME_BOARD_SIZE, CELL, BOARD_X, BOARD_Y, BALL_RADIUS);
+    CHECK(g_ps.count == MAX_PARTICLES);
+    return check_in_board(&g_ps);
+}
+
+static int test_particles_pushed_out_of_balls(void) {
+    uint8_t board[GAME_CELLS];
+    memset(board, 1, sizeof(board));
+
+    srand(11);
+    particles_init(&g_ps);
+    SDL_Color c = {1, 2, 3, 255};
+    float cx = (float)(BOARD_X + 4 * CELL + CELL / 2);
+    float cy = (float)(BOARD_Y + 4 * CELL + CELL / 2);
+    particles_spawn_burst(&g_ps, cx, cy, c, 9);
+
+    particles_update(&g_ps, 0.001f, board, GAME_BOARD_SIZE, CELL, BOARD_X, BOARD_Y, BALL_RADIUS);
+    for (int i = 0; i < g_ps.count; ++i) {
+        float dx = g_ps.x[i] - cx;
+        float dy = g_ps.y[i] - cy;
+        float min_dist = g_ps.radius[i] + BALL_RADIUS;
+        CHECK(sqrtf(dx * dx + dy * dy) >= min_dist - 0.01f);
+    }
+    return 0;
+}
+
+/* The SIMD kernel must match the scalar loop lane for lane, including the
+   tail past the last full batch and particles bouncing off every edge. */
+static int test_simd_matches_scalar(void) {
+    static ParticleSystem reference;
+    srand(23);
+    particles_init(&g_ps);
+    SDL_Color c = {90, 180, 40, 255};
+    particles_spawn_burst(&g_ps, (float)(BOARD_X + 3), (float)(BOARD_Y + 3), c, 19);
+    particles_spawn_burst(&g_ps, (float)(BOARD_X + GAME_BOARD_SIZE * CELL - 3), (float)(BOARD_Y + 200), c, 21);
+    particles_spawn_burst(&g_ps, (float)(BOARD_X + 250), (float)(BOARD_Y + GAME_BOARD_SIZE * CELL - 3), c, 23);
+    CHECK(g_ps.count == 63);
+    memcpy(&reference, &g_ps, sizeof(reference));
+
+    const float floor_y = (float)(BOARD_Y + GAME_BOARD_SIZE * CELL);
+    int floor_hits = 0;
+    for (int step = 0; step < 90; ++step) {
+        particles_integrate(&g_ps, 1.0f / 60.0f, GAME_BOARD_SIZE, CELL, BOARD_X, BOARD_Y, true);
+        particles_integrate(&reference, 1.0f / 60.0f, GAME_BOARD_SIZE, CELL, BOARD_X, BOARD_Y, false);
+        for (int i = 0; i < g_ps.count; ++i) {
+            CHECK(fabsf(g_ps.x[i] - reference.x[i]) <= 1e-3f);
+            CHECK(fabsf(g_ps.y[i] - reference.y[i]) <= 1e-3f);
+            CHECK(fabsf(g_ps.vx[i] - reference.vx[i]) <= 1e-3f);
+            CHECK(fabsf(g_ps.vy[i] - reference.vy[i]) <= 1e-3f);
+            CHECK(fabsf(g_ps.life[i] - reference.life[i]) <= 1e-5f);
+            if (reference.y[i] >= floor_y - reference.radius[i]) {
+                ++floor_hits;
+            }
+        }
+    }
+    CHECK(floor_hits > 0);
+    return 0;
+}
+
+int main(void) {
+    if (test_particles_stay_on_board_and_expire() != 0) {
+        return 1;
+    }
+    if (test_capacity_is_bounded() != 0) {
+        return 1;
+    }
+    if (test_particles_pushed_out_of_balls() != 0) {
+        return 1;
+    }
+    if (test_simd_matches_scalar() != 0) {
+        return 1;
+    }
+
+    printf("Particle tests passed.\n");
+    return 0;
+}
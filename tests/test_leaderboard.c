@@ -0,0 +1,138 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "leaderboard.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+#define TEST_RESULTS 20000
+#define TEST_TOP_K 100
+
+static char board_path[64];
+static LeaderboardEntry reference[TEST_RESULTS + 64];
+static size_t reference_count;
+
+/* Orders entries best first, like the leaderboard. */
+static int compare_entries(const void *pa, const void *pb) {
+    const LeaderboardEntry *a = (const LeaderboardEntry *)pa;
+    const LeaderboardEntry *b = (const LeaderboardEntry *)pb;
+    if (a->score != b->score) {
+        return a->score > b->score ? -1 : 1;
+    }
+    return a->seq < b->seq ? -1 : a->seq > b->seq;
+}
+
+/* Checks top-K reads, ranks and scores-at-rank against a sorted copy. */
+static int check_against_reference(Leaderboard *board) {
+    static LeaderboardEntry sorted[TEST_RESULTS + 64];
+    memcpy(sorted, reference, reference_count * sizeof(LeaderboardEntry));
+    qsort(sorted, reference_count, sizeof(LeaderboardEntry), compare_entries);
+    CHECK(leaderboard_count(board) == reference_count);
+
+    LeaderboardEntry top[TEST_TOP_K];
+    size_t n = leaderboard_top(board, 0, TEST_TOP_K, top);
+    CHECK(n == (reference_count < TEST_TOP_K ? reference_count : TEST_TOP_K));
+    for (size_t i = 0; i < n; ++i) {
+        CHECK(top[i].seq == sorted[i].seq && top[i].score == sorted[i].score);
+        CHECK(top[i].session == sorted[i].session && top[i].finished_ms == sorted[i].finished_ms);
+    }
+    LeaderboardEntry page[7];
+    CHECK(leaderboard_top(board, 40, 7, page) == 7 && page[0].seq == sorted[40].seq && page[6].seq == sorted[46].seq);
+    CHECK(leaderboard_top(board, TEST_TOP_K - 2, 7, page) == 2);
+
+    for (size_t i = 0; i < reference_count; i += 97) {
+        int32_t score = sorted[i].score;
+        size_t higher = 0;
+        while (sorted[higher].score > score) {
+            ++higher;
+        }
+        CHECK(leaderboard_rank(board, score) == higher + 1);
+        CHECK(leaderboard_score_at(board, (uint32_t)i + 1) == score);
+    }
+    CHECK(leaderboard_rank(board, sorted[0].score + 1) == 1);
+    CHECK(leaderboard_rank(board, -5) == reference_count + 1);
+    CHECK(leaderboard_score_at(board, (uint32_t)reference_count) == sorted[reference_count - 1].score);
+    CHECK(leaderboard_score_at(board, (uint32_t)reference_count + 1) == -1);
+    return 0;
+}
+
+/* Submits results whose scores span several Fenwick growths. */
+static int submit_results(Leaderboard *board, size_t count, uint32_t seed) {
+    for (size_t i = 0; i < count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        int32_t score = (int32_t)((seed >> 8) % (i < count / 2 ? 3000u : 60000u));
+        LeaderboardEntry entry;
+        CHECK(leaderboard_submit(board, (uint32_t)i * 3u + 1u, score, 1700000000000ull + i, &entry));
+        CHECK(entry.seq == reference_count + 1 && entry.score == score);
+        reference[reference_count++] = entry;
+    }
+    return 0;
+}
+
+/* Indexes match a sorted reference, and survive a reopen. */
+static int test_submit_and_reopen(void) {
+    unlink(board_path);
+    reference_count = 0;
+    Leaderboard board;
+    CHECK(leaderboard_open(&board, board_path, TEST_TOP_K));
+    CHECK(leaderboard_count(&board) == 0 && leaderboard_score_at(&board, 1) == -1 && leaderboard_rank(&board, 7) == 1);
+    CHECK(submit_results(&board, TEST_RESULTS, 5) == 0);
+    CHECK(check_against_reference(&board) == 0);
+    CHECK(leaderboard_sync(&board));
+    leaderboard_close(&board);
+
+    CHECK(leaderboard_open(&board, board_path, TEST_TOP_K));
+    CHECK(check_against_reference(&board) == 0);
+    leaderboard_close(&board);
+    return 0;
+}
+
+/* A record whose commit never landed is ignored, and its slot reused. */
+static int test_torn_record(void) {
+    Leaderboard board;
+    int fd = open(board_path, O_WRONLY);
+    CHECK(fd >= 0);
+    uint8_t flip = 0x5A;
+    off_t last = LEADERBOARD_HEADER_SIZE + (off_t)(TEST_RESULTS - 1) * LEADERBOARD_RECORD_SIZE;
+    CHECK(pwrite(fd, &flip, 1, last + 13) == 1);
+    close(fd);
+
+    CHECK(leaderboard_open(&board, board_path, TEST_TOP_K));
+    --reference_count;
+    CHECK(check_against_reference(&board) == 0);
+    CHECK(submit_results(&board, 50, 9) == 0);
+    CHECK(check_against_reference(&board) == 0);
+    leaderboard_close(&board);
+
+    CHECK(leaderboard_open(&board, board_path, TEST_TOP_K));
+    CHECK(check_against_reference(&board) == 0);
+    leaderboard_close(&board);
+
+    fd = open(board_path, O_WRONLY);
+    CHECK(fd >= 0);
+    CHECK(pwrite(fd, "NOTBOARD", 8, 0) == 8);
+    close(fd);
+    CHECK(!leaderboard_open(&board, board_path, TEST_TOP_K));
+    return 0;
+}
+
+int main(void) {
+    snprintf(board_path, sizeof(board_path), "/tmp/lines98_leaderboard_test_%d.db", (int)getpid());
+    int failed = test_submit_and_reopen() != 0 || test_torn_record() != 0;
+    unlink(board_path);
+    if (failed) {
+        return 1;
+    }
+
+    printf("Leaderboard tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "movelog.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+#define TEST_THREADS 3
+#define TEST_PER_THREAD 2000
+
+static char log_path[64];
+
+/* Collects replayed records and checks per-session ordering. */
+typedef struct {
+    size_t count;
+    uint32_t next_seed[TEST_THREADS + 1];
+    bool ordered;
+    MoveLogRecord last;
+} ReplayLog;
+
+/* Replay callback: each session's seeds must arrive 0, 1, 2, ... */
+static void collect(void *ctx, const MoveLogRecord *record) {
+    ReplayLog *replayed = (ReplayLog *)ctx;
+    if (record->session > TEST_THREADS || record->seed != replayed->next_seed[record->session] ||
+        record->a != (uint8_t)record->seed || record->b != (uint8_t)(record->seed >> 8)) {
+        replayed->ordered = false;
+    } else {
+        ++replayed->next_seed[record->session];
+    }
+    replayed->last = *record;
+    ++replayed->count;
+}
+
+/* Appender arguments. */
+typedef struct {
+    MoveLog *log;
+    uint32_t session;
+    uint64_t last_lsn;
+} Appender;
+
+/* Appends TEST_PER_THREAD records for one session. */
+static void *append_thread(void *data) {
+    Appender *appender = (Appender *)data;
+    for (uint32_t i = 0; i < TEST_PER_THREAD; ++i) {
+        MoveLogRecord record = {appender->session, i, 3, (uint8_t)i, (uint8_t)(i >> 8)};
+        appender->last_lsn = movelog_append(appender->log, &record);
+    }
+    return NULL;
+}
+
+/* Waits until lsn is durable or about two seconds pass. */
+static bool wait_durable(MoveLog *log, uint64_t lsn) {
+    for (int i = 0; i < 2000 && movelog_durable(log) < lsn; ++i) {
+        struct timespec pause = {0, 1000000L};
+        nanosleep(&pause, NULL);
+    }
+    return movelog_durable(log) >= lsn;
+}
+
+/* Returns the journal file size. */
+static off_t file_size(void) {
+    struct stat st;
+    return stat(log_path, &st) == 0 ? st.st_size : -1;
+}
+
+/* Concurrent appends become durable, notify, and replay in order. */
+static int test_append_and_recover(void) {
+    unlink(log_path);
+    MoveLog log;
+    CHECK(movelog_open(&log, log_path, 0, NULL, NULL));
+    int notify = eventfd(0, EFD_NONBLOCK);
+    CHECK(notify >= 0 && movelog_add_notify(&log, notify));
+    CHECK(movelog_start(&log));
+    CHECK(!movelog_add_notify(&log, notify));
+
+    pthread_t threads[TEST_THREADS];
+    Appender appenders[TEST_THREADS];
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        appenders[t].log = &log;
+        appenders[t].session = (uint32_t)t + 1;
+        appenders[t].last_lsn = 0;
+        CHECK(pthread_create(&threads[t], NULL, append_thread, &appenders[t]) == 0);
+    }
+    uint64_t last = 0;
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+        last = appenders[t].last_lsn > last ? appenders[t].last_lsn : last;
+    }
+    CHECK(last == (uint64_t)TEST_THREADS * TEST_PER_THREAD * MOVELOG_RECORD_SIZE);
+    CHECK(wait_durable(&log, last));
+    CHECK(file_size() == (off_t)last);
+    uint64_t signalled = 0;
+    CHECK(read(notify, &signalled, sizeof(signalled)) == sizeof(signalled) && signalled >= 1);
+    CHECK(atomic_load(&log.records) == TEST_THREADS * TEST_PER_THREAD);
+    movelog_close(&log);
+    close(notify);
+
+    ReplayLog replayed;
+    memset(&replayed, 0, sizeof(replayed));
+    replayed.ordered = true;
+    CHECK(movelog_open(&log, log_path, 0, collect, &replayed));
+    CHECK(replayed.count == TEST_THREADS * TEST_PER_THREAD && replayed.ordered);
+    CHECK(movelog_durable(&log) == last);
+    movelog_close(&log);
+    return 0;
+}
+
+/* A durability window folds a burst of appends into a few fsyncs. */
+static int test_group_commit_window(void) {
+    unlink(log_path);
+    MoveLog log;
+    CHECK(movelog_open(&log, log_path, 50, NULL, NULL));
+    CHECK(movelog_start(&log));
+    uint64_t lsn = 0;
+    for (uint32_t i = 0; i < 500; ++i) {
+        MoveLogRecord record = {1, i, 3, (uint8_t)i, (uint8_t)(i >> 8)};
+        lsn = movelog_append(&log, &record);
+    }
+    CHECK(wait_durable(&log, lsn));
+    CHECK(atomic_load(&log.records) == 500 && atomic_load(&log.commits) <= 3);
+    movelog_close(&log);
+    return 0;
+}
+
+/* A torn tail is dropped and a corrupt record ends the valid prefix. */
+static int test_torn_and_corrupt_tail(void) {
+    unlink(log_path);
+    MoveLog log;
+    CHECK(movelog_open(&log, log_path, 0, NULL, NULL));
+    CHECK(movelog_start(&log));
+    for (uint32_t i = 0; i < 100; ++i) {
+        MoveLogRecord record = {2, i, 3, (uint8_t)i, 0};
+        movelog_append(&log, &record);
+    }
+    movelog_close(&log);
+    CHECK(file_size() == 100 * MOVELOG_RECORD_SIZE);
+
+    int fd = open(log_path, O_WRONLY | O_APPEND);
+    CHECK(fd >= 0);
+    static const uint8_t torn[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    CHECK(write(fd, torn, sizeof(torn)) == (ssize_t)sizeof(torn));
+    close(fd);
+
+    ReplayLog replayed;
+    memset(&replayed, 0, sizeof(replayed));
+    replayed.ordered = true;
+    replayed.next_seed[2] = 0;
+    CHECK(movelog_open(&log, log_path, 0, collect, &replayed));
+    CHECK(replayed.count == 100 && replayed.ordered && replayed.last.seed == 99);
+    CHECK(file_size() == 100 * MOVELOG_RECORD_SIZE);
+    movelog_close(&log);
+
+    fd = open(log_path, O_WRONLY);
+    CHECK(fd >= 0);
+    uint8_t flip = 0xFF;
+    CHECK(pwrite(fd, &flip, 1, 60 * MOVELOG_RECORD_SIZE + 9) == 1);
+    close(fd);
+
+    memset(&replayed, 0, sizeof(replayed));
+    replayed.ordered = true;
+    CHECK(movelog_open(&log, log_path, 0, collect, &replayed));
+    CHECK(replayed.count == 60 && replayed.ordered);
+    CHECK(file_size() == 60 * MOVELOG_RECORD_SIZE);
+
+    CHECK(movelog_start(&log));
+    MoveLogRecord record = {2, 60, 3, 60, 0};
+    uint64_t lsn = movelog_append(&log, &record);
+    CHECK(lsn == 61 * MOVELOG_RECORD_SIZE);
+    movelog_close(&log);
+    CHECK(file_size() == 61 * MOVELOG_RECORD_SIZE);
+    return 0;
+}
+
+/* A restart leaves only its head record, and appends continue after it. */
+static int test_restart(void) {
+    unlink(log_path);
+    MoveLog log;
+    CHECK(movelog_open(&log, log_path, 0, NULL, NULL));
+    CHECK(movelog_start(&log));
+    for (uint32_t i = 0; i < 50; ++i) {
+        MoveLogRecord record = {1, i, 3, (uint8_t)i, 0};
+        movelog_append(&log, &record);
+    }
+    MoveLogRecord head = {0, 77, 0, 0, 0};
+    CHECK(!movelog_restart(&log, &head));
+    movelog_close(&log);
+
+    ReplayLog replayed;
+    memset(&replayed, 0, sizeof(replayed));
+    CHECK(movelog_open(&log, log_path, 0, collect, &replayed));
+    CHECK(replayed.count == 50);
+    CHECK(movelog_restart(&log, &head));
+    CHECK(file_size() == MOVELOG_RECORD_SIZE && movelog_durable(&log) == MOVELOG_RECORD_SIZE);
+    CHECK(movelog_start(&log));
+    MoveLogRecord record = {1, 0, 3, 0, 0};
+    uint64_t lsn = movelog_append(&log, &record);
+    CHECK(lsn == 2 * MOVELOG_RECORD_SIZE && wait_durable(&log, lsn));
+    movelog_close(&log);
+
+    memset(&replayed, 0, sizeof(replayed));
+    replayed.ordered = true;
+    CHECK(movelog_open(&log, log_path, 0, collect, &replayed));
+    CHECK(replayed.count == 2 && replayed.last.session == 1 && replayed.last.seed == 0);
+    movelog_close(&log);
+    return 0;
+}
+
+int main(void) {
+    snprintf(log_path, sizeof(log_path), "/tmp/lines98_movelog_test_%d.log", (int)getpid());
+    int failed = test_append_and_recover() != 0 || test_group_commit_window() != 0 ||
+                 test_torn_and_corrupt_tail() != 0 || test_restart() != 0;
+    unlink(log_path);
+    if (failed) {
+        return 1;
+    }
+
+    printf("Move log tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "game.h"
+#include "protocol.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+/* Requests survive an encode/decode round trip; partial frames wait. */
+static int test_request_round_trip(void) {
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_MOVE;
+    req.session = 0xA1B2C3D4u;
+    req.tag = 77;
+    req.from = 3;
+    req.to = 80;
+    req.token = 0x0123456789ABCDEFull;
+
+    uint8_t buf[PROTO_MAX_FRAME];
+    int n = proto_encode_request(&req, buf, sizeof(buf));
+    CHECK(n == PROTO_HEADER_SIZE + 2 + 8);
+
+    ProtoRequest out;
+    for (int partial = 0; partial < n; ++partial) {
+        CHECK(proto_decode_request(buf, (size_t)partial, &out) == 0);
+    }
+    CHECK(proto_decode_request(buf, (size_t)n, &out) == n);
+    CHECK(out.type == PROTO_MOVE && out.session == req.session && out.tag == 77 && out.from == 3 && out.to == 80);
+    CHECK(out.token == req.token);
+
+    req.type = PROTO_NEW_GAME;
+    req.seed = 123456;
+    n = proto_encode_request(&req, buf, sizeof(buf));
+    CHECK(proto_decode_request(buf, (size_t)n, &out) == n);
+    CHECK(out.type == PROTO_NEW_GAME && out.seed == 123456 && out.token == req.token);
+    return 0;
+}
+
+/* Bad lengths, unknown types and trailing bytes are rejected. */
+static int test_malformed_requests(void) {
+    uint8_t buf[PROTO_MAX_FRAME];
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_STATE;
+    int n = proto_encode_request(&req, buf, sizeof(buf));
+
+    ProtoRequest out;
+    buf[0] = 4;
+    CHECK(proto_decode_request(buf, (size_t)n, &out) == -1);
+
+    n = proto_encode_request(&req, buf, sizeof(buf));
+    buf[2] = 0x42;
+    CHECK(proto_decode_request(buf, (size_t)n, &out) == -1);
+
+    req.type = PROTO_SELECT;
+    n = proto_encode_request(&req, buf, sizeof(buf));
+    buf[2] = PROTO_STATE;
+    CHECK(proto_decode_request(buf, (size_t)n, &out) == -1);
+    return 0;
+}
+
+/* Replays a move reply on the previous board the way a client would. */
+static void mirror_move(uint8_t *board, const ProtoReply *reply) {
+    if (reply->path_len >= 2) {
+        int from = reply->path[0];
+        int to = reply->path[reply->path_len - 1];
+        board[to] = board[from];
+        board[from] = 0;
+    }
+    for (int i = 0; i < reply->cleared_count; ++i) {
+        board[reply->cleared[i]] = 0;
+    }
+    for (int i = 0; i < reply->spawned_count; ++i) {
+        board[reply->spawned[i]] = reply->spawned_color[i];
+    }
+}
+
+/* Move replies carry enough to rebuild the board, through the wire format. */
+static int test_move_replies_rebuild_board(void) {
+    Game game;
+    game_init(&game, 5);
+    uint8_t mirror[GAME_CELLS];
+    memcpy(mirror, game.board, GAME_CELLS);
+
+    int moves = 0;
+    for (int turn = 0; turn < 400 && !game.game_over; ++turn) {
+        ProtoRequest req;
+        memset(&req, 0, sizeof(req));
+        req.type = PROTO_MOVE;
+        req.tag = (uint32_t)turn;
+        req.from = (uint8_t)((turn * 37) % GAME_CELLS);
+        req.to = (uint8_t)((turn * 53 + 11) % GAME_CELLS);
+
+        int score_before = game.score;
+        ProtoReply applied;
+        proto_apply(&game, &req, &applied);
+
+        uint8_t buf[PROTO_MAX_FRAME];
+        int n = proto_encode_reply(&applied, buf, sizeof(buf));
+        CHECK(n > 0);
+        ProtoReply reply;
+        CHECK(proto_decode_reply(buf, (size_t)n, &reply) == n);
+        CHECK(reply.type == PROTO_REPLY_MOVE && reply.tag == (uint32_t)turn);
+        CHECK(reply.score == game.score && reply.score_delta == game.score - score_before);
+        CHECK(memcmp(reply.next_colors, game.next_colors, GAME_NEXT_COUNT) == 0);
+
+        if (reply.action == GAME_ACTION_MOVED || reply.action == GAME_ACTION_GAME_OVER) {
+            ++moves;
+            CHECK(reply.path_len >= 2 && reply.path[0] == req.from && reply.path[reply.path_len - 1] == req.to);
+        } else {
+            CHECK(reply.path_len == 0 && reply.cleared_count == 0 && reply.spawned_count == 0);
+        }
+        mirror_move(mirror, &reply);
+        CHECK(memcmp(mirror, game.board, GAME_CELLS) == 0);
+    }
+    CHECK(moves > 10);
+    return 0;
+}
+
+/* State replies expose the whole game; bad cells are reported, not applied. */
+static int test_state_and_errors(void) {
+    Game game;
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 99;
+    req.session = 12;
+
+    ProtoReply reply;
+    proto_apply(&game, &req, &reply);
+    CHECK(reply.type == PROTO_REPLY_STATE && reply.session == 12);
+    CHECK(memcmp(reply.board, game.board, GAME_CELLS) == 0);
+    CHECK(reply.selected == -1 && !reply.game_over && reply.score == 0);
+
+    CHECK(reply.token == 0);
+
+    uint8_t buf[PROTO_MAX_FRAME];
+    reply.token = 0xFEDCBA9876543210ull;
+    int n = proto_encode_reply(&reply, buf, sizeof(buf));
+    ProtoReply decoded;
+    CHECK(proto_decode_reply(buf, (size_t)n, &decoded) == n);
+    CHECK(memcmp(decoded.board, game.board, GAME_CELLS) == 0 && decoded.selected == -1);
+    CHECK(decoded.token == reply.token);
+
+    req.type = PROTO_SELECT;
+    req.cell = GAME_CELLS;
+    proto_apply(&game, &req, &reply);
+    CHECK(reply.type == PROTO_REPLY_ERROR && reply.status == PROTO_ERR_MALFORMED);
+
+    for (int cell = 0; cell < GAME_CELLS; ++cell) {
+        if (game.board[cell] != 0) {
+            req.cell = (uint8_t)cell;
+            proto_apply(&game, &req, &reply);
+            CHECK(reply.type == PROTO_REPLY_SELECT && reply.action == GAME_ACTION_SELECTED && reply.selected == cell);
+            break;
+        }
+    }
+    return 0;
+}
+
+/* Spectator frames round-trip; keyframes pack every color into 3 bits. */
+static int test_spectator_frames(void) {
+    ProtoReply keyframe;
+    memset(&keyframe, 0, sizeof(keyframe));
+    keyframe.type = PROTO_KEYFRAME;
+    keyframe.session = 9;
+    keyframe.seq = 0x01020304u;
+    for (int i = 0; i < GAME_CELLS; ++i) {
+        keyframe.board[i] = (uint8_t)(i % (GAME_COLORS + 1));
+    }
+    keyframe.next_colors[0] = 1;
+    keyframe.next_colors[2] = GAME_COLORS;
+    keyframe.score = 1234;
+    keyframe.game_over = true;
+
+    uint8_t buf[PROTO_MAX_FRAME];
+    int n = proto_encode_reply(&keyframe, buf, sizeof(buf));
+    CHECK(n == PROTO_HEADER_SIZE + 4 + PROTO_PACKED_BOARD_BYTES + GAME_NEXT_COUNT + 4 + 1);
+    ProtoReply out;
+    CHECK(proto_decode_reply(buf, (size_t)n, &out) == n);
+    CHECK(out.type == PROTO_KEYFRAME && out.session == 9 && out.seq == keyframe.seq && out.score == 1234);
+    CHECK(out.game_over && memcmp(out.board, keyframe.board, GAME_CELLS) == 0);
+    CHECK(memcmp(out.next_colors, keyframe.next_colors, GAME_NEXT_COUNT) == 0);
+
+    ProtoReply delta;
+    memset(&delta, 0, sizeof(delta));
+    delta.type = PROTO_DELTA;
+    delta.seq = 42;
+    delta.action = GAME_ACTION_MOVED;
+    delta.score = 10;
+    delta.score_delta = 10;
+    delta.path_len = 3;
+    delta.path[0] = 0;
+    delta.path[1] = 1;
+    delta.path[2] = 10;
+    delta.cleared_count = 1;
+    delta.cleared[0] = 10;
+    delta.spawned_count = 2;
+    delta.spawned[0] = 5;
+    delta.spawned[1] = 80;
+    delta.spawned_color[0] = 2;
+    delta.spawned_color[1] = 7;
+    n = proto_encode_reply(&delta, buf, sizeof(buf));
+    CHECK(proto_decode_reply(buf, (size_t)n, &out) == n);
+    CHECK(out.type == PROTO_DELTA && out.seq == 42 && out.action == GAME_ACTION_MOVED && out.score_delta == 10);
+    CHECK(out.path_len == 3 && out.path[2] == 10 && out.cleared_count == 1 && out.spawned_count == 2);
+    CHECK(out.spawned[1] == 80 && out.spawned_color[1] == 7);
+    buf[0] = (uint8_t)(n - 1);
+    CHECK(proto_decode_reply(buf, (size_t)n - 1, &out) == -1);
+
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_WATCH;
+    req.session = 9;
+    n = proto_encode_request(&req, buf, sizeof(buf));
+    ProtoRequest watch;
+    CHECK(n == PROTO_HEADER_SIZE && proto_decode_request(buf, (size_t)n, &watch) == n);
+    CHECK(watch.type == PROTO_WATCH && watch.session == 9);
+
+    Game game;
+    game_init(&game, 1);
+    ProtoReply reply;
+    proto_apply(&game, &req, &reply);
+    CHECK(reply.type == PROTO_REPLY_ERROR && reply.status == PROTO_ERR_MALFORMED);
+    return 0;
+}
+
+/* Leaderboard requests and replies round-trip; oversized lists are bad. */
+static int test_leaderboard_frames(void) {
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_TOP;
+    req.offset = 70000;
+    req.count = 12;
+    uint8_t buf[PROTO_MAX_FRAME];
+    int n = proto_encode_request(&req, buf, sizeof(buf));
+    ProtoRequest out;
+    CHECK(proto_decode_request(buf, (size_t)n, &out) == n && out.type == PROTO_TOP && out.offset == 70000 && out.count == 12);
+    req.type = PROTO_RANK;
+    req.score = 4321;
+    n = proto_encode_request(&req, buf, sizeof(buf));
+    CHECK(proto_decode_request(buf, (size_t)n, &out) == n && out.type == PROTO_RANK && out.score == 4321);
+
+    ProtoReply reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.type = PROTO_REPLY_TOP;
+    reply.total = 1000000;
+    reply.entry_count = PROTO_MAX_ENTRIES;
+    for (int i = 0; i < PROTO_MAX_ENTRIES; ++i) {
+        reply.entry_session[i] = (uint32_t)i * 5u + 1u;
+        reply.entry_score[i] = 5000 - i;
+    }
+    n = proto_encode_reply(&reply, buf, sizeof(buf));
+    ProtoReply decoded;
+    CHECK(n > 0 && proto_decode_reply(buf, (size_t)n, &decoded) == n);
+    CHECK(decoded.total == 1000000 && decoded.entry_count == PROTO_MAX_ENTRIES);
+    CHECK(decoded.entry_session[31] == 156 && decoded.entry_score[31] == 5000 - 31);
+    buf[PROTO_HEADER_SIZE + 4] = PROTO_MAX_ENTRIES + 1;
+    CHECK(proto_decode_reply(buf, (size_t)n, &decoded) == -1);
+
+    reply.type = PROTO_REPLY_RANK;
+    reply.rank = 17;
+    n = proto_encode_reply(&reply, buf, sizeof(buf));
+    CHECK(proto_decode_reply(buf, (size_t)n, &decoded) == n && decoded.rank == 17 && decoded.total == 1000000);
+    return 0;
+}
+
+int main(void) {
+    if (test_request_round_trip() != 0) {
+        return 1;
+    }
+    if (test_malformed_requests() != 0) {
+        return 1;
+    }
+    if (test_move_replies_rebuild_board() != 0) {
+        return 1;
+    }
+    if (test_state_and_errors() != 0) {
+        return 1;
+    }
+    if (test_spectator_frames() != 0) {
+        return 1;
+    }
+    if (test_leaderboard_frames() != 0) {
+        return 1;
+    }
+
+    printf("Protocol tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,1021 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "protocol.h"
+#include "server.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+#define TEST_PIPELINE 300
+#define TEST_CLIENTS 64
+#define TEST_HIBERNATE_MS 100
+#define TEST_WATCHERS 4
+#define TEST_SPECTATE_TURNS 80
+#define TEST_FINISHED_GAMES 3
+#define TEST_RESET_ROUNDS 200
+#define TEST_SLOW_WINDOW_MS 200
+#define TEST_MAX_TURNS 5000
+
+/* Blocking test client with a reply reassembly buffer. */
+typedef struct {
+    int fd;
+    uint8_t buf[PROTO_MAX_FRAME * 4];
+    size_t len;
+} Client;
+
+static Server server;
+static char unix_path[108];
+static char journal_path[108];
+static char journal_key_path[116];
+static char journal_snap_path[116];
+static char leaderboard_path[108];
+
+/* Connects to a Unix socket path. */
+static bool connect_path(Client *client, const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    client->len = 0;
+    client->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    return client->fd >= 0 && connect(client->fd, (const struct sockaddr *)&addr, sizeof(addr)) == 0;
+}
+
+/* Connects to the server's Unix socket. */
+static bool connect_unix(Client *client) {
+    return connect_path(client, unix_path);
+}
+
+/* Connects to the server's loopback TCP port. */
+static bool connect_tcp(Client *client) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)server.tcp_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    client->len = 0;
+    client->fd = socket(AF_INET, SOCK_STREAM, 0);
+    return client->fd >= 0 && connect(client->fd, (const struct sockaddr *)&addr, sizeof(addr)) == 0;
+}
+
+/* Writes all bytes or fails. */
+static bool send_all(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/* Encodes and sends one request. */
+static bool client_send(Client *client, const ProtoRequest *req) {
+    uint8_t frame[PROTO_MAX_FRAME];
+    int n = proto_encode_request(req, frame, sizeof(frame));
+    return n > 0 && send_all(client->fd, frame, (size_t)n);
+}
+
+/* Blocks until one reply frame arrives; false on close or bad frame. */
+static bool client_recv(Client *client, ProtoReply *reply) {
+    for (;;) {
+        int used = proto_decode_reply(client->buf, client->len, reply);
+        if (used < 0) {
+            return false;
+        }
+        if (used > 0) {
+            memmove(client->buf, client->buf + used, client->len - (size_t)used);
+            client->len -= (size_t)used;
+            return true;
+        }
+        ssize_t n = recv(client->fd, client->buf + client->len, sizeof(client->buf) - client->len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        client->len += (size_t)n;
+    }
+}
+
+/* Sends one request and waits for its reply. */
+static bool client_call(Client *client, const ProtoRequest *req, ProtoReply *reply) {
+    return client_send(client, req) && client_recv(client, reply) && reply->tag == req->tag;
+}
+
+/* Compares two replies through their wire encoding. */
+static bool same_reply(const ProtoReply *a, const ProtoReply *b) {
+    uint8_t ea[PROTO_MAX_FRAME];
+    uint8_t eb[PROTO_MAX_FRAME];
+    int na = proto_encode_reply(a, ea, sizeof(ea));
+    int nb = proto_encode_reply(b, eb, sizeof(eb));
+    return na > 0 && na == nb && memcmp(ea, eb, (size_t)na) == 0;
+}
+
+/* A hosted game answers exactly like a local copy driven the same way. */
+static int test_session_matches_local_game(void) {
+    Client client;
+    CHECK(connect_unix(&client));
+
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 7;
+    req.tag = 1;
+    ProtoReply reply;
+    CHECK(client_call(&client, &req, &reply));
+    CHECK(reply.type == PROTO_REPLY_STATE && reply.status == PROTO_OK && reply.session != 0);
+    uint32_t session = reply.session;
+    uint64_t token = reply.token;
+
+    Game local;
+    ProtoRequest local_req = req;
+    local_req.session = session;
+    ProtoReply expected;
+    proto_apply(&local, &local_req, &expected);
+    expected.token = token;
+    CHECK(same_reply(&reply, &expected));
+
+    for (uint32_t turn = 0; turn < 200; ++turn) {
+        memset(&req, 0, sizeof(req));
+        req.type = PROTO_MOVE;
+        req.session = session;
+        req.token = token;
+        req.tag = 100 + turn;
+        req.from = (uint8_t)((turn * 31 + 5) % GAME_CELLS);
+        req.to = (uint8_t)((turn * 47 + 2) % GAME_CELLS);
+        CHECK(client_call(&client, &req, &reply));
+        proto_apply(&local, &req, &expected);
+        CHECK(same_reply(&reply, &expected));
+    }
+
+    close(client.fd);
+    return 0;
+}
+
+/* A game left idle past the threshold is hibernated by its worker and
+   resumes exactly where it stopped. */
+static int test_hibernated_session_resumes(void) {
+    Client client;
+    CHECK(connect_unix(&client));
+
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 3;
+    ProtoReply reply;
+    CHECK(client_call(&client, &req, &reply));
+    uint64_t token = reply.token;
+    Game local;
+    req.session = reply.session;
+    ProtoReply expected;
+    proto_apply(&local, &req, &expected);
+
+    for (uint32_t turn = 0; turn < 100; ++turn) {
+        if (turn == 50) {
+            struct timespec pause = {0, TEST_HIBERNATE_MS * 4 * 1000000L};
+            nanosleep(&pause, NULL);
+            ServerStats stats;
+            server_get_stats(&server, &stats);
+            CHECK(stats.memory.hibernated_sessions >= 1 && stats.memory.live_sessions == 0);
+        }
+        memset(&req, 0, sizeof(req));
+        req.type = turn % 5 == 0 ? PROTO_SELECT : PROTO_MOVE;
+        req.session = reply.session;
+        req.token = token;
+        req.tag = turn;
+        req.cell = (uint8_t)((turn * 13) % GAME_CELLS);
+        req.from = (uint8_t)((turn * 29 + 1) % GAME_CELLS);
+        req.to = (uint8_t)((turn * 41 + 9) % GAME_CELLS);
+        uint32_t session = req.session;
+        CHECK(client_call(&client, &req, &reply));
+        proto_apply(&local, &req, &expected);
+        CHECK(same_reply(&reply, &expected));
+        reply.session = session;
+    }
+
+    ServerStats stats;
+    server_get_stats(&server, &stats);
+    CHECK(stats.memory.restores >= 1 && stats.memory.live_sessions >= 1);
+    close(client.fd);
+    return 0;
+}
+
+/* Hundreds of pipelined requests come back complete and in order even
+   though their replies overflow the server's output buffer. */
+static int test_pipelined_requests(void) {
+    Client client;
+    CHECK(connect_tcp(&client));
+
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 11;
+    ProtoReply reply;
+    CHECK(client_call(&client, &req, &reply));
+    uint32_t session = reply.session;
+    uint64_t token = reply.token;
+
+    static uint8_t batch[TEST_PIPELINE * PROTO_MAX_FRAME];
+    size_t len = 0;
+    for (uint32_t i = 0; i < TEST_PIPELINE; ++i) {
+        memset(&req, 0, sizeof(req));
+        req.type = i % 2 == 0 ? PROTO_STATE : PROTO_MOVE;
+        req.session = session;
+        req.token = token;
+        req.tag = i;
+        req.from = (uint8_t)(i % GAME_CELLS);
+        req.to = (uint8_t)((i * 7) % GAME_CELLS);
+        len += (size_t)proto_encode_request(&req, batch + len, sizeof(batch) - len);
+    }
+    CHECK(send_all(client.fd, batch, len));
+
+    for (uint32_t i = 0; i < TEST_PIPELINE; ++i) {
+        CHECK(client_recv(&client, &reply));
+        CHECK(reply.tag == i && reply.status == PROTO_OK);
+        CHECK(reply.type == (i % 2 == 0 ? PROTO_REPLY_STATE : PROTO_REPLY_MOVE));
+    }
+
+    close(client.fd);
+    return 0;
+}
+
+/* Sessions are reachable from any connection; unknown ids are errors and
+   a malformed frame drops the connection. */
+static int test_sessions_across_connections(void) {
+    Client clients[TEST_CLIENTS];
+    uint32_t sessions[TEST_CLIENTS];
+    for (int c = 0; c < TEST_CLIENTS; ++c) {
+        CHECK(c % 2 == 0 ? connect_unix(&clients[c]) : connect_tcp(&clients[c]));
+        ProtoRequest req;
+        memset(&req, 0, sizeof(req));
+        req.type = PROTO_NEW_GAME;
+        req.seed = (uint32_t)c + 1;
+        ProtoReply reply;
+        CHECK(client_call(&clients[c], &req, &reply));
+        sessions[c] = reply.session;
+    }
+
+    for (int c = 0; c < TEST_CLIENTS; ++c) {
+        ProtoRequest req;
+        memset(&req, 0, sizeof(req));
+        req.type = PROTO_STATE;
+        req.session = sessions[(c + 1) % TEST_CLIENTS];
+        ProtoReply reply;
+        CHECK(client_call(&clients[c], &req, &reply));
+        Game local;
+        game_init(&local, (uint32_t)((c + 1) % TEST_CLIENTS) + 1);
+        CHECK(reply.type == PROTO_REPLY_STATE && memcmp(reply.board, local.board, GAME_CELLS) == 0);
+    }
+
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_STATE;
+    req.session = 0xFFFFFFF0u;
+    ProtoReply reply;
+    CHECK(client_call(&clients[0], &req, &reply));
+    CHECK(reply.type == PROTO_REPLY_ERROR && reply.status == PROTO_ERR_NO_SESSION);
+
+    static const uint8_t garbage[PROTO_HEADER_SIZE] = {2, 0};
+    CHECK(send_all(clients[1].fd, garbage, sizeof(garbage)));
+    CHECK(!client_recv(&clients[1], &reply));
+
+    for (int c = 0; c < TEST_CLIENTS; ++c) {
+        close(clients[c].fd);
+    }
+
+    ServerStats stats;
+    server_get_stats(&server, &stats);
+    CHECK(stats.sessions == TEST_CLIENTS + 3);
+    CHECK(stats.connections == TEST_CLIENTS + 3);
+    return 0;
+}
+
+/* Picks a legal move on the local mirror: the first ball that can reach
+   the last reachable empty cell. Returns false if none can move. */
+static bool pick_move(const Game *game, ProtoRequest *req) {
+    for (int from = 0; from < GAME_CELLS && !game->game_over; ++from) {
+        if (game->board[from] == 0) {
+            continue;
+        }
+        for (int to = GAME_CELLS - 1; to >= 0; --to) {
+            if (game->board[to] == 0 &&
+                game_can_reach(game, from / GAME_BOARD_SIZE, from % GAME_BOARD_SIZE, to / GAME_BOARD_SIZE, to % GAME_BOARD_SIZE)) {
+                req->from = (uint8_t)from;
+                req->to = (uint8_t)to;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* Reads pushed frames into view until it reaches seq; the WATCH reply may
+   arrive before or after the keyframe. */
+static bool spectate_until(Client *client, SpectateView *view, uint32_t seq) {
+    while (!view->synced || view->seq < seq) {
+        ProtoReply frame;
+        if (!client_recv(client, &frame)) {
+            return false;
+        }
+        if (frame.type == PROTO_REPLY_WATCH) {
+            continue;
+        }
+        if (!spectate_view_apply(view, &frame)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Only a holder of the session token can change a game; anyone can still
+   read or watch it. */
+static int test_mutations_need_token(void) {
+    Client owner;
+    Client other;
+    CHECK(connect_unix(&owner));
+    CHECK(connect_tcp(&other));
+
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 17;
+    ProtoReply reply;
+    CHECK(client_call(&owner, &req, &reply) && reply.status == PROTO_OK && reply.token != 0);
+    uint32_t session = reply.session;
+    uint64_t token = reply.token;
+    Game local;
+    game_init(&local, 17);
+
+    static const uint8_t forged[] = {PROTO_NEW_GAME, PROTO_SELECT, PROTO_MOVE};
+    for (size_t i = 0; i < sizeof(forged); ++i) {
+        memset(&req, 0, sizeof(req));
+        req.type = forged[i];
+        req.session = session;
+        req.token = i == 0 ? 0 : token ^ (1ull << (i * 9));
+        req.tag = 20 + (uint32_t)i;
+        CHECK(pick_move(&local, &req));
+        req.cell = req.from;
+        CHECK(client_call(&other, &req, &reply));
+        CHECK(reply.type == PROTO_REPLY_ERROR && reply.status == PROTO_ERR_FORBIDDEN);
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_STATE;
+    req.session = session;
+    CHECK(client_call(&other, &req, &reply) && reply.type == PROTO_REPLY_STATE && reply.token == 0);
+    CHECK(memcmp(reply.board, local.board, GAME_CELLS) == 0 && reply.selected == -1);
+
+    SpectateView view;
+    memset(&view, 0, sizeof(view));
+    req.type = PROTO_WATCH;
+    req.tag = 30;
+    CHECK(client_send(&other, &req));
+    CHECK(spectate_until(&other, &view, 0));
+    CHECK(memcmp(view.board, local.board, GAME_CELLS) == 0);
+
+    /* The token is the credential, not the connection that created it. */
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_SELECT;
+    req.session = session;
+    req.token = token;
+    req.tag = 31;
+    CHECK(pick_move(&local, &req));
+    req.cell = req.from;
+    CHECK(client_call(&owner, &req, &reply) && reply.status == PROTO_OK && reply.selected == (int8_t)req.cell);
+
+    close(other.fd);
+    close(owner.fd);
+    return 0;
+}
+
+/* Watchers on other connections (and workers) see every turn of a game,
+   a late joiner starts from a keyframe, and unknown sessions are errors. */
+static int test_spectators(void) {
+    Client player;
+    CHECK(connect_tcp(&player));
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 31;
+    ProtoReply reply;
+    CHECK(client_call(&player, &req, &reply));
+    uint32_t session = reply.session;
+    uint64_t token = reply.token;
+    Game local;
+    game_init(&local, 31);
+
+    Client watchers[TEST_WATCHERS];
+    SpectateView views[TEST_WATCHERS];
+    memset(views, 0, sizeof(views));
+    for (int w = 0; w < TEST_WATCHERS; ++w) {
+        CHECK(w % 2 == 0 ? connect_unix(&watchers[w]) : connect_tcp(&watchers[w]));
+        memset(&req, 0, sizeof(req));
+        req.type = PROTO_WATCH;
+        req.session = session;
+        req.tag = 500 + (uint32_t)w;
+        CHECK(client_send(&watchers[w], &req));
+        CHECK(spectate_until(&watchers[w], &views[w], 0));
+    }
+
+    uint32_t turns = 0;
+    while (turns < TEST_SPECTATE_TURNS) {
+        memset(&req, 0, sizeof(req));
+        req.session = session;
+        req.token = token;
+        req.tag = turns;
+        if (pick_move(&local, &req)) {
+            req.type = PROTO_MOVE;
+        } else {
+            req.type = PROTO_NEW_GAME;
+            req.seed = 100 + turns;
+        }
+        CHECK(client_call(&player, &req, &reply) && reply.status == PROTO_OK);
+        ProtoReply expected;
+        proto_apply(&local, &req, &expected);
+        ++turns;
+    }
+
+    for (int w = 0; w < TEST_WATCHERS; ++w) {
+        CHECK(spectate_until(&watchers[w], &views[w], turns));
+        CHECK(views[w].seq == turns && memcmp(views[w].board, local.board, GAME_CELLS) == 0);
+        CHECK(views[w].score == local.score && memcmp(views[w].next_colors, local.next_colors, GAME_NEXT_COUNT) == 0);
+    }
+
+    Client late;
+    CHECK(connect_unix(&late));
+    SpectateView late_view;
+    memset(&late_view, 0, sizeof(late_view));
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_WATCH;
+    req.session = session;
+    CHECK(client_send(&late, &req));
+    CHECK(spectate_until(&late, &late_view, turns));
+    CHECK(memcmp(late_view.board, local.board, GAME_CELLS) == 0);
+
+    req.session = 0;
+    req.tag = 9;
+    CHECK(client_call(&late, &req, &reply) && reply.type == PROTO_REPLY_WATCH && reply.status == PROTO_OK);
+    req.session = 0xFFFFFFF0u;
+    CHECK(client_call(&late, &req, &reply) && reply.status == PROTO_ERR_NO_SESSION);
+
+    ServerStats stats;
+    server_get_stats(&server, &stats);
+    CHECK(stats.spectator_frames >= turns && stats.spectator_pushes >= (unsigned long long)turns * TEST_WATCHERS);
+
+    close(late.fd);
+    for (int w = 0; w < TEST_WATCHERS; ++w) {
+        close(watchers[w].fd);
+    }
+    close(player.fd);
+    return 0;
+}
+
+/* Watchers that reset their connections while turns are being pushed to
+   them: a push can close a connection that still has an event later in
+   the same epoll batch, which must then be skipped rather than serviced. */
+static int test_watchers_reset_mid_push(void) {
+    Client player;
+    CHECK(connect_unix(&player));
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 37;
+    ProtoReply reply;
+    CHECK(client_call(&player, &req, &reply));
+    uint32_t session = reply.session;
+    uint64_t token = reply.token;
+    Game local;
+    game_init(&local, 37);
+
+    uint32_t turns = 0;
+    for (int round = 0; round < TEST_RESET_ROUNDS; ++round) {
+        Client watchers[TEST_WATCHERS];
+        for (int w = 0; w < TEST_WATCHERS; ++w) {
+            CHECK(w % 2 == 0 ? connect_unix(&watchers[w]) : connect_tcp(&watchers[w]));
+            memset(&req, 0, sizeof(req));
+            req.type = PROTO_WATCH;
+            req.session = session;
+            CHECK(client_send(&watchers[w], &req));
+        }
+        for (int move = 0; move < 4; ++move) {
+            memset(&req, 0, sizeof(req));
+            req.session = session;
+            req.token = token;
+            req.tag = turns;
+            if (pick_move(&local, &req)) {
+                req.type = PROTO_MOVE;
+            } else {
+                req.type = PROTO_NEW_GAME;
+                req.seed = 200 + turns;
+            }
+            CHECK(client_send(&player, &req));
+            ProtoReply expected;
+            proto_apply(&local, &req, &expected);
+            ++turns;
+            if (move == 1) {
+                for (int w = 0; w < TEST_WATCHERS; ++w) {
+                    struct linger reset = {1, 0};
+                    setsockopt(watchers[w].fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+                    close(watchers[w].fd);
+                }
+            }
+        }
+        for (int move = 0; move < 4; ++move) {
+            CHECK(client_recv(&player, &reply) && reply.status == PROTO_OK);
+        }
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_STATE;
+    req.session = session;
+    CHECK(client_call(&player, &req, &reply) && memcmp(reply.board, local.board, GAME_CELLS) == 0);
+    close(player.fd);
+    return 0;
+}
+
+/* Deletes the journal with its key and checkpoint. */
+static void remove_journal_files(void) {
+    unlink(journal_path);
+    unlink(journal_key_path);
+    unlink(journal_snap_path);
+}
+
+/* Replaces to with a copy of from. */
+static bool copy_file(const char *from, const char *to) {
+    static uint8_t data[1 << 20];
+    FILE *in = fopen(from, "rb");
+    if (in == NULL) {
+        return false;
+    }
+    size_t len = fread(data, 1, sizeof(data), in);
+    fclose(in);
+    FILE *out = fopen(to, "wb");
+    if (out == NULL) {
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, out) == len;
+    return fclose(out) == 0 && ok;
+}
+
+/* Starts a journaled server on its own socket. */
+static bool start_journaled(Server *journaled, const char *path) {
+    ServerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.unix_path = path;
+    config.tcp_port = -1;
+    config.workers = 2;
+    config.journal_path = journal_path;
+    config.journal_window_ms = 1;
+    if (!server_init(journaled, &config) || !server_start(journaled)) {
+        server_shutdown(journaled);
+        return false;
+    }
+    return true;
+}
+
+/* Acknowledged moves survive a restart: the journal replays them through
+   the engine and the game continues identically. */
+static int test_journal_recovery(void) {
+    static Server journaled;
+    char path[108];
+    snprintf(path, sizeof(path), "/tmp/lines98_server_journal_test_%d.sock", (int)getpid());
+    remove_journal_files();
+    CHECK(start_journaled(&journaled, path));
+
+    Client client;
+    CHECK(connect_path(&client, path));
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 21;
+    ProtoReply reply;
+    CHECK(client_call(&client, &req, &reply));
+    uint32_t session = reply.session;
+    uint64_t token = reply.token;
+    Game local;
+    req.session = session;
+    ProtoReply expected;
+    proto_apply(&local, &req, &expected);
+
+    for (uint32_t turn = 0; turn < 120; ++turn) {
+        memset(&req, 0, sizeof(req));
+        req.type = turn % 7 == 3 ? PROTO_SELECT : PROTO_MOVE;
+        req.session = session;
+        req.token = token;
+        req.tag = turn;
+        req.cell = (uint8_t)((turn * 17) % GAME_CELLS);
+        req.from = (uint8_t)((turn * 23 + 4) % GAME_CELLS);
+        req.to = (uint8_t)((turn * 59 + 6) % GAME_CELLS);
+        CHECK(client_call(&client, &req, &reply));
+        proto_apply(&local, &req, &expected);
+        CHECK(same_reply(&reply, &expected));
+    }
+
+    /* A pipelined burst fills the output buffer with held replies. */
+    static uint8_t batch[TEST_PIPELINE * PROTO_MAX_FRAME];
+    static ProtoRequest burst[TEST_PIPELINE];
+    size_t len = 0;
+    for (uint32_t i = 0; i < TEST_PIPELINE; ++i) {
+        memset(&burst[i], 0, sizeof(burst[i]));
+        burst[i].type = PROTO_MOVE;
+        burst[i].session = session;
+        burst[i].token = token;
+        burst[i].tag = 1000 + i;
+        burst[i].from = (uint8_t)((i * 31 + 8) % GAME_CELLS);
+        burst[i].to = (uint8_t)((i * 43 + 1) % GAME_CELLS);
+        len += (size_t)proto_encode_request(&burst[i], batch + len, sizeof(batch) - len);
+    }
+    CHECK(send_all(client.fd, batch, len));
+    for (uint32_t i = 0; i < TEST_PIPELINE; ++i) {
+        CHECK(client_recv(&client, &reply) && reply.tag == burst[i].tag);
+        proto_apply(&local, &burst[i], &expected);
+        CHECK(same_reply(&reply, &expected));
+    }
+    close(client.fd);
+
+    ServerStats stats;
+    server_get_stats(&journaled, &stats);
+    CHECK(stats.journal_replayed == 0 && stats.journal_records == 121 + TEST_PIPELINE);
+    server_shutdown(&journaled);
+
+    CHECK(start_journaled(&journaled, path));
+    server_get_stats(&journaled, &stats);
+    CHECK(stats.journal_replayed == 121 + TEST_PIPELINE && stats.sessions == 1);
+
+    CHECK(connect_path(&client, path));
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_STATE;
+    req.session = session;
+    CHECK(client_call(&client, &req, &reply));
+    proto_apply(&local, &req, &expected);
+    CHECK(same_reply(&reply, &expected));
+
+    /* The session key is kept with the journal, so the token still works. */
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_SELECT;
+    req.session = session;
+    req.token = token;
+    req.cell = 40;
+    CHECK(client_call(&client, &req, &reply));
+    proto_apply(&local, &req, &expected);
+    CHECK(same_reply(&reply, &expected));
+
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_MOVE;
+    req.session = session;
+    req.token = token;
+    CHECK(pick_move(&local, &req));
+    CHECK(client_call(&client, &req, &reply));
+    proto_apply(&local, &req, &expected);
+    CHECK(same_reply(&reply, &expected));
+
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    CHECK(client_call(&client, &req, &reply));
+    CHECK(reply.status == PROTO_OK && reply.session > session);
+    close(client.fd);
+    server_shutdown(&journaled);
+
+    /* The last startup checkpointed the game, so only this run's three
+       requests are replayed on top of it. */
+    char stale[120];
+    snprintf(stale, sizeof(stale), "%s.stale", journal_path);
+    CHECK(copy_file(journal_path, stale));
+    CHECK(start_journaled(&journaled, path));
+    server_get_stats(&journaled, &stats);
+    CHECK(stats.checkpoint_sessions == 1 && stats.journal_replayed == 3 && stats.sessions == 2);
+    server_shutdown(&journaled);
+
+    /* A crash after writing a checkpoint but before restarting the journal
+       leaves records the checkpoint already holds; they are skipped. */
+    CHECK(copy_file(stale, journal_path));
+    unlink(stale);
+    CHECK(start_journaled(&journaled, path));
+    server_get_stats(&journaled, &stats);
+    CHECK(stats.checkpoint_sessions == 2 && stats.journal_replayed == 0 && stats.sessions == 2);
+    CHECK(connect_path(&client, path));
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_STATE;
+    req.session = session;
+    CHECK(client_call(&client, &req, &reply));
+    proto_apply(&local, &req, &expected);
+    CHECK(same_reply(&reply, &expected));
+    close(client.fd);
+    server_shutdown(&journaled);
+
+    /* Sessions on disk without their key refuse to start rather than
+       mint a new key that would reject every owner's token. */
+    char saved_key[124];
+    snprintf(saved_key, sizeof(saved_key), "%s.saved", journal_key_path);
+    CHECK(copy_file(journal_key_path, saved_key));
+    unlink(journal_key_path);
+    CHECK(!start_journaled(&journaled, path));
+    CHECK(copy_file(saved_key, journal_key_path) && truncate(journal_key_path, 8) == 0);
+    CHECK(!start_journaled(&journaled, path));
+    CHECK(copy_file(saved_key, journal_key_path));
+    unlink(saved_key);
+    CHECK(start_journaled(&journaled, path));
+    server_get_stats(&journaled, &stats);
+    CHECK(stats.sessions == 2);
+    server_shutdown(&journaled);
+    remove_journal_files();
+    return 0;
+}
+
+/* Starts a server with a leaderboard on its own socket. */
+static bool start_ranked(Server *ranked, const char *path) {
+    ServerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.unix_path = path;
+    config.tcp_port = -1;
+    config.workers = 2;
+    config.leaderboard_path = leaderboard_path;
+    if (!server_init(ranked, &config) || !server_start(ranked)) {
+        server_shutdown(ranked);
+        return false;
+    }
+    return true;
+}
+
+/* Finished games land on the leaderboard, which TOP and RANK serve and
+   which survives a restart; without one both requests are unavailable. */
+static int test_leaderboard(void) {
+    Client client;
+    CHECK(connect_unix(&client));
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_TOP;
+    req.count = 5;
+    ProtoReply reply;
+    CHECK(client_call(&client, &req, &reply) && reply.status == PROTO_ERR_UNAVAILABLE);
+    close(client.fd);
+
+    static Server ranked;
+    char path[108];
+    snprintf(path, sizeof(path), "/tmp/lines98_server_board_test_%d.sock", (int)getpid());
+    unlink(leaderboard_path);
+    CHECK(start_ranked(&ranked, path));
+    CHECK(connect_path(&client, path));
+
+    int32_t best = -1;
+    uint32_t best_session = 0;
+    for (uint32_t g = 0; g < TEST_FINISHED_GAMES; ++g) {
+        memset(&req, 0, sizeof(req));
+        req.type = PROTO_NEW_GAME;
+        req.seed = 40 + g;
+        CHECK(client_call(&client, &req, &reply));
+        uint32_t session = reply.session;
+        uint64_t token = reply.token;
+        Game local;
+        game_init(&local, req.seed);
+        for (uint32_t turn = 0; !local.game_over; ++turn) {
+            CHECK(turn < TEST_MAX_TURNS);
+            memset(&req, 0, sizeof(req));
+            req.type = PROTO_MOVE;
+            req.session = session;
+            req.token = token;
+            req.tag = turn;
+            CHECK(pick_move(&local, &req));
+            CHECK(client_call(&client, &req, &reply));
+            ProtoReply expected;
+            proto_apply(&local, &req, &expected);
+        }
+        CHECK(reply.action == GAME_ACTION_GAME_OVER && reply.score == local.score);
+        if (local.score > best) {
+            best = local.score;
+            best_session = session;
+        }
+    }
+
+    for (int restart = 0; restart < 2; ++restart) {
+        memset(&req, 0, sizeof(req));
+        req.type = PROTO_TOP;
+        req.tag = 1;
+        req.count = 200;
+        CHECK(client_call(&client, &req, &reply));
+        CHECK(reply.type == PROTO_REPLY_TOP && reply.total == TEST_FINISHED_GAMES);
+        CHECK(reply.entry_count == TEST_FINISHED_GAMES);
+        CHECK(reply.entry_session[0] == best_session && reply.entry_score[0] == best);
+        for (int i = 1; i < reply.entry_count; ++i) {
+            CHECK(reply.entry_score[i] <= reply.entry_score[i - 1]);
+        }
+        int32_t worst = reply.entry_score[TEST_FINISHED_GAMES - 1];
+
+        req.type = PROTO_RANK;
+        req.score = best + 1;
+        CHECK(client_call(&client, &req, &reply) && reply.type == PROTO_REPLY_RANK && reply.rank == 1);
+        req.score = worst - 1;
+        CHECK(client_call(&client, &req, &reply) && reply.rank == TEST_FINISHED_GAMES + 1);
+
+        close(client.fd);
+        server_shutdown(&ranked);
+        if (restart == 0) {
+            CHECK(start_ranked(&ranked, path));
+            CHECK(connect_path(&client, path));
+        }
+    }
+    unlink(leaderboard_path);
+    return 0;
+}
+
+/* Starts a server with both a slow-committing journal and a leaderboard. */
+static bool start_durable_ranked(Server *ranked, const char *path) {
+    ServerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.unix_path = path;
+    config.tcp_port = -1;
+    config.workers = 2;
+    config.journal_path = journal_path;
+    config.journal_window_ms = TEST_SLOW_WINDOW_MS;
+    config.leaderboard_path = leaderboard_path;
+    if (!server_init(ranked, &config) || !server_start(ranked)) {
+        server_shutdown(ranked);
+        return false;
+    }
+    return true;
+}
+
+/* A STATE read from another connection does not show a turn before the
+   journal holds it: its reply waits behind the mover's. */
+static int test_state_waits_for_journal(void) {
+    static Server durable;
+    char path[108];
+    snprintf(path, sizeof(path), "/tmp/lines98_server_state_test_%d.sock", (int)getpid());
+    remove_journal_files();
+    unlink(leaderboard_path);
+    CHECK(start_durable_ranked(&durable, path));
+
+    Client player;
+    Client reader;
+    CHECK(connect_path(&player, path) && connect_path(&reader, path));
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 47;
+    ProtoReply reply;
+    CHECK(client_call(&player, &req, &reply) && reply.status == PROTO_OK);
+    Game local;
+    game_init(&local, 47);
+
+    ProtoRequest move;
+    memset(&move, 0, sizeof(move));
+    move.type = PROTO_MOVE;
+    move.session = reply.session;
+    move.token = reply.token;
+    CHECK(pick_move(&local, &move));
+    ProtoReply expected;
+    proto_apply(&local, &move, &expected);
+    CHECK(client_send(&player, &move));
+    struct timespec pause = {0, TEST_SLOW_WINDOW_MS / 4 * 1000000L};
+    nanosleep(&pause, NULL);
+
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_STATE;
+    req.session = move.session;
+    CHECK(client_send(&reader, &req));
+    nanosleep(&pause, NULL);
+    struct pollfd pfd = {reader.fd, POLLIN, 0};
+    CHECK(poll(&pfd, 1, 0) == 0);
+    CHECK(client_recv(&player, &reply) && reply.status == PROTO_OK);
+    CHECK(client_recv(&reader, &reply) && memcmp(reply.board, local.board, GAME_CELLS) == 0);
+
+    close(reader.fd);
+    close(player.fd);
+    server_shutdown(&durable);
+    remove_journal_files();
+    unlink(leaderboard_path);
+    return 0;
+}
+
+/* With a journal, a finished game is ranked and shown to watchers only
+   once its final move is durable, before the game-over reply goes out;
+   replaying the journal after a restart does not rank it again. */
+static int test_results_wait_for_journal(void) {
+    static Server ranked;
+    static ProtoRequest moves[TEST_MAX_TURNS];
+    static uint8_t batch[TEST_MAX_TURNS * 32];
+    char path[108];
+    snprintf(path, sizeof(path), "/tmp/lines98_server_durable_test_%d.sock", (int)getpid());
+    remove_journal_files();
+    unlink(leaderboard_path);
+    CHECK(start_durable_ranked(&ranked, path));
+
+    Client client;
+    CHECK(connect_path(&client, path));
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = PROTO_NEW_GAME;
+    req.seed = 43;
+    ProtoReply reply;
+    CHECK(client_call(&client, &req, &reply) && reply.status == PROTO_OK);
+
+    Client watcher;
+    SpectateView view;
+    memset(&view, 0, sizeof(view));
+    CHECK(connect_path(&watcher, path));
+    req.type = PROTO_WATCH;
+    req.session = reply.session;
+    CHECK(client_send(&watcher, &req));
+    CHECK(spectate_until(&watcher, &view, 0));
+
+    /* The mirror plays the whole game up front so all but the final move
+       can be pipelined into one commit window. */
+    Game local;
+    game_init(&local, 43);
+    uint32_t turns = 0;
+    while (!local.game_over) {
+        CHECK(turns < TEST_MAX_TURNS);
+        ProtoRequest *move = &moves[turns];
+        memset(move, 0, sizeof(*move));
+        move->type = PROTO_MOVE;
+        move->session = reply.session;
+        move->token = reply.token;
+        move->tag = turns;
+        CHECK(pick_move(&local, move));
+        ProtoReply expected;
+        proto_apply(&local, move, &expected);
+        ++turns;
+    }
+    size_t len = 0;
+    for (uint32_t i = 0; i + 1 < turns; ++i) {
+        len += (size_t)proto_encode_request(&moves[i], batch + len, sizeof(batch) - len);
+    }
+    CHECK(send_all(client.fd, batch, len));
+    for (uint32_t i = 0; i + 1 < turns; ++i) {
+        CHECK(client_recv(&client, &reply) && reply.tag == i && reply.action != GAME_ACTION_GAME_OVER);
+    }
+    CHECK(spectate_until(&watcher, &view, turns - 1));
+
+    ServerStats stats;
+    CHECK(client_send(&client, &moves[turns - 1]));
+    struct timespec pause = {0, TEST_SLOW_WINDOW_MS / 4 * 1000000L};
+    nanosleep(&pause, NULL);
+    server_get_stats(&ranked, &stats);
+    CHECK(stats.leaderboard_results == 0);
+    struct pollfd pfd = {watcher.fd, POLLIN, 0};
+    CHECK(watcher.len == 0 && poll(&pfd, 1, 0) == 0);
+    CHECK(client_recv(&client, &reply) && reply.action == GAME_ACTION_GAME_OVER);
+    server_get_stats(&ranked, &stats);
+    CHECK(stats.leaderboard_results == 1);
+    CHECK(spectate_until(&watcher, &view, turns) && view.game_over);
+    close(watcher.fd);
+    close(client.fd);
+    server_shutdown(&ranked);
+
+    CHECK(start_durable_ranked(&ranked, path));
+    server_get_stats(&ranked, &stats);
+    CHECK(stats.journal_replayed == turns + 1 && stats.leaderboard_results == 1);
+    server_shutdown(&ranked);
+    remove_journal_files();
+    unlink(leaderboard_path);
+    return 0;
+}
+
+int main(void) {
+    snprintf(unix_path, sizeof(unix_path), "/tmp/lines98_server_test_%d.sock", (int)getpid());
+    snprintf(journal_path, sizeof(journal_path), "/tmp/lines98_server_test_%d.journal", (int)getpid());
+    snprintf(journal_key_path, sizeof(journal_key_path), "%s.key", journal_path);
+    snprintf(journal_snap_path, sizeof(journal_snap_path), "%s.snap", journal_path);
+    snprintf(leaderboard_path, sizeof(leaderboard_path), "/tmp/lines98_server_test_%d.board", (int)getpid());
+    ServerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.unix_path = unix_path;
+    config.tcp_host = "127.0.0.1";
+    config.tcp_port = 0;
+    config.workers = 3;
+    config.hibernate_after_ms = TEST_HIBERNATE_MS;
+    if (!server_init(&server, &config) || !server_start(&server)) {
+        server_shutdown(&server);
+        fprintf(stderr, "FAILED: server did not start\n");
+        return 1;
+    }
+
+    int failed = test_session_matches_local_game() != 0 || test_hibernated_session_resumes() != 0 ||
+                 test_pipelined_requests() != 0 || test_sessions_across_connections() != 0 ||
+                 test_mutations_need_token() != 0 || test_spectators() != 0 || test_watchers_reset_mid_push() != 0 ||
+                 test_journal_recovery() != 0 || test_leaderboard() != 0 ||
+                 test_state_waits_for_journal() != 0 || test_results_wait_for_journal() != 0;
+    server_shutdown(&server);
+    if (failed) {
+        return 1;
+    }
+
+    printf("Server tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "game.h"
+#include "sessions.h"
+#include "slab.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+#define TEST_OBJECTS 2000
+#define TEST_SESSIONS 2000
+
+/* Field-wise game comparison (Game has padding). */
+static bool same_game(const Game *a, const Game *b) {
+    return memcmp(a->board, b->board, GAME_CELLS) == 0 && memcmp(a->next_colors, b->next_colors, GAME_NEXT_COUNT) == 0 &&
+           a->selected_index == b->selected_index && a->score == b->score && a->game_over == b->game_over &&
+           a->rng.state == b->rng.state;
+}
+
+/* Plays a seed-dependent number of clicks so games differ in score,
+   selection and game-over state. */
+static void play(Game *game, uint32_t seed) {
+    game_init(game, seed);
+    int clicks = (int)(seed % 151);
+    for (int c = 0; c < clicks && !game->game_over; ++c) {
+        /* Alternate a ball and a cell it can reach so click pairs move. */
+        int from = game->selected_index;
+        int start = (int)((seed * 7u + (uint32_t)c * 37u) % GAME_CELLS);
+        int cell = start;
+        for (int step = 0; step < GAME_CELLS; ++step) {
+            int probe = (start + step) % GAME_CELLS;
+            bool usable = from < 0 ? game->board[probe] != 0
+                                   : game->board[probe] == 0 &&
+                                         game_can_reach(
+                                             game,
+                                             from / GAME_BOARD_SIZE,
+                                             from % GAME_BOARD_SIZE,
+                                             probe / GAME_BOARD_SIZE,
+                                             probe % GAME_BOARD_SIZE
+                                         );
+            if (usable) {
+                cell = probe;
+                break;
+            }
+        }
+        game_click(game, cell / GAME_BOARD_SIZE, cell % GAME_BOARD_SIZE);
+    }
+}
+
+/* Objects are aligned, distinct, reused, and empty blocks go back. */
+static int test_slab_pool(void) {
+    SlabPool pool;
+    CHECK(slab_init(&pool, sizeof(Session), _Alignof(Session)));
+    CHECK(pool.object_size == sizeof(Session) && pool.per_block > 1);
+
+    static uint8_t *objects[TEST_OBJECTS];
+    for (int i = 0; i < TEST_OBJECTS; ++i) {
+        objects[i] = (uint8_t *)slab_alloc(&pool);
+        CHECK(objects[i] != NULL && (uintptr_t)objects[i] % SESSIONS_CACHE_LINE == 0);
+        memset(objects[i], i & 0xFF, pool.object_size);
+    }
+    for (int i = 0; i < TEST_OBJECTS; ++i) {
+        CHECK(objects[i][0] == (uint8_t)(i & 0xFF) && objects[i][pool.object_size - 1] == (uint8_t)(i & 0xFF));
+    }
+    size_t blocks = (TEST_OBJECTS + pool.per_block - 1) / pool.per_block;
+    CHECK(pool.in_use == TEST_OBJECTS && slab_reserved_bytes(&pool) == blocks * SLAB_BLOCK_BYTES);
+
+    for (int i = 0; i < TEST_OBJECTS; i += 2) {
+        slab_free(&pool, objects[i]);
+    }
+    for (int i = 0; i < TEST_OBJECTS; i += 2) {
+        objects[i] = (uint8_t *)slab_alloc(&pool);
+        CHECK(objects[i] != NULL);
+    }
+    CHECK(slab_reserved_bytes(&pool) == blocks * SLAB_BLOCK_BYTES);
+
+    for (int i = 0; i < TEST_OBJECTS; ++i) {
+        slab_free(&pool, objects[i]);
+    }
+    CHECK(pool.in_use == 0 && slab_reserved_bytes(&pool) == SLAB_BLOCK_BYTES);
+    slab_destroy(&pool);
+    CHECK(slab_reserved_bytes(&pool) == 0);
+    return 0;
+}
+
+/* Idle sessions pack down and come back bit-identical on next use. */
+static int test_hibernate_round_trip(void) {
+    SessionTable table;
+    CHECK(sessions_init(&table, 4));
+    for (uint32_t id = 1; id <= TEST_SESSIONS; ++id) {
+        Session *session = sessions_create(&table, id, 1000);
+        CHECK(session != NULL);
+        play(&session->game, id);
+        sessions_release(&table, session);
+    }
+    CHECK(sessions_create(&table, 7, 1000) == NULL);
+
+    SessionMemory live;
+    sessions_memory(&table, &live);
+    CHECK(live.live_sessions == TEST_SESSIONS && live.hibernated_sessions == 0);
+    CHECK(live.live_bytes == TEST_SESSIONS * sizeof(Session));
+
+    size_t packed = 0;
+    for (int s = 0; s < 4; ++s) {
+        CHECK(sessions_hibernate_idle(&table, s, 1999, 1000) == 0);
+        packed += sessions_hibernate_idle(&table, s, 2000, 1000);
+    }
+    CHECK(packed == TEST_SESSIONS);
+
+    SessionMemory idle;
+    sessions_memory(&table, &idle);
+    CHECK(idle.live_sessions == 0 && idle.hibernated_sessions == TEST_SESSIONS && idle.hibernations == TEST_SESSIONS);
+    CHECK(idle.live_bytes == 0 && idle.hibernated_bytes * 2 < live.live_bytes);
+    CHECK(idle.live_slab_bytes + idle.hibernated_slab_bytes < live.live_slab_bytes);
+    CHECK(sessions_count(&table) == TEST_SESSIONS);
+
+    int selected = 0;
+    int over = 0;
+    for (uint32_t id = 1; id <= TEST_SESSIONS; ++id) {
+        Session *session = sessions_acquire(&table, id, 3000);
+        CHECK(session != NULL && session->id == id);
+        Game expected;
+        play(&expected, id);
+        CHECK(same_game(&session->game, &expected));
+        selected += expected.selected_index >= 0;
+        over += expected.game_over;
+        sessions_release(&table, session);
+    }
+    CHECK(selected > 0 && over > 0);
+    CHECK(sessions_acquire(&table, TEST_SESSIONS + 4, 3000) == NULL);
+
+    SessionMemory back;
+    sessions_memory(&table, &back);
+    CHECK(back.live_sessions == TEST_SESSIONS && back.restores == TEST_SESSIONS && back.hibernated_bytes == 0);
+    sessions_shutdown(&table);
+    return 0;
+}
+
+/* Only sessions idle past the threshold hibernate; use refreshes them. */
+static int test_lru_threshold(void) {
+    SessionTable table;
+    CHECK(sessions_init(&table, 1));
+    for (uint32_t id = 1; id <= 10; ++id) {
+        Session *session = sessions_create(&table, id, id * 100);
+        CHECK(session != NULL);
+        game_init(&session->game, id);
+        sessions_release(&table, session);
+    }
+    Session *session = sessions_acquire(&table, 2, 2000);
+    CHECK(session != NULL);
+    sessions_release(&table, session);
+
+    /* Ids 1 and 3..5 were last used at or before 500. */
+    CHECK(sessions_hibernate_idle(&table, 0, 1500, 1000) == 4);
+    SessionMemory memory;
+    sessions_memory(&table, &memory);
+    CHECK(memory.live_sessions == 6 && memory.hibernated_sessions == 4);
+
+    session = sessions_acquire(&table, 3, 2500);
+    CHECK(session != NULL && table.shards[0].lru_tail == session);
+    sessions_release(&table, session);
+    CHECK(sessions_hibernate_idle(&table, 0, 1000000, 1000) == 7);
+    CHECK(sessions_hibernate_idle(&table, 1, 1000000, 1000) == 0);
+    sessions_shutdown(&table);
+    return 0;
+}
+
+static int copy_failures;
+
+/* Inserts one visited session into the table at ctx. */
+static void copy_packed(void *ctx, uint32_t id, const SessionPacked *packed) {
+    if (!sessions_insert_packed((SessionTable *)ctx, id, packed)) {
+        ++copy_failures;
+    }
+}
+
+/* Sessions exported through sessions_visit and inserted into another
+   table come back identical, whether they were live or hibernated. */
+static int test_visit_and_insert(void) {
+    SessionTable table;
+    SessionTable copy;
+    CHECK(sessions_init(&table, 3));
+    CHECK(sessions_init(&copy, 2));
+    for (uint32_t id = 1; id <= 300; ++id) {
+        Session *session = sessions_create(&table, id, id < 150 ? 0 : 5000);
+        CHECK(session != NULL);
+        play(&session->game, id);
+        sessions_release(&table, session);
+    }
+    for (int s = 0; s < 3; ++s) {
+        sessions_hibernate_idle(&table, s, 1000, 1000);
+    }
+
+    CHECK(sessions_visit(&table, copy_packed, &copy) == 300);
+    CHECK(copy_failures == 0 && sessions_count(&copy) == 300);
+    SessionPacked packed;
+    memset(&packed, 0, sizeof(packed));
+    CHECK(!sessions_insert_packed(&copy, 7, &packed) && !sessions_insert_packed(&copy, 0, &packed));
+
+    SessionMemory memory;
+    sessions_memory(&copy, &memory);
+    CHECK(memory.hibernated_sessions == 300 && memory.live_sessions == 0);
+    for (uint32_t id = 1; id <= 300; ++id) {
+        Session *session = sessions_acquire(&copy, id, 6000);
+        CHECK(session != NULL);
+        Game expected;
+        play(&expected, id);
+        CHECK(same_game(&session->game, &expected));
+        sessions_release(&copy, session);
+    }
+    sessions_shutdown(&copy);
+    sessions_shutdown(&table);
+    return 0;
+}
+
+int main(void) {
+    if (test_slab_pool() != 0) {
+        return 1;
+    }
+    if (test_hibernate_round_trip() != 0) {
+        return 1;
+    }
+    if (test_lru_threshold() != 0) {
+        return 1;
+    }
+    if (test_visit_and_insert() != 0) {
+        return 1;
+    }
+
+    printf("Session store tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "game.h"
+#include "protocol.h"
+#include "spectate.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+#define TEST_SESSION 7u
+#define TEST_WATCHERS 3
+
+/* Plays one legal move: the first ball that can reach some empty cell.
+   Returns false once the game is over or nothing can move. */
+static bool play_turn(Game *game, ProtoReply *reply) {
+    for (int from = 0; from < GAME_CELLS && !game->game_over; ++from) {
+        if (game->board[from] == 0) {
+            continue;
+        }
+        for (int to = GAME_CELLS - 1; to >= 0; --to) {
+            if (game->board[to] == 0 &&
+                game_can_reach(game, from / GAME_BOARD_SIZE, from % GAME_BOARD_SIZE, to / GAME_BOARD_SIZE, to % GAME_BOARD_SIZE)) {
+                ProtoRequest req;
+                memset(&req, 0, sizeof(req));
+                req.type = PROTO_MOVE;
+                req.session = TEST_SESSION;
+                req.from = (uint8_t)from;
+                req.to = (uint8_t)to;
+                proto_apply(game, &req, reply);
+                return reply->action == GAME_ACTION_MOVED || reply->action == GAME_ACTION_GAME_OVER;
+            }
+        }
+    }
+    return false;
+}
+
+/* Drains a watcher the way a connection would, decoding each frame from
+   the shared bytes into view. Returns frames applied, or -1 on a bad frame
+   or a seq gap. */
+static int drain(SpectateWatcher *watcher, SpectateView *view) {
+    int applied = 0;
+    for (;;) {
+        struct iovec iov[8];
+        int count = spectate_watcher_iov(watcher, iov, 8, 0);
+        if (count == 0) {
+            return applied;
+        }
+        for (int i = 0; i < count; ++i) {
+            ProtoReply frame;
+            int used = proto_decode_reply((const uint8_t *)iov[i].iov_base, iov[i].iov_len, &frame);
+            if (used != (int)iov[i].iov_len || !spectate_view_apply(view, &frame)) {
+                return -1;
+            }
+            spectate_watcher_consume(watcher, iov[i].iov_len);
+            ++applied;
+        }
+    }
+}
+
+/* Returns true if view mirrors game exactly. */
+static bool view_matches(const SpectateView *view, const Game *game) {
+    return view->synced && memcmp(view->board, game->board, GAME_CELLS) == 0 &&
+           memcmp(view->next_colors, game->next_colors, GAME_NEXT_COUNT) == 0 && view->score == game->score &&
+           view->game_over == game->game_over;
+}
+
+/* A turn is encoded once and every watcher queues the same bytes; views
+   rebuilt from keyframe plus deltas track the game. */
+static int test_shared_fan_out(void) {
+    SpectateHub hub;
+    CHECK(spectate_init(&hub, 2));
+    Game game;
+    game_init(&game, 11);
+
+    SpectateWatcher watchers[TEST_WATCHERS];
+    SpectateView views[TEST_WATCHERS];
+    memset(views, 0, sizeof(views));
+    for (int w = 0; w < TEST_WATCHERS; ++w) {
+        spectate_watcher_init(&watchers[w], -1);
+        CHECK(spectate_watch(&hub, &watchers[w], TEST_SESSION, &game, 0) == 0);
+        CHECK(drain(&watchers[w], &views[w]) == 1 && view_matches(&views[w], &game));
+    }
+    /* Everyone joined at seq 0, so they shared one cached keyframe. */
+    CHECK(atomic_load(&hub.frames_encoded) == 1);
+
+    int turns = 0;
+    ProtoReply reply;
+    while (turns < 60 && play_turn(&game, &reply)) {
+        spectate_publish_move(&hub, TEST_SESSION, &reply, &game, 0);
+        ++turns;
+
+        struct iovec first[1];
+        CHECK(spectate_watcher_iov(&watchers[0], first, 1, 0) == 1);
+        for (int w = 1; w < TEST_WATCHERS; ++w) {
+            struct iovec other[1];
+            CHECK(spectate_watcher_iov(&watchers[w], other, 1, 0) == 1);
+            CHECK(other[0].iov_base == first[0].iov_base && other[0].iov_len == first[0].iov_len);
+        }
+        for (int w = 0; w < TEST_WATCHERS; ++w) {
+            CHECK(drain(&watchers[w], &views[w]) == 1 && view_matches(&views[w], &game));
+        }
+    }
+    CHECK(turns > 20);
+    CHECK(atomic_load(&hub.frames_encoded) == 1 + (unsigned long long)turns);
+    CHECK(views[0].seq == (uint32_t)turns);
+
+    /* A restart reaches everyone as a keyframe. */
+    game_init(&game, 12);
+    spectate_publish_reset(&hub, TEST_SESSION, &game, 0);
+    for (int w = 0; w < TEST_WATCHERS; ++w) {
+        CHECK(drain(&watchers[w], &views[w]) == 1 && view_matches(&views[w], &game));
+        spectate_watcher_destroy(&hub, &watchers[w]);
+    }
+    spectate_shutdown(&hub);
+    return 0;
+}
+
+/* A late joiner starts from the current keyframe; a stalled watcher is
+   resynced with one instead of growing its queue. */
+static int test_late_join_and_resync(void) {
+    SpectateHub hub;
+    CHECK(spectate_init(&hub, 1));
+    Game game;
+    game_init(&game, 3);
+
+    SpectateWatcher stalled;
+    SpectateView stalled_view;
+    memset(&stalled_view, 0, sizeof(stalled_view));
+    spectate_watcher_init(&stalled, -1);
+    spectate_watch(&hub, &stalled, TEST_SESSION, &game, 0);
+
+    /* A half-sent frame stays at the head across a resync. */
+    struct iovec iov[1];
+    CHECK(spectate_watcher_iov(&stalled, iov, 1, 0) == 1);
+    uint8_t head[PROTO_MAX_FRAME];
+    size_t head_len = iov[0].iov_len;
+    memcpy(head, iov[0].iov_base, head_len);
+    spectate_watcher_consume(&stalled, 5);
+    CHECK(spectate_watcher_midframe(&stalled));
+
+    int turns = 0;
+    ProtoReply reply;
+    while (turns < SPECTATE_QUEUE_FRAMES + 40) {
+        if (!play_turn(&game, &reply)) {
+            game_init(&game, (uint32_t)turns + 100);
+            spectate_publish_reset(&hub, TEST_SESSION, &game, 0);
+        } else {
+            spectate_publish_move(&hub, TEST_SESSION, &reply, &game, 0);
+        }
+        ++turns;
+    }
+    CHECK(stalled.resyncs > 0 && stalled.count <= SPECTATE_QUEUE_FRAMES);
+
+    CHECK(spectate_watcher_iov(&stalled, iov, 1, 0) == 1);
+    CHECK(iov[0].iov_len == head_len - 5 && memcmp(iov[0].iov_base, head + 5, head_len - 5) == 0);
+    ProtoReply frame;
+    CHECK(proto_decode_reply(head, head_len, &frame) == (int)head_len && spectate_view_apply(&stalled_view, &frame));
+    spectate_watcher_consume(&stalled, head_len - 5);
+    CHECK(drain(&stalled, &stalled_view) > 0 && view_matches(&stalled_view, &game));
+
+    SpectateWatcher late[2];
+    SpectateView late_views[2];
+    memset(late_views, 0, sizeof(late_views));
+    for (int w = 0; w < 2; ++w) {
+        spectate_watcher_init(&late[w], -1);
+        CHECK(spectate_watch(&hub, &late[w], TEST_SESSION, &game, 0) == (uint32_t)turns);
+    }
+    struct iovec a[1];
+    struct iovec b[1];
+    CHECK(spectate_watcher_iov(&late[0], a, 1, 0) == 1 && spectate_watcher_iov(&late[1], b, 1, 0) == 1);
+    CHECK(a[0].iov_base == b[0].iov_base);
+    for (int w = 0; w < 2; ++w) {
+        CHECK(drain(&late[w], &late_views[w]) == 1 && view_matches(&late_views[w], &game));
+    }
+
+    /* Unwatching the last watcher frees the channel. */
+    spectate_watcher_destroy(&hub, &stalled);
+    spectate_watcher_destroy(&hub, &late[0]);
+    CHECK(hub.shards[0].channels == 1);
+    spectate_watcher_destroy(&hub, &late[1]);
+    CHECK(hub.shards[0].channels == 0);
+    spectate_shutdown(&hub);
+    return 0;
+}
+
+/* A resync while the owner is mid-write keeps the frames it handed out as
+   iovecs: the iovecs stay readable and the bytes sent from them are
+   counted against those frames, not the resync keyframe. */
+static int test_resync_keeps_inflight(void) {
+    SpectateHub hub;
+    CHECK(spectate_init(&hub, 1));
+    Game game;
+    game_init(&game, 9);
+    SpectateWatcher watcher;
+    SpectateView view;
+    memset(&view, 0, sizeof(view));
+    spectate_watcher_init(&watcher, -1);
+    spectate_watch(&hub, &watcher, TEST_SESSION, &game, 0);
+
+    ProtoReply reply;
+    CHECK(play_turn(&game, &reply));
+    while (watcher.count < SPECTATE_QUEUE_FRAMES - 1) {
+        spectate_publish_move(&hub, TEST_SESSION, &reply, &game, 0);
+    }
+    static struct iovec iov[SPECTATE_QUEUE_FRAMES];
+    int count = spectate_watcher_iov(&watcher, iov, SPECTATE_QUEUE_FRAMES, 0);
+    CHECK(count == SPECTATE_QUEUE_FRAMES - 1);
+
+    CHECK(play_turn(&game, &reply));
+    spectate_publish_move(&hub, TEST_SESSION, &reply, &game, 0);
+    spectate_publish_move(&hub, TEST_SESSION, &reply, &game, 0);
+    CHECK(watcher.resyncs == 1);
+
+    size_t sent = 0;
+    for (int i = 0; i < count; ++i) {
+        ProtoReply frame;
+        CHECK(proto_decode_reply((const uint8_t *)iov[i].iov_base, iov[i].iov_len, &frame) == (int)iov[i].iov_len);
+        CHECK(spectate_view_apply(&view, &frame));
+        sent += iov[i].iov_len;
+    }
+    CHECK(watcher.count == SPECTATE_QUEUE_FRAMES);
+    spectate_watcher_consume(&watcher, sent);
+    CHECK(drain(&watcher, &view) == 1 && view_matches(&view, &game));
+
+    spectate_watcher_destroy(&hub, &watcher);
+    spectate_shutdown(&hub);
+    return 0;
+}
+
+/* Frames wait for the journal record they describe: nothing past the
+   durable LSN is offered, except the rest of a frame already partly sent. */
+static int test_durability_gate(void) {
+    SpectateHub hub;
+    CHECK(spectate_init(&hub, 1));
+    Game game;
+    game_init(&game, 17);
+    SpectateWatcher watcher;
+    SpectateView view;
+    memset(&view, 0, sizeof(view));
+    spectate_watcher_init(&watcher, -1);
+    spectate_watch(&hub, &watcher, TEST_SESSION, &game, 16);
+
+    ProtoReply reply;
+    CHECK(play_turn(&game, &reply));
+    spectate_publish_move(&hub, TEST_SESSION, &reply, &game, 32);
+    CHECK(play_turn(&game, &reply));
+    spectate_publish_move(&hub, TEST_SESSION, &reply, &game, 48);
+
+    struct iovec iov[4];
+    CHECK(!spectate_watcher_pending(&watcher, 15) && spectate_watcher_iov(&watcher, iov, 4, 15) == 0);
+    CHECK(spectate_watcher_pending(&watcher, 16) && spectate_watcher_iov(&watcher, iov, 4, 31) == 1);
+    ProtoReply frame;
+    CHECK(proto_decode_reply((const uint8_t *)iov[0].iov_base, iov[0].iov_len, &frame) == (int)iov[0].iov_len);
+    CHECK(spectate_view_apply(&view, &frame));
+    spectate_watcher_consume(&watcher, iov[0].iov_len);
+    CHECK(!spectate_watcher_pending(&watcher, 31));
+
+    CHECK(spectate_watcher_iov(&watcher, iov, 4, 47) == 1);
+    uint8_t delta[PROTO_MAX_FRAME];
+    size_t delta_len = iov[0].iov_len;
+    memcpy(delta, iov[0].iov_base, delta_len);
+    spectate_watcher_consume(&watcher, 3);
+    /* A torn frame must finish whatever the journal says. */
+    CHECK(spectate_watcher_pending(&watcher, 0) && spectate_watcher_iov(&watcher, iov, 4, 0) == 1);
+    CHECK(iov[0].iov_len == delta_len - 3 && memcmp(iov[0].iov_base, delta + 3, delta_len - 3) == 0);
+    spectate_watcher_consume(&watcher, delta_len - 3);
+    CHECK(proto_decode_reply(delta, delta_len, &frame) == (int)delta_len && spectate_view_apply(&view, &frame));
+
+    CHECK(!spectate_watcher_pending(&watcher, 47) && spectate_watcher_iov(&watcher, iov, 4, 47) == 0);
+    CHECK(spectate_watcher_iov(&watcher, iov, 4, UINT64_MAX) == 1);
+    CHECK(proto_decode_reply((const uint8_t *)iov[0].iov_base, iov[0].iov_len, &frame) == (int)iov[0].iov_len);
+    CHECK(spectate_view_apply(&view, &frame) && view_matches(&view, &game));
+    spectate_watcher_consume(&watcher, iov[0].iov_len);
+
+    spectate_watcher_destroy(&hub, &watcher);
+    spectate_shutdown(&hub);
+    return 0;
+}
+
+/* Views refuse deltas they cannot place until the next keyframe. */
+static int test_view_gap(void) {
+    Game game;
+    game_init(&game, 21);
+    ProtoReply keyframe;
+    memset(&keyframe, 0, sizeof(keyframe));
+    keyframe.type = PROTO_KEYFRAME;
+    keyframe.seq = 4;
+    memcpy(keyframe.board, game.board, GAME_CELLS);
+
+    ProtoReply delta;
+    memset(&delta, 0, sizeof(delta));
+    delta.type = PROTO_DELTA;
+    delta.seq = 5;
+
+    SpectateView view;
+    memset(&view, 0, sizeof(view));
+    CHECK(!spectate_view_apply(&view, &delta));
+    CHECK(spectate_view_apply(&view, &keyframe) && view.synced);
+    delta.seq = 6;
+    CHECK(!spectate_view_apply(&view, &delta) && !view.synced);
+    delta.seq = 7;
+    CHECK(!spectate_view_apply(&view, &delta));
+    keyframe.seq = 7;
+    CHECK(spectate_view_apply(&view, &keyframe));
+    delta.seq = 8;
+    CHECK(spectate_view_apply(&view, &delta) && view.seq == 8);
+    return 0;
+}
+
+int main(void) {
+    if (test_shared_fan_out() != 0 || test_late_join_and_resync() != 0 || test_resync_keeps_inflight() != 0 ||
+        test_durability_gate() != 0 || test_view_gap() != 0) {
+        return 1;
+    }
+
+    printf("Spectate tests passed.\n");
+    return 0;
+}
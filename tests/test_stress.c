@@ -1,17 +1,159 @@
-#include <stdio.h>
-#include <stdint.h>
+/* Parallel long-run simulation/invariant stress test.
+   Games are independent, so seeds are handed out to a thread pool through
+   one atomic counter and results do not depend on the thread count. A
+   failing run reports the smallest failing seed and the move it broke on;
+   --soak scales the run to millions of games. */
+
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "game.h"
+#include "perf_counters.h"
+
+#define STRESS_DEFAULT_GAMES 40
+#define STRESS_DEFAULT_MOVES 500
+#define STRESS_DEFAULT_THREADS 4
+#define STRESS_SOAK_GAMES 1000000
+#define STRESS_MAX_THREADS 256
+#define STRESS_SEED_BASE 1000u
+#define STRESS_SEED_STRIDE 7919u
 
+/* Records the failing expression and move, then fails the game. */
 #define CHECK(cond)                                                                                  \
     do {                                                                                             \
         if (!(cond)) {                                                                               \
-            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            fail->expr = #cond;                                                                      \
+            fail->line = __LINE__;                                                                   \
+            fail->move = moves_done;                                                                 \
             return 1;                                                                                \
         }                                                                                            \
     } while (0)
 
+/* Run configuration from the command line or LINES98_STRESS_* variables. */
+typedef struct {
+    long long games;
+    int move_limit;
+    int threads;
+    uint32_t seed_base;
+} StressConfig;
+
+/* First broken invariant of one game. */
+typedef struct {
+    const char *expr;
+    int line;
+    int move;
+} StressFailure;
+
+/* Work shared by all workers; only the smallest failing game is kept. */
+typedef struct {
+    const StressConfig *config;
+    atomic_llong next_game;
+    atomic_llong first_failed_game;
+    pthread_mutex_t lock;
+    StressFailure failure;
+    long long moves;
+    long long score_sum;
+    bool use_perf;
+    PerfSample perf_turns;
+    long long perf_turn_count;
+} StressRun;
+
+/* Totals gathered by one worker and merged when it exits. */
+typedef struct {
+    long long moves;
+    long long score_sum;
+    PerfCounters perf;
+    PerfSample perf_turns;
+    long long perf_turn_count;
+} StressWorker;
+
+/* Seed of game index i; the historical 40-game sequence is i = 0..39. */
+static uint32_t seed_for_game(const StressConfig *config, long long i) {
+    return config->seed_base + (uint32_t)i * STRESS_SEED_STRIDE;
+}
+
+/* Labels connected empty regions; region_min[cell] is the smallest cell
+   index of the region containing that empty cell, -1 for balls. */
+static void label_empty_regions(const Game *game, int *region_min) {
+    int queue[GAME_CELLS];
+    for (int i = 0; i < GAME_CELLS; ++i) {
+        region_min[i] = -1;
+    }
+
+    for (int start = 0; start < GAME_CELLS; ++start) {
+        if (game->board[start] != 0 || region_min[start] >= 0) {
+            continue;
+        }
+
+        /* Cells are visited in index order, so start is the region minimum. */
+        int head = 0;
+        int tail = 0;
+        queue[tail++] = start;
+        region_min[start] = start;
+        while (head < tail) {
+            int cur = queue[head++];
+            int row = cur / GAME_BOARD_SIZE;
+            int col = cur % GAME_BOARD_SIZE;
+            int next[4] = {
+                row > 0 ? cur - GAME_BOARD_SIZE : -1,
+                row < GAME_BOARD_SIZE - 1 ? cur + GAME_BOARD_SIZE : -1,
+                col > 0 ? cur - 1 : -1,
+                col < GAME_BOARD_SIZE - 1 ? cur + 1 : -1,
+            };
+            for (int k = 0; k < 4; ++k) {
+                int n = next[k];
+                if (n >= 0 && game->board[n] == 0 && region_min[n] < 0) {
+                    region_min[n] = start;
+                    queue[tail++] = n;
+                }
+            }
+        }
+    }
+}
+
+/* Picks the first ball in index order that borders an empty region and the
+   lowest empty cell it can reach. This is the same move the exhaustive
+   game_can_reach scan would pick, found with one flood fill per turn. */
+static bool pick_move(const Game *game, int *from, int *to) {
+    int region_min[GAME_CELLS];
+    label_empty_regions(game, region_min);
+
+    for (int cell = 0; cell < GAME_CELLS; ++cell) {
+        if (game->board[cell] == 0) {
+            continue;
+        }
+        int row = cell / GAME_BOARD_SIZE;
+        int col = cell % GAME_BOARD_SIZE;
+        int next[4] = {
+            row > 0 ? cell - GAME_BOARD_SIZE : -1,
+            row < GAME_BOARD_SIZE - 1 ? cell + GAME_BOARD_SIZE : -1,
+            col > 0 ? cell - 1 : -1,
+            col < GAME_BOARD_SIZE - 1 ? cell + 1 : -1,
+        };
+        int best = -1;
+        for (int k = 0; k < 4; ++k) {
+            int n = next[k];
+            if (n >= 0 && region_min[n] >= 0 && (best < 0 || region_min[n] < best)) {
+                best = region_min[n];
+            }
+        }
+        if (best >= 0) {
+            *from = cell;
+            *to = best;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Exhaustive cross-check used only when pick_move finds nothing. */
 static bool has_any_move(const Game *game) {
     for (int fr = 0; fr < GAME_BOARD_SIZE; ++fr) {
         for (int fc = 0; fc < GAME_BOARD_SIZE; ++fc) {
@@ -33,73 +175,277 @@ static bool has_any_move(const Game *game) {
     return false;
 }
 
-static int run_single_game(uint32_t seed, int move_limit) {
+/* Checks per-turn board invariants. */
+static int check_board(const Game *game, int moves_done, StressFailure *fail) {
+    for (int i = 0; i < GAME_CELLS; ++i) {
+        CHECK(game->board[i] <= GAME_COLORS);
+    }
+    for (int i = 0; i < GAME_NEXT_COUNT; ++i) {
+        CHECK(game->next_colors[i] >= 1 && game->next_colors[i] <= GAME_COLORS);
+    }
+    CHECK(game->score >= 0);
+    return 0;
+}
+
+/* Plays one game to the move limit; on failure fills fail and returns 1. */
+static int run_single_game(uint32_t seed, int move_limit, StressWorker *worker, StressFailure *fail) {
+    int moves_done = 0;
     Game game;
     game_init(&game, seed);
 
     CHECK(game_empty_count(&game) <= GAME_CELLS);
+    if (check_board(&game, moves_done, fail) != 0) {
+        return 1;
+    }
 
-    int moves_done = 0;
     while (!game.game_over && moves_done < move_limit) {
-        bool moved = false;
+        int from;
+        int to;
+        if (!pick_move(&game, &from, &to)) {
+            CHECK(game.game_over || !has_any_move(&game));
+            break;
+        }
 
-        for (int fr = 0; fr < GAME_BOARD_SIZE && !moved; ++fr) {
-            for (int fc = 0; fc < GAME_BOARD_SIZE && !moved; ++fc) {
-                if (game_get_cell(&game, fr, fc) == 0) {
-                    continue;
-                }
+        int fr = from / GAME_BOARD_SIZE;
+        int fc = from % GAME_BOARD_SIZE;
+        int tr = to / GAME_BOARD_SIZE;
+        int tc = to % GAME_BOARD_SIZE;
+        CHECK(game_can_reach(&game, fr, fc, tr, tc));
 
-                for (int tr = 0; tr < GAME_BOARD_SIZE && !moved; ++tr) {
-                    for (int tc = 0; tc < GAME_BOARD_SIZE && !moved; ++tc) {
-                        if (game_get_cell(&game, tr, tc) != 0) {
-                            continue;
-                        }
-                        if (!game_can_reach(&game, fr, fc, tr, tc)) {
-                            continue;
-                        }
+        GameAction a = game_click(&game, fr, fc);
+        CHECK(a == GAME_ACTION_SELECTED);
 
-                        GameAction a = game_click(&game, fr, fc);
-                        CHECK(a == GAME_ACTION_SELECTED);
+        int score_before = game.score;
+        perf_counters_begin(&worker->perf);
+        a = game_click(&game, tr, tc);
+        perf_counters_end(&worker->perf, &worker->perf_turns);
+        ++worker->perf_turn_count;
+        CHECK(a == GAME_ACTION_MOVED || a == GAME_ACTION_GAME_OVER);
+        CHECK(game.selected_index == -1);
 
-                        int score_before = game.score;
+        int empty_after = game_empty_count(&game);
+        CHECK(empty_after >= 0 && empty_after <= GAME_CELLS);
+        CHECK(game.score >= score_before);
+        CHECK(game.game_over == (empty_after == 0));
+        if (check_board(&game, moves_done, fail) != 0) {
+            return 1;
+        }
 
-                        a = game_click(&game, tr, tc);
-                        CHECK(a == GAME_ACTION_MOVED || a == GAME_ACTION_GAME_OVER);
+        ++moves_done;
+    }
 
-                        int empty_after = game_empty_count(&game);
-                        CHECK(empty_after >= 0 && empty_after <= GAME_CELLS);
-                        CHECK(game.score >= score_before);
+    CHECK(game.score >= 0);
+    CHECK(game_empty_count(&game) >= 0 && game_empty_count(&game) <= GAME_CELLS);
 
-                        moved = true;
-                        ++moves_done;
-                    }
-                }
-            }
+    worker->moves += moves_done;
+    worker->score_sum += game.score;
+    return 0;
+}
+
+/* Lowers first_failed_game to game if smaller; returns true if it did. */
+static bool claim_failure(StressRun *run, long long game) {
+    long long current = atomic_load(&run->first_failed_game);
+    while (game < current) {
+        if (atomic_compare_exchange_weak(&run->first_failed_game, &current, game)) {
+            return true;
         }
+    }
+    return false;
+}
 
-        if (!moved) {
-            CHECK(game.game_over || !has_any_move(&game));
+/* Worker loop: takes game indices until the range is exhausted or every
+   remaining index is above an already failing one. */
+static void *stress_worker(void *data) {
+    StressRun *run = (StressRun *)data;
+    const StressConfig *config = run->config;
+    StressWorker worker;
+    memset(&worker, 0, sizeof(worker));
+    if (run->use_perf) {
+        (void)perf_counters_open(&worker.perf);
+    }
+    perf_sample_reset(&worker.perf, &worker.perf_turns);
+
+    for (;;) {
+        long long i = atomic_fetch_add(&run->next_game, 1);
+        if (i >= config->games || i > atomic_load(&run->first_failed_game)) {
             break;
         }
+
+        StressFailure fail;
+        if (run_single_game(seed_for_game(config, i), config->move_limit, &worker, &fail) != 0) {
+            pthread_mutex_lock(&run->lock);
+            if (claim_failure(run, i)) {
+                run->failure = fail;
+            }
+            pthread_mutex_unlock(&run->lock);
+        }
     }
 
-    CHECK(game.score >= 0);
-    CHECK(game_empty_count(&game) >= 0 && game_empty_count(&game) <= GAME_CELLS);
+    pthread_mutex_lock(&run->lock);
+    run->moves += worker.moves;
+    run->score_sum += worker.score_sum;
+    run->perf_turn_count += worker.perf_turn_count;
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        run->perf_turns.value[e] += worker.perf_turns.value[e];
+        run->perf_turns.valid[e] = run->perf_turns.valid[e] || worker.perf_turns.valid[e];
+    }
+    pthread_mutex_unlock(&run->lock);
 
-    return 0;
+    perf_counters_close(&worker.perf);
+    return NULL;
 }
 
-int main(void) {
-    const int games = 40;
-    const int move_limit = 500;
+/* Prints hardware events averaged over measured turns. */
+static void report_perf(const StressRun *run) {
+    printf("perf per game_click turn (%lld turns):", run->perf_turn_count);
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (run->perf_turns.valid[e] && run->perf_turn_count > 0) {
+            printf(" %s=%.1f", perf_event_name((PerfEvent)e), (double)run->perf_turns.value[e] / (double)run->perf_turn_count);
+        } else {
+            printf(" %s=n/a", perf_event_name((PerfEvent)e));
+        }
+    }
+    printf("\n");
+}
 
-    for (int i = 0; i < games; ++i) {
-        uint32_t seed = 1000u + (uint32_t)i * 7919u;
-        if (run_single_game(seed, move_limit) != 0) {
-            return 1;
+/* Reads a positive integer environment variable, or fallback. */
+static long long env_count(const char *name, long long fallback) {
+    const char *value = getenv(name);
+    if (value == NULL || value[0] == '\0') {
+        return fallback;
+    }
+    return strtoll(value, NULL, 10);
+}
+
+/* Fills config from LINES98_STRESS_* variables, then command-line flags. */
+static bool parse_config(int argc, char **argv, StressConfig *config) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int default_threads = cpus > 0 && cpus < STRESS_DEFAULT_THREADS ? (int)cpus : STRESS_DEFAULT_THREADS;
+    bool soak = false;
+
+    config->games = env_count("LINES98_STRESS_GAMES", STRESS_DEFAULT_GAMES);
+    config->move_limit = (int)env_count("LINES98_STRESS_MOVES", STRESS_DEFAULT_MOVES);
+    config->threads = (int)env_count("LINES98_STRESS_THREADS", 0);
+    config->seed_base = (uint32_t)env_count("LINES98_STRESS_SEED", STRESS_SEED_BASE);
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "--soak") == 0) {
+            soak = true;
+        } else if (strcmp(arg, "--games") == 0 && has_value) {
+            config->games = strtoll(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--moves") == 0 && has_value) {
+            config->move_limit = atoi(argv[++i]);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            config->threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            config->seed_base = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--soak] [--games N] [--moves N] [--threads N] [--seed S]\n", argv[0]);
+            return false;
         }
     }
 
-    printf("Stress tests passed (%d games, up to %d moves each).\n", games, move_limit);
+    /* Soak only changes defaults; explicit counts still win. */
+    if (soak) {
+        if (getenv("LINES98_STRESS_GAMES") == NULL && config->games == STRESS_DEFAULT_GAMES) {
+            config->games = STRESS_SOAK_GAMES;
+        }
+        if (config->threads <= 0 && cpus > 0) {
+            config->threads = (int)(cpus < STRESS_MAX_THREADS ? cpus : STRESS_MAX_THREADS);
+        }
+    }
+    if (config->threads <= 0) {
+        config->threads = default_threads;
+    }
+
+    if (config->games <= 0 || config->move_limit <= 0 || config->threads > STRESS_MAX_THREADS) {
+        fprintf(stderr, "games and moves must be positive, threads at most %d\n", STRESS_MAX_THREADS);
+        return false;
+    }
+    if (config->games < config->threads) {
+        config->threads = (int)config->games;
+    }
+    return true;
+}
+
+/* Returns monotonic seconds. */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    StressConfig config;
+    if (!parse_config(argc, argv, &config)) {
+        return 2;
+    }
+
+    StressRun run;
+    memset(&run, 0, sizeof(run));
+    run.config = &config;
+    atomic_init(&run.next_game, 0);
+    atomic_init(&run.first_failed_game, config.games);
+    pthread_mutex_init(&run.lock, NULL);
+
+    const char *perf_env = getenv("LINES98_PERF");
+    run.use_perf = perf_env != NULL && perf_env[0] == '1';
+    if (run.use_perf) {
+        PerfCounters probe;
+        if (perf_counters_open(&probe)) {
+            perf_counters_close(&probe);
+        } else {
+            fprintf(stderr, "Hardware counters unavailable (%s)\n", probe.reason);
+        }
+    }
+
+    double start = now_seconds();
+    pthread_t threads[STRESS_MAX_THREADS];
+    int started = 0;
+    for (int t = 0; t < config.threads; ++t) {
+        if (pthread_create(&threads[t], NULL, stress_worker, &run) != 0) {
+            break;
+        }
+        ++started;
+    }
+    if (started == 0) {
+        (void)stress_worker(&run);
+    }
+    for (int t = 0; t < started; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+    double elapsed = now_seconds() - start;
+    pthread_mutex_destroy(&run.lock);
+
+    long long failed = atomic_load(&run.first_failed_game);
+    if (failed < config.games) {
+        fprintf(
+            stderr,
+            "FAILED: %s at %s:%d (game %lld, seed %u, move %d; rerun with --games 1 --seed %u --threads 1)\n",
+            run.failure.expr,
+            __FILE__,
+            run.failure.line,
+            failed,
+            seed_for_game(&config, failed),
+            run.failure.move,
+            seed_for_game(&config, failed)
+        );
+        return 1;
+    }
+
+    printf(
+        "Stress tests passed (%lld games, up to %d moves each, %d threads, %lld moves, score sum %lld, %.0f games/s).\n",
+        config.games,
+        config.move_limit,
+        started > 0 ? started : 1,
+        run.moves,
+        run.score_sum,
+        elapsed > 0.0 ? (double)config.games / elapsed : 0.0
+    );
+    if (run.use_perf) {
+        report_perf(&run);
+    }
     return 0;
 }
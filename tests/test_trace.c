@@ -0,0 +1,328 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+#include "turn_anim.h"
+
+#define CHECK(cond)                                                                                  \
+    do {                                                                                             \
+        if (!(cond)) {                                                                               \
+            fprintf(stderr, "FAILED: %s at %s:%d\n", #cond, __FILE__, __LINE__);                 \
+            return 1;                                                                                \
+        }                                                                                            \
+    } while (0)
+
+#define TRACE_TEST_PATH "lines98_trace_test.json"
+#define TRACE_TEST_MAX_TIDS 16
+#define TRACE_TEST_MAX_DEPTH 32
+
+/* Reads a whole file into a NUL-terminated heap string. */
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = (char *)malloc((size_t)size + 1);
+    if (text != NULL) {
+        size_t got = fread(text, 1, (size_t)size, f);
+        text[got] = '\0';
+    }
+    fclose(f);
+    return text;
+}
+
+/* Counts non-overlapping occurrences of needle in text. */
+static int count_of(const char *text, const char *needle) {
+    int count = 0;
+    for (const char *p = strstr(text, needle); p != NULL; p = strstr(p + 1, needle)) {
+        ++count;
+    }
+    return count;
+}
+
+/* Copies the string value following key on line into out; false if the
+   key is missing. */
+static bool field(const char *line, const char *key, char *out, size_t size) {
+    const char *p = strstr(line, key);
+    if (p == NULL) {
+        return false;
+    }
+    p += strlen(key);
+    size_t n = 0;
+    while (*p != '"' && *p != '\0' && n + 1 < size) {
+        out[n++] = *p++;
+    }
+    out[n] = '\0';
+    return true;
+}
+
+/* Returns true if every thread's B/E events nest strictly, innermost
+   closed first, and async b/e events nest the same way per id. */
+static bool spans_nest(const char *text) {
+    static char stacks[TRACE_TEST_MAX_TIDS][TRACE_TEST_MAX_DEPTH][32];
+    int depth[TRACE_TEST_MAX_TIDS] = {0};
+    static char async_names[TRACE_TEST_MAX_DEPTH][32];
+    static char async_ids[TRACE_TEST_MAX_DEPTH][24];
+    int async_depth = 0;
+    for (const char *line = strstr(text, "{\"ph\""); line != NULL; line = strstr(line + 1, "{\"ph\"")) {
+        char phase[4];
+        char name[32];
+        char tid_text[12];
+        if (!field(line, "\"ph\":\"", phase, sizeof(phase)) || !field(line, "\"tid\":", tid_text, sizeof(tid_text))) {
+            return false;
+        }
+        if (phase[0] == 'M' || phase[0] == 'i') {
+            continue;
+        }
+        if (!field(line, "\"name\":\"", name, sizeof(name))) {
+            return false;
+        }
+        int tid = atoi(tid_text);
+        if (tid < 0 || tid >= TRACE_TEST_MAX_TIDS) {
+            return false;
+        }
+        if (phase[0] == 'B') {
+            if (depth[tid] == TRACE_TEST_MAX_DEPTH) {
+                return false;
+            }
+            snprintf(stacks[tid][depth[tid]++], 32, "%s", name);
+        } else if (phase[0] == 'E') {
+            if (depth[tid] == 0 || strcmp(stacks[tid][--depth[tid]], name) != 0) {
+                return false;
+            }
+        } else {
+            char id[24];
+            if (!field(line, "\"id\":\"", id, sizeof(id))) {
+                return false;
+            }
+            if (phase[0] == 'b') {
+                if (async_depth == TRACE_TEST_MAX_DEPTH) {
+                    return false;
+                }
+                snprintf(async_names[async_depth], 32, "%s", name);
+                snprintf(async_ids[async_depth++], 24, "%s", id);
+            } else if (async_depth == 0 || strcmp(async_names[async_depth - 1], name) != 0 ||
+                       strcmp(async_ids[--async_depth], id) != 0) {
+                return false;
+            }
+        }
+    }
+    for (int tid = 0; tid < TRACE_TEST_MAX_TIDS; ++tid) {
+        if (depth[tid] != 0) {
+            return false;
+        }
+    }
+    return async_depth == 0;
+}
+
+/* Events are dropped while tracing is off. */
+static int test_disabled_is_noop(void) {
+    CHECK(!trace_enabled());
+    trace_begin("test", "ignored");
+    trace_end("test", "ignored");
+    CHECK(!trace_stop());
+    return 0;
+}
+
+/* Spans and markers land in the JSON with thread metadata. */
+static int test_writes_chrome_json(void) {
+    CHECK(trace_start(TRACE_TEST_PATH));
+    CHECK(!trace_start(TRACE_TEST_PATH));
+    trace_set_thread_name("main");
+    for (int i = 0; i < 3; ++i) {
+        trace_begin("test", "outer");
+        trace_instant("test", "mark");
+        trace_end("test", "outer");
+    }
+    CHECK(trace_stop());
+
+    char *text = read_file(TRACE_TEST_PATH);
+    CHECK(text != NULL);
+    int ok = strncmp(text, "{\"displayTimeUnit\"", 18) == 0 &&
+             count_of(text, "\"ph\":\"B\",\"cat\":\"test\",\"name\":\"outer\"") == 3 &&
+             count_of(text, "\"ph\":\"E\",\"cat\":\"test\",\"name\":\"outer\"") == 3 &&
+             count_of(text, "\"name\":\"mark\"") == 3 &&
+             count_of(text, "\"args\":{\"name\":\"main\"}") == 1 &&
+             count_of(text, "\"dropped_events\":0") == 1 && spans_nest(text);
+    free(text);
+    remove(TRACE_TEST_PATH);
+    CHECK(ok);
+    return 0;
+}
+
+/* A second session starts with fresh buffers and writes only its own events. */
+static int test_restart_starts_fresh(void) {
+    CHECK(trace_start(TRACE_TEST_PATH));
+    for (int i = 0; i < 20000; ++i) {
+        trace_instant("test", "tick");
+    }
+    CHECK(trace_stop());
+
+    char *text = read_file(TRACE_TEST_PATH);
+    CHECK(text != NULL);
+    int ticks = count_of(text, "\"name\":\"tick\"");
+    int outers = count_of(text, "\"name\":\"outer\"");
+    free(text);
+    remove(TRACE_TEST_PATH);
+    CHECK(ticks == 20000);
+    CHECK(outers == 0);
+    return 0;
+}
+
+/* Fills a one-step move from cell 0 to cell 1. */
+static void one_step_move(uint8_t *before, uint8_t *final_board, int *path) {
+    memset(before, 0, GAME_CELLS);
+    before[0] = 1;
+    memcpy(final_board, before, GAME_CELLS);
+    final_board[0] = 0;
+    final_board[1] = 1;
+    path[0] = 0;
+    path[1] = 1;
+}
+
+/* A turn starts while handling input, outside any frame span, and changes
+   phase inside later frames; its spans must not interleave with the frame
+   spans on the same thread. */
+static int test_turn_spans_across_frames(void) {
+    uint8_t before[GAME_CELLS];
+    uint8_t final_board[GAME_CELLS];
+    int path[2];
+    one_step_move(before, final_board, path);
+    uint8_t render[GAME_CELLS];
+
+    CHECK(trace_start(TRACE_TEST_PATH));
+    trace_set_thread_name("main");
+    TurnAnim anim;
+    turn_anim_init(&anim);
+    for (int turn = 0; turn < 2; ++turn) {
+        turn_anim_start(&anim, before, final_board, 0, 1, path, 2);
+        while (turn_anim_active(&anim)) {
+            trace_begin("frame", "frame");
+            turn_anim_update(&anim, 0.1f, render, GAME_CELLS, NULL);
+            trace_end("frame", "frame");
+        }
+    }
+    CHECK(trace_stop());
+
+    char *text = read_file(TRACE_TEST_PATH);
+    CHECK(text != NULL);
+    int ok = spans_nest(text) && count_of(text, "\"ph\":\"b\",\"cat\":\"turn\",\"name\":\"turn\"") == 2 &&
+             count_of(text, "\"ph\":\"b\",\"cat\":\"turn\",\"name\":\"spawn\"") == 2 &&
+             count_of(text, "\"ph\":\"B\",\"cat\":\"turn\"") == 0;
+    free(text);
+    remove(TRACE_TEST_PATH);
+    CHECK(ok);
+    return 0;
+}
+
+/* Restarting mid-turn closes the turn and phase spans it left open, so
+   later spans do not nest under them. */
+static int test_cancel_closes_turn_spans(void) {
+    uint8_t before[GAME_CELLS];
+    uint8_t final_board[GAME_CELLS];
+    int path[2];
+    one_step_move(before, final_board, path);
+    uint8_t render[GAME_CELLS];
+
+    CHECK(trace_start(TRACE_TEST_PATH));
+    TurnAnim anim;
+    turn_anim_init(&anim);
+    turn_anim_start(&anim, before, final_board, 0, 1, path, 2);
+    turn_anim_cancel(&anim);
+    CHECK(!turn_anim_active(&anim));
+
+    /* Cancel again mid-spawn, then once more while idle. */
+    turn_anim_start(&anim, before, final_board, 0, 1, path, 2);
+    turn_anim_update(&anim, 1.0f, render, GAME_CELLS, NULL);
+    turn_anim_cancel(&anim);
+    turn_anim_cancel(&anim);
+    trace_begin("test", "after");
+    trace_end("test", "after");
+    CHECK(trace_stop());
+
+    char *text = read_file(TRACE_TEST_PATH);
+    CHECK(text != NULL);
+    int turn_begins = count_of(text, "\"ph\":\"b\",\"cat\":\"turn\"");
+    int turn_ends = count_of(text, "\"ph\":\"e\",\"cat\":\"turn\"");
+    int turns = count_of(text, "\"name\":\"turn\"");
+    bool nested = spans_nest(text);
+    free(text);
+    remove(TRACE_TEST_PATH);
+    CHECK(turn_begins > 0 && turn_begins == turn_ends);
+    CHECK(turns == 4);
+    CHECK(nested);
+    return 0;
+}
+
+/* Handshake between the test and a worker recording across sessions. */
+static pthread_barrier_t worker_step;
+
+/* Records one event in each of two trace sessions. */
+static void *record_across_sessions(void *data) {
+    (void)data;
+    trace_set_thread_name("worker");
+    trace_instant("test", "first");
+    pthread_barrier_wait(&worker_step);
+    pthread_barrier_wait(&worker_step);
+    trace_set_thread_name("worker");
+    trace_instant("test", "second");
+    pthread_barrier_wait(&worker_step);
+    return NULL;
+}
+
+/* A thread that recorded in a stopped session starts a new chunk in the
+   next one instead of writing through its freed chunk. */
+static int test_other_thread_survives_restart(void) {
+    CHECK(pthread_barrier_init(&worker_step, NULL, 2) == 0);
+    CHECK(trace_start(TRACE_TEST_PATH));
+    pthread_t worker;
+    CHECK(pthread_create(&worker, NULL, record_across_sessions, NULL) == 0);
+    pthread_barrier_wait(&worker_step);
+    CHECK(trace_stop());
+    remove(TRACE_TEST_PATH);
+
+    CHECK(trace_start(TRACE_TEST_PATH));
+    pthread_barrier_wait(&worker_step);
+    pthread_barrier_wait(&worker_step);
+    pthread_join(worker, NULL);
+    pthread_barrier_destroy(&worker_step);
+    CHECK(trace_stop());
+
+    char *text = read_file(TRACE_TEST_PATH);
+    CHECK(text != NULL);
+    int ok = count_of(text, "\"name\":\"second\"") == 1 && count_of(text, "\"name\":\"first\"") == 0 &&
+             count_of(text, "\"args\":{\"name\":\"worker\"}") == 1;
+    free(text);
+    remove(TRACE_TEST_PATH);
+    CHECK(ok);
+    return 0;
+}
+
+int main(void) {
+    if (test_disabled_is_noop() != 0) {
+        return 1;
+    }
+    if (test_writes_chrome_json() != 0) {
+        return 1;
+    }
+    if (test_restart_starts_fresh() != 0) {
+        return 1;
+    }
+    if (test_turn_spans_across_frames() != 0) {
+        return 1;
+    }
+    if (test_cancel_closes_turn_spans() != 0) {
+        return 1;
+    }
+    if (test_other_thread_survives_restart() != 0) {
+        return 1;
+    }
+
+    printf("Trace tests passed.\n");
+    return 0;
+}